@@ -39,6 +39,9 @@
 #define AT45DB321D_FLASH_COMMAND_READ_FROM_MAIN_MEMORY_DIRECT    0xD2
 #define AT45DB321D_FLASH_COMMAND_PAGE_ERASE                      0x81
 #define AT45DB321D_FLASH_COMMAND_BLOCK_ERASE                     0x50
+#define AT45DB321D_FLASH_COMMAND_CONTINUOUS_ARRAY_READ           0x0B
+#define AT45DB321D_FLASH_COMMAND_WRITE_BUFFER_1_TO_MEMORY_NO_ERASE   0x88
+#define AT45DB321D_FLASH_COMMAND_WRITE_BUFFER_2_TO_MEMORY_NO_ERASE   0x89
 
 #define AT45DB321D_FLASH_COMMAND_SIZE                      4
 #define AT45DB321D_FLASH_ACCESS_TIMEOUT                    1000
@@ -49,12 +52,18 @@
 #define AT45DB321D_FLASH_MANUFACTURER_CODE                 0x1F
 #define AT45DB321D_FLASH_DEVICE_CODE                       0x27
 
-#define AT45DB321D_SPI_CLOCK_HZ 20000000
+// Continuous Array Read (0x0B), buffer writes and the other commands the driver uses are specified up to 66MHz
+#ifndef AT45DB321D_SPI_STREAM_CLOCK_HZ
+#define AT45DB321D_SPI_STREAM_CLOCK_HZ 50000000
+#endif
 
 const TinyCLR_Spi_Controller* g_AT45DB321D_Flash_SpiProvider;
 const TinyCLR_NativeTime_Controller* g_AT45DB321D_Flash_TimeProvider;
 static TinyCLR_Spi_Settings g_AT45DB321D_Flash_SpiSettings;
 
+// in RAM so the SPI DMA can repeat it
+static uint8_t g_AT45DB321D_Flash_DummyByte = 0xFF;
+
 uint32_t g_AT45DB321D_Flash_SpiChipSelectLine;
 
 uint64_t g_AT45DB321D_Flash_SectorAddress[AT45DB321D_FLASH_SECTOR_NUM];
@@ -65,6 +74,17 @@ uint8_t g_AT45DB321D_Flash_BufferRW[(AT45DB321D_FLASH_PAGE_SIZE * 1) + AT45DB321
 uint8_t g_AT45DB321D_Flash_DataReadBuffer[AT45DB321D_FLASH_BLOCK_SIZE + 8];
 uint8_t g_AT45DB321D_Flash_DataWriteBuffer[AT45DB321D_FLASH_BLOCK_SIZE + 8];
 
+// Chip select is owned by the driver, the SPI settings carry no pin. Each command gets its own select.
+TinyCLR_Result AT45DB321D_Flash_WriteRead(const uint8_t* writeBuffer, size_t& writeLength, uint8_t* readBuffer, size_t& readLength) {
+    CONCAT(DEVICE_TARGET, _Gpio_Write)(nullptr, g_AT45DB321D_Flash_SpiChipSelectLine, TinyCLR_Gpio_PinValue::Low);
+
+    auto result = g_AT45DB321D_Flash_SpiProvider->WriteRead(g_AT45DB321D_Flash_SpiProvider, writeBuffer, writeLength, readBuffer, readLength, false);
+
+    CONCAT(DEVICE_TARGET, _Gpio_Write)(nullptr, g_AT45DB321D_Flash_SpiChipSelectLine, TinyCLR_Gpio_PinValue::High);
+
+    return result;
+}
+
 uint8_t AT45DB321D_Flash_GetStatus() {
     size_t writeLength;
     size_t readLength;
@@ -75,131 +95,113 @@ uint8_t AT45DB321D_Flash_GetStatus() {
     writeLength = 2;
     readLength = 2;
 
-    g_AT45DB321D_Flash_SpiProvider->WriteRead(g_AT45DB321D_Flash_SpiProvider, g_AT45DB321D_Flash_DataWriteBuffer, writeLength, g_AT45DB321D_Flash_DataReadBuffer, readLength, false);
+    AT45DB321D_Flash_WriteRead(g_AT45DB321D_Flash_DataWriteBuffer, writeLength, g_AT45DB321D_Flash_DataReadBuffer, readLength);
 
     return g_AT45DB321D_Flash_DataReadBuffer[1];
 }
 
-TinyCLR_Result AT45DB321D_Flash_Read(uint32_t address, size_t length, uint8_t* buffer) {
-    DISABLE_INTERRUPTS_SCOPED(irq);
-
-    int32_t block = length / AT45DB321D_FLASH_PAGE_SIZE;
-    int32_t rest = length % AT45DB321D_FLASH_PAGE_SIZE;
-    int32_t index = 0;
-    size_t writeLength;
-    size_t readLength;
-
-    g_AT45DB321D_Flash_SpiProvider->Acquire(g_AT45DB321D_Flash_SpiProvider);
+bool AT45DB321D_Flash_WaitReady() {
+    for (auto timeout = 0; timeout < AT45DB321D_FLASH_ACCESS_TIMEOUT; timeout++) {
+        if (AT45DB321D_Flash_GetStatus() & 0x80)
+            return true;
 
-    g_AT45DB321D_Flash_SpiProvider->SetActiveSettings(g_AT45DB321D_Flash_SpiProvider, &g_AT45DB321D_Flash_SpiSettings);
+        g_AT45DB321D_Flash_TimeProvider->Wait(g_AT45DB321D_Flash_TimeProvider, g_AT45DB321D_Flash_TimeProvider->ConvertSystemTimeToNativeTime(g_AT45DB321D_Flash_TimeProvider, 1000));
+    }
 
-    while (block > 0) {
-        uint32_t pageNumber = (address % AT45DB321D_FLASH_PAGE_SIZE) | ((address / AT45DB321D_FLASH_PAGE_SIZE) << 10);
+    return false;
+}
 
-        g_AT45DB321D_Flash_DataWriteBuffer[0] = AT45DB321D_FLASH_COMMAND_READ_FROM_MAIN_MEMORY_LEGACY;
-        g_AT45DB321D_Flash_DataWriteBuffer[1] = pageNumber >> 16;
-        g_AT45DB321D_Flash_DataWriteBuffer[2] = pageNumber >> 8;
-        g_AT45DB321D_Flash_DataWriteBuffer[3] = pageNumber;
-        g_AT45DB321D_Flash_DataWriteBuffer[4] = 0x00;
-        g_AT45DB321D_Flash_DataWriteBuffer[5] = 0x00;
-        g_AT45DB321D_Flash_DataWriteBuffer[6] = 0x00;
-        g_AT45DB321D_Flash_DataWriteBuffer[7] = 0x00;
+uint32_t AT45DB321D_Flash_GetPageAddress(uint32_t address) {
+    return (address % AT45DB321D_FLASH_PAGE_SIZE) | ((address / AT45DB321D_FLASH_PAGE_SIZE) << 10);
+}
 
-        writeLength = AT45DB321D_FLASH_PAGE_SIZE + 8;
-        readLength = AT45DB321D_FLASH_PAGE_SIZE + 8;
+// Command followed by a data phase under a single chip select, the data phase goes straight from/to the caller's buffer.
+TinyCLR_Result AT45DB321D_Flash_Stream(const uint8_t* command, size_t commandLength, const uint8_t* writeBuffer, uint8_t* readBuffer, size_t length) {
+    size_t writeLength = commandLength;
+    size_t readLength = 0;
 
-        g_AT45DB321D_Flash_SpiProvider->WriteRead(g_AT45DB321D_Flash_SpiProvider, g_AT45DB321D_Flash_DataWriteBuffer, writeLength, g_AT45DB321D_Flash_DataReadBuffer, readLength, false);
+    CONCAT(DEVICE_TARGET, _Gpio_Write)(nullptr, g_AT45DB321D_Flash_SpiChipSelectLine, TinyCLR_Gpio_PinValue::Low);
 
-        int32_t timeout;
+    auto result = g_AT45DB321D_Flash_SpiProvider->WriteRead(g_AT45DB321D_Flash_SpiProvider, command, writeLength, nullptr, readLength, false);
 
-        for (timeout = 0; timeout < AT45DB321D_FLASH_ACCESS_TIMEOUT; timeout++) {
-            if (AT45DB321D_Flash_GetStatus() & 0x80)
-                break;
+    if (result == TinyCLR_Result::Success && length > 0) {
+        if (readBuffer != nullptr) {
+            // single dummy byte is repeated by the controller for the whole data phase
+            writeLength = 1;
+            readLength = length;
 
-            g_AT45DB321D_Flash_TimeProvider->Wait(g_AT45DB321D_Flash_TimeProvider, g_AT45DB321D_Flash_TimeProvider->ConvertSystemTimeToNativeTime(g_AT45DB321D_Flash_TimeProvider, 1000));
+            result = g_AT45DB321D_Flash_SpiProvider->WriteRead(g_AT45DB321D_Flash_SpiProvider, &g_AT45DB321D_Flash_DummyByte, writeLength, readBuffer, readLength, false);
         }
+        else {
+            writeLength = length;
+            readLength = 0;
 
-        memcpy(&buffer[index], &g_AT45DB321D_Flash_DataReadBuffer[8], AT45DB321D_FLASH_PAGE_SIZE);
-
-        address += AT45DB321D_FLASH_PAGE_SIZE;
-        index += AT45DB321D_FLASH_PAGE_SIZE;
-        block--;
+            result = g_AT45DB321D_Flash_SpiProvider->WriteRead(g_AT45DB321D_Flash_SpiProvider, writeBuffer, writeLength, nullptr, readLength, false);
+        }
     }
 
-    if (rest > 0) {
-        uint32_t pageNumber = (address % AT45DB321D_FLASH_PAGE_SIZE) | ((address / AT45DB321D_FLASH_PAGE_SIZE) << 10);
+    CONCAT(DEVICE_TARGET, _Gpio_Write)(nullptr, g_AT45DB321D_Flash_SpiChipSelectLine, TinyCLR_Gpio_PinValue::High);
 
-        g_AT45DB321D_Flash_DataWriteBuffer[0] = AT45DB321D_FLASH_COMMAND_READ_FROM_MAIN_MEMORY_LEGACY;
-        g_AT45DB321D_Flash_DataWriteBuffer[1] = pageNumber >> 16;
-        g_AT45DB321D_Flash_DataWriteBuffer[2] = pageNumber >> 8;
-        g_AT45DB321D_Flash_DataWriteBuffer[3] = pageNumber;
-        g_AT45DB321D_Flash_DataWriteBuffer[4] = 0x00;
-        g_AT45DB321D_Flash_DataWriteBuffer[5] = 0x00;
-        g_AT45DB321D_Flash_DataWriteBuffer[6] = 0x00;
-        g_AT45DB321D_Flash_DataWriteBuffer[7] = 0x00;
+    return result;
+}
 
-        writeLength = rest + 8;
-        readLength = rest + 8;
+TinyCLR_Result AT45DB321D_Flash_Read(uint32_t address, size_t length, uint8_t* buffer) {
+    DISABLE_INTERRUPTS_SCOPED(irq);
 
-        g_AT45DB321D_Flash_SpiProvider->WriteRead(g_AT45DB321D_Flash_SpiProvider, g_AT45DB321D_Flash_DataWriteBuffer, writeLength, g_AT45DB321D_Flash_DataReadBuffer, readLength, false);
+    g_AT45DB321D_Flash_SpiProvider->Acquire(g_AT45DB321D_Flash_SpiProvider);
 
-        int32_t timeout;
+    g_AT45DB321D_Flash_SpiProvider->SetActiveSettings(g_AT45DB321D_Flash_SpiProvider, &g_AT45DB321D_Flash_SpiSettings);
 
-        for (timeout = 0; timeout < AT45DB321D_FLASH_ACCESS_TIMEOUT; timeout++) {
-            if (AT45DB321D_Flash_GetStatus() & 0x80)
-                break;
+    auto result = TinyCLR_Result::InvalidOperation;
 
-            g_AT45DB321D_Flash_TimeProvider->Wait(g_AT45DB321D_Flash_TimeProvider, g_AT45DB321D_Flash_TimeProvider->ConvertSystemTimeToNativeTime(g_AT45DB321D_Flash_TimeProvider, 1000));
-        }
+    if (AT45DB321D_Flash_WaitReady()) {
+        // Continuous Array Read wraps from page to page by itself, one command covers the whole range
+        uint32_t pageAddress = AT45DB321D_Flash_GetPageAddress(address);
+        uint8_t command[AT45DB321D_FLASH_COMMAND_SIZE + 1];
 
-        memcpy(&buffer[index], &g_AT45DB321D_Flash_DataReadBuffer[8], rest);
+        command[0] = AT45DB321D_FLASH_COMMAND_CONTINUOUS_ARRAY_READ;
+        command[1] = pageAddress >> 16;
+        command[2] = pageAddress >> 8;
+        command[3] = pageAddress;
+        command[4] = 0x00; // dummy
 
-        address += rest;
-        index += rest;
-        block--;
+        result = AT45DB321D_Flash_Stream(command, sizeof(command), nullptr, buffer, length);
     }
 
     g_AT45DB321D_Flash_SpiProvider->Release(g_AT45DB321D_Flash_SpiProvider);
 
-    return TinyCLR_Result::Success;
+    return result == TinyCLR_Result::Success ? TinyCLR_Result::Success : TinyCLR_Result::InvalidOperation;
 }
 
-bool AT45DB321D_Flash_WriteSector(uint32_t pageNumber, uint8_t* dataBuffer) {
+// Loads one page into SRAM buffer 1 or 2 and starts programming it. The caller waits for ready before the next program,
+// the load of the other buffer overlaps with the programming of this one.
+bool AT45DB321D_Flash_WritePage(uint32_t pageNumber, uint32_t bufferIndex, const uint8_t* dataBuffer) {
     size_t writeLength;
     size_t readLength;
 
-    g_AT45DB321D_Flash_DataWriteBuffer[0] = AT45DB321D_FLASH_COMMAND_WRITE_BUFFER_1;
-    g_AT45DB321D_Flash_DataWriteBuffer[1] = 0x00;
-    g_AT45DB321D_Flash_DataWriteBuffer[2] = 0x00;
-    g_AT45DB321D_Flash_DataWriteBuffer[3] = 0x00;
+    uint8_t command[AT45DB321D_FLASH_COMMAND_SIZE];
 
-    memcpy(&g_AT45DB321D_Flash_DataWriteBuffer[4], dataBuffer, AT45DB321D_FLASH_PAGE_SIZE);
+    command[0] = bufferIndex == 0 ? AT45DB321D_FLASH_COMMAND_WRITE_BUFFER_1 : AT45DB321D_FLASH_COMMAND_WRITE_BUFFER_2;
+    command[1] = 0x00;
+    command[2] = 0x00;
+    command[3] = 0x00;
 
-    writeLength = AT45DB321D_FLASH_COMMAND_SIZE + AT45DB321D_FLASH_PAGE_SIZE;
-    readLength = AT45DB321D_FLASH_COMMAND_SIZE + AT45DB321D_FLASH_PAGE_SIZE;
+    if (AT45DB321D_Flash_Stream(command, sizeof(command), dataBuffer, nullptr, AT45DB321D_FLASH_PAGE_SIZE) != TinyCLR_Result::Success)
+        return false;
 
-    g_AT45DB321D_Flash_SpiProvider->WriteRead(g_AT45DB321D_Flash_SpiProvider, g_AT45DB321D_Flash_DataWriteBuffer, writeLength, g_AT45DB321D_Flash_DataReadBuffer, readLength, false);
+    // the previous page may still be programming from the other buffer
+    if (!AT45DB321D_Flash_WaitReady())
+        return false;
 
-    g_AT45DB321D_Flash_DataWriteBuffer[0] = 0x88;
+    g_AT45DB321D_Flash_DataWriteBuffer[0] = bufferIndex == 0 ? AT45DB321D_FLASH_COMMAND_WRITE_BUFFER_1_TO_MEMORY_NO_ERASE : AT45DB321D_FLASH_COMMAND_WRITE_BUFFER_2_TO_MEMORY_NO_ERASE;
     g_AT45DB321D_Flash_DataWriteBuffer[1] = (pageNumber << 2) >> 8;
     g_AT45DB321D_Flash_DataWriteBuffer[2] = pageNumber << 2;
     g_AT45DB321D_Flash_DataWriteBuffer[3] = 0x00;
 
     writeLength = AT45DB321D_FLASH_COMMAND_SIZE;
-    readLength = AT45DB321D_FLASH_COMMAND_SIZE;
-
-    g_AT45DB321D_Flash_SpiProvider->WriteRead(g_AT45DB321D_Flash_SpiProvider, g_AT45DB321D_Flash_DataWriteBuffer, writeLength, g_AT45DB321D_Flash_DataReadBuffer, readLength, false);
-
-    int32_t timeout;
-
-    for (timeout = 0; timeout < AT45DB321D_FLASH_ACCESS_TIMEOUT; timeout++) {
-        if (AT45DB321D_Flash_GetStatus() & 0x80)
-            return true;
-
-        g_AT45DB321D_Flash_TimeProvider->Wait(g_AT45DB321D_Flash_TimeProvider, g_AT45DB321D_Flash_TimeProvider->ConvertSystemTimeToNativeTime(g_AT45DB321D_Flash_TimeProvider, 1000));
-    }
+    readLength = 0;
 
-    return false;
+    return AT45DB321D_Flash_WriteRead(g_AT45DB321D_Flash_DataWriteBuffer, writeLength, nullptr, readLength) == TinyCLR_Result::Success;
 }
 
 TinyCLR_Result AT45DB321D_Flash_Write(uint32_t address, size_t length, const uint8_t* buffer) {
@@ -207,101 +209,59 @@ TinyCLR_Result AT45DB321D_Flash_Write(uint32_t address, size_t length, const uin
 
     uint32_t pageNumber = address / AT45DB321D_FLASH_PAGE_SIZE;
     uint32_t pageOffset = address % AT45DB321D_FLASH_PAGE_SIZE;
-    uint32_t currentIndex = 0;
-    uint32_t remainingBytes = length;
-    uint32_t beginningBytes = AT45DB321D_FLASH_PAGE_SIZE - pageOffset;
-    uint32_t remainingBytesPageSegmentSize = AT45DB321D_FLASH_PAGE_SIZE - pageOffset;
+    uint32_t bufferIndex = 0;
+    auto success = true;
 
     g_AT45DB321D_Flash_SpiProvider->Acquire(g_AT45DB321D_Flash_SpiProvider);
 
     g_AT45DB321D_Flash_SpiProvider->SetActiveSettings(g_AT45DB321D_Flash_SpiProvider, &g_AT45DB321D_Flash_SpiSettings);
 
-    if (pageOffset) {
-        memset(g_AT45DB321D_Flash_BufferRW, 0xFF, AT45DB321D_FLASH_PAGE_SIZE);
+    while (length > 0 && success) {
+        uint32_t count = AT45DB321D_FLASH_PAGE_SIZE - pageOffset;
 
-        if (length <= remainingBytesPageSegmentSize) {
-            memcpy(&g_AT45DB321D_Flash_BufferRW[pageOffset], &buffer[currentIndex], length);
+        if (count > length)
+            count = length;
 
-            remainingBytes -= length;
+        if (count == AT45DB321D_FLASH_PAGE_SIZE) {
+            success = AT45DB321D_Flash_WritePage(pageNumber, bufferIndex, buffer);
         }
         else {
-            memcpy(&g_AT45DB321D_Flash_BufferRW[pageOffset], &buffer[currentIndex], beginningBytes);
+            // partial page, bytes outside the range are programmed as 0xFF and keep their content
+            memset(g_AT45DB321D_Flash_BufferRW, 0xFF, AT45DB321D_FLASH_PAGE_SIZE);
+            memcpy(&g_AT45DB321D_Flash_BufferRW[pageOffset], buffer, count);
 
-            currentIndex += beginningBytes;
-            remainingBytes -= beginningBytes;
+            success = AT45DB321D_Flash_WritePage(pageNumber, bufferIndex, g_AT45DB321D_Flash_BufferRW);
         }
 
-        AT45DB321D_Flash_WriteSector(pageNumber, g_AT45DB321D_Flash_BufferRW);
-
-        pageNumber++;
-    }
-
-    if (!remainingBytes)
-        TinyCLR_Result::Success;
-
-    uint32_t sector = remainingBytes / AT45DB321D_FLASH_PAGE_SIZE;
-
-    while (sector) {
-        memset(g_AT45DB321D_Flash_BufferRW, 0xFF, AT45DB321D_FLASH_PAGE_SIZE);
-        memcpy(g_AT45DB321D_Flash_BufferRW, &buffer[currentIndex], AT45DB321D_FLASH_PAGE_SIZE);
-
-        AT45DB321D_Flash_WriteSector(pageNumber, g_AT45DB321D_Flash_BufferRW);
-
-        currentIndex += AT45DB321D_FLASH_PAGE_SIZE;
-        remainingBytes -= AT45DB321D_FLASH_PAGE_SIZE;
-        sector--;
+        buffer += count;
+        length -= count;
+        pageOffset = 0;
         pageNumber++;
+        bufferIndex ^= 1;
     }
 
-    if (!remainingBytes)
-        TinyCLR_Result::Success;
-
-    memset(g_AT45DB321D_Flash_BufferRW, 0xFF, AT45DB321D_FLASH_PAGE_SIZE);
-    memcpy(g_AT45DB321D_Flash_BufferRW, &buffer[currentIndex], remainingBytes);
-
-    AT45DB321D_Flash_WriteSector(pageNumber, g_AT45DB321D_Flash_BufferRW);
+    if (success)
+        success = AT45DB321D_Flash_WaitReady();
 
     g_AT45DB321D_Flash_SpiProvider->Release(g_AT45DB321D_Flash_SpiProvider);
 
-    return TinyCLR_Result::Success;
+    return success ? TinyCLR_Result::Success : TinyCLR_Result::InvalidOperation;
 }
 
 TinyCLR_Result AT45DB321D_Flash_IsBlockErased(uint32_t sector, bool &erased) {
     DISABLE_INTERRUPTS_SCOPED(irq);
-    uint32_t startAddress = g_AT45DB321D_Flash_SectorAddress[sector];
 
-    int32_t block = AT45DB321D_FLASH_BLOCK_SIZE / AT45DB321D_FLASH_PAGE_SIZE;
-    int32_t rest = AT45DB321D_FLASH_BLOCK_SIZE % AT45DB321D_FLASH_PAGE_SIZE;
-
-    erased = true;
+    erased = false;
 
-    while (block > 0) {
-        AT45DB321D_Flash_Read(startAddress, AT45DB321D_FLASH_PAGE_SIZE, g_AT45DB321D_Flash_BufferRW);
-
-        for (auto i = 0; i < AT45DB321D_FLASH_PAGE_SIZE; i++) {
-            if (g_AT45DB321D_Flash_BufferRW[i] != 0xFF) {
-                erased = false;
-
-                return TinyCLR_Result::Success;
-            }
-        }
-
-        block--;
+    if (AT45DB321D_Flash_Read(g_AT45DB321D_Flash_SectorAddress[sector], AT45DB321D_FLASH_BLOCK_SIZE, g_AT45DB321D_Flash_DataReadBuffer) != TinyCLR_Result::Success)
+        return TinyCLR_Result::InvalidOperation;
 
-        startAddress += AT45DB321D_FLASH_PAGE_SIZE;
+    for (auto i = 0; i < AT45DB321D_FLASH_BLOCK_SIZE; i++) {
+        if (g_AT45DB321D_Flash_DataReadBuffer[i] != 0xFF)
+            return TinyCLR_Result::Success;
     }
 
-    if (rest > 0) {
-        AT45DB321D_Flash_Read(startAddress, rest, g_AT45DB321D_Flash_BufferRW);
-
-        for (auto i = 0; i < rest; i++) {
-            if (g_AT45DB321D_Flash_BufferRW[i] != 0xFF) {
-                erased = false;
-
-                return TinyCLR_Result::Success;
-            }
-        }
-    }
+    erased = true;
 
     return TinyCLR_Result::Success;
 }
@@ -327,7 +287,7 @@ TinyCLR_Result AT45DB321D_Flash_EraseBlock(uint32_t sector) {
     readLength = AT45DB321D_FLASH_COMMAND_SIZE;
 
 
-    g_AT45DB321D_Flash_SpiProvider->WriteRead(g_AT45DB321D_Flash_SpiProvider, g_AT45DB321D_Flash_DataWriteBuffer, writeLength, g_AT45DB321D_Flash_DataReadBuffer, readLength, false);
+    AT45DB321D_Flash_WriteRead(g_AT45DB321D_Flash_DataWriteBuffer, writeLength, g_AT45DB321D_Flash_DataReadBuffer, readLength);
 
     int32_t timeout;
 
@@ -358,17 +318,27 @@ TinyCLR_Result AT45DB321D_Flash_Acquire(const TinyCLR_Spi_Controller* spiProvide
 
     g_AT45DB321D_Flash_SpiChipSelectLine = chipSelectLine;
 
+    if (CONCAT(DEVICE_TARGET, _Gpio_OpenPin)(nullptr, g_AT45DB321D_Flash_SpiChipSelectLine) != TinyCLR_Result::Success)
+        return TinyCLR_Result::SharingViolation;
+
+    CONCAT(DEVICE_TARGET, _Gpio_Write)(nullptr, g_AT45DB321D_Flash_SpiChipSelectLine, TinyCLR_Gpio_PinValue::High);
+    CONCAT(DEVICE_TARGET, _Gpio_SetDriveMode)(nullptr, g_AT45DB321D_Flash_SpiChipSelectLine, TinyCLR_Gpio_PinDriveMode::Output);
+
     g_AT45DB321D_Flash_SpiProvider->Acquire(g_AT45DB321D_Flash_SpiProvider);
 
+    // one settings for every command, the controller is not reprogrammed between them
     g_AT45DB321D_Flash_SpiSettings.Mode = TinyCLR_Spi_Mode::Mode0;
-    g_AT45DB321D_Flash_SpiSettings.ClockFrequency = AT45DB321D_SPI_CLOCK_HZ;
+    g_AT45DB321D_Flash_SpiSettings.ClockFrequency = g_AT45DB321D_Flash_SpiProvider->GetMaxClockFrequency(g_AT45DB321D_Flash_SpiProvider);
     g_AT45DB321D_Flash_SpiSettings.DataBitLength = 8;
     g_AT45DB321D_Flash_SpiSettings.ChipSelectType = TinyCLR_Spi_ChipSelectType::Gpio;
-    g_AT45DB321D_Flash_SpiSettings.ChipSelectLine = g_AT45DB321D_Flash_SpiChipSelectLine;
+    g_AT45DB321D_Flash_SpiSettings.ChipSelectLine = PIN_NONE;
     g_AT45DB321D_Flash_SpiSettings.ChipSelectSetupTime = 0;
     g_AT45DB321D_Flash_SpiSettings.ChipSelectHoldTime = 0;
     g_AT45DB321D_Flash_SpiSettings.ChipSelectActiveState = false;
 
+    if (g_AT45DB321D_Flash_SpiSettings.ClockFrequency > AT45DB321D_SPI_STREAM_CLOCK_HZ)
+        g_AT45DB321D_Flash_SpiSettings.ClockFrequency = AT45DB321D_SPI_STREAM_CLOCK_HZ;
+
     g_AT45DB321D_Flash_SpiProvider->SetActiveSettings(g_AT45DB321D_Flash_SpiProvider, &g_AT45DB321D_Flash_SpiSettings);
 
     g_AT45DB321D_Flash_DataWriteBuffer[0] = AT45DB321D_FLASH_COMMAND_READID;
@@ -380,13 +350,15 @@ TinyCLR_Result AT45DB321D_Flash_Acquire(const TinyCLR_Spi_Controller* spiProvide
     writeLength = 5;
     readLength = 5;
 
-    g_AT45DB321D_Flash_SpiProvider->WriteRead(g_AT45DB321D_Flash_SpiProvider, g_AT45DB321D_Flash_DataWriteBuffer, writeLength, g_AT45DB321D_Flash_DataReadBuffer, readLength, false);
+    AT45DB321D_Flash_WriteRead(g_AT45DB321D_Flash_DataWriteBuffer, writeLength, g_AT45DB321D_Flash_DataReadBuffer, readLength);
 
-    if (AT45DB321D_FLASH_MANUFACTURER_CODE != g_AT45DB321D_Flash_DataReadBuffer[1])
-        return TinyCLR_Result::InvalidOperation;
+    if (AT45DB321D_FLASH_MANUFACTURER_CODE != g_AT45DB321D_Flash_DataReadBuffer[1] || AT45DB321D_FLASH_DEVICE_CODE != g_AT45DB321D_Flash_DataReadBuffer[2]) {
+        g_AT45DB321D_Flash_SpiProvider->Release(g_AT45DB321D_Flash_SpiProvider);
+
+        CONCAT(DEVICE_TARGET, _Gpio_ClosePin)(nullptr, g_AT45DB321D_Flash_SpiChipSelectLine);
 
-    if (AT45DB321D_FLASH_DEVICE_CODE != g_AT45DB321D_Flash_DataReadBuffer[2])
         return TinyCLR_Result::InvalidOperation;
+    }
 
     for (timeout = 0; timeout < AT45DB321D_FLASH_ACCESS_TIMEOUT; timeout++) {
         if (AT45DB321D_Flash_GetStatus() & 0x80) {
@@ -400,11 +372,14 @@ TinyCLR_Result AT45DB321D_Flash_Acquire(const TinyCLR_Spi_Controller* spiProvide
 
     g_AT45DB321D_Flash_SpiProvider->Release(g_AT45DB321D_Flash_SpiProvider);
 
+    CONCAT(DEVICE_TARGET, _Gpio_ClosePin)(nullptr, g_AT45DB321D_Flash_SpiChipSelectLine);
+
     return TinyCLR_Result::InvalidOperation;
 }
 
 TinyCLR_Result AT45DB321D_Flash_Release() {
-    // UnInitialize Flash can be here
+    CONCAT(DEVICE_TARGET, _Gpio_ClosePin)(nullptr, g_AT45DB321D_Flash_SpiChipSelectLine);
+
     return TinyCLR_Result::Success;
 }
 
@@ -46,6 +46,9 @@ static const TinyCLR_Interop_MethodHandler methods[] = {
     nullptr,
     Interop_GHIElectronics_TinyCLR_Devices_Adc_GHIElectronics_TinyCLR_Devices_Adc_Provider_AdcControllerApiWrapper::Acquire___VOID,
     Interop_GHIElectronics_TinyCLR_Devices_Adc_GHIElectronics_TinyCLR_Devices_Adc_Provider_AdcControllerApiWrapper::Release___VOID,
+    Interop_GHIElectronics_TinyCLR_Devices_Adc_GHIElectronics_TinyCLR_Devices_Adc_Provider_AdcControllerApiWrapper::StartScan___VOID__SZARRAY_U4__I4__I4,
+    Interop_GHIElectronics_TinyCLR_Devices_Adc_GHIElectronics_TinyCLR_Devices_Adc_Provider_AdcControllerApiWrapper::StopScan___VOID,
+    Interop_GHIElectronics_TinyCLR_Devices_Adc_GHIElectronics_TinyCLR_Devices_Adc_Provider_AdcControllerApiWrapper::ReadScan___I4__SZARRAY_U2__I4__I4,
 };
 
 const TinyCLR_Interop_Assembly Interop_GHIElectronics_TinyCLR_Devices_Adc = {
@@ -27,6 +27,9 @@ struct Interop_GHIElectronics_TinyCLR_Devices_Adc_GHIElectronics_TinyCLR_Devices
     static TinyCLR_Result Read___I4__I4(const TinyCLR_Interop_MethodData md);
     static TinyCLR_Result Acquire___VOID(const TinyCLR_Interop_MethodData md);
     static TinyCLR_Result Release___VOID(const TinyCLR_Interop_MethodData md);
+    static TinyCLR_Result StartScan___VOID__SZARRAY_U4__I4__I4(const TinyCLR_Interop_MethodData md);
+    static TinyCLR_Result StopScan___VOID(const TinyCLR_Interop_MethodData md);
+    static TinyCLR_Result ReadScan___I4__SZARRAY_U2__I4__I4(const TinyCLR_Interop_MethodData md);
 };
 
 extern const TinyCLR_Interop_Assembly Interop_GHIElectronics_TinyCLR_Devices_Adc;
@@ -1,3 +1,4 @@
+#include <Device.h>
 #include "GHIElectronics_TinyCLR_Devices_Adc.h"
 #include "../GHIElectronics_TinyCLR_InteropUtil.h"
 
@@ -125,3 +126,74 @@ TinyCLR_Result Interop_GHIElectronics_TinyCLR_Devices_Adc_GHIElectronics_TinyCLR
 
     return api->Release(api);
 }
+
+// Samples are read by polling, there is no native event for completed halves
+TinyCLR_Result Interop_GHIElectronics_TinyCLR_Devices_Adc_GHIElectronics_TinyCLR_Devices_Adc_Provider_AdcControllerApiWrapper::StartScan___VOID__SZARRAY_U4__I4__I4(const TinyCLR_Interop_MethodData md) {
+    auto api = reinterpret_cast<const TinyCLR_Adc_Controller*>(TinyCLR_Interop_GetApi(md, FIELD___impl___I));
+
+    TinyCLR_Interop_ClrValue arg0, arg1, arg2;
+
+    md.InteropManager->GetArgument(md.InteropManager, md.Stack, 0, arg0);
+    md.InteropManager->GetArgument(md.InteropManager, md.Stack, 1, arg1);
+    md.InteropManager->GetArgument(md.InteropManager, md.Stack, 2, arg2);
+
+    auto channels = reinterpret_cast<uint32_t*>(arg0.Data.SzArray.Data);
+    auto sampleRate = arg1.Data.Numeric->I4;
+    auto oversample = arg2.Data.Numeric->I4;
+
+    if (channels == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    if (sampleRate <= 0 || oversample <= 0)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+#if defined(INCLUDE_ADC) && defined(TARGET_ADC_SCAN_SUPPORTED)
+    return CONCAT(DEVICE_TARGET, _Adc_StartScan)(api, channels, arg0.Data.SzArray.Length, static_cast<uint32_t>(sampleRate), static_cast<uint32_t>(oversample), nullptr);
+#else
+    return TinyCLR_Result::NotSupported;
+#endif
+}
+
+TinyCLR_Result Interop_GHIElectronics_TinyCLR_Devices_Adc_GHIElectronics_TinyCLR_Devices_Adc_Provider_AdcControllerApiWrapper::StopScan___VOID(const TinyCLR_Interop_MethodData md) {
+    auto api = reinterpret_cast<const TinyCLR_Adc_Controller*>(TinyCLR_Interop_GetApi(md, FIELD___impl___I));
+
+#if defined(INCLUDE_ADC) && defined(TARGET_ADC_SCAN_SUPPORTED)
+    return CONCAT(DEVICE_TARGET, _Adc_StopScan)(api);
+#else
+    return TinyCLR_Result::NotSupported;
+#endif
+}
+
+// Returns the number of samples copied into buffer, whole frames of the scanned channels in sequence order
+TinyCLR_Result Interop_GHIElectronics_TinyCLR_Devices_Adc_GHIElectronics_TinyCLR_Devices_Adc_Provider_AdcControllerApiWrapper::ReadScan___I4__SZARRAY_U2__I4__I4(const TinyCLR_Interop_MethodData md) {
+    auto api = reinterpret_cast<const TinyCLR_Adc_Controller*>(TinyCLR_Interop_GetApi(md, FIELD___impl___I));
+
+    TinyCLR_Interop_ClrValue arg0, arg1, arg2, ret;
+
+    md.InteropManager->GetArgument(md.InteropManager, md.Stack, 0, arg0);
+    md.InteropManager->GetArgument(md.InteropManager, md.Stack, 1, arg1);
+    md.InteropManager->GetArgument(md.InteropManager, md.Stack, 2, arg2);
+    md.InteropManager->GetReturn(md.InteropManager, md.Stack, ret);
+
+    auto buffer = reinterpret_cast<uint16_t*>(arg0.Data.SzArray.Data);
+    auto offset = arg1.Data.Numeric->I4;
+    auto count = arg2.Data.Numeric->I4;
+
+    if (buffer == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    if (offset < 0 || count < 0 || static_cast<size_t>(offset) + static_cast<size_t>(count) > arg0.Data.SzArray.Length)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+#if defined(INCLUDE_ADC) && defined(TARGET_ADC_SCAN_SUPPORTED)
+    size_t length = static_cast<size_t>(count);
+
+    auto result = CONCAT(DEVICE_TARGET, _Adc_ReadScan)(api, buffer + offset, length);
+
+    ret.Data.Numeric->I4 = static_cast<int32_t>(length);
+
+    return result;
+#else
+    return TinyCLR_Result::NotSupported;
+#endif
+}
@@ -40,6 +40,16 @@ struct Interop_GHIElectronics_TinyCLR_Devices_Display_GHIElectronics_TinyCLR_Dev
     static TinyCLR_Result Enable___VOID(const TinyCLR_Interop_MethodData md);
     static TinyCLR_Result Disable___VOID(const TinyCLR_Interop_MethodData md);
     static TinyCLR_Result DrawBuffer___VOID__I4__I4__I4__I4__SZARRAY_U1__I4(const TinyCLR_Interop_MethodData md);
+    static TinyCLR_Result DrawRle___VOID__I4__I4__I4__I4__SZARRAY_U1__I4__I4(const TinyCLR_Interop_MethodData md);
+    static TinyCLR_Result DrawIndexed___VOID__I4__I4__I4__I4__SZARRAY_U1__I4__SZARRAY_U2(const TinyCLR_Interop_MethodData md);
+    static TinyCLR_Result SetDoubleBuffering___VOID__BOOLEAN(const TinyCLR_Interop_MethodData md);
+    static TinyCLR_Result WaitForFlip___VOID(const TinyCLR_Interop_MethodData md);
+    static TinyCLR_Result SetOverlay___VOID__I4__I4__I4__I4__I4(const TinyCLR_Interop_MethodData md);
+    static TinyCLR_Result RemoveOverlay___VOID(const TinyCLR_Interop_MethodData md);
+    static TinyCLR_Result MoveOverlay___VOID__I4__I4(const TinyCLR_Interop_MethodData md);
+    static TinyCLR_Result SetOverlayBlending___VOID__U1__BOOLEAN__U4(const TinyCLR_Interop_MethodData md);
+    static TinyCLR_Result SetOverlayPalette___VOID__SZARRAY_U4(const TinyCLR_Interop_MethodData md);
+    static TinyCLR_Result DrawOverlay___VOID__I4__I4__I4__I4__SZARRAY_U1__I4(const TinyCLR_Interop_MethodData md);
     static TinyCLR_Result DrawPixel___VOID__I4__I4__I8(const TinyCLR_Interop_MethodData md);
     static TinyCLR_Result DrawString___VOID__STRING(const TinyCLR_Interop_MethodData md);
     static TinyCLR_Result get_Interface___GHIElectronicsTinyCLRDevicesDisplayDisplayInterface(const TinyCLR_Interop_MethodData md);
@@ -1,8 +1,19 @@
+#include <Device.h>
 #include "GHIElectronics_TinyCLR_Devices_Display.h"
 #include "../GHIElectronics_TinyCLR_InteropUtil.h"
 #include "../Spi/GHIElectronics_TinyCLR_Devices_Spi.h"
 #include "../I2c/GHIElectronics_TinyCLR_Devices_I2c.h"
 
+#if defined(INCLUDE_DISPLAY) && defined(TARGET_DISPLAY_DOUBLE_BUFFER_SUPPORTED)
+static void TinyCLR_Display_FrameFlippedIsr(const TinyCLR_Display_Controller* self, uint64_t timestamp) {
+    extern const TinyCLR_Api_Manager* apiManager;
+    auto interopManager = reinterpret_cast<const TinyCLR_Interop_Manager*>(apiManager->FindDefault(apiManager, TinyCLR_Api_Type::InteropManager));
+
+    if (interopManager != nullptr)
+        interopManager->RaiseEvent(interopManager, "GHIElectronics.TinyCLR.NativeEventNames.Display.FrameFlipped", self->ApiInfo->Name, 0, 0, 0, 0, timestamp);
+}
+#endif
+
 TinyCLR_Result Interop_GHIElectronics_TinyCLR_Devices_Display_GHIElectronics_TinyCLR_Devices_Display_Provider_DisplayControllerApiWrapper::Enable___VOID(const TinyCLR_Interop_MethodData md) {
     auto api = reinterpret_cast<const TinyCLR_Display_Controller*>(TinyCLR_Interop_GetApi(md, FIELD___impl___I));
 
@@ -41,6 +52,77 @@ TinyCLR_Result Interop_GHIElectronics_TinyCLR_Devices_Display_GHIElectronics_Tin
 
 }
 
+// Compressed images are expanded by the target straight into its framebuffer, other controllers report NotSupported
+TinyCLR_Result Interop_GHIElectronics_TinyCLR_Devices_Display_GHIElectronics_TinyCLR_Devices_Display_Provider_DisplayControllerApiWrapper::DrawRle___VOID__I4__I4__I4__I4__SZARRAY_U1__I4__I4(const TinyCLR_Interop_MethodData md) {
+    auto api = reinterpret_cast<const TinyCLR_Display_Controller*>(TinyCLR_Interop_GetApi(md, FIELD___impl___I));
+
+    TinyCLR_Interop_ClrValue arg0, arg1, arg2, arg3, arg4, arg5, arg6;
+
+    md.InteropManager->GetArgument(md.InteropManager, md.Stack, 0, arg0);
+    md.InteropManager->GetArgument(md.InteropManager, md.Stack, 1, arg1);
+    md.InteropManager->GetArgument(md.InteropManager, md.Stack, 2, arg2);
+    md.InteropManager->GetArgument(md.InteropManager, md.Stack, 3, arg3);
+    md.InteropManager->GetArgument(md.InteropManager, md.Stack, 4, arg4);
+    md.InteropManager->GetArgument(md.InteropManager, md.Stack, 5, arg5);
+    md.InteropManager->GetArgument(md.InteropManager, md.Stack, 6, arg6);
+
+    auto x = arg0.Data.Numeric->I4;
+    auto y = arg1.Data.Numeric->I4;
+    auto w = arg2.Data.Numeric->I4;
+    auto h = arg3.Data.Numeric->I4;
+    auto offset = arg5.Data.Numeric->I4;
+    auto length = arg6.Data.Numeric->I4;
+
+    auto data = reinterpret_cast<uint8_t*>(arg4.Data.SzArray.Data);
+
+    if (data == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    if (offset < 0 || length < 0 || static_cast<size_t>(offset) + static_cast<size_t>(length) > arg4.Data.SzArray.Length)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+#if defined(INCLUDE_DISPLAY) && defined(TARGET_DISPLAY_COMPRESSED_SUPPORTED)
+    return CONCAT(DEVICE_TARGET, _Display_DrawRle)(api, x, y, w, h, data + offset, static_cast<size_t>(length));
+#else
+    return TinyCLR_Result::NotSupported;
+#endif
+}
+
+TinyCLR_Result Interop_GHIElectronics_TinyCLR_Devices_Display_GHIElectronics_TinyCLR_Devices_Display_Provider_DisplayControllerApiWrapper::DrawIndexed___VOID__I4__I4__I4__I4__SZARRAY_U1__I4__SZARRAY_U2(const TinyCLR_Interop_MethodData md) {
+    auto api = reinterpret_cast<const TinyCLR_Display_Controller*>(TinyCLR_Interop_GetApi(md, FIELD___impl___I));
+
+    TinyCLR_Interop_ClrValue arg0, arg1, arg2, arg3, arg4, arg5, arg6;
+
+    md.InteropManager->GetArgument(md.InteropManager, md.Stack, 0, arg0);
+    md.InteropManager->GetArgument(md.InteropManager, md.Stack, 1, arg1);
+    md.InteropManager->GetArgument(md.InteropManager, md.Stack, 2, arg2);
+    md.InteropManager->GetArgument(md.InteropManager, md.Stack, 3, arg3);
+    md.InteropManager->GetArgument(md.InteropManager, md.Stack, 4, arg4);
+    md.InteropManager->GetArgument(md.InteropManager, md.Stack, 5, arg5);
+    md.InteropManager->GetArgument(md.InteropManager, md.Stack, 6, arg6);
+
+    auto x = arg0.Data.Numeric->I4;
+    auto y = arg1.Data.Numeric->I4;
+    auto w = arg2.Data.Numeric->I4;
+    auto h = arg3.Data.Numeric->I4;
+    auto offset = arg5.Data.Numeric->I4;
+
+    auto data = reinterpret_cast<uint8_t*>(arg4.Data.SzArray.Data);
+    auto palette = reinterpret_cast<uint16_t*>(arg6.Data.SzArray.Data);
+
+    if (data == nullptr || palette == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    if (w <= 0 || h <= 0 || offset < 0 || static_cast<uint64_t>(offset) + static_cast<uint64_t>(w) * static_cast<uint64_t>(h) > arg4.Data.SzArray.Length)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+#if defined(INCLUDE_DISPLAY) && defined(TARGET_DISPLAY_COMPRESSED_SUPPORTED)
+    return CONCAT(DEVICE_TARGET, _Display_DrawIndexed)(api, x, y, w, h, data + offset, palette, arg6.Data.SzArray.Length);
+#else
+    return TinyCLR_Result::NotSupported;
+#endif
+}
+
 TinyCLR_Result Interop_GHIElectronics_TinyCLR_Devices_Display_GHIElectronics_TinyCLR_Devices_Display_Provider_DisplayControllerApiWrapper::DrawPixel___VOID__I4__I4__I8(const TinyCLR_Interop_MethodData md) {
     auto api = reinterpret_cast<const TinyCLR_Display_Controller*>(TinyCLR_Interop_GetApi(md, FIELD___impl___I));
 
@@ -266,3 +348,158 @@ TinyCLR_Result Interop_GHIElectronics_TinyCLR_Devices_Display_GHIElectronics_Tin
 
     return api->SetConfiguration(api, type, width, height, &config);
 }
+
+TinyCLR_Result Interop_GHIElectronics_TinyCLR_Devices_Display_GHIElectronics_TinyCLR_Devices_Display_Provider_DisplayControllerApiWrapper::SetDoubleBuffering___VOID__BOOLEAN(const TinyCLR_Interop_MethodData md) {
+    auto api = reinterpret_cast<const TinyCLR_Display_Controller*>(TinyCLR_Interop_GetApi(md, FIELD___impl___I));
+
+    TinyCLR_Interop_ClrValue arg0;
+
+    md.InteropManager->GetArgument(md.InteropManager, md.Stack, 0, arg0);
+
+    auto enable = arg0.Data.Numeric->Boolean;
+
+#if defined(INCLUDE_DISPLAY) && defined(TARGET_DISPLAY_DOUBLE_BUFFER_SUPPORTED)
+    auto result = CONCAT(DEVICE_TARGET, _Display_SetDoubleBuffering)(api, enable);
+
+    if (result == TinyCLR_Result::Success)
+        CONCAT(DEVICE_TARGET, _Display_SetFlipHandler)(api, enable ? TinyCLR_Display_FrameFlippedIsr : nullptr);
+
+    return result;
+#else
+    return TinyCLR_Result::NotSupported;
+#endif
+}
+
+TinyCLR_Result Interop_GHIElectronics_TinyCLR_Devices_Display_GHIElectronics_TinyCLR_Devices_Display_Provider_DisplayControllerApiWrapper::WaitForFlip___VOID(const TinyCLR_Interop_MethodData md) {
+    auto api = reinterpret_cast<const TinyCLR_Display_Controller*>(TinyCLR_Interop_GetApi(md, FIELD___impl___I));
+
+#if defined(INCLUDE_DISPLAY) && defined(TARGET_DISPLAY_DOUBLE_BUFFER_SUPPORTED)
+    return CONCAT(DEVICE_TARGET, _Display_WaitForFlip)(api);
+#else
+    return TinyCLR_Result::NotSupported;
+#endif
+}
+
+TinyCLR_Result Interop_GHIElectronics_TinyCLR_Devices_Display_GHIElectronics_TinyCLR_Devices_Display_Provider_DisplayControllerApiWrapper::SetOverlay___VOID__I4__I4__I4__I4__I4(const TinyCLR_Interop_MethodData md) {
+    auto api = reinterpret_cast<const TinyCLR_Display_Controller*>(TinyCLR_Interop_GetApi(md, FIELD___impl___I));
+
+    TinyCLR_Interop_ClrValue arg0, arg1, arg2, arg3, arg4;
+
+    md.InteropManager->GetArgument(md.InteropManager, md.Stack, 0, arg0);
+    md.InteropManager->GetArgument(md.InteropManager, md.Stack, 1, arg1);
+    md.InteropManager->GetArgument(md.InteropManager, md.Stack, 2, arg2);
+    md.InteropManager->GetArgument(md.InteropManager, md.Stack, 3, arg3);
+    md.InteropManager->GetArgument(md.InteropManager, md.Stack, 4, arg4);
+
+    auto x = arg0.Data.Numeric->I4;
+    auto y = arg1.Data.Numeric->I4;
+    auto w = arg2.Data.Numeric->I4;
+    auto h = arg3.Data.Numeric->I4;
+    auto format = arg4.Data.Numeric->I4;
+
+#if defined(INCLUDE_DISPLAY) && defined(TARGET_DISPLAY_OVERLAY_SUPPORTED)
+    return CONCAT(DEVICE_TARGET, _Display_SetOverlay)(api, x, y, w, h, static_cast<CONCAT(DEVICE_TARGET, _Display_OverlayFormat)>(format));
+#else
+    return TinyCLR_Result::NotSupported;
+#endif
+}
+
+TinyCLR_Result Interop_GHIElectronics_TinyCLR_Devices_Display_GHIElectronics_TinyCLR_Devices_Display_Provider_DisplayControllerApiWrapper::RemoveOverlay___VOID(const TinyCLR_Interop_MethodData md) {
+    auto api = reinterpret_cast<const TinyCLR_Display_Controller*>(TinyCLR_Interop_GetApi(md, FIELD___impl___I));
+
+#if defined(INCLUDE_DISPLAY) && defined(TARGET_DISPLAY_OVERLAY_SUPPORTED)
+    return CONCAT(DEVICE_TARGET, _Display_RemoveOverlay)(api);
+#else
+    return TinyCLR_Result::NotSupported;
+#endif
+}
+
+TinyCLR_Result Interop_GHIElectronics_TinyCLR_Devices_Display_GHIElectronics_TinyCLR_Devices_Display_Provider_DisplayControllerApiWrapper::MoveOverlay___VOID__I4__I4(const TinyCLR_Interop_MethodData md) {
+    auto api = reinterpret_cast<const TinyCLR_Display_Controller*>(TinyCLR_Interop_GetApi(md, FIELD___impl___I));
+
+    TinyCLR_Interop_ClrValue arg0, arg1;
+
+    md.InteropManager->GetArgument(md.InteropManager, md.Stack, 0, arg0);
+    md.InteropManager->GetArgument(md.InteropManager, md.Stack, 1, arg1);
+
+    auto x = arg0.Data.Numeric->I4;
+    auto y = arg1.Data.Numeric->I4;
+
+#if defined(INCLUDE_DISPLAY) && defined(TARGET_DISPLAY_OVERLAY_SUPPORTED)
+    return CONCAT(DEVICE_TARGET, _Display_MoveOverlay)(api, x, y);
+#else
+    return TinyCLR_Result::NotSupported;
+#endif
+}
+
+TinyCLR_Result Interop_GHIElectronics_TinyCLR_Devices_Display_GHIElectronics_TinyCLR_Devices_Display_Provider_DisplayControllerApiWrapper::SetOverlayBlending___VOID__U1__BOOLEAN__U4(const TinyCLR_Interop_MethodData md) {
+    auto api = reinterpret_cast<const TinyCLR_Display_Controller*>(TinyCLR_Interop_GetApi(md, FIELD___impl___I));
+
+    TinyCLR_Interop_ClrValue arg0, arg1, arg2;
+
+    md.InteropManager->GetArgument(md.InteropManager, md.Stack, 0, arg0);
+    md.InteropManager->GetArgument(md.InteropManager, md.Stack, 1, arg1);
+    md.InteropManager->GetArgument(md.InteropManager, md.Stack, 2, arg2);
+
+    auto alpha = arg0.Data.Numeric->U1;
+    auto colorKeyEnable = arg1.Data.Numeric->Boolean;
+    auto colorKey = arg2.Data.Numeric->U4;
+
+#if defined(INCLUDE_DISPLAY) && defined(TARGET_DISPLAY_OVERLAY_SUPPORTED)
+    return CONCAT(DEVICE_TARGET, _Display_SetOverlayBlending)(api, alpha, colorKeyEnable, colorKey);
+#else
+    return TinyCLR_Result::NotSupported;
+#endif
+}
+
+TinyCLR_Result Interop_GHIElectronics_TinyCLR_Devices_Display_GHIElectronics_TinyCLR_Devices_Display_Provider_DisplayControllerApiWrapper::SetOverlayPalette___VOID__SZARRAY_U4(const TinyCLR_Interop_MethodData md) {
+    auto api = reinterpret_cast<const TinyCLR_Display_Controller*>(TinyCLR_Interop_GetApi(md, FIELD___impl___I));
+
+    TinyCLR_Interop_ClrValue arg0;
+
+    md.InteropManager->GetArgument(md.InteropManager, md.Stack, 0, arg0);
+
+    auto colors = reinterpret_cast<uint32_t*>(arg0.Data.SzArray.Data);
+
+    if (colors == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+#if defined(INCLUDE_DISPLAY) && defined(TARGET_DISPLAY_OVERLAY_SUPPORTED)
+    return CONCAT(DEVICE_TARGET, _Display_SetOverlayPalette)(api, colors, arg0.Data.SzArray.Length);
+#else
+    return TinyCLR_Result::NotSupported;
+#endif
+}
+
+TinyCLR_Result Interop_GHIElectronics_TinyCLR_Devices_Display_GHIElectronics_TinyCLR_Devices_Display_Provider_DisplayControllerApiWrapper::DrawOverlay___VOID__I4__I4__I4__I4__SZARRAY_U1__I4(const TinyCLR_Interop_MethodData md) {
+    auto api = reinterpret_cast<const TinyCLR_Display_Controller*>(TinyCLR_Interop_GetApi(md, FIELD___impl___I));
+
+    TinyCLR_Interop_ClrValue arg0, arg1, arg2, arg3, arg4, arg5;
+
+    md.InteropManager->GetArgument(md.InteropManager, md.Stack, 0, arg0);
+    md.InteropManager->GetArgument(md.InteropManager, md.Stack, 1, arg1);
+    md.InteropManager->GetArgument(md.InteropManager, md.Stack, 2, arg2);
+    md.InteropManager->GetArgument(md.InteropManager, md.Stack, 3, arg3);
+    md.InteropManager->GetArgument(md.InteropManager, md.Stack, 4, arg4);
+    md.InteropManager->GetArgument(md.InteropManager, md.Stack, 5, arg5);
+
+    auto x = arg0.Data.Numeric->I4;
+    auto y = arg1.Data.Numeric->I4;
+    auto w = arg2.Data.Numeric->I4;
+    auto h = arg3.Data.Numeric->I4;
+    auto offset = arg5.Data.Numeric->I4;
+
+    auto data = reinterpret_cast<uint8_t*>(arg4.Data.SzArray.Data);
+
+    if (data == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    if (offset < 0 || static_cast<size_t>(offset) > arg4.Data.SzArray.Length)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+#if defined(INCLUDE_DISPLAY) && defined(TARGET_DISPLAY_OVERLAY_SUPPORTED)
+    return CONCAT(DEVICE_TARGET, _Display_DrawOverlay)(api, x, y, w, h, data + offset, arg4.Data.SzArray.Length - offset);
+#else
+    return TinyCLR_Result::NotSupported;
+#endif
+}
@@ -67,6 +67,7 @@ static const TinyCLR_Interop_MethodHandler methods[] = {
     Interop_GHIElectronics_TinyCLR_Devices_Gpio_GHIElectronics_TinyCLR_Devices_Gpio_Provider_GpioControllerApiWrapper::ClearPinChangedEdge___VOID__I4,
     nullptr,
     nullptr,
+    Interop_GHIElectronics_TinyCLR_Devices_Gpio_GHIElectronics_TinyCLR_Devices_Gpio_Provider_GpioControllerApiWrapper::ReadEdges___I4__I4__SZARRAY_I8__SZARRAY_BOOLEAN__I4__I4__BYREF_I4,
 };
 
 const TinyCLR_Interop_Assembly Interop_GHIElectronics_TinyCLR_Devices_Gpio = {
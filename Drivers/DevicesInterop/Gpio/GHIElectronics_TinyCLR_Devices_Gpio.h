@@ -38,6 +38,7 @@ struct Interop_GHIElectronics_TinyCLR_Devices_Gpio_GHIElectronics_TinyCLR_Device
     static TinyCLR_Result Release___VOID(const TinyCLR_Interop_MethodData md);
     static TinyCLR_Result SetPinChangedEdge___VOID__I4__GHIElectronicsTinyCLRDevicesGpioGpioPinEdge(const TinyCLR_Interop_MethodData md);
     static TinyCLR_Result ClearPinChangedEdge___VOID__I4(const TinyCLR_Interop_MethodData md);
+    static TinyCLR_Result ReadEdges___I4__I4__SZARRAY_I8__SZARRAY_BOOLEAN__I4__I4__BYREF_I4(const TinyCLR_Interop_MethodData md);
 };
 
 extern const TinyCLR_Interop_Assembly Interop_GHIElectronics_TinyCLR_Devices_Gpio;
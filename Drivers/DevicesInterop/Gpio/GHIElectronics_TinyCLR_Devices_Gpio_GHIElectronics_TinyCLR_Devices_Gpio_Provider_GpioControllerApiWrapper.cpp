@@ -1,3 +1,4 @@
+#include <Device.h>
 #include "GHIElectronics_TinyCLR_Devices_Gpio.h"
 #include "../GHIElectronics_TinyCLR_InteropUtil.h"
 
@@ -207,3 +208,60 @@ TinyCLR_Result Interop_GHIElectronics_TinyCLR_Devices_Gpio_GHIElectronics_TinyCL
 
     return api->SetPinChangedHandler(api, pin, TinyCLR_Gpio_PinChangeEdge::FallingEdge, nullptr);
 }
+
+// Collects the queued edges of a pin, used with batched pin change events where one event announces several edges.
+// Returns the number of edges read, overflows is the number lost since the last read.
+TinyCLR_Result Interop_GHIElectronics_TinyCLR_Devices_Gpio_GHIElectronics_TinyCLR_Devices_Gpio_Provider_GpioControllerApiWrapper::ReadEdges___I4__I4__SZARRAY_I8__SZARRAY_BOOLEAN__I4__I4__BYREF_I4(const TinyCLR_Interop_MethodData md) {
+    TinyCLR_Interop_ClrValue args[6], ret;
+
+    for (auto i = 0; i < 6; i++)
+        md.InteropManager->GetArgument(md.InteropManager, md.Stack, i, args[i]);
+
+    md.InteropManager->GetReturn(md.InteropManager, md.Stack, ret);
+
+    auto pin = args[0].Data.Numeric->I4;
+    auto timestamps = reinterpret_cast<int64_t*>(args[1].Data.SzArray.Data);
+    auto risingEdges = reinterpret_cast<bool*>(args[2].Data.SzArray.Data);
+    auto offset = args[3].Data.Numeric->I4;
+    auto count = args[4].Data.Numeric->I4;
+
+    if (timestamps == nullptr || risingEdges == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    if (pin < 0 || offset < 0 || count < 0 || static_cast<size_t>(offset) + static_cast<size_t>(count) > args[1].Data.SzArray.Length || static_cast<size_t>(offset) + static_cast<size_t>(count) > args[2].Data.SzArray.Length)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+#if defined(TARGET_GPIO_READ_EDGES_SUPPORTED)
+    CONCAT(DEVICE_TARGET, _Gpio_Edge) edges[8];
+
+    size_t read = 0;
+    uint32_t overflows = 0;
+
+    while (read < static_cast<size_t>(count)) {
+        size_t chunk = static_cast<size_t>(count) - read < SIZEOF_ARRAY(edges) ? static_cast<size_t>(count) - read : SIZEOF_ARRAY(edges);
+        uint32_t lost;
+
+        auto result = CONCAT(DEVICE_TARGET, _Gpio_ReadEdges)(static_cast<uint32_t>(pin), edges, chunk, lost);
+
+        if (result != TinyCLR_Result::Success)
+            return result;
+
+        overflows += lost;
+
+        for (size_t i = 0; i < chunk; i++, read++) {
+            timestamps[offset + read] = static_cast<int64_t>(edges[i].timestamp);
+            risingEdges[offset + read] = edges[i].value == TinyCLR_Gpio_PinValue::High;
+        }
+
+        if (chunk < SIZEOF_ARRAY(edges))
+            break;
+    }
+
+    args[5].Data.Numeric->I4 = static_cast<int32_t>(overflows);
+    ret.Data.Numeric->I4 = static_cast<int32_t>(read);
+
+    return TinyCLR_Result::Success;
+#else
+    return TinyCLR_Result::NotSupported;
+#endif
+}
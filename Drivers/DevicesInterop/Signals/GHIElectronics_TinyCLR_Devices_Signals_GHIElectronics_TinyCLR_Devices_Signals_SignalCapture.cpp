@@ -1,5 +1,40 @@
+#include <Device.h>
 #include "GHIElectronics_TinyCLR_Devices_Signals.h"
 
+// Uses the target's timer input capture when the pin has one, the edges are then timestamped by hardware instead
+// of by polling the pin. Timestamps are captured into the start of the TimeSpan array and expanded in place.
+static bool SignalCapture_ReadNative(const TinyCLR_Gpio_Controller* gpio, uint32_t pin, bool waitForInitialState, TinyCLR_Gpio_PinValue& initialState, TinyCLR_Interop_ClrObjectReference* arr, int32_t len, uint64_t timeout, int32_t& count) {
+#if defined(INCLUDE_SIGNALS) && defined(TARGET_SIGNAL_CAPTURE_SUPPORTED)
+    if (len <= 0 || !CONCAT(DEVICE_TARGET, _SignalCapture_IsPinSupported)(pin))
+        return false;
+
+    auto timestamps = reinterpret_cast<uint32_t*>(arr);
+    auto mode = gpio->GetDriveMode(gpio, pin);
+    size_t captured = static_cast<size_t>(len);
+    uint32_t startTime, frequency;
+
+    if (CONCAT(DEVICE_TARGET, _SignalCapture_Read)(pin, waitForInitialState, initialState, timestamps, captured, timeout / 10, startTime, frequency) != TinyCLR_Result::Success)
+        return false;
+
+    // give the pin back to the GPIO controller
+    gpio->SetDriveMode(gpio, pin, mode);
+
+    // a TimeSpan slot is at least twice the size of a timestamp, so walking backwards never overwrites one still needed
+    for (auto i = static_cast<int32_t>(captured) - 1; i >= 0; i--) {
+        auto previous = i > 0 ? timestamps[i - 1] : startTime;
+
+        //Since TimeSpan and DateTime are stored inline, not as a proper object
+        arr[i].b = static_cast<uint64_t>(timestamps[i] - previous) * 10000000ULL / frequency;
+    }
+
+    count = static_cast<int32_t>(captured);
+
+    return true;
+#else
+    return false;
+#endif
+}
+
 TinyCLR_Result Interop_GHIElectronics_TinyCLR_Devices_Signals_GHIElectronics_TinyCLR_Devices_Signals_SignalCapture::Read___I4__BYREF_GHIElectronicsTinyCLRDevicesGpioGHIElectronicsTinyCLRDevicesGpioGpioPinValue__SZARRAY_mscorlibSystemTimeSpan__I4__I4(const TinyCLR_Interop_MethodData md) {
     TinyCLR_Interop_ClrValue ret, initialArg, arrArg, offsetArg, countArg, apiFld, pinFld, disableFld, timeoutFld;
     const TinyCLR_Interop_ClrObject* self;
@@ -28,6 +63,15 @@ TinyCLR_Result Interop_GHIElectronics_TinyCLR_Devices_Signals_GHIElectronics_Tin
     auto currentState = TinyCLR_Gpio_PinValue::Low;
     auto nextState = TinyCLR_Gpio_PinValue::Low;
 
+    int32_t count = 0;
+
+    if (SignalCapture_ReadNative(gpio, pin, false, currentState, arr, len, timeout, count)) {
+        initialArg.Data.Numeric->I4 = static_cast<int32_t>(currentState);
+        ret.Data.Numeric->I4 = count;
+
+        return TinyCLR_Result::Success;
+    }
+
     if (disableInterrupts)
         interrupt->Disable();
 
@@ -37,7 +81,6 @@ TinyCLR_Result Interop_GHIElectronics_TinyCLR_Devices_Signals_GHIElectronics_Tin
 
     nextState = currentState == TinyCLR_Gpio_PinValue::High ? TinyCLR_Gpio_PinValue::Low : TinyCLR_Gpio_PinValue::High;
 
-    int32_t count = 0;
     auto currentTime = time->GetNativeTime(time);
     auto lastTime = currentTime;
     auto endTime = currentTime + time->ConvertSystemTimeToNativeTime(time, timeout);
@@ -96,6 +139,13 @@ TinyCLR_Result Interop_GHIElectronics_TinyCLR_Devices_Signals_GHIElectronics_Tin
     auto nextState = static_cast<TinyCLR_Gpio_PinValue>(initialArg.Data.Numeric->I4);
 
     int32_t count = 0;
+
+    if (SignalCapture_ReadNative(gpio, pin, true, nextState, arr, len, timeout, count)) {
+        ret.Data.Numeric->I4 = count;
+
+        return TinyCLR_Result::Success;
+    }
+
     auto currentTime = time->GetNativeTime(time);
     auto lastTime = currentTime;
     auto endTime = currentTime + time->ConvertSystemTimeToNativeTime(time, timeout);
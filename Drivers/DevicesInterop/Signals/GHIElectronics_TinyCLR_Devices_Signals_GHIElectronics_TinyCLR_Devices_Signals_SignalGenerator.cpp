@@ -1,5 +1,44 @@
+#include <Device.h>
 #include "GHIElectronics_TinyCLR_Devices_Signals.h"
 
+// Slack on top of the total duration before a native write is given up, covers the interrupt latency of every edge
+#define SIGNAL_GENERATOR_TIMEOUT_MARGIN 1000000 // 100ms in TimeSpan ticks
+
+// Plays the durations out from a timer interrupt when the target supports it, the edges are then placed by hardware
+// instead of by waiting between GPIO writes. The managed Write is synchronous so this waits for the timer to finish,
+// at most for the total duration plus SIGNAL_GENERATOR_TIMEOUT_MARGIN. NotSupported leaves the write to the GPIO loop.
+static TinyCLR_Result SignalGenerator_WriteNative(const TinyCLR_NativeTime_Controller* time, uint32_t pin, TinyCLR_Gpio_PinValue idleState, const TinyCLR_Interop_ClrObjectReference* arr, int32_t len) {
+#if defined(INCLUDE_SIGNALS) && defined(TARGET_SIGNAL_GENERATOR_SUPPORTED)
+    // TimeSpan is stored inline, the array elements can be handed over as is when they are nothing but the ticks
+    if (sizeof(TinyCLR_Interop_ClrObjectReference) != sizeof(uint64_t) || len <= 0)
+        return TinyCLR_Result::NotSupported;
+
+    auto durations = reinterpret_cast<const uint64_t*>(arr);
+    uint64_t total = SIGNAL_GENERATOR_TIMEOUT_MARGIN;
+
+    for (auto i = 0; i < len; i++)
+        total += durations[i];
+
+    if (CONCAT(DEVICE_TARGET, _SignalGenerator_Write)(pin, idleState, durations, static_cast<size_t>(len), nullptr) != TinyCLR_Result::Success)
+        return TinyCLR_Result::NotSupported;
+
+    auto start = time->GetNativeTime(time);
+    auto timeout = time->ConvertSystemTimeToNativeTime(time, total);
+
+    while (CONCAT(DEVICE_TARGET, _SignalGenerator_IsBusy)()) {
+        if (time->GetNativeTime(time) - start > timeout) {
+            CONCAT(DEVICE_TARGET, _SignalGenerator_Abort)();
+
+            return TinyCLR_Result::InvalidOperation;
+        }
+    }
+
+    return TinyCLR_Result::Success;
+#else
+    return TinyCLR_Result::NotSupported;
+#endif
+}
+
 TinyCLR_Result Interop_GHIElectronics_TinyCLR_Devices_Signals_GHIElectronics_TinyCLR_Devices_Signals_SignalGenerator::Write___VOID__SZARRAY_mscorlibSystemTimeSpan__I4__I4(const TinyCLR_Interop_MethodData md) {
     TinyCLR_Interop_ClrValue arrArg, offsetArg, countArg, apiFld, pinFld, idleFld, disableFld, generateFld, freqFld;
     const TinyCLR_Interop_ClrObject* self;
@@ -32,6 +71,14 @@ TinyCLR_Result Interop_GHIElectronics_TinyCLR_Devices_Signals_GHIElectronics_Tin
     if (generateCarrierFrequency)
         return TinyCLR_Result::NotImplemented;
 
+    // the timer interrupt cannot run with interrupts disabled, that request is served by the GPIO loop
+    if (!disableInterrupts) {
+        auto result = SignalGenerator_WriteNative(time, pin, idleState, arr, len);
+
+        if (result != TinyCLR_Result::NotSupported)
+            return result;
+    }
+
     gpio->Write(gpio, pin, idleState);
 
     if (disableInterrupts)
@@ -0,0 +1,104 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string.h>
+
+#include "DmaAllocator.h"
+
+static bool DmaAllocator_IsValid(const DmaAllocator* allocator, int32_t channel) {
+    return allocator != nullptr && channel >= 0 && static_cast<size_t>(channel) < allocator->channelCount;
+}
+
+void DmaAllocator_Initialize(DmaAllocator* allocator, size_t channelCount) {
+    memset(allocator, 0, sizeof(DmaAllocator));
+
+    allocator->channelCount = channelCount < DMA_ALLOCATOR_MAX_CHANNELS ? channelCount : DMA_ALLOCATOR_MAX_CHANNELS;
+}
+
+int32_t DmaAllocator_Acquire(DmaAllocator* allocator, uint32_t candidates, const void* owner) {
+    if (allocator == nullptr || owner == nullptr)
+        return DMA_ALLOCATOR_CHANNEL_NONE;
+
+    for (size_t channel = 0; channel < allocator->channelCount; channel++) {
+        auto bit = static_cast<uint32_t>(1) << channel;
+
+        if (!(candidates & bit) || (allocator->acquired & bit))
+            continue;
+
+        allocator->acquired |= bit;
+        allocator->owners[channel] = owner;
+        allocator->statistics[channel].acquisitions++;
+
+        return static_cast<int32_t>(channel);
+    }
+
+    allocator->rejections++;
+
+    return DMA_ALLOCATOR_CHANNEL_NONE;
+}
+
+// Only the owner gives a channel back, a stale handle from a driver that already released it does nothing.
+bool DmaAllocator_Release(DmaAllocator* allocator, int32_t channel, const void* owner) {
+    if (!DmaAllocator_IsAcquired(allocator, channel) || allocator->owners[channel] != owner)
+        return false;
+
+    allocator->acquired &= ~(static_cast<uint32_t>(1) << channel);
+    allocator->owners[channel] = nullptr;
+
+    return true;
+}
+
+bool DmaAllocator_IsAcquired(const DmaAllocator* allocator, int32_t channel) {
+    return DmaAllocator_IsValid(allocator, channel) && (allocator->acquired & (static_cast<uint32_t>(1) << channel)) != 0;
+}
+
+const void* DmaAllocator_GetOwner(const DmaAllocator* allocator, int32_t channel) {
+    return DmaAllocator_IsAcquired(allocator, channel) ? allocator->owners[channel] : nullptr;
+}
+
+size_t DmaAllocator_GetAcquiredCount(const DmaAllocator* allocator) {
+    size_t count = 0;
+
+    if (allocator != nullptr)
+        for (auto acquired = allocator->acquired; acquired != 0; acquired &= acquired - 1)
+            count++;
+
+    return count;
+}
+
+void DmaAllocator_RecordTransfer(DmaAllocator* allocator, int32_t channel, size_t bytes) {
+    if (!DmaAllocator_IsValid(allocator, channel))
+        return;
+
+    allocator->statistics[channel].transfers++;
+    allocator->statistics[channel].bytes += bytes;
+}
+
+void DmaAllocator_RecordError(DmaAllocator* allocator, int32_t channel) {
+    if (!DmaAllocator_IsValid(allocator, channel))
+        return;
+
+    allocator->statistics[channel].errors++;
+}
+
+const DmaAllocator_Statistics* DmaAllocator_GetStatistics(const DmaAllocator* allocator, int32_t channel) {
+    return DmaAllocator_IsValid(allocator, channel) ? &allocator->statistics[channel] : nullptr;
+}
+
+void DmaAllocator_ResetStatistics(DmaAllocator* allocator, int32_t channel) {
+    if (!DmaAllocator_IsValid(allocator, channel))
+        return;
+
+    memset(&allocator->statistics[channel], 0, sizeof(DmaAllocator_Statistics));
+}
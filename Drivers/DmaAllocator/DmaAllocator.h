@@ -0,0 +1,54 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Channel bookkeeping for the target DMA services: which channels (or streams) are taken, by whom, and what went
+// through them. It touches no registers and takes no locks, the target serializes the calls, so it builds and runs
+// unchanged on a host.
+//
+// A request names its candidate channels as a bit mask, the lowest free one is given out. The target numbers its
+// channels so that lower means preferred, e.g. controller * 8 + stream.
+#define DMA_ALLOCATOR_MAX_CHANNELS                  32
+#define DMA_ALLOCATOR_CHANNEL_NONE                  -1
+
+struct DmaAllocator_Statistics {
+    uint32_t acquisitions;
+    uint32_t transfers; // completed descriptors, or buffer halves in double buffer mode
+    uint32_t errors;
+    uint64_t bytes;
+};
+
+struct DmaAllocator {
+    size_t channelCount;
+    uint32_t acquired;
+    uint32_t rejections; // requests that found every candidate taken
+
+    const void* owners[DMA_ALLOCATOR_MAX_CHANNELS];
+    DmaAllocator_Statistics statistics[DMA_ALLOCATOR_MAX_CHANNELS];
+};
+
+void DmaAllocator_Initialize(DmaAllocator* allocator, size_t channelCount);
+int32_t DmaAllocator_Acquire(DmaAllocator* allocator, uint32_t candidates, const void* owner);
+bool DmaAllocator_Release(DmaAllocator* allocator, int32_t channel, const void* owner);
+bool DmaAllocator_IsAcquired(const DmaAllocator* allocator, int32_t channel);
+const void* DmaAllocator_GetOwner(const DmaAllocator* allocator, int32_t channel);
+size_t DmaAllocator_GetAcquiredCount(const DmaAllocator* allocator);
+void DmaAllocator_RecordTransfer(DmaAllocator* allocator, int32_t channel, size_t bytes);
+void DmaAllocator_RecordError(DmaAllocator* allocator, int32_t channel);
+const DmaAllocator_Statistics* DmaAllocator_GetStatistics(const DmaAllocator* allocator, int32_t channel);
+void DmaAllocator_ResetStatistics(DmaAllocator* allocator, int32_t channel);
@@ -0,0 +1,615 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stddef.h>
+#include <string.h>
+#include <Device.h>
+
+#include "KeyValueStore.h"
+
+// Log layout, per sector:
+//   sector header | record | record | ... | erased
+// A record is a header followed by the value, padded to KEY_VALUE_STORE_ALIGNMENT. Records are only ever appended;
+// a newer record for the same key supersedes the older one. When the active sector is full the live records are
+// copied to the other sector, which only becomes valid once its completed word is programmed, so a power cut at any
+// point leaves either the old or the new sector intact.
+
+#define KEY_VALUE_STORE_INDEX_SIZE                  (KEY_VALUE_STORE_MAX_KEYS * 2)
+#define KEY_VALUE_STORE_COPY_BUFFER_SIZE            64
+
+#define KEY_VALUE_STORE_ALIGN(x)                    (((x) + KEY_VALUE_STORE_ALIGNMENT - 1) & ~(KEY_VALUE_STORE_ALIGNMENT - 1))
+
+struct KeyValueStoreSectorHeader {
+    uint32_t magic;
+    uint32_t sequence;
+    uint32_t completed;
+    uint32_t reserved;
+};
+
+struct KeyValueStoreRecordHeader {
+    uint32_t key;
+    uint16_t length;
+    uint16_t type;
+    uint32_t crc;
+    uint32_t reserved;
+};
+
+struct KeyValueStoreIndexEntry {
+    uint32_t key;
+    uint32_t offset; // 0 when the key was deleted
+    uint32_t length;
+};
+
+struct KeyValueStoreState {
+    const TinyCLR_Storage_Controller* storageProvider;
+    const TinyCLR_Storage_Descriptor* descriptor;
+
+    size_t regions[2];
+    size_t sectorSize;
+
+    uint32_t active;
+    uint32_t sequence;
+    uint32_t writeOffset;
+
+    KeyValueStoreIndexEntry index[KEY_VALUE_STORE_INDEX_SIZE];
+    size_t indexCount; // keys that hold a value, a deleted key only keeps its slot until a new key reuses it
+
+    bool initialized;
+};
+
+static KeyValueStoreState keyValueStoreState;
+
+uint32_t KeyValueStore_Crc32(uint32_t crc, const uint8_t* data, size_t length) {
+    crc = ~crc;
+
+    while (length--) {
+        crc ^= *data++;
+
+        for (auto i = 0; i < 8; i++)
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+
+    return ~crc;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+/// Storage access
+///////////////////////////////////////////////////////////////////////////////////////////
+TinyCLR_Result KeyValueStore_ReadBytes(uint32_t sector, uint32_t offset, uint8_t* data, size_t length) {
+    auto state = &keyValueStoreState;
+    auto storage = state->storageProvider;
+    auto address = state->descriptor->RegionAddresses[state->regions[sector]] + offset;
+
+    // internal flash controllers copy whole words, keep a partial tail out of the caller's buffer
+    size_t count = length & ~3;
+    size_t tail = length & 3;
+
+    if (count > 0 && storage->Read(storage, address, count, data, KEY_VALUE_STORE_TIMEOUT) != TinyCLR_Result::Success)
+        return TinyCLR_Result::InvalidOperation;
+
+    if (tail > 0) {
+        uint32_t word;
+        size_t wordCount = sizeof(word);
+
+        if (storage->Read(storage, address + count, wordCount, reinterpret_cast<uint8_t*>(&word), KEY_VALUE_STORE_TIMEOUT) != TinyCLR_Result::Success)
+            return TinyCLR_Result::InvalidOperation;
+
+        memcpy(data + count, &word, tail);
+    }
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result KeyValueStore_WriteBytes(uint32_t sector, uint32_t offset, const uint8_t* data, size_t length) {
+    auto state = &keyValueStoreState;
+    auto storage = state->storageProvider;
+
+    return storage->Write(storage, state->descriptor->RegionAddresses[state->regions[sector]] + offset, length, data, KEY_VALUE_STORE_TIMEOUT);
+}
+
+TinyCLR_Result KeyValueStore_EraseSector(uint32_t sector) {
+    auto state = &keyValueStoreState;
+    auto storage = state->storageProvider;
+    size_t length = state->descriptor->RegionSizes[state->regions[sector]];
+    bool erased = false;
+
+    if (storage->IsErased(storage, state->regions[sector], length, erased) == TinyCLR_Result::Success && erased)
+        return TinyCLR_Result::Success;
+
+    return storage->Erase(storage, state->regions[sector], length, KEY_VALUE_STORE_TIMEOUT);
+}
+
+bool KeyValueStore_IsRangeErased(uint32_t sector, uint32_t offset, size_t length) {
+    uint8_t buffer[KEY_VALUE_STORE_COPY_BUFFER_SIZE];
+
+    while (length > 0) {
+        auto count = length < sizeof(buffer) ? length : sizeof(buffer);
+
+        if (KeyValueStore_ReadBytes(sector, offset, buffer, count) != TinyCLR_Result::Success)
+            return false;
+
+        for (size_t i = 0; i < count; i++)
+            if (buffer[i] != 0xFF)
+                return false;
+
+        offset += count;
+        length -= count;
+    }
+
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+/// RAM index
+///////////////////////////////////////////////////////////////////////////////////////////
+// A new key takes the first deleted slot on its probe sequence, or the free slot that ends it. The index has twice
+// KEY_VALUE_STORE_MAX_KEYS slots, so while fewer keys hold a value there is always one of the two.
+KeyValueStoreIndexEntry* KeyValueStore_FindEntry(uint32_t key, bool create) {
+    auto state = &keyValueStoreState;
+    auto slot = (key * 2654435761U) % KEY_VALUE_STORE_INDEX_SIZE;
+    KeyValueStoreIndexEntry* reusable = nullptr;
+
+    for (size_t i = 0; i < KEY_VALUE_STORE_INDEX_SIZE; i++) {
+        auto entry = &state->index[slot];
+
+        if (entry->key == key)
+            return entry;
+
+        if (entry->key == KEY_VALUE_STORE_INVALID_KEY) {
+            if (reusable == nullptr)
+                reusable = entry;
+
+            break;
+        }
+
+        if (entry->offset == 0 && reusable == nullptr)
+            reusable = entry;
+
+        slot = (slot + 1) % KEY_VALUE_STORE_INDEX_SIZE;
+    }
+
+    if (!create || reusable == nullptr || state->indexCount == KEY_VALUE_STORE_MAX_KEYS)
+        return nullptr;
+
+    reusable->key = key;
+    reusable->offset = 0;
+    reusable->length = 0;
+
+    return reusable;
+}
+
+void KeyValueStore_SetEntry(KeyValueStoreIndexEntry* entry, uint32_t offset, uint32_t length) {
+    auto state = &keyValueStoreState;
+
+    if (entry->offset == 0 && offset != 0)
+        state->indexCount++;
+    else if (entry->offset != 0 && offset == 0)
+        state->indexCount--;
+
+    entry->offset = offset;
+    entry->length = length;
+}
+
+void KeyValueStore_ClearIndex() {
+    auto state = &keyValueStoreState;
+
+    for (size_t i = 0; i < KEY_VALUE_STORE_INDEX_SIZE; i++) {
+        state->index[i].key = KEY_VALUE_STORE_INVALID_KEY;
+        state->index[i].offset = 0;
+        state->index[i].length = 0;
+    }
+
+    state->indexCount = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+/// Log
+///////////////////////////////////////////////////////////////////////////////////////////
+TinyCLR_Result KeyValueStore_CheckRecord(uint32_t sector, uint32_t offset, const KeyValueStoreRecordHeader& header, bool& valid) {
+    uint8_t buffer[KEY_VALUE_STORE_COPY_BUFFER_SIZE];
+
+    auto crc = KeyValueStore_Crc32(0, reinterpret_cast<const uint8_t*>(&header), 8);
+    size_t remaining = header.length;
+
+    offset += sizeof(KeyValueStoreRecordHeader);
+
+    while (remaining > 0) {
+        auto count = remaining < sizeof(buffer) ? remaining : sizeof(buffer);
+
+        if (KeyValueStore_ReadBytes(sector, offset, buffer, count) != TinyCLR_Result::Success)
+            return TinyCLR_Result::InvalidOperation;
+
+        crc = KeyValueStore_Crc32(crc, buffer, count);
+
+        offset += count;
+        remaining -= count;
+    }
+
+    valid = crc == header.crc;
+
+    return TinyCLR_Result::Success;
+}
+
+// Rebuilds the RAM index from the active sector and finds the append position
+TinyCLR_Result KeyValueStore_Scan() {
+    auto state = &keyValueStoreState;
+    uint32_t offset = sizeof(KeyValueStoreSectorHeader);
+
+    KeyValueStore_ClearIndex();
+
+    while (offset + sizeof(KeyValueStoreRecordHeader) <= state->sectorSize) {
+        KeyValueStoreRecordHeader header;
+
+        if (KeyValueStore_ReadBytes(state->active, offset, reinterpret_cast<uint8_t*>(&header), sizeof(header)) != TinyCLR_Result::Success)
+            return TinyCLR_Result::InvalidOperation;
+
+        if (header.key == KEY_VALUE_STORE_INVALID_KEY && header.length == 0xFFFF && header.type == 0xFFFF && header.crc == 0xFFFFFFFF)
+            break; // end of log
+
+        auto recordSize = KEY_VALUE_STORE_ALIGN(sizeof(KeyValueStoreRecordHeader) + header.length);
+
+        if (header.length > KEY_VALUE_STORE_MAX_VALUE_SIZE || offset + recordSize > state->sectorSize) {
+            // torn header, nothing after it can be trusted; the next write compacts the sector
+            offset = state->sectorSize;
+
+            break;
+        }
+
+        bool valid = false;
+
+        if (KeyValueStore_CheckRecord(state->active, offset, header, valid) != TinyCLR_Result::Success)
+            return TinyCLR_Result::InvalidOperation;
+
+        if (valid && (header.type == KEY_VALUE_STORE_RECORD_VALUE || header.type == KEY_VALUE_STORE_RECORD_DELETED)) {
+            // a deletion only clears a key that is already indexed, it never takes a slot
+            auto entry = KeyValueStore_FindEntry(header.key, header.type == KEY_VALUE_STORE_RECORD_VALUE);
+
+            if (entry != nullptr)
+                KeyValueStore_SetEntry(entry, header.type == KEY_VALUE_STORE_RECORD_VALUE ? offset : 0, header.length);
+        }
+
+        offset += recordSize;
+    }
+
+    state->writeOffset = offset;
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result KeyValueStore_Format(uint32_t sector, uint32_t sequence) {
+    KeyValueStoreSectorHeader header;
+
+    if (KeyValueStore_EraseSector(sector) != TinyCLR_Result::Success)
+        return TinyCLR_Result::InvalidOperation;
+
+    header.magic = KEY_VALUE_STORE_SECTOR_MAGIC;
+    header.sequence = sequence;
+    header.completed = 0xFFFFFFFF;
+    header.reserved = 0xFFFFFFFF;
+
+    return KeyValueStore_WriteBytes(sector, 0, reinterpret_cast<const uint8_t*>(&header), sizeof(header));
+}
+
+TinyCLR_Result KeyValueStore_MarkCompleted(uint32_t sector) {
+    uint32_t completed = KEY_VALUE_STORE_SECTOR_COMPLETED;
+
+    return KeyValueStore_WriteBytes(sector, offsetof(KeyValueStoreSectorHeader, completed), reinterpret_cast<const uint8_t*>(&completed), sizeof(completed));
+}
+
+TinyCLR_Result KeyValueStore_AppendRecord(uint32_t key, uint16_t type, const uint8_t* data, size_t length, uint32_t& offset) {
+    auto state = &keyValueStoreState;
+
+    KeyValueStoreRecordHeader header;
+
+    header.key = key;
+    header.length = length;
+    header.type = type;
+    header.reserved = 0xFFFFFFFF;
+    header.crc = KeyValueStore_Crc32(KeyValueStore_Crc32(0, reinterpret_cast<const uint8_t*>(&header), 8), data, length);
+
+    offset = state->writeOffset;
+
+    // Whatever lands in flash from here on is consumed, even if the write below is cut short
+    state->writeOffset += KEY_VALUE_STORE_ALIGN(sizeof(KeyValueStoreRecordHeader) + length);
+
+    if (KeyValueStore_WriteBytes(state->active, offset, reinterpret_cast<const uint8_t*>(&header), sizeof(header)) != TinyCLR_Result::Success)
+        return TinyCLR_Result::InvalidOperation;
+
+    if (length > 0 && KeyValueStore_WriteBytes(state->active, offset + sizeof(header), data, length) != TinyCLR_Result::Success)
+        return TinyCLR_Result::InvalidOperation;
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result KeyValueStore_CopyRecord(uint32_t source, uint32_t sourceOffset, uint32_t destination, uint32_t destinationOffset, size_t length) {
+    uint8_t buffer[KEY_VALUE_STORE_COPY_BUFFER_SIZE];
+
+    while (length > 0) {
+        auto count = length < sizeof(buffer) ? length : sizeof(buffer);
+
+        if (KeyValueStore_ReadBytes(source, sourceOffset, buffer, count) != TinyCLR_Result::Success)
+            return TinyCLR_Result::InvalidOperation;
+
+        if (KeyValueStore_WriteBytes(destination, destinationOffset, buffer, count) != TinyCLR_Result::Success)
+            return TinyCLR_Result::InvalidOperation;
+
+        sourceOffset += count;
+        destinationOffset += count;
+        length -= count;
+    }
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result KeyValueStore_Compact() {
+    auto state = &keyValueStoreState;
+
+    if (!state->initialized)
+        return TinyCLR_Result::NotAvailable;
+
+    auto source = state->active;
+    auto destination = source ^ 1;
+    uint32_t offset = sizeof(KeyValueStoreSectorHeader);
+
+    if (KeyValueStore_Format(destination, state->sequence + 1) != TinyCLR_Result::Success)
+        return TinyCLR_Result::InvalidOperation;
+
+    for (size_t i = 0; i < KEY_VALUE_STORE_INDEX_SIZE; i++) {
+        auto entry = &state->index[i];
+
+        if (entry->key == KEY_VALUE_STORE_INVALID_KEY || entry->offset == 0)
+            continue;
+
+        auto recordSize = sizeof(KeyValueStoreRecordHeader) + entry->length;
+
+        if (KeyValueStore_CopyRecord(source, entry->offset, destination, offset, recordSize) != TinyCLR_Result::Success)
+            return TinyCLR_Result::InvalidOperation;
+
+        offset += KEY_VALUE_STORE_ALIGN(recordSize);
+    }
+
+    // The new sector takes over only from here; before this the old one is still the valid copy
+    if (KeyValueStore_MarkCompleted(destination) != TinyCLR_Result::Success)
+        return TinyCLR_Result::InvalidOperation;
+
+    state->active = destination;
+    state->sequence++;
+
+    // the index kept pointing into the old sector until here, rebuild it from the new one
+    auto result = KeyValueStore_Scan();
+
+    if (result != TinyCLR_Result::Success)
+        return result;
+
+    return KeyValueStore_EraseSector(source);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+/// API
+///////////////////////////////////////////////////////////////////////////////////////////
+TinyCLR_Result KeyValueStore_Append(uint32_t key, uint16_t type, const uint8_t* data, size_t length) {
+    auto state = &keyValueStoreState;
+    auto recordSize = KEY_VALUE_STORE_ALIGN(sizeof(KeyValueStoreRecordHeader) + length);
+
+    auto entry = KeyValueStore_FindEntry(key, type == KEY_VALUE_STORE_RECORD_VALUE);
+
+    if (entry == nullptr)
+        return type == KEY_VALUE_STORE_RECORD_VALUE ? TinyCLR_Result::OutOfMemory : TinyCLR_Result::NotFound;
+
+    if (state->writeOffset + recordSize > state->sectorSize || !KeyValueStore_IsRangeErased(state->active, state->writeOffset, recordSize)) {
+        auto result = KeyValueStore_Compact();
+
+        if (result != TinyCLR_Result::Success)
+            return result;
+
+        entry = KeyValueStore_FindEntry(key, type == KEY_VALUE_STORE_RECORD_VALUE);
+
+        if (entry == nullptr)
+            return type == KEY_VALUE_STORE_RECORD_VALUE ? TinyCLR_Result::OutOfMemory : TinyCLR_Result::NotFound;
+
+        if (state->writeOffset + recordSize > state->sectorSize)
+            return TinyCLR_Result::OutOfMemory;
+    }
+
+    uint32_t offset;
+
+    auto result = KeyValueStore_AppendRecord(key, type, data, length, offset);
+
+    if (result != TinyCLR_Result::Success)
+        return result;
+
+    KeyValueStore_SetEntry(entry, type == KEY_VALUE_STORE_RECORD_VALUE ? offset : 0, length);
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result KeyValueStore_Write(uint32_t key, const uint8_t* data, size_t length) {
+    if (!keyValueStoreState.initialized)
+        return TinyCLR_Result::NotAvailable;
+
+    if (key == KEY_VALUE_STORE_INVALID_KEY || length > KEY_VALUE_STORE_MAX_VALUE_SIZE)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    if (data == nullptr && length > 0)
+        return TinyCLR_Result::ArgumentNull;
+
+    return KeyValueStore_Append(key, KEY_VALUE_STORE_RECORD_VALUE, data, length);
+}
+
+TinyCLR_Result KeyValueStore_Delete(uint32_t key) {
+    if (!keyValueStoreState.initialized)
+        return TinyCLR_Result::NotAvailable;
+
+    auto entry = KeyValueStore_FindEntry(key, false);
+
+    if (entry == nullptr || entry->offset == 0)
+        return TinyCLR_Result::NotFound;
+
+    return KeyValueStore_Append(key, KEY_VALUE_STORE_RECORD_DELETED, nullptr, 0);
+}
+
+TinyCLR_Result KeyValueStore_GetLength(uint32_t key, size_t& length) {
+    if (!keyValueStoreState.initialized)
+        return TinyCLR_Result::NotAvailable;
+
+    auto entry = KeyValueStore_FindEntry(key, false);
+
+    if (entry == nullptr || entry->offset == 0)
+        return TinyCLR_Result::NotFound;
+
+    length = entry->length;
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result KeyValueStore_Read(uint32_t key, uint8_t* data, size_t& length) {
+    auto state = &keyValueStoreState;
+
+    if (!state->initialized)
+        return TinyCLR_Result::NotAvailable;
+
+    auto entry = KeyValueStore_FindEntry(key, false);
+
+    if (entry == nullptr || entry->offset == 0)
+        return TinyCLR_Result::NotFound;
+
+    if (length < entry->length) {
+        length = entry->length;
+
+        return TinyCLR_Result::ArgumentOutOfRange;
+    }
+
+    if (data == nullptr && entry->length > 0)
+        return TinyCLR_Result::ArgumentNull;
+
+    length = entry->length;
+
+    if (length == 0)
+        return TinyCLR_Result::Success;
+
+    return KeyValueStore_ReadBytes(state->active, entry->offset + sizeof(KeyValueStoreRecordHeader), data, length);
+}
+
+TinyCLR_Result KeyValueStore_GetUsage(size_t& usedBytes, size_t& liveBytes, size_t& totalBytes) {
+    auto state = &keyValueStoreState;
+
+    if (!state->initialized)
+        return TinyCLR_Result::NotAvailable;
+
+    usedBytes = state->writeOffset;
+    totalBytes = state->sectorSize;
+    liveBytes = sizeof(KeyValueStoreSectorHeader);
+
+    for (size_t i = 0; i < KEY_VALUE_STORE_INDEX_SIZE; i++) {
+        if (state->index[i].key != KEY_VALUE_STORE_INVALID_KEY && state->index[i].offset != 0)
+            liveBytes += KEY_VALUE_STORE_ALIGN(sizeof(KeyValueStoreRecordHeader) + state->index[i].length);
+    }
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result KeyValueStore_Mount() {
+    auto state = &keyValueStoreState;
+
+    KeyValueStoreSectorHeader headers[2];
+    bool valid[2];
+
+    for (auto i = 0; i < 2; i++) {
+        if (KeyValueStore_ReadBytes(i, 0, reinterpret_cast<uint8_t*>(&headers[i]), sizeof(KeyValueStoreSectorHeader)) != TinyCLR_Result::Success)
+            return TinyCLR_Result::InvalidOperation;
+
+        valid[i] = headers[i].magic == KEY_VALUE_STORE_SECTOR_MAGIC && headers[i].completed == KEY_VALUE_STORE_SECTOR_COMPLETED;
+    }
+
+    if (!valid[0] && !valid[1]) {
+        // blank or foreign content
+        if (KeyValueStore_Format(0, 1) != TinyCLR_Result::Success || KeyValueStore_MarkCompleted(0) != TinyCLR_Result::Success)
+            return TinyCLR_Result::InvalidOperation;
+
+        state->active = 0;
+        state->sequence = 1;
+    }
+    else {
+        if (valid[0] && valid[1])
+            state->active = static_cast<int32_t>(headers[1].sequence - headers[0].sequence) > 0 ? 1 : 0; // power cut before the old sector was erased
+        else
+            state->active = valid[0] ? 0 : 1;
+
+        state->sequence = headers[state->active].sequence;
+    }
+
+    // an interrupted compaction or the superseded sector
+    if (KeyValueStore_EraseSector(state->active ^ 1) != TinyCLR_Result::Success)
+        return TinyCLR_Result::InvalidOperation;
+
+    return KeyValueStore_Scan();
+}
+
+TinyCLR_Result KeyValueStore_Acquire(const TinyCLR_Storage_Controller* storageProvider, size_t region0, size_t region1) {
+    auto state = &keyValueStoreState;
+
+    if (state->initialized)
+        return TinyCLR_Result::SharingViolation;
+
+    if (storageProvider == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    memset(state, 0, sizeof(KeyValueStoreState));
+
+    if (storageProvider->Acquire(storageProvider) != TinyCLR_Result::Success)
+        return TinyCLR_Result::NotAvailable;
+
+    storageProvider->Open(storageProvider);
+
+    state->storageProvider = storageProvider;
+
+    if (storageProvider->GetDescriptor(storageProvider, state->descriptor) != TinyCLR_Result::Success || !state->descriptor->EraseBeforeWrite
+        || region0 == region1 || region0 >= state->descriptor->RegionCount || region1 >= state->descriptor->RegionCount) {
+        storageProvider->Close(storageProvider);
+        storageProvider->Release(storageProvider);
+
+        return TinyCLR_Result::ArgumentInvalid;
+    }
+
+    state->regions[0] = region0;
+    state->regions[1] = region1;
+    state->sectorSize = state->descriptor->RegionSizes[region0] < state->descriptor->RegionSizes[region1] ? state->descriptor->RegionSizes[region0] : state->descriptor->RegionSizes[region1];
+
+    auto result = KeyValueStore_Mount();
+
+    if (result != TinyCLR_Result::Success) {
+        storageProvider->Close(storageProvider);
+        storageProvider->Release(storageProvider);
+
+        return result;
+    }
+
+    state->initialized = true;
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result KeyValueStore_Release() {
+    auto state = &keyValueStoreState;
+
+    if (!state->initialized)
+        return TinyCLR_Result::Success;
+
+    state->storageProvider->Close(state->storageProvider);
+    state->storageProvider->Release(state->storageProvider);
+
+    state->initialized = false;
+
+    return TinyCLR_Result::Success;
+}
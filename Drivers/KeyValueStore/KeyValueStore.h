@@ -0,0 +1,47 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <TinyCLR.h>
+
+// Maximum number of distinct keys held in the RAM index
+#ifndef KEY_VALUE_STORE_MAX_KEYS
+#define KEY_VALUE_STORE_MAX_KEYS                    64
+#endif
+
+#define KEY_VALUE_STORE_MAX_VALUE_SIZE              1024
+
+// Every record starts on this boundary so it never shares a program unit with the previous one
+#define KEY_VALUE_STORE_ALIGNMENT                   8
+
+#define KEY_VALUE_STORE_SECTOR_MAGIC                0x3153564B // "KVS1"
+#define KEY_VALUE_STORE_SECTOR_COMPLETED            0x00000000
+
+#define KEY_VALUE_STORE_RECORD_VALUE                0x5641
+#define KEY_VALUE_STORE_RECORD_DELETED              0x4C44
+
+#define KEY_VALUE_STORE_INVALID_KEY                 0xFFFFFFFF
+
+#define KEY_VALUE_STORE_TIMEOUT                     1000
+
+// region0 and region1 are storage controller region indexes used as the two ping-pong sectors
+TinyCLR_Result KeyValueStore_Acquire(const TinyCLR_Storage_Controller* storageProvider, size_t region0, size_t region1);
+TinyCLR_Result KeyValueStore_Release();
+TinyCLR_Result KeyValueStore_Read(uint32_t key, uint8_t* data, size_t& length);
+TinyCLR_Result KeyValueStore_Write(uint32_t key, const uint8_t* data, size_t length);
+TinyCLR_Result KeyValueStore_Delete(uint32_t key);
+TinyCLR_Result KeyValueStore_GetLength(uint32_t key, size_t& length);
+TinyCLR_Result KeyValueStore_Compact();
+TinyCLR_Result KeyValueStore_GetUsage(size_t& usedBytes, size_t& liveBytes, size_t& totalBytes);
@@ -18,18 +18,37 @@
 #include "S25FL032_Flash.h"
 #include <Device.h>
 
-#define SPI_CLOCK_RATE_HZ 20000000
+// every command but READ (0x03), which the driver does not use, runs at the FAST_READ clock
+#ifndef S25FL032_FLASH_FAST_READ_CLOCK_RATE_HZ
+#define S25FL032_FLASH_FAST_READ_CLOCK_RATE_HZ 50000000
+#endif
+
+#define __min(a,b)  (((a) < (b)) ? (a) : (b))
 
 const TinyCLR_Spi_Controller* s25fl032FlashSpiProvider;
 static uint32_t s25fl032FlashSpiChipSelectLine;
 static TinyCLR_Spi_Settings s25fl032FlashSpiSettings;
 
+// in RAM so the SPI DMA can repeat it
+static uint8_t s25fl032FlashDummyByte = 0xFF;
+
 static uint8_t s25fl032FlashDataReadBuffer[S25FL032_FLASH_SECTOR_SIZE + 4];
 static uint8_t s25fl032FlashDataWriteBuffer[S25FL032_FLASH_SECTOR_SIZE + 4];
 
 static uint64_t s25fl032FlashSectorAddress[S25FL032_FLASH_SECTOR_NUM];
 static size_t s25fl032FlashSectorSize[S25FL032_FLASH_SECTOR_NUM];
 
+// Chip select is owned by the driver, the SPI settings carry no pin. Each command gets its own select.
+TinyCLR_Result S25FL032_Flash_WriteRead(const uint8_t* writeBuffer, size_t& writeLength, uint8_t* readBuffer, size_t& readLength) {
+    CONCAT(DEVICE_TARGET, _Gpio_Write)(nullptr, s25fl032FlashSpiChipSelectLine, TinyCLR_Gpio_PinValue::Low);
+
+    auto result = s25fl032FlashSpiProvider->WriteRead(s25fl032FlashSpiProvider, writeBuffer, writeLength, readBuffer, readLength, false);
+
+    CONCAT(DEVICE_TARGET, _Gpio_Write)(nullptr, s25fl032FlashSpiChipSelectLine, TinyCLR_Gpio_PinValue::High);
+
+    return result;
+}
+
 bool S25FL032_Flash_WriteEnable() {
     s25fl032FlashDataWriteBuffer[0] = S25FL032_FLASH_COMMAND_WRITE_ENABLE;
     s25fl032FlashDataWriteBuffer[1] = 0x00;
@@ -37,7 +56,7 @@ bool S25FL032_Flash_WriteEnable() {
     size_t writeLength = 1;
     size_t readLength = 0;
 
-    s25fl032FlashSpiProvider->WriteRead(s25fl032FlashSpiProvider, s25fl032FlashDataWriteBuffer, writeLength, s25fl032FlashDataReadBuffer, readLength, false);
+    S25FL032_Flash_WriteRead(s25fl032FlashDataWriteBuffer, writeLength, s25fl032FlashDataReadBuffer, readLength);
 
     s25fl032FlashDataWriteBuffer[0] = S25FL032_FLASH_COMMAND_READ_STATUS_REGISTER;
     s25fl032FlashDataWriteBuffer[1] = 0x00;
@@ -45,7 +64,7 @@ bool S25FL032_Flash_WriteEnable() {
     writeLength = 2;
     readLength = 2;
 
-    s25fl032FlashSpiProvider->WriteRead(s25fl032FlashSpiProvider, s25fl032FlashDataWriteBuffer, writeLength, s25fl032FlashDataReadBuffer, readLength, false);
+    S25FL032_Flash_WriteRead(s25fl032FlashDataWriteBuffer, writeLength, s25fl032FlashDataReadBuffer, readLength);
 
     if ((s25fl032FlashDataReadBuffer[1] & 0x2) != 0)
         return true;
@@ -60,7 +79,7 @@ bool S25FL032_Flash_WriteInProgress() {
     size_t writeLength = 2;
     size_t readLength = 2;
 
-    s25fl032FlashSpiProvider->WriteRead(s25fl032FlashSpiProvider, s25fl032FlashDataWriteBuffer, writeLength, s25fl032FlashDataReadBuffer, readLength, false);
+    S25FL032_Flash_WriteRead(s25fl032FlashDataWriteBuffer, writeLength, s25fl032FlashDataReadBuffer, readLength);
 
     if ((s25fl032FlashDataReadBuffer[1] & 0x1) != 0)
         return true;
@@ -77,56 +96,36 @@ TinyCLR_Result S25FL032_Flash_Read(uint32_t address, size_t length, uint8_t* buf
 
     while (S25FL032_Flash_WriteInProgress() == true);
 
-    int32_t block = length / S25FL032_FLASH_SECTOR_SIZE;
-    int32_t rest = length % S25FL032_FLASH_SECTOR_SIZE;
-    int32_t index = 0;
-    size_t writeLength = S25FL032_FLASH_SECTOR_SIZE + 4;
-    size_t readLength = S25FL032_FLASH_SECTOR_SIZE + 4;
+    // The command and the data phase are two transfers under one select,
+    // the data phase then clocks straight into the caller's buffer.
+    uint8_t command[S25FL032_FLASH_FAST_READ_COMMAND_SIZE];
 
-    while (block > 0) {
-        s25fl032FlashDataWriteBuffer[0] = S25FL032_FLASH_COMMAND_READ_DATA;
-        s25fl032FlashDataWriteBuffer[1] = (uint8_t)((address) >> 16);
-        s25fl032FlashDataWriteBuffer[2] = (uint8_t)((address) >> 8);
-        s25fl032FlashDataWriteBuffer[3] = (uint8_t)((address) >> 0);
+    command[0] = S25FL032_FLASH_COMMAND_FAST_READ;
+    command[1] = (uint8_t)((address) >> 16);
+    command[2] = (uint8_t)((address) >> 8);
+    command[3] = (uint8_t)((address) >> 0);
+    command[4] = 0x00; // dummy
 
-        writeLength = S25FL032_FLASH_SECTOR_SIZE + 4;
-        readLength = S25FL032_FLASH_SECTOR_SIZE + 4;
+    size_t writeLength = S25FL032_FLASH_FAST_READ_COMMAND_SIZE;
+    size_t readLength = 0;
 
-        // start to read
-        s25fl032FlashSpiProvider->WriteRead(s25fl032FlashSpiProvider, s25fl032FlashDataWriteBuffer, writeLength, s25fl032FlashDataReadBuffer, readLength, false);
+    CONCAT(DEVICE_TARGET, _Gpio_Write)(nullptr, s25fl032FlashSpiChipSelectLine, TinyCLR_Gpio_PinValue::Low);
 
-        // copy to buffer
-        memcpy(&buffer[index], &s25fl032FlashDataReadBuffer[4], S25FL032_FLASH_SECTOR_SIZE);
+    auto result = s25fl032FlashSpiProvider->WriteRead(s25fl032FlashSpiProvider, command, writeLength, nullptr, readLength, false);
 
-        address += S25FL032_FLASH_SECTOR_SIZE;
-        index += S25FL032_FLASH_SECTOR_SIZE;
-        block--;
+    if (result == TinyCLR_Result::Success && length > 0) {
+        // single dummy byte is repeated by the controller for the whole data phase
+        writeLength = 1;
+        readLength = length;
 
+        result = s25fl032FlashSpiProvider->WriteRead(s25fl032FlashSpiProvider, &s25fl032FlashDummyByte, writeLength, buffer, readLength, false);
     }
 
-    if (rest > 0) {
-        s25fl032FlashDataWriteBuffer[0] = S25FL032_FLASH_COMMAND_READ_DATA;
-        s25fl032FlashDataWriteBuffer[1] = (uint8_t)((address) >> 16);
-        s25fl032FlashDataWriteBuffer[2] = (uint8_t)((address) >> 8);
-        s25fl032FlashDataWriteBuffer[3] = (uint8_t)((address) >> 0);
-
-        writeLength = rest + 4;
-        readLength = rest + 4;
-
-        // start to read
-        s25fl032FlashSpiProvider->WriteRead(s25fl032FlashSpiProvider, s25fl032FlashDataWriteBuffer, writeLength, s25fl032FlashDataReadBuffer, readLength, false);
-
-        // copy to buffer
-        memcpy(&buffer[index], &s25fl032FlashDataReadBuffer[4], rest);
-
-        address += rest;
-        index += rest;
-        rest = 0;
-    }
+    CONCAT(DEVICE_TARGET, _Gpio_Write)(nullptr, s25fl032FlashSpiChipSelectLine, TinyCLR_Gpio_PinValue::High);
 
     s25fl032FlashSpiProvider->Release(s25fl032FlashSpiProvider);
 
-    return index == length ? TinyCLR_Result::Success : TinyCLR_Result::InvalidOperation;
+    return result == TinyCLR_Result::Success ? TinyCLR_Result::Success : TinyCLR_Result::InvalidOperation;
 }
 
 TinyCLR_Result S25FL032_Flash_PageProgram(uint32_t byteAddress, uint32_t NumberOfBytesToWrite, const uint8_t * pointerToWriteBuffer) {
@@ -157,7 +156,7 @@ TinyCLR_Result S25FL032_Flash_PageProgram(uint32_t byteAddress, uint32_t NumberO
         memcpy(&s25fl032FlashDataWriteBuffer[4], pointerToWriteBuffer + source_index, block_size);
 
         // Write cmd to Write
-        s25fl032FlashSpiProvider->WriteRead(s25fl032FlashSpiProvider, s25fl032FlashDataWriteBuffer, actualWrite, nullptr, actualRead, false);
+        S25FL032_Flash_WriteRead(s25fl032FlashDataWriteBuffer, actualWrite, nullptr, actualRead);
 
         while (S25FL032_Flash_WriteInProgress() == true);
 
@@ -237,7 +236,7 @@ TinyCLR_Result S25FL032_Flash_EraseBlock(uint32_t sector) {
     size_t writeLength = 4;
     size_t readLength = 0;
 
-    s25fl032FlashSpiProvider->WriteRead(s25fl032FlashSpiProvider, s25fl032FlashDataWriteBuffer, writeLength, nullptr, readLength, false);
+    S25FL032_Flash_WriteRead(s25fl032FlashDataWriteBuffer, writeLength, nullptr, readLength);
 
     while (S25FL032_Flash_WriteInProgress() == true);
 
@@ -260,38 +259,43 @@ TinyCLR_Result S25FL032_Flash_Acquire(const TinyCLR_Spi_Controller* spiProvider,
     s25fl032FlashSpiProvider = spiProvider;
     s25fl032FlashSpiChipSelectLine = chipSelectLine;
 
+    if (CONCAT(DEVICE_TARGET, _Gpio_OpenPin)(nullptr, s25fl032FlashSpiChipSelectLine) != TinyCLR_Result::Success)
+        return TinyCLR_Result::SharingViolation;
+
+    CONCAT(DEVICE_TARGET, _Gpio_Write)(nullptr, s25fl032FlashSpiChipSelectLine, TinyCLR_Gpio_PinValue::High);
+    CONCAT(DEVICE_TARGET, _Gpio_SetDriveMode)(nullptr, s25fl032FlashSpiChipSelectLine, TinyCLR_Gpio_PinDriveMode::Output);
+
     s25fl032FlashSpiProvider->Acquire(s25fl032FlashSpiProvider);
 
+    // one settings for every command, the controller is not reprogrammed between them
     s25fl032FlashSpiSettings.Mode = TinyCLR_Spi_Mode::Mode0;
-    s25fl032FlashSpiSettings.ClockFrequency = SPI_CLOCK_RATE_HZ;
+    s25fl032FlashSpiSettings.ClockFrequency = __min(s25fl032FlashSpiProvider->GetMaxClockFrequency(s25fl032FlashSpiProvider), S25FL032_FLASH_FAST_READ_CLOCK_RATE_HZ);
     s25fl032FlashSpiSettings.DataBitLength = 8;
     s25fl032FlashSpiSettings.ChipSelectType = TinyCLR_Spi_ChipSelectType::Gpio;
-    s25fl032FlashSpiSettings.ChipSelectLine = s25fl032FlashSpiChipSelectLine;
+    s25fl032FlashSpiSettings.ChipSelectLine = PIN_NONE;
     s25fl032FlashSpiSettings.ChipSelectSetupTime = 0;
     s25fl032FlashSpiSettings.ChipSelectHoldTime = 0;
     s25fl032FlashSpiSettings.ChipSelectActiveState = false;
 
     s25fl032FlashSpiProvider->SetActiveSettings(s25fl032FlashSpiProvider, &s25fl032FlashSpiSettings);
 
-    s25fl032FlashSpiProvider->WriteRead(s25fl032FlashSpiProvider, s25fl032FlashDataWriteBuffer, writeLength, s25fl032FlashDataReadBuffer, readLength, false);
-
-    if (S25F_FLASH_MANUFACTURER_CODE != s25fl032FlashDataReadBuffer[1] && MX25L_FLASH_MANUFACTURER_CODE != s25fl032FlashDataReadBuffer[1]) {
+    S25FL032_Flash_WriteRead(s25fl032FlashDataWriteBuffer, writeLength, s25fl032FlashDataReadBuffer, readLength);
 
-        return TinyCLR_Result::WrongType;
-    }
+    s25fl032FlashSpiProvider->Release(s25fl032FlashSpiProvider);
 
-    if ((S25F_FLASH_DEVICE_CODE_0 != s25fl032FlashDataReadBuffer[2] || S25F_FLASH_DEVICE_CODE_1 != s25fl032FlashDataReadBuffer[3]) && (MX25L_FLASH_DEVICE_CODE_0 != s25fl032FlashDataReadBuffer[2] || MX25L_FLASH_DEVICE_CODE_1 != s25fl032FlashDataReadBuffer[3])) {
+    if ((S25F_FLASH_MANUFACTURER_CODE != s25fl032FlashDataReadBuffer[1] && MX25L_FLASH_MANUFACTURER_CODE != s25fl032FlashDataReadBuffer[1]) ||
+        ((S25F_FLASH_DEVICE_CODE_0 != s25fl032FlashDataReadBuffer[2] || S25F_FLASH_DEVICE_CODE_1 != s25fl032FlashDataReadBuffer[3]) && (MX25L_FLASH_DEVICE_CODE_0 != s25fl032FlashDataReadBuffer[2] || MX25L_FLASH_DEVICE_CODE_1 != s25fl032FlashDataReadBuffer[3]))) {
+        CONCAT(DEVICE_TARGET, _Gpio_ClosePin)(nullptr, s25fl032FlashSpiChipSelectLine);
 
         return TinyCLR_Result::WrongType;
     }
 
-    s25fl032FlashSpiProvider->Release(s25fl032FlashSpiProvider);
-
     return TinyCLR_Result::Success;
 }
 
 TinyCLR_Result S25FL032_Flash_Release() {
-    // UnInitialize Flash can be here
+    CONCAT(DEVICE_TARGET, _Gpio_ClosePin)(nullptr, s25fl032FlashSpiChipSelectLine);
+
     return TinyCLR_Result::Success;
 }
 
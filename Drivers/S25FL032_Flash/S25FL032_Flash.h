@@ -10,6 +10,8 @@
 #define S25FL032_FLASH_COMMAND_READID                              0x9F
 #define S25FL032_FLASH_COMMAND_READ_STATUS_REGISTER                0x05
 #define S25FL032_FLASH_COMMAND_READ_DATA                           0x03
+#define S25FL032_FLASH_COMMAND_FAST_READ                           0x0B
+#define S25FL032_FLASH_FAST_READ_COMMAND_SIZE                      5
 #define S25FL032_FLASH_COMMAND_WRITE_ENABLE                        0x06
 #define S25FL032_FLASH_COMMAND_PAGE_PROGRAMMING                    0x02
 #define S25FL032_FLASH_COMMAND_ERASE_SECTOR_64K                    0xD8
@@ -28,6 +28,7 @@ static UsClientState usbClientStates[TOTAL_USBCLIENT_CONTROLLERS];
 TinyCLR_UsbClient_DataReceivedHandler TinyCLR_UsbClient_SetDataReceived;
 TinyCLR_UsbClient_RequestHandler TinyCLR_UsbClient_ProcessVendorClassRequest = nullptr;
 TinyCLR_UsbClient_RequestHandler TinyCLR_UsbClient_SetGetDescriptor = nullptr;
+USB_CLASS_REQUEST_CALLBACK TinyCLR_UsbClient_ProcessNativeClassRequest = nullptr;
 
 void TinyCLR_UsbClient_SetEvent(UsClientState *usClientState, uint32_t event) {
     DISABLE_INTERRUPTS_SCOPED(irq);
@@ -230,8 +231,7 @@ uint8_t TinyCLR_UsbClient_HandleClearFeature(UsClientState* usClientState, TinyC
             return USB_STATE_STALL;
 
         /* clear the halt feature */
-        usClientState->endpointStatus[Setup->Index] &= ~USB_STATUS_ENDPOINT_HALT;
-        usClientState->endpointStatusChange = Setup->Index;
+        TinyCLR_UsbClient_SetEndpointHalt(usClientState, Setup->Index, false);
         retState = USB_STATE_STATUS;
         break;
 
@@ -300,8 +300,7 @@ uint8_t TinyCLR_UsbClient_HandleSetFeature(UsClientState* usClientState, TinyCLR
         }
 
         /* set the halt feature */
-        usClientState->endpointStatus[Setup->Index] |= USB_STATUS_ENDPOINT_HALT;
-        usClientState->endpointStatusChange = Setup->Index;
+        TinyCLR_UsbClient_SetEndpointHalt(usClientState, Setup->Index, true);
         retState = USB_STATE_STATUS;
         break;
 
@@ -363,6 +362,15 @@ uint8_t TinyCLR_UsbClient_HandleConfigurationRequests(UsClientState* usClientSta
     usClientState->expected = Setup->Length;
 
     if (usClientState->expected == 0) {
+        // let a native class driver see no-data requests (e.g. mass storage reset)
+        if ((Setup->RequestType & USB_REQUEST_TYPE_CLASS) && TinyCLR_UsbClient_ProcessNativeClassRequest != nullptr) {
+            const uint8_t* responsePayload;
+
+            size_t responsePayloadLength = 0;
+
+            TinyCLR_UsbClient_ProcessNativeClassRequest(usClientState, Setup, responsePayload, responsePayloadLength);
+        }
+
         // just return an empty Status packet
         usClientState->residualCount = 0;
         usClientState->dataCallback = TinyCLR_UsbClient_DataCallback;
@@ -533,7 +541,13 @@ uint8_t TinyCLR_UsbClient_HandleConfigurationRequests(UsClientState* usClientSta
 
             size_t responsePayloadLength = 0;
 
-            if (TinyCLR_UsbClient_ProcessVendorClassRequest(&usbClientControllers[controllerIndex], Setup, responsePayload, responsePayloadLength, TinyCLR_UsbClient_Now()) == TinyCLR_Result::Success) {
+            if ((Setup->RequestType & USB_REQUEST_TYPE_CLASS) && TinyCLR_UsbClient_ProcessNativeClassRequest != nullptr && TinyCLR_UsbClient_ProcessNativeClassRequest(usClientState, Setup, responsePayload, responsePayloadLength)) {
+                memcpy(usClientState->controlEndpointBuffer, reinterpret_cast<uint8_t*>(const_cast<uint8_t*>(responsePayload)), responsePayloadLength);
+
+                usClientState->residualData = usClientState->controlEndpointBuffer;
+                usClientState->residualCount = __min(usClientState->expected, responsePayloadLength);
+            }
+            else if (TinyCLR_UsbClient_ProcessVendorClassRequest != nullptr && TinyCLR_UsbClient_ProcessVendorClassRequest(&usbClientControllers[controllerIndex], Setup, responsePayload, responsePayloadLength, TinyCLR_UsbClient_Now()) == TinyCLR_Result::Success) {
                 memcpy(usClientState->controlEndpointBuffer, reinterpret_cast<uint8_t*>(const_cast<uint8_t*>(responsePayload)), responsePayloadLength);
 
                 usClientState->residualData = usClientState->controlEndpointBuffer;
@@ -722,6 +736,25 @@ void TinyCLR_UsbClient_ClearEndpoints(UsClientState* usClientState, int32_t endp
     usClientState->fifoPacketIn[endpoint] = usClientState->fifoPacketOut[endpoint] = usClientState->fifoPacketCount[endpoint] = 0;
 }
 
+// Halting an endpoint drops what is queued on it and makes the controller answer with STALL until the halt is cleared,
+// by the host with CLEAR_FEATURE or by a native class driver. Clearing it also resets the data toggle.
+void TinyCLR_UsbClient_SetEndpointHalt(UsClientState* usClientState, int32_t endpoint, bool halt) {
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    if (halt) {
+        usClientState->endpointStatus[endpoint] |= USB_STATUS_ENDPOINT_HALT;
+
+        TinyCLR_UsbClient_ClearEndpoints(usClientState, endpoint);
+    }
+    else {
+        usClientState->endpointStatus[endpoint] &= ~USB_STATUS_ENDPOINT_HALT;
+    }
+
+    usClientState->endpointStatusChange = endpoint;
+
+    TinyCLR_UsbClient_SetEndpointStall(usClientState, endpoint, halt);
+}
+
 bool TinyCLR_UsbClient_CanReceivePackage(UsClientState* usClientState, int32_t endpoint) {
     return usClientState->fifoPacketCount[endpoint] < usClientState->maxFifoPacketCount[endpoint];
 }
@@ -1001,10 +1034,18 @@ TinyCLR_Result TinyCLR_UsbClient_ClosePipe(const TinyCLR_UsbClient_Controller* s
 TinyCLR_Result TinyCLR_UsbClient_WritePipe(const TinyCLR_UsbClient_Controller* self, uint32_t pipe, const uint8_t* data, size_t& length) {
     UsClientState * usClientState = reinterpret_cast<UsClientState*>(self->ApiInfo->State);
 
+    if (data == nullptr || length == 0) {
+        return TinyCLR_Result::NotAvailable;
+    }
+
+    return TinyCLR_UsbClient_WritePipeInternal(usClientState, pipe, data, length, true);
+}
+
+TinyCLR_Result TinyCLR_UsbClient_WritePipeInternal(UsClientState* usClientState, uint32_t pipe, const uint8_t* data, size_t& length, bool endOfTransfer) {
     if (!usClientState->initialized
         || usClientState->deviceState != USB_DEVICE_STATE_CONFIGURED
-        || data == nullptr
-        || length == 0) {
+        || (data == nullptr && length > 0)
+        || (length == 0 && !endOfTransfer)) {
         return TinyCLR_Result::NotAvailable;
     }
 
@@ -1027,6 +1068,8 @@ TinyCLR_Result TinyCLR_UsbClient_WritePipe(const TinyCLR_UsbClient_Controller* s
     // will always have less than the maximum length - even if the packet length
     // must be zero for this to occur.   This is done to comply with standard
     // USB bulk-mode transfers.
+    // When endOfTransfer is false the caller streams one transfer across several
+    // calls (e.g. mass storage data phase), so no short/zero-length packet is added.
     while (!Done) {
 
         USB_PACKET64* Packet64 = nullptr;
@@ -1062,6 +1105,10 @@ TinyCLR_Result TinyCLR_UsbClient_WritePipe(const TinyCLR_UsbClient_Controller* s
             count -= max_move;
             ptr += max_move;
 
+            if (!endOfTransfer && count == 0) {
+                Done = true;
+            }
+
             totWrite += max_move;
 
             WaitLoopCnt = 0;
@@ -1230,6 +1277,10 @@ TinyCLR_Result TinyCLR_UsbClient_SetVendorClassRequestHandler(const TinyCLR_UsbC
     return TinyCLR_Result::Success;
 }
 
+void TinyCLR_UsbClient_SetNativeClassRequestCallback(USB_CLASS_REQUEST_CALLBACK callback) {
+    TinyCLR_UsbClient_ProcessNativeClassRequest = callback;
+}
+
 TinyCLR_Result TinyCLR_UsbClient_SetGetDescriptorHandler(const TinyCLR_UsbClient_Controller* self, TinyCLR_UsbClient_RequestHandler handler) {
     TinyCLR_UsbClient_SetGetDescriptor = handler;
 
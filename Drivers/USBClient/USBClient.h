@@ -183,6 +183,10 @@ struct UsClientState {
     uint16_t initializeCount;
 };
 
+// Native class drivers (e.g. mass storage) hook class requests here before the managed vendor/class handler.
+// Return true when the request was handled; responsePayload/responsePayloadLength describe the data stage.
+typedef bool(*USB_CLASS_REQUEST_CALLBACK)(UsClientState* usClientState, TinyCLR_UsbClient_SetupPacket* setup, const uint8_t*& responsePayload, size_t& responsePayloadLength);
+
 const TinyCLR_Api_Info* TinyCLR_UsbClient_GetRequiredApi();
 void TinyCLR_UsbClient_AddApi(const TinyCLR_Api_Manager* apiManager);
 void TinyCLR_UsbClient_Reset(int32_t controller);
@@ -207,10 +211,15 @@ size_t TinyCLR_UsbClient_GetReadBufferSize(const TinyCLR_UsbClient_Controller* s
 TinyCLR_Result TinyCLR_UsbClient_SetWriteBufferSize(const TinyCLR_UsbClient_Controller* self, uint32_t pipe, size_t size);
 TinyCLR_Result TinyCLR_UsbClient_SetReadBufferSize(const TinyCLR_UsbClient_Controller* self, uint32_t pipe, size_t size);
 
+TinyCLR_Result TinyCLR_UsbClient_WritePipeInternal(UsClientState* usClientState, uint32_t pipe, const uint8_t* data, size_t& length, bool endOfTransfer);
+void TinyCLR_UsbClient_SetNativeClassRequestCallback(USB_CLASS_REQUEST_CALLBACK callback);
+void TinyCLR_UsbClient_SetEndpointHalt(UsClientState* usClientState, int32_t endpoint, bool halt);
+
 bool TinyCLR_UsbClient_Initialize(UsClientState* usClientState);
 bool TinyCLR_UsbClient_Uninitialize(UsClientState* usClientState);
 bool TinyCLR_UsbClient_StartOutput(UsClientState* usClientState, int32_t endpoint);
 bool TinyCLR_UsbClient_RxEnable(UsClientState* usClientState, int32_t endpoint);
+bool TinyCLR_UsbClient_SetEndpointStall(UsClientState* usClientState, int32_t endpoint, bool stall);
 void TinyCLR_UsbClient_Delay(uint64_t microseconds);
 uint64_t TinyCLR_UsbClient_Now();
 TinyCLR_Result TinyCLR_UsbClient_GetControllerCount(const TinyCLR_UsbClient_Controller* self, int32_t& count);
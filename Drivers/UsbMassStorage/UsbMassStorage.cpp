@@ -0,0 +1,843 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string.h>
+#include <Device.h>
+
+#include "../USBClient/USBClient.h"
+#include "UsbMassStorage.h"
+
+#define __max(a,b)  (((a) > (b)) ? (a) : (b))
+
+#define USB_MASS_STORAGE_INQUIRY_SIZE                   36
+#define USB_MASS_STORAGE_REQUEST_SENSE_SIZE             18
+#define USB_MASS_STORAGE_READ_CAPACITY_SIZE             8
+#define USB_MASS_STORAGE_READ_FORMAT_CAPACITIES_SIZE    12
+#define USB_MASS_STORAGE_MODE_SENSE_6_SIZE              4
+#define USB_MASS_STORAGE_MODE_SENSE_10_SIZE             8
+
+#define USB_MASS_STORAGE_TICKS_PER_MICROSECOND          10
+
+struct UsbMassStorageState {
+    const TinyCLR_UsbClient_Controller* usbClientProvider;
+    const TinyCLR_Storage_Controller* storageProvider;
+    const TinyCLR_Storage_Descriptor* descriptor;
+    UsClientState* usClientState;
+
+    uint32_t pipe;
+
+    bool blockAddressed;
+    bool writeProtected;
+    uint32_t blockSize;
+    uint32_t blockCount;
+    uint32_t blocksPerBuffer;
+
+    uint8_t* buffers[2];
+    uint8_t* regionBuffer;
+    size_t regionBufferSize;
+
+    uint8_t cbw[USB_MASS_STORAGE_CBW_SIZE];
+    size_t cbwLength;
+
+    uint8_t response[USB_MASS_STORAGE_INQUIRY_SIZE];
+
+    uint8_t senseKey;
+    uint8_t additionalSenseCode;
+
+    volatile bool resetRequested;
+    bool resetRecoveryNeeded;
+    bool initialized;
+};
+
+static UsbMassStorageState usbMassStorageState;
+
+static const uint8_t usbMassStorageMaxLun = 0;
+
+static const uint8_t usbMassStorageInquiry[USB_MASS_STORAGE_INQUIRY_SIZE] = {
+    0x00,                                                   // direct access block device
+    0x80,                                                   // removable
+    0x04,                                                   // SPC-2
+    0x02,                                                   // response data format
+    USB_MASS_STORAGE_INQUIRY_SIZE - 5,
+    0x00, 0x00, 0x00,
+    'T', 'i', 'n', 'y', 'C', 'L', 'R', ' ',                 // vendor
+    'M', 'a', 's', 's', ' ', 'S', 't', 'o', 'r', 'a', 'g', 'e', ' ', ' ', ' ', ' ', // product
+    '1', '.', '0', '0'                                      // revision
+};
+
+uint32_t UsbMassStorage_GetBigEndian32(const uint8_t* data) {
+    return (data[0] << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+}
+
+uint16_t UsbMassStorage_GetBigEndian16(const uint8_t* data) {
+    return (data[0] << 8) | data[1];
+}
+
+void UsbMassStorage_SetBigEndian32(uint8_t* data, uint32_t value) {
+    data[0] = value >> 24;
+    data[1] = value >> 16;
+    data[2] = value >> 8;
+    data[3] = value;
+}
+
+uint32_t UsbMassStorage_GetLittleEndian32(const uint8_t* data) {
+    return data[0] | (data[1] << 8) | (data[2] << 16) | (data[3] << 24);
+}
+
+void UsbMassStorage_SetLittleEndian32(uint8_t* data, uint32_t value) {
+    data[0] = value;
+    data[1] = value >> 8;
+    data[2] = value >> 16;
+    data[3] = value >> 24;
+}
+
+void UsbMassStorage_SetSense(uint8_t senseKey, uint8_t additionalSenseCode) {
+    usbMassStorageState.senseKey = senseKey;
+    usbMassStorageState.additionalSenseCode = additionalSenseCode;
+}
+
+bool UsbMassStorage_ClassRequest(UsClientState* usClientState, TinyCLR_UsbClient_SetupPacket* setup, const uint8_t*& responsePayload, size_t& responsePayloadLength) {
+    auto state = &usbMassStorageState;
+
+    if (!state->initialized || usClientState != state->usClientState)
+        return false;
+
+    switch (setup->Request) {
+    case USB_MASS_STORAGE_REQUEST_GET_MAX_LUN:
+        responsePayload = &usbMassStorageMaxLun;
+        responsePayloadLength = sizeof(usbMassStorageMaxLun);
+
+        return true;
+
+    case USB_MASS_STORAGE_REQUEST_RESET:
+        // Processed from UsbMassStorage_Process, the control request itself has no data stage
+        state->resetRequested = true;
+
+        responsePayload = &usbMassStorageMaxLun;
+        responsePayloadLength = 0;
+
+        return true;
+    }
+
+    return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+/// Storage access
+///////////////////////////////////////////////////////////////////////////////////////////
+// Byte addressed storage (EraseBeforeWrite flash) is exposed as 512 byte logical blocks laid over its regions.
+bool UsbMassStorage_FindRegion(uint64_t offset, size_t& region, uint64_t& address, size_t& available) {
+    auto descriptor = usbMassStorageState.descriptor;
+
+    uint64_t regionStart = 0;
+
+    for (region = 0; region < descriptor->RegionCount; region++) {
+        auto regionSize = descriptor->RegionSizes[region];
+
+        if (offset < regionStart + regionSize) {
+            address = descriptor->RegionAddresses[region] + (offset - regionStart);
+            available = regionSize - (offset - regionStart);
+
+            return true;
+        }
+
+        regionStart += regionSize;
+    }
+
+    return false;
+}
+
+TinyCLR_Result UsbMassStorage_ReadBlocks(uint32_t lba, uint32_t blocks, uint8_t* data) {
+    auto state = &usbMassStorageState;
+    auto storage = state->storageProvider;
+
+    if (state->blockAddressed) {
+        size_t count = blocks;
+
+        return storage->Read(storage, lba, count, data, USB_MASS_STORAGE_STORAGE_TIMEOUT);
+    }
+
+    uint64_t offset = (uint64_t)lba * state->blockSize;
+    size_t remaining = blocks * state->blockSize;
+
+    while (remaining > 0) {
+        size_t region;
+        uint64_t address;
+        size_t available;
+
+        if (!UsbMassStorage_FindRegion(offset, region, address, available))
+            return TinyCLR_Result::ArgumentOutOfRange;
+
+        size_t count = __min(remaining, available);
+
+        auto result = storage->Read(storage, address, count, data, USB_MASS_STORAGE_STORAGE_TIMEOUT);
+
+        if (result != TinyCLR_Result::Success)
+            return result;
+
+        offset += count;
+        data += count;
+        remaining -= count;
+    }
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result UsbMassStorage_WriteBlocks(uint32_t lba, uint32_t blocks, const uint8_t* data) {
+    auto state = &usbMassStorageState;
+    auto storage = state->storageProvider;
+
+    if (state->blockAddressed) {
+        size_t count = blocks;
+
+        return storage->Write(storage, lba, count, data, USB_MASS_STORAGE_STORAGE_TIMEOUT);
+    }
+
+    uint64_t offset = (uint64_t)lba * state->blockSize;
+    size_t remaining = blocks * state->blockSize;
+
+    while (remaining > 0) {
+        size_t region;
+        uint64_t address;
+        size_t available;
+
+        if (!UsbMassStorage_FindRegion(offset, region, address, available))
+            return TinyCLR_Result::ArgumentOutOfRange;
+
+        auto regionAddress = state->descriptor->RegionAddresses[region];
+        size_t regionSize = state->descriptor->RegionSizes[region];
+        size_t regionOffset = address - regionAddress;
+        size_t count = __min(remaining, available);
+        size_t length = regionSize;
+
+        auto result = storage->Read(storage, regionAddress, length, state->regionBuffer, USB_MASS_STORAGE_STORAGE_TIMEOUT);
+
+        if (result != TinyCLR_Result::Success)
+            return result;
+
+        // NOR flash can only clear bits, so the region only has to be erased if a bit goes from 0 to 1
+        auto needErase = false;
+
+        for (size_t i = 0; i < count; i++) {
+            if ((state->regionBuffer[regionOffset + i] & data[i]) != data[i]) {
+                needErase = true;
+
+                break;
+            }
+        }
+
+        if (needErase) {
+            memcpy(&state->regionBuffer[regionOffset], data, count);
+
+            length = regionSize;
+
+            if ((result = storage->Erase(storage, region, length, USB_MASS_STORAGE_STORAGE_TIMEOUT)) != TinyCLR_Result::Success)
+                return result;
+
+            length = regionSize;
+
+            result = storage->Write(storage, regionAddress, length, state->regionBuffer, USB_MASS_STORAGE_STORAGE_TIMEOUT);
+        }
+        else {
+            length = count;
+
+            result = storage->Write(storage, address, length, data, USB_MASS_STORAGE_STORAGE_TIMEOUT);
+        }
+
+        if (result != TinyCLR_Result::Success)
+            return result;
+
+        offset += count;
+        data += count;
+        remaining -= count;
+    }
+
+    return TinyCLR_Result::Success;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+/// Pipe access
+///////////////////////////////////////////////////////////////////////////////////////////
+size_t UsbMassStorage_GetWriteSpace() {
+    auto usClientState = usbMassStorageState.usClientState;
+    auto endpoint = usClientState->pipes[usbMassStorageState.pipe].TxEP;
+
+    return (usClientState->maxFifoPacketCount[endpoint] - usClientState->fifoPacketCount[endpoint]) * usClientState->maxEndpointsPacketSize[endpoint];
+}
+
+bool UsbMassStorage_IsTransferAborted(uint64_t lastProgress) {
+    auto state = &usbMassStorageState;
+
+    if (state->resetRequested || state->usClientState->deviceState != USB_DEVICE_STATE_CONFIGURED)
+        return true;
+
+    return (TinyCLR_UsbClient_Now() - lastProgress) > (uint64_t)USB_MASS_STORAGE_TRANSFER_TIMEOUT_US * USB_MASS_STORAGE_TICKS_PER_MICROSECOND;
+}
+
+TinyCLR_Result UsbMassStorage_SendData(const uint8_t* data, size_t length, bool endOfTransfer) {
+    auto state = &usbMassStorageState;
+    auto lastProgress = TinyCLR_UsbClient_Now();
+
+    while (length > 0 || endOfTransfer) {
+        size_t count = length;
+
+        if (TinyCLR_UsbClient_WritePipeInternal(state->usClientState, state->pipe, data, count, endOfTransfer) != TinyCLR_Result::Success)
+            return TinyCLR_Result::NotAvailable;
+
+        if (count == length)
+            return TinyCLR_Result::Success;
+
+        if (count > 0) {
+            data += count;
+            length -= count;
+            lastProgress = TinyCLR_UsbClient_Now();
+        }
+        else if (UsbMassStorage_IsTransferAborted(lastProgress)) {
+            return TinyCLR_Result::TimedOut;
+        }
+    }
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result UsbMassStorage_ReceiveData(uint8_t* data, size_t length) {
+    auto state = &usbMassStorageState;
+    auto lastProgress = TinyCLR_UsbClient_Now();
+
+    while (length > 0) {
+        size_t count = length;
+
+        if (state->usbClientProvider->ReadPipe(state->usbClientProvider, state->pipe, data, count) != TinyCLR_Result::Success)
+            return TinyCLR_Result::NotAvailable;
+
+        if (count > 0) {
+            data += count;
+            length -= count;
+            lastProgress = TinyCLR_UsbClient_Now();
+        }
+        else if (UsbMassStorage_IsTransferAborted(lastProgress)) {
+            return TinyCLR_Result::TimedOut;
+        }
+        else {
+            TinyCLR_UsbClient_Delay(50);
+        }
+    }
+
+    return TinyCLR_Result::Success;
+}
+
+// Data IN phase of READ(10). Two buffers are used so the storage read of the next chunk runs while
+// the USB interrupt drains the previous chunk from the IN endpoint packet FIFO.
+TinyCLR_Result UsbMassStorage_SendBlocks(uint32_t lba, uint32_t blocks, size_t& sent) {
+    auto state = &usbMassStorageState;
+
+    size_t pending[2] = { 0, 0 };
+    size_t offset[2] = { 0, 0 };
+    auto current = 0;
+    auto lastProgress = TinyCLR_UsbClient_Now();
+
+    sent = 0;
+
+    while (blocks > 0 || pending[current] > 0) {
+        auto idle = current ^ 1;
+        auto target = pending[current] == 0 ? current : idle;
+
+        if (pending[target] == 0 && blocks > 0) {
+            auto count = __min(blocks, state->blocksPerBuffer);
+
+            if (UsbMassStorage_ReadBlocks(lba, count, state->buffers[target]) != TinyCLR_Result::Success) {
+                UsbMassStorage_SetSense(USB_MASS_STORAGE_SENSE_MEDIUM_ERROR, USB_MASS_STORAGE_ASC_UNRECOVERED_READ_ERROR);
+
+                return TinyCLR_Result::InvalidOperation;
+            }
+
+            pending[target] = count * state->blockSize;
+            offset[target] = 0;
+
+            lba += count;
+            blocks -= count;
+        }
+
+        auto space = __min(UsbMassStorage_GetWriteSpace(), pending[current]);
+
+        if (space > 0) {
+            size_t count = space;
+
+            if (TinyCLR_UsbClient_WritePipeInternal(state->usClientState, state->pipe, state->buffers[current] + offset[current], count, false) != TinyCLR_Result::Success)
+                return TinyCLR_Result::NotAvailable;
+
+            offset[current] += count;
+            pending[current] -= count;
+            sent += count;
+
+            if (count > 0)
+                lastProgress = TinyCLR_UsbClient_Now();
+
+            if (pending[current] == 0)
+                current = idle;
+        }
+        else if (pending[current] > 0) {
+            if (UsbMassStorage_IsTransferAborted(lastProgress))
+                return TinyCLR_Result::TimedOut;
+
+            TinyCLR_UsbClient_Delay(50);
+        }
+    }
+
+    return TinyCLR_Result::Success;
+}
+
+// Data OUT phase of WRITE(10). Packets keep arriving in the OUT endpoint FIFO while a buffer is written to storage.
+TinyCLR_Result UsbMassStorage_ReceiveBlocks(uint32_t lba, uint32_t blocks, size_t& received) {
+    auto state = &usbMassStorageState;
+    auto current = 0;
+
+    received = 0;
+
+    while (blocks > 0) {
+        auto count = __min(blocks, state->blocksPerBuffer);
+        auto length = count * state->blockSize;
+
+        auto result = UsbMassStorage_ReceiveData(state->buffers[current], length);
+
+        if (result != TinyCLR_Result::Success)
+            return result;
+
+        received += length;
+
+        if (!state->writeProtected && UsbMassStorage_WriteBlocks(lba, count, state->buffers[current]) != TinyCLR_Result::Success) {
+            UsbMassStorage_SetSense(USB_MASS_STORAGE_SENSE_MEDIUM_ERROR, USB_MASS_STORAGE_ASC_WRITE_FAULT);
+
+            return TinyCLR_Result::InvalidOperation;
+        }
+
+        lba += count;
+        blocks -= count;
+        current ^= 1;
+    }
+
+    return TinyCLR_Result::Success;
+}
+
+// Host expects more or other data than the command provides: drain OUT data so the CSW stays in sync.
+TinyCLR_Result UsbMassStorage_DiscardData(size_t length) {
+    auto state = &usbMassStorageState;
+
+    while (length > 0) {
+        auto count = __min(length, (size_t)(state->blocksPerBuffer * state->blockSize));
+        auto result = UsbMassStorage_ReceiveData(state->buffers[0], count);
+
+        if (result != TinyCLR_Result::Success)
+            return result;
+
+        length -= count;
+    }
+
+    return TinyCLR_Result::Success;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+/// SCSI
+///////////////////////////////////////////////////////////////////////////////////////////
+uint8_t UsbMassStorage_ReadWrite(const uint8_t* cdb, bool read, bool directionIn, uint32_t hostLength, size_t& transferred) {
+    auto state = &usbMassStorageState;
+
+    auto lba = UsbMassStorage_GetBigEndian32(&cdb[2]);
+    auto blocks = UsbMassStorage_GetBigEndian16(&cdb[7]);
+    auto length = blocks * state->blockSize;
+
+    transferred = 0;
+
+    if (length != hostLength || (length > 0 && directionIn != read)) {
+        // Mismatched CBW: drain what the host sends, report a phase error, host resets recovery
+        if (!directionIn && hostLength > 0 && UsbMassStorage_DiscardData(hostLength) == TinyCLR_Result::Success)
+            transferred = hostLength;
+
+        return USB_MASS_STORAGE_CSW_STATUS_PHASE_ERROR;
+    }
+
+    if (lba + blocks > state->blockCount || lba + blocks < lba) {
+        UsbMassStorage_SetSense(USB_MASS_STORAGE_SENSE_ILLEGAL_REQUEST, USB_MASS_STORAGE_ASC_LBA_OUT_OF_RANGE);
+
+        if (read)
+            UsbMassStorage_SendData(nullptr, 0, true);
+        else if (UsbMassStorage_DiscardData(hostLength) == TinyCLR_Result::Success)
+            transferred = hostLength;
+
+        return USB_MASS_STORAGE_CSW_STATUS_FAILED;
+    }
+
+    if (!read && state->writeProtected) {
+        UsbMassStorage_SetSense(USB_MASS_STORAGE_SENSE_DATA_PROTECT, USB_MASS_STORAGE_ASC_WRITE_PROTECTED);
+
+        if (UsbMassStorage_DiscardData(hostLength) == TinyCLR_Result::Success)
+            transferred = hostLength;
+
+        return USB_MASS_STORAGE_CSW_STATUS_FAILED;
+    }
+
+    auto result = read ? UsbMassStorage_SendBlocks(lba, blocks, transferred) : UsbMassStorage_ReceiveBlocks(lba, blocks, transferred);
+
+    if (result != TinyCLR_Result::Success) {
+        if (transferred < hostLength && read)
+            UsbMassStorage_SendData(nullptr, 0, true);
+
+        return USB_MASS_STORAGE_CSW_STATUS_FAILED;
+    }
+
+    return USB_MASS_STORAGE_CSW_STATUS_PASSED;
+}
+
+uint8_t UsbMassStorage_ExecuteCommand(const uint8_t* cdb, bool directionIn, uint32_t hostLength, size_t& transferred) {
+    auto state = &usbMassStorageState;
+    auto response = state->response;
+    size_t responseLength = 0;
+    uint8_t status = USB_MASS_STORAGE_CSW_STATUS_PASSED;
+
+    transferred = 0;
+
+    switch (cdb[0]) {
+    case USB_MASS_STORAGE_SCSI_READ_10:
+        return UsbMassStorage_ReadWrite(cdb, true, directionIn, hostLength, transferred);
+
+    case USB_MASS_STORAGE_SCSI_WRITE_10:
+        return UsbMassStorage_ReadWrite(cdb, false, directionIn, hostLength, transferred);
+
+    case USB_MASS_STORAGE_SCSI_INQUIRY:
+        memcpy(response, usbMassStorageInquiry, USB_MASS_STORAGE_INQUIRY_SIZE);
+
+        if (!state->descriptor->Removable)
+            response[1] = 0x00;
+
+        responseLength = USB_MASS_STORAGE_INQUIRY_SIZE;
+
+        break;
+
+    case USB_MASS_STORAGE_SCSI_REQUEST_SENSE:
+        memset(response, 0, USB_MASS_STORAGE_REQUEST_SENSE_SIZE);
+
+        response[0] = 0x70;
+        response[2] = state->senseKey;
+        response[7] = USB_MASS_STORAGE_REQUEST_SENSE_SIZE - 8;
+        response[12] = state->additionalSenseCode;
+
+        responseLength = USB_MASS_STORAGE_REQUEST_SENSE_SIZE;
+
+        UsbMassStorage_SetSense(USB_MASS_STORAGE_SENSE_NO_SENSE, 0);
+
+        break;
+
+    case USB_MASS_STORAGE_SCSI_READ_CAPACITY_10:
+        UsbMassStorage_SetBigEndian32(&response[0], state->blockCount - 1);
+        UsbMassStorage_SetBigEndian32(&response[4], state->blockSize);
+
+        responseLength = USB_MASS_STORAGE_READ_CAPACITY_SIZE;
+
+        break;
+
+    case USB_MASS_STORAGE_SCSI_READ_FORMAT_CAPACITIES:
+        memset(response, 0, USB_MASS_STORAGE_READ_FORMAT_CAPACITIES_SIZE);
+
+        response[3] = 8;
+        UsbMassStorage_SetBigEndian32(&response[4], state->blockCount);
+        UsbMassStorage_SetBigEndian32(&response[8], state->blockSize);
+        response[8] = 0x02; // formatted media
+
+        responseLength = USB_MASS_STORAGE_READ_FORMAT_CAPACITIES_SIZE;
+
+        break;
+
+    case USB_MASS_STORAGE_SCSI_MODE_SENSE_6:
+        memset(response, 0, USB_MASS_STORAGE_MODE_SENSE_6_SIZE);
+
+        response[0] = USB_MASS_STORAGE_MODE_SENSE_6_SIZE - 1;
+        response[2] = state->writeProtected ? 0x80 : 0x00;
+
+        responseLength = USB_MASS_STORAGE_MODE_SENSE_6_SIZE;
+
+        break;
+
+    case USB_MASS_STORAGE_SCSI_MODE_SENSE_10:
+        memset(response, 0, USB_MASS_STORAGE_MODE_SENSE_10_SIZE);
+
+        response[1] = USB_MASS_STORAGE_MODE_SENSE_10_SIZE - 2;
+        response[3] = state->writeProtected ? 0x80 : 0x00;
+
+        responseLength = USB_MASS_STORAGE_MODE_SENSE_10_SIZE;
+
+        break;
+
+    case USB_MASS_STORAGE_SCSI_TEST_UNIT_READY:
+    case USB_MASS_STORAGE_SCSI_START_STOP_UNIT:
+    case USB_MASS_STORAGE_SCSI_PREVENT_ALLOW_REMOVAL:
+    case USB_MASS_STORAGE_SCSI_VERIFY_10:
+    case USB_MASS_STORAGE_SCSI_SYNCHRONIZE_CACHE_10: {
+        bool present = true;
+
+        if (state->storageProvider->IsPresent(state->storageProvider, present) == TinyCLR_Result::Success && !present) {
+            UsbMassStorage_SetSense(USB_MASS_STORAGE_SENSE_NOT_READY, USB_MASS_STORAGE_ASC_MEDIUM_NOT_PRESENT);
+
+            status = USB_MASS_STORAGE_CSW_STATUS_FAILED;
+        }
+
+        break;
+    }
+
+    default:
+        UsbMassStorage_SetSense(USB_MASS_STORAGE_SENSE_ILLEGAL_REQUEST, USB_MASS_STORAGE_ASC_INVALID_COMMAND);
+
+        status = USB_MASS_STORAGE_CSW_STATUS_FAILED;
+
+        break;
+    }
+
+    if (hostLength == 0)
+        return status;
+
+    if (!directionIn) {
+        // No supported command takes OUT data besides WRITE(10)
+        if (UsbMassStorage_DiscardData(hostLength) == TinyCLR_Result::Success)
+            transferred = hostLength;
+
+        return responseLength > 0 ? USB_MASS_STORAGE_CSW_STATUS_PHASE_ERROR : status;
+    }
+
+    responseLength = __min(responseLength, hostLength);
+
+    // Short responses end the transfer with a short or zero-length packet
+    if (UsbMassStorage_SendData(response, responseLength, responseLength < hostLength) == TinyCLR_Result::Success)
+        transferred = responseLength;
+
+    return status;
+}
+
+void UsbMassStorage_SendStatus(uint32_t tag, uint32_t residue, uint8_t status) {
+    uint8_t csw[USB_MASS_STORAGE_CSW_SIZE];
+
+    UsbMassStorage_SetLittleEndian32(&csw[0], USB_MASS_STORAGE_CSW_SIGNATURE);
+    UsbMassStorage_SetLittleEndian32(&csw[4], tag);
+    UsbMassStorage_SetLittleEndian32(&csw[8], residue);
+    csw[12] = status;
+
+    UsbMassStorage_SendData(csw, USB_MASS_STORAGE_CSW_SIZE, true);
+}
+
+// BOT 6.6.1: after an invalid CBW both bulk endpoints stay halted until the host does a reset recovery, a bulk-only
+// mass storage reset followed by CLEAR_FEATURE(ENDPOINT_HALT) on each of them.
+void UsbMassStorage_HaltPipe() {
+    auto usClientState = usbMassStorageState.usClientState;
+    auto pipe = &usClientState->pipes[usbMassStorageState.pipe];
+
+    if (!(usClientState->endpointStatus[pipe->TxEP] & USB_STATUS_ENDPOINT_HALT))
+        TinyCLR_UsbClient_SetEndpointHalt(usClientState, pipe->TxEP, true);
+
+    if (!(usClientState->endpointStatus[pipe->RxEP] & USB_STATUS_ENDPOINT_HALT))
+        TinyCLR_UsbClient_SetEndpointHalt(usClientState, pipe->RxEP, true);
+}
+
+TinyCLR_Result UsbMassStorage_Process() {
+    auto state = &usbMassStorageState;
+
+    if (!state->initialized)
+        return TinyCLR_Result::NotAvailable;
+
+    if (state->resetRequested || state->usClientState->deviceState != USB_DEVICE_STATE_CONFIGURED) {
+        state->resetRequested = false;
+        state->resetRecoveryNeeded = false;
+        state->cbwLength = 0;
+
+        return TinyCLR_Result::Success;
+    }
+
+    if (state->resetRecoveryNeeded) {
+        // a CLEAR_FEATURE without the reset does not end the recovery
+        UsbMassStorage_HaltPipe();
+
+        return TinyCLR_Result::Success;
+    }
+
+    while (true) {
+        size_t count = USB_MASS_STORAGE_CBW_SIZE - state->cbwLength;
+
+        if (state->usbClientProvider->ReadPipe(state->usbClientProvider, state->pipe, &state->cbw[state->cbwLength], count) != TinyCLR_Result::Success || count == 0)
+            return TinyCLR_Result::Success;
+
+        state->cbwLength += count;
+
+        if (state->cbwLength < USB_MASS_STORAGE_CBW_SIZE)
+            continue;
+
+        state->cbwLength = 0;
+
+        auto cbw = state->cbw;
+
+        if (UsbMassStorage_GetLittleEndian32(&cbw[0]) != USB_MASS_STORAGE_CBW_SIGNATURE || cbw[13] != 0 || cbw[14] == 0 || cbw[14] > 16) {
+            state->resetRecoveryNeeded = true;
+
+            UsbMassStorage_HaltPipe();
+
+            return TinyCLR_Result::Success;
+        }
+
+        auto tag = UsbMassStorage_GetLittleEndian32(&cbw[4]);
+        auto hostLength = UsbMassStorage_GetLittleEndian32(&cbw[8]);
+        auto directionIn = (cbw[12] & USB_MASS_STORAGE_CBW_FLAG_IN) != 0;
+
+        size_t transferred = 0;
+
+        auto status = UsbMassStorage_ExecuteCommand(&cbw[15], directionIn, hostLength, transferred);
+
+        if (state->resetRequested)
+            return TinyCLR_Result::Success;
+
+        UsbMassStorage_SendStatus(tag, hostLength - transferred, status);
+    }
+}
+
+TinyCLR_Result UsbMassStorage_GetGeometry(uint32_t& blockSize, uint32_t& blockCount, bool& writeProtected) {
+    auto state = &usbMassStorageState;
+
+    if (!state->initialized)
+        return TinyCLR_Result::NotAvailable;
+
+    blockSize = state->blockSize;
+    blockCount = state->blockCount;
+    writeProtected = state->writeProtected;
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result UsbMassStorage_Acquire(const TinyCLR_UsbClient_Controller* usbClientProvider, const TinyCLR_Storage_Controller* storageProvider, uint8_t writeEndpoint, uint8_t readEndpoint) {
+    auto state = &usbMassStorageState;
+
+    if (state->initialized)
+        return TinyCLR_Result::SharingViolation;
+
+    memset(state, 0, sizeof(UsbMassStorageState));
+
+    auto memoryManager = reinterpret_cast<const TinyCLR_Memory_Manager*>(apiManager->FindDefault(apiManager, TinyCLR_Api_Type::MemoryManager));
+
+    if (memoryManager == nullptr)
+        return TinyCLR_Result::NotAvailable;
+
+    if (storageProvider->Acquire(storageProvider) != TinyCLR_Result::Success)
+        return TinyCLR_Result::NotAvailable;
+
+    storageProvider->Open(storageProvider);
+
+    if (storageProvider->GetDescriptor(storageProvider, state->descriptor) != TinyCLR_Result::Success || state->descriptor->RegionCount == 0)
+        goto acquire_storage_error;
+
+    state->storageProvider = storageProvider;
+    state->blockAddressed = !state->descriptor->EraseBeforeWrite;
+
+    if (state->blockAddressed) {
+        // Block devices (SD) address and count in blocks of RegionSizes[0]
+        state->blockSize = state->descriptor->RegionSizes[0];
+        state->blockCount = state->descriptor->RegionCount;
+    }
+    else {
+        uint64_t totalSize = 0;
+
+        for (size_t i = 0; i < state->descriptor->RegionCount; i++) {
+            totalSize += state->descriptor->RegionSizes[i];
+            state->regionBufferSize = __max(state->regionBufferSize, state->descriptor->RegionSizes[i]);
+        }
+
+        state->blockSize = USB_MASS_STORAGE_FLASH_BLOCK_SIZE;
+        state->blockCount = totalSize / USB_MASS_STORAGE_FLASH_BLOCK_SIZE;
+
+        // Writes need a whole erase region in RAM; without it the LUN is exposed read only
+        state->regionBuffer = reinterpret_cast<uint8_t*>(memoryManager->Allocate(memoryManager, state->regionBufferSize));
+        state->writeProtected = state->regionBuffer == nullptr || !state->descriptor->CanWriteDirect;
+    }
+
+    if (state->blockSize == 0 || (state->blockSize % TinyCLR_UsbClient_GetEndpointSize(writeEndpoint)) != 0)
+        goto acquire_storage_error;
+
+    state->blocksPerBuffer = __max(USB_MASS_STORAGE_BUFFER_SIZE / state->blockSize, 1);
+
+    for (auto i = 0; i < 2; i++) {
+        state->buffers[i] = reinterpret_cast<uint8_t*>(memoryManager->Allocate(memoryManager, state->blocksPerBuffer * state->blockSize));
+
+        if (state->buffers[i] == nullptr)
+            goto acquire_memory_error;
+    }
+
+    if (usbClientProvider->Acquire(usbClientProvider) != TinyCLR_Result::Success)
+        goto acquire_memory_error;
+
+    if (usbClientProvider->OpenPipe(usbClientProvider, writeEndpoint, readEndpoint, state->pipe) != TinyCLR_Result::Success) {
+        usbClientProvider->Release(usbClientProvider);
+
+        goto acquire_memory_error;
+    }
+
+    state->usbClientProvider = usbClientProvider;
+    state->usClientState = reinterpret_cast<UsClientState*>(usbClientProvider->ApiInfo->State);
+
+    UsbMassStorage_SetSense(USB_MASS_STORAGE_SENSE_NO_SENSE, 0);
+
+    state->initialized = true;
+
+    TinyCLR_UsbClient_SetNativeClassRequestCallback(&UsbMassStorage_ClassRequest);
+
+    return TinyCLR_Result::Success;
+
+acquire_memory_error:
+    for (auto i = 0; i < 2; i++) {
+        if (state->buffers[i] != nullptr)
+            memoryManager->Free(memoryManager, state->buffers[i]);
+    }
+
+acquire_storage_error:
+    if (state->regionBuffer != nullptr)
+        memoryManager->Free(memoryManager, state->regionBuffer);
+
+    storageProvider->Close(storageProvider);
+    storageProvider->Release(storageProvider);
+
+    memset(state, 0, sizeof(UsbMassStorageState));
+
+    return TinyCLR_Result::InvalidOperation;
+}
+
+TinyCLR_Result UsbMassStorage_Release() {
+    auto state = &usbMassStorageState;
+
+    if (!state->initialized)
+        return TinyCLR_Result::Success;
+
+    TinyCLR_UsbClient_SetNativeClassRequestCallback(nullptr);
+
+    state->usbClientProvider->ClosePipe(state->usbClientProvider, state->pipe);
+    state->usbClientProvider->Release(state->usbClientProvider);
+
+    state->storageProvider->Close(state->storageProvider);
+    state->storageProvider->Release(state->storageProvider);
+
+    auto memoryManager = reinterpret_cast<const TinyCLR_Memory_Manager*>(apiManager->FindDefault(apiManager, TinyCLR_Api_Type::MemoryManager));
+
+    if (memoryManager != nullptr) {
+        for (auto i = 0; i < 2; i++)
+            memoryManager->Free(memoryManager, state->buffers[i]);
+
+        if (state->regionBuffer != nullptr)
+            memoryManager->Free(memoryManager, state->regionBuffer);
+    }
+
+    memset(state, 0, sizeof(UsbMassStorageState));
+
+    return TinyCLR_Result::Success;
+}
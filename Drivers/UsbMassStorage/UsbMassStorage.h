@@ -0,0 +1,85 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <TinyCLR.h>
+
+// Interface descriptor codes the device descriptor must use for the mass storage interface
+#define USB_MASS_STORAGE_INTERFACE_CLASS                0x08
+#define USB_MASS_STORAGE_INTERFACE_SUBCLASS_SCSI        0x06
+#define USB_MASS_STORAGE_INTERFACE_PROTOCOL_BOT         0x50
+
+// Bulk-Only Transport class requests
+#define USB_MASS_STORAGE_REQUEST_GET_MAX_LUN            0xFE
+#define USB_MASS_STORAGE_REQUEST_RESET                  0xFF
+
+// Command/Status wrappers
+#define USB_MASS_STORAGE_CBW_SIGNATURE                  0x43425355
+#define USB_MASS_STORAGE_CSW_SIGNATURE                  0x53425355
+#define USB_MASS_STORAGE_CBW_SIZE                       31
+#define USB_MASS_STORAGE_CSW_SIZE                       13
+#define USB_MASS_STORAGE_CBW_FLAG_IN                    0x80
+
+#define USB_MASS_STORAGE_CSW_STATUS_PASSED              0x00
+#define USB_MASS_STORAGE_CSW_STATUS_FAILED              0x01
+#define USB_MASS_STORAGE_CSW_STATUS_PHASE_ERROR         0x02
+
+// SCSI commands
+#define USB_MASS_STORAGE_SCSI_TEST_UNIT_READY           0x00
+#define USB_MASS_STORAGE_SCSI_REQUEST_SENSE             0x03
+#define USB_MASS_STORAGE_SCSI_INQUIRY                   0x12
+#define USB_MASS_STORAGE_SCSI_MODE_SENSE_6              0x1A
+#define USB_MASS_STORAGE_SCSI_START_STOP_UNIT           0x1B
+#define USB_MASS_STORAGE_SCSI_PREVENT_ALLOW_REMOVAL     0x1E
+#define USB_MASS_STORAGE_SCSI_READ_FORMAT_CAPACITIES    0x23
+#define USB_MASS_STORAGE_SCSI_READ_CAPACITY_10          0x25
+#define USB_MASS_STORAGE_SCSI_READ_10                   0x28
+#define USB_MASS_STORAGE_SCSI_WRITE_10                  0x2A
+#define USB_MASS_STORAGE_SCSI_VERIFY_10                 0x2F
+#define USB_MASS_STORAGE_SCSI_SYNCHRONIZE_CACHE_10      0x35
+#define USB_MASS_STORAGE_SCSI_MODE_SENSE_10             0x5A
+
+// Sense keys / additional sense codes
+#define USB_MASS_STORAGE_SENSE_NO_SENSE                 0x00
+#define USB_MASS_STORAGE_SENSE_NOT_READY                0x02
+#define USB_MASS_STORAGE_SENSE_MEDIUM_ERROR             0x03
+#define USB_MASS_STORAGE_SENSE_ILLEGAL_REQUEST          0x05
+#define USB_MASS_STORAGE_SENSE_DATA_PROTECT             0x07
+
+#define USB_MASS_STORAGE_ASC_INVALID_COMMAND            0x20
+#define USB_MASS_STORAGE_ASC_LBA_OUT_OF_RANGE           0x21
+#define USB_MASS_STORAGE_ASC_INVALID_FIELD_IN_CDB       0x24
+#define USB_MASS_STORAGE_ASC_WRITE_PROTECTED            0x27
+#define USB_MASS_STORAGE_ASC_MEDIUM_NOT_PRESENT         0x3A
+#define USB_MASS_STORAGE_ASC_WRITE_FAULT                0x03
+#define USB_MASS_STORAGE_ASC_UNRECOVERED_READ_ERROR     0x11
+
+// Logical block size exposed for storage that is byte addressed (EraseBeforeWrite flash)
+#define USB_MASS_STORAGE_FLASH_BLOCK_SIZE               512
+
+// Size of each of the two sector buffers used to overlap storage access with USB transfers
+#define USB_MASS_STORAGE_BUFFER_SIZE                    (4 * 1024)
+
+#define USB_MASS_STORAGE_STORAGE_TIMEOUT                1000
+#define USB_MASS_STORAGE_TRANSFER_TIMEOUT_US            2000000
+
+// A device that exposes storage over USB calls UsbMassStorage_Acquire from its <TARGET>_Startup_OnSoftResetDevice, once its
+// USB client descriptor lists the mass storage interface with the two bulk endpoints. UsbMassStorage_Process runs the
+// commands from thread context, never from an interrupt, and returns as soon as no CBW is waiting, so the device calls
+// it whenever the runtime is idle, ahead of the WFI in <TARGET>_Power_Sleep.
+TinyCLR_Result UsbMassStorage_Acquire(const TinyCLR_UsbClient_Controller* usbClientProvider, const TinyCLR_Storage_Controller* storageProvider, uint8_t writeEndpoint, uint8_t readEndpoint);
+TinyCLR_Result UsbMassStorage_Release();
+TinyCLR_Result UsbMassStorage_Process();
+TinyCLR_Result UsbMassStorage_GetGeometry(uint32_t& blockSize, uint32_t& blockCount, bool& writeProtected);
@@ -283,6 +283,32 @@ struct ARM9_MMU {
     static void    GenerateL1_Sections(uint32_t* baseOfTTBs, uint32_t mappedAddress, uint32_t physAddress, int32_t size, uint32_t AP, uint32_t domain, bool Cachable, bool Buffered, bool Xtended = false);
 };
 
+// C and B bits of a section, on the ARM926 C=0 B=1 is uncached with the write buffer merging the stores
+enum class AT91_MMU_CachePolicy : uint32_t {
+    Uncached = 0,
+    Buffered = 1,
+    WriteThrough = 2,
+    WriteBack = 3,
+};
+
+#ifndef AT91_MMU_SDRAM_CACHE_POLICY
+#define AT91_MMU_SDRAM_CACHE_POLICY AT91_MMU_CachePolicy::WriteBack
+#endif
+
+#ifndef AT91_MMU_SRAM_CACHE_POLICY
+#define AT91_MMU_SRAM_CACHE_POLICY AT91_MMU_CachePolicy::WriteBack
+#endif
+
+// SDRAM is mapped a second time at this address for the LCDC framebuffer and DMA buffers, it must not overlap
+// the RLP regions at 0xA0000000
+#ifndef AT91_MMU_SDRAM_UNCACHED_ALIAS
+#define AT91_MMU_SDRAM_UNCACHED_ALIAS 0x80000000
+#endif
+
+#ifndef AT91_MMU_SDRAM_UNCACHED_POLICY
+#define AT91_MMU_SDRAM_UNCACHED_POLICY AT91_MMU_CachePolicy::Buffered
+#endif
+
 void AT91_MMU_Initialize();
 void AT91_CPU_InvalidateTLBs();
 void AT91_CPU_EnableMMU(void* TTB);
@@ -300,6 +326,21 @@ template <typename T> void AT91_Cache_InvalidateAddress(T* address);
 size_t AT91_Cache_GetCachableAddress(size_t address);
 size_t AT91_Cache_GetUncachableAddress(size_t address);
 
+#define AT91_CACHE_LINE_SIZE 32
+
+void AT91_Cache_CleanRange(const void* address, size_t length);
+void AT91_Cache_InvalidateRange(void* address, size_t length);
+void AT91_Cache_CleanInvalidateRange(const void* address, size_t length);
+
+// transfer rates in KB/s
+struct AT91_Cache_Bandwidth {
+    uint32_t read;
+    uint32_t write;
+    uint32_t copy;
+};
+
+TinyCLR_Result AT91_Cache_MeasureBandwidth(void* buffer, size_t length, bool uncached, AT91_Cache_Bandwidth& bandwidth);
+
 // GPIO
 
 //////////////////////////////////////////////////////////////////////////////
@@ -577,6 +618,12 @@ TinyCLR_Result AT91_SdCard_GetDescriptor(const TinyCLR_Storage_Controller* self,
 
 TinyCLR_Result AT91_SdCard_Reset();
 
+//Signal Capture
+#define TARGET_SIGNAL_CAPTURE_SUPPORTED
+
+bool AT91_SignalCapture_IsPinSupported(uint32_t pin);
+TinyCLR_Result AT91_SignalCapture_Read(uint32_t pin, bool waitForInitialState, TinyCLR_Gpio_PinValue& initialState, uint32_t* timestamps, size_t& count, uint64_t timeoutMicroseconds, uint32_t& startTime, uint32_t& frequency);
+
 //SPI
 //////////////////////////////////////////////////////////////////////////////
 // AT91_SPI
@@ -610,6 +657,7 @@ struct AT91_SPI {
     /****/ volatile uint32_t SPI_SR;         // Status Register
     static const    uint32_t SPI_SR_RDRF = (0x1 << 0); // RDR full
     static const    uint32_t SPI_SR_TDRE = (0x1 << 1); // TDR empty
+    static const    uint32_t SPI_SR_OVRES = (0x1 << 3); // overrun error
     static const    uint32_t SPI_SR_RXBUFF = (0x1 << 6); // receive buffer full
     static const    uint32_t SPI_SR_TXBUFE = (0x1 << 7); // transmit buffer empty
     static const    uint32_t SPI_SR_NSSR = (0x1 << 8); // Slave mode control
@@ -638,6 +686,32 @@ struct AT91_SPI {
     /****/ volatile uint32_t SPI_CSR2;       // Chip Select Register 2
     /****/ volatile uint32_t SPI_CSR3;       // Chip Select Register 3
 
+    /****/ volatile uint32_t Reserved2[48];
+
+    /****/ volatile uint32_t SPI_RPR;        // Receive Pointer Register
+
+    /****/ volatile uint32_t SPI_RCR;        // Receive Counter Register
+
+    /****/ volatile uint32_t SPI_TPR;        // Transmit Pointer Register
+
+    /****/ volatile uint32_t SPI_TCR;        // Transmit Counter Register
+
+    /****/ volatile uint32_t SPI_RNPR;       // Receive Next Pointer Register
+
+    /****/ volatile uint32_t SPI_RNCR;       // Receive Next Counter Register
+
+    /****/ volatile uint32_t SPI_TNPR;       // Transmit Next Pointer Register
+
+    /****/ volatile uint32_t SPI_TNCR;       // Transmit Next Counter Register
+
+    /****/ volatile uint32_t SPI_PTCR;       // PDC Transfer Control Register
+    static const    uint32_t SPI_PTCR_RXTEN = (0x1 << 0); // Receiver Transfer Enable
+    static const    uint32_t SPI_PTCR_RXTDIS = (0x1 << 1); // Receiver Transfer Disable
+    static const    uint32_t SPI_PTCR_TXTEN = (0x1 << 8); // Transmitter Transfer Enable
+    static const    uint32_t SPI_PTCR_TXTDIS = (0x1 << 9); // Transmitter Transfer Disable
+
+    /****/ volatile uint32_t SPI_PTSR;       // PDC Transfer Status Register
+
     __inline static uint32_t ConvertClockRateToDivisor(uint32_t clockKHz) {
         uint32_t mckKHz = AT91_SYSTEM_PERIPHERAL_CLOCK_HZ / 1000;
         uint32_t divisor = mckKHz / clockKHz;
@@ -838,6 +912,10 @@ struct AT91_USART {
     /****/ volatile uint32_t US_TNCR;        // Transmit Next Counter Register
 
     /****/ volatile uint32_t US_PTCR;        // PDC Transfer Control Register
+    static const    uint32_t US_RXTEN = (0x1 << 0); // (PDC) Receiver Transfer Enable
+    static const    uint32_t US_RXTDIS = (0x1 << 1); // (PDC) Receiver Transfer Disable
+    static const    uint32_t US_TXTEN = (0x1 << 8); // (PDC) Transmitter Transfer Enable
+    static const    uint32_t US_TXTDIS = (0x1 << 9); // (PDC) Transmitter Transfer Disable
 
     /****/ volatile uint32_t US_PTSR;        // PDC Transfer Status Register
 };
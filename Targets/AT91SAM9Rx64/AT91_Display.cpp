@@ -640,7 +640,7 @@ bool AT91_Display_Initialize() {
     lcdc.LCDC_CTRSTCON = value;
     lcdc.LCDC_CTRSTVAL = 0xDA;
 
-    lcdc.LCDC_BA1 = (uint32_t)m_AT91_Display_VituralRam;
+    lcdc.LCDC_BA1 = (uint32_t)AT91_Cache_GetCachableAddress((size_t)m_AT91_Display_VituralRam);
     lcdc.LCDC_FRMCFG = (4 << 24) + (m_AT91_DisplayHeight * m_AT91_DisplayWidth * m_AT91_Display_BitsPerPixel >> 5);
 
     // Enable
@@ -1046,7 +1046,7 @@ TinyCLR_Result AT91_Display_Release(const TinyCLR_Display_Controller* self) {
         if (m_AT91_Display_VituralRam != nullptr) {
             auto memoryProvider = (const TinyCLR_Memory_Manager*)apiManager->FindDefault(apiManager, TinyCLR_Api_Type::MemoryManager);
 
-            memoryProvider->Free(memoryProvider, m_AT91_Display_VituralRam);
+            memoryProvider->Free(memoryProvider, (void*)AT91_Cache_GetCachableAddress((size_t)m_AT91_Display_VituralRam));
 
             m_AT91_Display_VituralRam = nullptr;
         }
@@ -1113,17 +1113,22 @@ TinyCLR_Result AT91_Display_SetConfiguration(const TinyCLR_Display_Controller* s
         auto memoryProvider = (const TinyCLR_Memory_Manager*)apiManager->FindDefault(apiManager, TinyCLR_Api_Type::MemoryManager);
 
         if (m_AT91_Display_VituralRam != nullptr) {
-            memoryProvider->Free(memoryProvider, m_AT91_Display_VituralRam);
+            memoryProvider->Free(memoryProvider, (void*)AT91_Cache_GetCachableAddress((size_t)m_AT91_Display_VituralRam));
 
             m_AT91_Display_VituralRam = nullptr;
         }
 
-        m_AT91_Display_VituralRam = (uint16_t*)((uint8_t*)memoryProvider->Allocate(memoryProvider, m_AT91_DisplayBufferSize));
+        auto frameBuffer = memoryProvider->Allocate(memoryProvider, m_AT91_DisplayBufferSize);
 
-        if (m_AT91_Display_VituralRam == nullptr) {
+        if (frameBuffer == nullptr) {
             return TinyCLR_Result::OutOfMemory;
         }
 
+        // the LCDC reads the framebuffer on its own, it is drawn through the uncached SDRAM alias so no write stays in the DCache
+        AT91_Cache_CleanInvalidateRange(frameBuffer, m_AT91_DisplayBufferSize);
+
+        m_AT91_Display_VituralRam = (uint16_t*)AT91_Cache_GetUncachableAddress((size_t)frameBuffer);
+
         if (displayEnablePins.number != PIN_NONE) {
             if (m_AT91_DisplayOutputEnableIsFixed) {
                 AT91_Gpio_EnableOutputPin(displayEnablePins.number, m_AT91_DisplayOutputEnablePolarity);
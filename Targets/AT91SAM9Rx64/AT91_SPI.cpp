@@ -13,11 +13,19 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include "AT91.h"
 
 #define DATA_BIT_LENGTH_16  16
 #define DATA_BIT_LENGTH_8   8
 
+// 8 bit transfers of at least this many bytes run on the DMA, the caller still waits for the end
+#ifndef AT91_SPI_DMA_THRESHOLD
+#define AT91_SPI_DMA_THRESHOLD 32
+#endif
+
+#define AT91_SPI_DMA_MAX_SEGMENT_SIZE (0xFFFF & ~(AT91_CACHE_LINE_SIZE - 1))
+
 static const AT91_Gpio_Pin spiMisoPins[] = AT91_SPI_MISO_PINS;
 static const AT91_Gpio_Pin spiMosiPins[] = AT91_SPI_MOSI_PINS;
 static const AT91_Gpio_Pin spiClkPins[] = AT91_SPI_SCLK_PINS;
@@ -46,6 +54,9 @@ struct SpiState {
     bool tableInitialized;
 
     uint16_t initializeCount;
+
+    uint8_t dmaMemory[2 * AT91_CACHE_LINE_SIZE];
+    uint8_t* dmaScratch;
 };
 
 static SpiState spiStates[TOTAL_SPI_CONTROLLERS];
@@ -141,10 +152,138 @@ bool AT91_Spi_Transaction_Stop(int32_t controllerIndex) {
     return true;
 }
 
+// The PDC of each SPI, polled for the end of every segment
+static void AT91_Spi_DmaEnable(int32_t controllerIndex) {
+    // the PDC is part of the SPI
+}
+
+static bool AT91_Spi_DmaIsAvailable(int32_t controllerIndex) {
+    return true;
+}
+
+static bool AT91_Spi_DmaTransferSegment(int32_t controllerIndex, const uint8_t* tx, bool txFixed, uint8_t* rx, size_t length) {
+    AT91_SPI &spi = AT91::SPI(controllerIndex);
+
+    // The PDC always increments, so a repeated byte is sent from the receive side filled with it beforehand. Every byte
+    // leaves before the one received at the same offset overwrites it.
+    if (txFixed) {
+        memset(rx, *tx, length);
+
+        AT91_Cache_CleanRange(rx, length);
+
+        tx = rx;
+    }
+
+    volatile uint32_t data = spi.SPI_RDR; // drop what is left from a polled transfer
+
+    data = spi.SPI_SR; // and its overrun
+
+    spi.SPI_PTCR = AT91_SPI::SPI_PTCR_RXTDIS | AT91_SPI::SPI_PTCR_TXTDIS;
+
+    // without a destination the receiver is left to overrun, nothing reads it before the next transfer drains it
+    if (rx != nullptr) {
+        spi.SPI_RPR = AT91_Cache_GetCachableAddress((size_t)rx);
+        spi.SPI_RCR = length;
+    }
+
+    spi.SPI_TPR = AT91_Cache_GetCachableAddress((size_t)tx);
+    spi.SPI_TCR = length;
+
+    spi.SPI_PTCR = (rx != nullptr ? AT91_SPI::SPI_PTCR_RXTEN : 0) | AT91_SPI::SPI_PTCR_TXTEN;
+
+    while (spi.SPI_TCR > 0 || (rx != nullptr && spi.SPI_RCR > 0));
+
+    while (!spi.TransmitBufferEmpty(spi));
+
+    spi.SPI_PTCR = AT91_SPI::SPI_PTCR_RXTDIS | AT91_SPI::SPI_PTCR_TXTDIS;
+
+    // the overrun is expected without a destination, with one it means the PDC lost a byte
+    auto status = spi.SPI_SR;
+
+    return rx == nullptr || (status & AT91_SPI::SPI_SR_OVRES) == 0;
+}
+
+// Sends max(writeLength, readLength) bytes like the polled path: the last written byte is repeated once the write
+// buffer runs out and received bytes past readLength are dropped. The transfer is cut where the source or destination
+// changes, the partial cache lines at both ends of the read buffer are received in the uncached scratch line.
+static bool AT91_Spi_DmaTransfer(int32_t controllerIndex, const uint8_t* writeBuffer, size_t writeLength, uint8_t* readBuffer, size_t readLength) {
+    static const uint8_t fillByte = 0xFF;
+
+    auto state = &spiStates[controllerIndex];
+    auto length = std::max(writeLength, readLength);
+    auto fill = writeLength > 0 ? &writeBuffer[writeLength - 1] : &fillByte;
+
+    if (writeLength > 0)
+        AT91_Cache_CleanRange(writeBuffer, writeLength);
+
+    size_t first = readLength;
+    size_t last = readLength;
+
+    if (readLength > 0) {
+        auto start = (size_t)readBuffer;
+        auto alignedStart = (start + AT91_CACHE_LINE_SIZE - 1) & ~(AT91_CACHE_LINE_SIZE - 1);
+        auto alignedEnd = (start + readLength) & ~(AT91_CACHE_LINE_SIZE - 1);
+
+        if (alignedEnd > alignedStart) {
+            first = alignedStart - start;
+            last = alignedEnd - start;
+
+            AT91_Cache_CleanInvalidateRange(readBuffer + first, last - first);
+        }
+    }
+
+    size_t position = 0;
+    auto success = true;
+
+    while (position < length && success) {
+        auto end = length;
+        auto direct = false;
+
+        if (position < writeLength)
+            end = std::min(end, writeLength);
+
+        if (position < readLength) {
+            end = std::min(end, readLength);
+
+            if (position < first) {
+                end = std::min(end, first);
+            }
+            else if (position < last) {
+                end = std::min(end, last);
+                direct = true;
+            }
+        }
+
+        auto size = end - position;
+        auto scratch = position < readLength && !direct;
+
+        size = std::min(size, static_cast<size_t>(scratch ? AT91_CACHE_LINE_SIZE : AT91_SPI_DMA_MAX_SEGMENT_SIZE));
+
+        auto tx = position < writeLength ? &writeBuffer[position] : fill;
+        auto rx = direct ? &readBuffer[position] : (scratch ? state->dmaScratch : nullptr);
+
+        success = AT91_Spi_DmaTransferSegment(controllerIndex, tx, position >= writeLength, rx, size);
+
+        if (scratch && success)
+            memcpy(&readBuffer[position], state->dmaScratch, size);
+
+        position += size;
+    }
+
+    if (last > first)
+        AT91_Cache_InvalidateRange(readBuffer + first, last - first);
+
+    return success;
+}
+
 bool AT91_Spi_Transaction_nWrite8_nRead8(int32_t controllerIndex) {
     uint8_t Data8;
     auto state = &spiStates[controllerIndex];
 
+    if (std::max(state->writeLength, state->readLength) >= AT91_SPI_DMA_THRESHOLD && AT91_Spi_DmaIsAvailable(controllerIndex)) {
+        return AT91_Spi_DmaTransfer(controllerIndex, state->writeBuffer, state->writeLength, state->readBuffer, state->readBuffer != nullptr ? state->readLength : 0);
+    }
+
     uint8_t* Write8 = state->writeBuffer;
     int32_t WriteCount = state->writeLength;
     uint8_t* Read8 = state->readBuffer;
@@ -222,19 +361,12 @@ TinyCLR_Result AT91_Spi_WriteRead(const TinyCLR_Spi_Controller* self, const uint
     state->writeBuffer = (uint8_t*)writeBuffer;
     state->writeLength = writeLength;
 
-    if (state->dataBitLength == DATA_BIT_LENGTH_16) {
-        if (!AT91_Spi_Transaction_nWrite16_nRead16(controllerIndex))
-            return TinyCLR_Result::InvalidOperation;
-    }
-    else {
-        if (!AT91_Spi_Transaction_nWrite8_nRead8(controllerIndex))
-            return TinyCLR_Result::InvalidOperation;
-    }
+    auto success = state->dataBitLength == DATA_BIT_LENGTH_16 ? AT91_Spi_Transaction_nWrite16_nRead16(controllerIndex) : AT91_Spi_Transaction_nWrite8_nRead8(controllerIndex);
 
-    if (!AT91_Spi_Transaction_Stop(controllerIndex))
+    // stop on failure too, a chip select left asserted would wedge the bus for the next device
+    if (!AT91_Spi_Transaction_Stop(controllerIndex) || !success)
         return TinyCLR_Result::InvalidOperation;
 
-
     return TinyCLR_Result::Success;
 }
 
@@ -251,16 +383,9 @@ TinyCLR_Result AT91_Spi_Read(const TinyCLR_Spi_Controller* self, uint8_t* buffer
     state->writeBuffer = nullptr;
     state->writeLength = 0;
 
-    if (state->dataBitLength == DATA_BIT_LENGTH_16) {
-        if (!AT91_Spi_Transaction_nWrite16_nRead16(controllerIndex))
-            return TinyCLR_Result::InvalidOperation;
-    }
-    else {
-        if (!AT91_Spi_Transaction_nWrite8_nRead8(controllerIndex))
-            return TinyCLR_Result::InvalidOperation;
-    }
+    auto success = state->dataBitLength == DATA_BIT_LENGTH_16 ? AT91_Spi_Transaction_nWrite16_nRead16(controllerIndex) : AT91_Spi_Transaction_nWrite8_nRead8(controllerIndex);
 
-    if (!AT91_Spi_Transaction_Stop(controllerIndex))
+    if (!AT91_Spi_Transaction_Stop(controllerIndex) || !success)
         return TinyCLR_Result::InvalidOperation;
 
     return TinyCLR_Result::Success;
@@ -279,16 +404,9 @@ TinyCLR_Result AT91_Spi_Write(const TinyCLR_Spi_Controller* self, const uint8_t*
     state->writeBuffer = (uint8_t*)buffer;
     state->writeLength = length;
 
-    if (state->dataBitLength == DATA_BIT_LENGTH_16) {
-        if (!AT91_Spi_Transaction_nWrite16_nRead16(controllerIndex))
-            return TinyCLR_Result::InvalidOperation;
-    }
-    else {
-        if (!AT91_Spi_Transaction_nWrite8_nRead8(controllerIndex))
-            return TinyCLR_Result::InvalidOperation;
-    }
+    auto success = state->dataBitLength == DATA_BIT_LENGTH_16 ? AT91_Spi_Transaction_nWrite16_nRead16(controllerIndex) : AT91_Spi_Transaction_nWrite8_nRead8(controllerIndex);
 
-    if (!AT91_Spi_Transaction_Stop(controllerIndex))
+    if (!AT91_Spi_Transaction_Stop(controllerIndex) || !success)
         return TinyCLR_Result::InvalidOperation;
 
     return TinyCLR_Result::Success;
@@ -435,6 +553,15 @@ TinyCLR_Result AT91_Spi_Acquire(const TinyCLR_Spi_Controller* self) {
         AT91_Gpio_ConfigurePin(clkPin, AT91_Gpio_Direction::Input, clkMode, AT91_Gpio_ResistorMode::Inactive);
         AT91_Gpio_ConfigurePin(misoPin, AT91_Gpio_Direction::Input, misoMode, AT91_Gpio_ResistorMode::Inactive);
         AT91_Gpio_ConfigurePin(mosiPin, AT91_Gpio_Direction::Input, mosiMode, AT91_Gpio_ResistorMode::Inactive);
+
+        // a whole cache line of the state, only ever used through the uncached alias
+        auto scratch = ((size_t)state->dmaMemory + AT91_CACHE_LINE_SIZE - 1) & ~(AT91_CACHE_LINE_SIZE - 1);
+
+        AT91_Cache_InvalidateRange((void*)scratch, AT91_CACHE_LINE_SIZE);
+
+        state->dmaScratch = (uint8_t*)AT91_Cache_GetUncachableAddress(scratch);
+
+        AT91_Spi_DmaEnable(controllerIndex);
     }
 
     state->initializeCount++;
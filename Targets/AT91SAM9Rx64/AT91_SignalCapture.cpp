@@ -0,0 +1,135 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "AT91.h"
+
+#ifdef INCLUDE_SIGNALS
+
+// TC channel n + 1 captures both edges of TIOA into RA, TC channel 0 is the system timer.
+// The TIOA pins differ between packages so the device lists them, e.g.
+// #define AT91_SIGNAL_CAPTURE_PINS { { PIN(x, y), PS(z) }, { PIN(x, y), PS(z) } }
+#define AT91_SIGNAL_CAPTURE_FIRST_TIMER 1
+#define AT91_SIGNAL_CAPTURE_CLOCK AT91_TC::TC_CLKS_TIMER_DIV3_CLOCK
+#define AT91_SIGNAL_CAPTURE_CLOCK_HZ (AT91_SYSTEM_PERIPHERAL_CLOCK_HZ / 32)
+#define AT91_SIGNAL_CAPTURE_COUNTER_BITS 16
+
+#ifdef AT91_SIGNAL_CAPTURE_PINS
+static const AT91_Gpio_Pin signalCapturePins[] = AT91_SIGNAL_CAPTURE_PINS;
+#endif
+
+static int32_t AT91_SignalCapture_GetChannel(uint32_t pin) {
+#ifdef AT91_SIGNAL_CAPTURE_PINS
+    for (auto i = 0; i < SIZEOF_ARRAY(signalCapturePins) && i + AT91_SIGNAL_CAPTURE_FIRST_TIMER < 3; i++)
+        if (signalCapturePins[i].number == pin)
+            return i;
+#endif
+
+    return -1;
+}
+
+bool AT91_SignalCapture_IsPinSupported(uint32_t pin) {
+    return AT91_SignalCapture_GetChannel(pin) >= 0;
+}
+
+TinyCLR_Result AT91_SignalCapture_Read(uint32_t pin, bool waitForInitialState, TinyCLR_Gpio_PinValue& initialState, uint32_t* timestamps, size_t& count, uint64_t timeoutMicroseconds, uint32_t& startTime, uint32_t& frequency) {
+#ifdef AT91_SIGNAL_CAPTURE_PINS
+    auto channel = AT91_SignalCapture_GetChannel(pin);
+
+    if (channel < 0)
+        return TinyCLR_Result::NotSupported;
+
+    if (timestamps == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    if (count == 0)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto timer = channel + AT91_SIGNAL_CAPTURE_FIRST_TIMER;
+    auto& tc = AT91::TIMER(timer);
+    auto& pmc = AT91::PMC();
+
+    pmc.PMC_PCER = (1 << (AT91C_ID_TC0 + timer));
+
+    if (tc.TC_SR & AT91_TC::TC_CLKSTA)
+        return TinyCLR_Result::SharingViolation;
+
+    // the pin was opened by the caller as a GPIO input, it is given back as one when done
+    AT91_Gpio_ConfigurePin(pin, AT91_Gpio_Direction::Input, signalCapturePins[channel].peripheralSelection, AT91_Gpio_ResistorMode::Inactive);
+
+    tc.TC_IDR = 0xFFFFFFFF;
+    tc.TC_CMR = AT91_SIGNAL_CAPTURE_CLOCK | AT91_TC::TC_LDRA_BOTH;
+
+    const uint64_t half = (1ULL << AT91_SIGNAL_CAPTURE_COUNTER_BITS) / 2;
+    uint64_t overflows = 0;
+
+    TinyCLR_Gpio_PinValue state;
+
+    {
+        DISABLE_INTERRUPTS_SCOPED(irq);
+
+        tc.TC_CCR = AT91_TC::TC_CLKEN | AT91_TC::TC_SWTRG;
+
+        volatile uint32_t sr = tc.TC_SR; // clear status
+
+        startTime = tc.TC_CV;
+        state = AT91_Gpio_ReadPin(pin) ? TinyCLR_Gpio_PinValue::High : TinyCLR_Gpio_PinValue::Low;
+    }
+
+    auto skip = waitForInitialState && state != initialState;
+    size_t captured = 0;
+    auto endTime = AT91_Time_GetCurrentProcessorTime() + timeoutMicroseconds * 10;
+
+    // reading TC_SR clears it, overflows are counted here to extend a narrow counter
+    while (captured < count && AT91_Time_GetCurrentProcessorTime() < endTime) {
+        uint32_t sr = tc.TC_SR;
+        auto extension = overflows;
+
+        if (sr & AT91_TC::TC_COVFS)
+            overflows++;
+
+        if (sr & AT91_TC::TC_LDRAS) {
+            uint32_t ra = tc.TC_RA;
+
+            // an edge latched right after the wrap belongs to the new period
+            if ((sr & AT91_TC::TC_COVFS) && ra < half)
+                extension = overflows;
+
+            auto timestamp = static_cast<uint32_t>((extension << AT91_SIGNAL_CAPTURE_COUNTER_BITS) + ra);
+
+            if (skip) {
+                // the first edge brought the pin into the requested state, measure from there
+                startTime = timestamp;
+                skip = false;
+            }
+            else {
+                timestamps[captured++] = timestamp;
+            }
+        }
+    }
+
+    tc.TC_CCR = AT91_TC::TC_CLKDIS;
+
+    if (!waitForInitialState)
+        initialState = state;
+
+    count = skip ? 0 : captured;
+    frequency = AT91_SIGNAL_CAPTURE_CLOCK_HZ;
+
+    return TinyCLR_Result::Success;
+#else
+    return TinyCLR_Result::NotSupported;
+#endif
+}
+
+#endif
@@ -21,6 +21,8 @@
 #include <TinyCLR.h>
 #include <Device.h>
 
+#include "../../Drivers/DmaAllocator/DmaAllocator.h"
+
 #define SIZEOF_ARRAY(arr) (sizeof(arr) / sizeof(arr[0]))
 #define CONCAT2(a, b) a##b
 #define CONCAT(a, b) CONCAT2(a, b)
@@ -67,6 +69,7 @@
 //
 #define AT91C_BASE_SYS          0xFFFFE600 // (SYS) Base Address
 #define AT91C_BASE_DMAC0        0xFFFFEC00 // Hydra original address 0xFFFFE600 // (DMAC)Address                        - Not same Memory Address
+#define AT91C_BASE_DMAC1        0xFFFFEE00 // (DMAC1) Base Address
 #define AT91C_BASE_DDRS         0xFFFFE800 // (DDRS) Address
 #define AT91C_BASE_SDRAMC       0xFFFFEA00 // (SDRAMC) Base Address
 #define AT91C_BASE_SMC          0xFFFFEC00 // (SMC) Base Address
@@ -280,6 +283,32 @@ struct ARM9_MMU {
     static void    GenerateL1_Sections(uint32_t* baseOfTTBs, uint32_t mappedAddress, uint32_t physAddress, int32_t size, uint32_t AP, uint32_t domain, bool Cachable, bool Buffered, bool Xtended = false);
 };
 
+// C and B bits of a section, on the ARM926 C=0 B=1 is uncached with the write buffer merging the stores
+enum class AT91_MMU_CachePolicy : uint32_t {
+    Uncached = 0,
+    Buffered = 1,
+    WriteThrough = 2,
+    WriteBack = 3,
+};
+
+#ifndef AT91_MMU_SDRAM_CACHE_POLICY
+#define AT91_MMU_SDRAM_CACHE_POLICY AT91_MMU_CachePolicy::WriteBack
+#endif
+
+#ifndef AT91_MMU_SRAM_CACHE_POLICY
+#define AT91_MMU_SRAM_CACHE_POLICY AT91_MMU_CachePolicy::WriteBack
+#endif
+
+// SDRAM is mapped a second time at this address for the LCDC framebuffer and DMA buffers, it must not overlap
+// the RLP regions at 0xA0000000
+#ifndef AT91_MMU_SDRAM_UNCACHED_ALIAS
+#define AT91_MMU_SDRAM_UNCACHED_ALIAS 0x80000000
+#endif
+
+#ifndef AT91_MMU_SDRAM_UNCACHED_POLICY
+#define AT91_MMU_SDRAM_UNCACHED_POLICY AT91_MMU_CachePolicy::Buffered
+#endif
+
 void AT91_MMU_Initialize();
 void AT91_CPU_InvalidateTLBs();
 void AT91_CPU_EnableMMU(void* TTB);
@@ -297,6 +326,21 @@ template <typename T> void AT91_Cache_InvalidateAddress(T* address);
 size_t AT91_Cache_GetCachableAddress(size_t address);
 size_t AT91_Cache_GetUncachableAddress(size_t address);
 
+#define AT91_CACHE_LINE_SIZE 32
+
+void AT91_Cache_CleanRange(const void* address, size_t length);
+void AT91_Cache_InvalidateRange(void* address, size_t length);
+void AT91_Cache_CleanInvalidateRange(const void* address, size_t length);
+
+// transfer rates in KB/s
+struct AT91_Cache_Bandwidth {
+    uint32_t read;
+    uint32_t write;
+    uint32_t copy;
+};
+
+TinyCLR_Result AT91_Cache_MeasureBandwidth(void* buffer, size_t length, bool uncached, AT91_Cache_Bandwidth& bandwidth);
+
 // GPIO
 
 //////////////////////////////////////////////////////////////////////////////
@@ -687,6 +731,12 @@ TinyCLR_Result AT91_SdCard_Close(const TinyCLR_Storage_Controller* self);
 
 TinyCLR_Result AT91_SdCard_Reset();
 
+//Signal Capture
+#define TARGET_SIGNAL_CAPTURE_SUPPORTED
+
+bool AT91_SignalCapture_IsPinSupported(uint32_t pin);
+TinyCLR_Result AT91_SignalCapture_Read(uint32_t pin, bool waitForInitialState, TinyCLR_Gpio_PinValue& initialState, uint32_t* timestamps, size_t& count, uint64_t timeoutMicroseconds, uint32_t& startTime, uint32_t& frequency);
+
 //SPI
 //////////////////////////////////////////////////////////////////////////////
 // AT91_SPI
@@ -1007,6 +1057,126 @@ TinyCLR_Result AT91_Deployment_SetPresenceChangedHandler(const TinyCLR_Storage_C
 TinyCLR_Result AT91_Deployment_Open(const TinyCLR_Storage_Controller* self);
 TinyCLR_Result AT91_Deployment_Close(const TinyCLR_Storage_Controller* self);
 
+// DMA
+//////////////////////////////////////////////////////////////////////////////
+// AT91_DMAC
+//
+struct AT91_DMAC_Channel {
+    volatile uint32_t DMAC_SADDR;     // Source Address Register
+
+    volatile uint32_t DMAC_DADDR;     // Destination Address Register
+
+    volatile uint32_t DMAC_DSCR;      // Descriptor Address Register
+
+    volatile uint32_t DMAC_CTRLA;     // Control A Register
+    static const    uint32_t DMAC_BTSIZE = (0xFFFF << 0); // Buffer Transfer Size
+    static const    uint32_t DMAC_SRC_WIDTH_BYTE = (0x0 << 24); // Source Single Transfer Size
+    static const    uint32_t DMAC_SRC_WIDTH_WORD = (0x2 << 24);
+    static const    uint32_t DMAC_DST_WIDTH_BYTE = (0x0 << 28); // Destination Single Transfer Size
+    static const    uint32_t DMAC_DST_WIDTH_WORD = (0x2 << 28);
+    static const    uint32_t DMAC_DONE = ((uint32_t)0x1 << 31); // Current Descriptor Done
+
+    volatile uint32_t DMAC_CTRLB;     // Control B Register
+    static const    uint32_t DMAC_SRC_DSCR = (0x1 << 16); // Source Buffer Descriptor Fetch Disable
+    static const    uint32_t DMAC_DST_DSCR = (0x1 << 20); // Destination Buffer Descriptor Fetch Disable
+    static const    uint32_t DMAC_FC_MEM2MEM = (0x0 << 21); // Flow Control
+    static const    uint32_t DMAC_FC_MEM2PER = (0x1 << 21);
+    static const    uint32_t DMAC_FC_PER2MEM = (0x2 << 21);
+    static const    uint32_t DMAC_SRC_INCR_FIXED = (0x2 << 24); // Source Address Incremental Type, incrementing when 0
+    static const    uint32_t DMAC_DST_INCR_FIXED = (0x2 << 28); // Destination Address Incremental Type, incrementing when 0
+    static const    uint32_t DMAC_IEN = (0x1 << 30); // Buffer Transfer Completed Interrupt Disable (active low)
+
+    volatile uint32_t DMAC_CFG;       // Configuration Register
+    static const    uint32_t DMAC_SRC_PER_Pos = 0; // Source Hardware Handshaking Interface
+    static const    uint32_t DMAC_DST_PER_Pos = 4; // Destination Hardware Handshaking Interface
+    static const    uint32_t DMAC_SRC_H2SEL = (0x1 << 9); // Source Hardware Handshaking
+    static const    uint32_t DMAC_DST_H2SEL = (0x1 << 13); // Destination Hardware Handshaking
+    static const    uint32_t DMAC_SOD = (0x1 << 16); // Stop On Done
+    static const    uint32_t DMAC_FIFOCFG_ASAP = (0x2 << 28); // Transfer as soon as a single AHB access fits
+
+    volatile uint32_t DMAC_SPIP;      // Source Picture-in-Picture Configuration Register
+
+    volatile uint32_t DMAC_DPIP;      // Destination Picture-in-Picture Configuration Register
+
+    volatile uint32_t Reserved[2];
+};
+
+struct AT91_DMAC {
+    static const uint32_t c_Base0 = AT91C_BASE_DMAC0;
+    static const uint32_t c_Base1 = AT91C_BASE_DMAC1;
+
+    static const uint32_t c_ChannelCount = 8;
+
+    volatile uint32_t DMAC_GCFG;      // Global Configuration Register
+
+    volatile uint32_t DMAC_EN;        // Enable Register
+    static const    uint32_t DMAC_ENABLE = (0x1 << 0);
+
+    volatile uint32_t DMAC_SREQ;      // Software Single Request Register
+
+    volatile uint32_t DMAC_CREQ;      // Software Chunk Transfer Request Register
+
+    volatile uint32_t DMAC_LAST;      // Software Last Transfer Flag Register
+
+    volatile uint32_t Reserved0[1];
+
+    volatile uint32_t DMAC_EBCIER;    // Error, Buffer Transfer and Chained Buffer Transfer Interrupt Enable Register
+    static const    uint32_t DMAC_BTC_Pos = 0; // Buffer Transfer Completed, one bit per channel
+    static const    uint32_t DMAC_CBTC_Pos = 8; // Chained Buffer Transfer Completed, one bit per channel
+    static const    uint32_t DMAC_ERR_Pos = 16; // Access Error, one bit per channel
+
+    volatile uint32_t DMAC_EBCIDR;    // Error, Buffer Transfer and Chained Buffer Transfer Interrupt Disable Register
+
+    volatile uint32_t DMAC_EBCIMR;    // Error, Buffer Transfer and Chained Buffer Transfer Interrupt Mask Register
+
+    volatile uint32_t DMAC_EBCISR;    // Error, Buffer Transfer and Chained Buffer Transfer Status Register, cleared on read
+
+    volatile uint32_t DMAC_CHER;      // Channel Handler Enable Register
+
+    volatile uint32_t DMAC_CHDR;      // Channel Handler Disable Register
+
+    volatile uint32_t DMAC_CHSR;      // Channel Handler Status Register
+
+    volatile uint32_t Reserved1[2];
+
+    AT91_DMAC_Channel DMAC_CH[c_ChannelCount];
+};
+
+// buffer descriptor fetched by a channel in linked list mode, it must be word aligned and visible to the DMAC
+struct AT91_DMAC_Descriptor {
+    uint32_t SADDR;
+    uint32_t DADDR;
+    uint32_t CTRLA;
+    uint32_t CTRLB;
+    uint32_t DSCR;
+};
+
+// DMA
+// Channels are numbered controller * 8 + channel. A peripheral's handshake interface only exists on one controller,
+// so a request names that controller's channels.
+#define AT91_DMA_CHANNEL_COUNT 16
+#define AT91_DMA_CHANNEL_NONE DMA_ALLOCATOR_CHANNEL_NONE
+#define AT91_DMA_DMAC0_CHANNELS 0x00FF
+#define AT91_DMA_DMAC1_CHANNELS 0xFF00
+
+enum class AT91_Dma_Event : uint8_t {
+    Completed,
+    Error
+};
+
+// Called from the DMAC interrupt at the end of every buffer that has its interrupt enabled in CTRLB, at the end of the
+// chain, and on an error
+typedef void(*AT91_Dma_EventHandler)(int32_t channel, AT91_Dma_Event event, void* param);
+
+int32_t AT91_Dma_AcquireChannel(uint32_t candidates, const void* owner);
+void AT91_Dma_ReleaseChannel(int32_t channel, const void* owner);
+TinyCLR_Result AT91_Dma_Start(int32_t channel, const AT91_DMAC_Descriptor* first, uint32_t cfg, AT91_Dma_EventHandler handler, void* param);
+void AT91_Dma_Stop(int32_t channel);
+bool AT91_Dma_IsBusy(int32_t channel);
+bool AT91_Dma_Wait(int32_t channel);
+uint32_t AT91_Dma_GetDestinationAddress(int32_t channel);
+const DmaAllocator_Statistics* AT91_Dma_GetStatistics(int32_t channel);
+
 // Interrupt
 //////////////////////////////////////////////////////////////////////////////
 // AT91_AIC
@@ -1435,6 +1605,14 @@ TinyCLR_Result AT91_Display_DrawBuffer(const TinyCLR_Display_Controller* self, i
 TinyCLR_Result AT91_Display_DrawPixel(const TinyCLR_Display_Controller* self, uint32_t x, uint32_t y, uint64_t color);
 TinyCLR_Result AT91_Display_WriteString(const TinyCLR_Display_Controller* self, const char* buffer, size_t length);
 
+#define TARGET_DISPLAY_DOUBLE_BUFFER_SUPPORTED
+
+typedef void(*AT91_Display_FlipHandler)(const TinyCLR_Display_Controller* self, uint64_t timestamp);
+
+TinyCLR_Result AT91_Display_SetDoubleBuffering(const TinyCLR_Display_Controller* self, bool enable);
+TinyCLR_Result AT91_Display_WaitForFlip(const TinyCLR_Display_Controller* self);
+TinyCLR_Result AT91_Display_SetFlipHandler(const TinyCLR_Display_Controller* self, AT91_Display_FlipHandler handler);
+
 //WatchDog
 //////////////////////////////////////////////////////////////////////////////
 // WATCHDOG
@@ -1500,6 +1678,7 @@ struct AT91 {
     }
 
     static AT91_TC      & TIMER(int sel) { return *(AT91_TC*)(size_t)(AT91_TC::c_Base + (sel * 0x40)); }
+    static AT91_DMAC    & DMAC(int sel) { return *(AT91_DMAC    *)(size_t)(sel == 0 ? AT91_DMAC::c_Base0 : AT91_DMAC::c_Base1); }
     static AT91_WATCHDOG& WTDG() { return *(AT91_WATCHDOG*)(size_t)(AT91_WATCHDOG::c_Base); }
     //***************************************************************************************************************************************************************************************************************
     static AT91_USART   & USART(int sel) {
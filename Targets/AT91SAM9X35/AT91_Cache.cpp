@@ -15,23 +15,29 @@
 
 #include "AT91.h"
 
+extern "C" {
+    extern uint32_t Load$$SDRAM$$Base;
+    extern uint32_t Image$$SDRAM$$Length;
+}
+
+// with write-back sections the DCache can hold the only copy of the data, it is cleaned before being invalidated
 void AT91_Cache_FlushCaches() {
     uint32_t reg = 0;
 #ifdef __GNUC__
-    asm("MCR p15, 0, %0, c7,  c6, 0" :: "r" (reg));
+    asm volatile("1: MRC p15, 0, r15, c7, c14, 3\n\t"
+                 "BNE 1b" ::: "cc", "memory");
     asm("MCR p15, 0, %0, c7, c10, 4" :: "r" (reg));
     asm("MCR p15, 0, %0, c7,  c5, 0" :: "r" (reg));
 #else
     __asm
     {
-        mcr p15, 0, reg, c7, c6, 0 // invalidate DCache (Write through)
+    tci_loop:
+        mrc p15, 0, pc, c7, c14, 3 // test, clean & invalidate DCache
+        bne tci_loop
         mcr p15, 0, reg, c7, c10, 4 // Drain write buffer
         mcr p15, 0, reg, c7, c5, 0 // invalidate Icache
     }
 #endif
-    //  tci_loop:
-    //  mrc p15, 0, pc, c7, c14, 3 // test clean & invalidate DCache
-    //  bne tci_loop
 }
 
 void AT91_Cache_DrainWriteBuffers() {
@@ -123,13 +129,187 @@ template <typename T> void AT91_Cache_InvalidateAddress(T* address) {
 
 //--//
 
+static bool AT91_Cache_IsSdram(size_t address) {
+    return address >= (size_t)&Load$$SDRAM$$Base && address - (size_t)&Load$$SDRAM$$Base < (size_t)&Image$$SDRAM$$Length;
+}
+
+static bool AT91_Cache_IsUncachedAlias(size_t address) {
+    return address >= AT91_MMU_SDRAM_UNCACHED_ALIAS && address - AT91_MMU_SDRAM_UNCACHED_ALIAS < (size_t)&Image$$SDRAM$$Length;
+}
+
+// the direct SDRAM mapping is also the physical address, that is the one to give to a bus master
 size_t AT91_Cache_GetCachableAddress(size_t address) {
+    if (AT91_Cache_IsUncachedAlias(address))
+        return address - AT91_MMU_SDRAM_UNCACHED_ALIAS + (size_t)&Load$$SDRAM$$Base;
+
     return address;
 }
 
 //--//
 
 size_t AT91_Cache_GetUncachableAddress(size_t address) {
+    if (AT91_Cache_IsSdram(address))
+        return address - (size_t)&Load$$SDRAM$$Base + AT91_MMU_SDRAM_UNCACHED_ALIAS;
+
     return address;
 }
 
+//--//
+
+static void AT91_Cache_CleanLine(uint32_t line) {
+#ifdef __GNUC__
+    asm volatile("MCR p15, 0, %0, c7, c10, 1" :: "r" (line) : "memory");
+#else
+    __asm
+    {
+        mcr     p15, 0, line, c7, c10, 1        // Clean DCache line.
+    }
+#endif
+}
+
+static void AT91_Cache_InvalidateLine(uint32_t line) {
+#ifdef __GNUC__
+    asm volatile("MCR p15, 0, %0, c7, c6, 1" :: "r" (line) : "memory");
+#else
+    __asm
+    {
+        mcr     p15, 0, line, c7, c6, 1        // Invalidate DCache line.
+    }
+#endif
+}
+
+static void AT91_Cache_CleanInvalidateLine(uint32_t line) {
+#ifdef __GNUC__
+    asm volatile("MCR p15, 0, %0, c7, c14, 1" :: "r" (line) : "memory");
+#else
+    __asm
+    {
+        mcr     p15, 0, line, c7, c14, 1        // Clean and invalidate DCache line.
+    }
+#endif
+}
+
+// before a bus master reads memory the CPU wrote through a cached mapping
+void AT91_Cache_CleanRange(const void* address, size_t length) {
+    auto end = reinterpret_cast<uint32_t>(address) + length;
+
+    for (auto line = reinterpret_cast<uint32_t>(address) & ~(AT91_CACHE_LINE_SIZE - 1); line < end; line += AT91_CACHE_LINE_SIZE)
+        AT91_Cache_CleanLine(line);
+
+    AT91_Cache_DrainWriteBuffers();
+}
+
+// after a bus master wrote memory the CPU reads through a cached mapping. Lines only partly inside the range can
+// hold data of their neighbours, they are cleaned too instead of being dropped.
+void AT91_Cache_InvalidateRange(void* address, size_t length) {
+    auto start = reinterpret_cast<uint32_t>(address);
+    auto end = start + length;
+
+    if (length == 0)
+        return;
+
+    if (start & (AT91_CACHE_LINE_SIZE - 1)) {
+        AT91_Cache_CleanInvalidateLine(start & ~(AT91_CACHE_LINE_SIZE - 1));
+
+        start = (start & ~(AT91_CACHE_LINE_SIZE - 1)) + AT91_CACHE_LINE_SIZE;
+    }
+
+    if (end & (AT91_CACHE_LINE_SIZE - 1)) {
+        end &= ~(AT91_CACHE_LINE_SIZE - 1);
+
+        if (end >= start)
+            AT91_Cache_CleanInvalidateLine(end);
+    }
+
+    for (auto line = start; line < end; line += AT91_CACHE_LINE_SIZE)
+        AT91_Cache_InvalidateLine(line);
+
+    AT91_Cache_DrainWriteBuffers();
+}
+
+// before memory written through a cached mapping is handed over to a bus master or used through the uncached alias
+void AT91_Cache_CleanInvalidateRange(const void* address, size_t length) {
+    auto end = reinterpret_cast<uint32_t>(address) + length;
+
+    for (auto line = reinterpret_cast<uint32_t>(address) & ~(AT91_CACHE_LINE_SIZE - 1); line < end; line += AT91_CACHE_LINE_SIZE)
+        AT91_Cache_CleanInvalidateLine(line);
+
+    AT91_Cache_DrainWriteBuffers();
+}
+
+//--//
+
+static uint32_t AT91_Cache_GetBandwidth(size_t length, uint64_t start) {
+    auto duration = AT91_Time_GetCurrentProcessorTime() - start;
+
+    if (duration == 0)
+        duration = 1;
+
+    // processor time is in 100ns units
+    return static_cast<uint32_t>((static_cast<uint64_t>(length) * 10000000 / 1024) / duration);
+}
+
+// Writes, reads and copies the buffer word by word through the direct SDRAM mapping or through the uncached alias.
+// The buffer must be in SDRAM and its content is lost, the copy goes from its first half to the second one. The
+// write back of the dirty lines is included in the cached write and copy.
+TinyCLR_Result AT91_Cache_MeasureBandwidth(void* buffer, size_t length, bool uncached, AT91_Cache_Bandwidth& bandwidth) {
+    if (buffer == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    auto address = AT91_Cache_GetCachableAddress(reinterpret_cast<size_t>(buffer));
+
+    length &= ~(2 * sizeof(uint32_t) - 1);
+
+    if (length < 2 * AT91_CACHE_LINE_SIZE)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    if (!AT91_Cache_IsSdram(address) || !AT91_Cache_IsSdram(address + length - 1))
+        return TinyCLR_Result::ArgumentInvalid;
+
+    // nothing from a previous use of the buffer may be written back in the middle of a measurement
+    AT91_Cache_CleanInvalidateRange(reinterpret_cast<void*>(address), length);
+
+    auto data = reinterpret_cast<volatile uint32_t*>(uncached ? AT91_Cache_GetUncachableAddress(address) : address);
+    auto words = length / sizeof(uint32_t);
+    auto half = words / 2;
+    uint32_t sum = 0;
+
+    auto start = AT91_Time_GetCurrentProcessorTime();
+
+    for (auto i = 0; i < words; i++)
+        data[i] = i;
+
+    if (!uncached)
+        AT91_Cache_CleanRange(reinterpret_cast<void*>(address), length);
+    else
+        AT91_Cache_DrainWriteBuffers();
+
+    bandwidth.write = AT91_Cache_GetBandwidth(length, start);
+
+    AT91_Cache_CleanInvalidateRange(reinterpret_cast<void*>(address), length);
+
+    start = AT91_Time_GetCurrentProcessorTime();
+
+    for (auto i = 0; i < words; i++)
+        sum += data[i];
+
+    bandwidth.read = AT91_Cache_GetBandwidth(length, start);
+
+    AT91_Cache_CleanInvalidateRange(reinterpret_cast<void*>(address), length);
+
+    start = AT91_Time_GetCurrentProcessorTime();
+
+    for (auto i = 0; i < half; i++)
+        data[half + i] = data[i];
+
+    if (!uncached)
+        AT91_Cache_CleanRange(reinterpret_cast<void*>(address), length);
+    else
+        AT91_Cache_DrainWriteBuffers();
+
+    bandwidth.copy = AT91_Cache_GetBandwidth(half * sizeof(uint32_t), start);
+
+    AT91_Cache_CleanInvalidateRange(reinterpret_cast<void*>(address), length);
+
+    return sum == static_cast<uint32_t>(static_cast<uint64_t>(words) * (words - 1) / 2) ? TinyCLR_Result::Success : TinyCLR_Result::InvalidOperation;
+}
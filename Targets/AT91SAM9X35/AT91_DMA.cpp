@@ -0,0 +1,326 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "AT91.h"
+
+// The channels of DMAC0 and DMAC1 are handed out to the drivers that need them (SD, SPI, UART...) through the shared
+// allocator. A controller is clocked and has its interrupt on while any of its channels is held. Reading EBCISR clears
+// it for all eight channels, so it is only ever read here and what belongs to a polled channel is kept for its Wait.
+#define AT91_DMA_CHANNELS_PER_CONTROLLER 8
+#define AT91_DMA_CONTROLLER_COUNT 2
+
+#define AT91_DMA_CTRLA_SRC_WIDTH_Pos 24
+#define AT91_DMA_CTRLA_WIDTH_MASK 0x3
+
+// Bounds the walk over a descriptor list when counting bytes, a ring is never followed to its end
+#define AT91_DMA_MAX_DESCRIPTORS 64
+
+struct DmaChannelState {
+    AT91_Dma_EventHandler handler;
+    void* param;
+
+    AT91_DMAC_Descriptor first;
+    const AT91_DMAC_Descriptor* current; // first buffer not counted in the statistics yet
+};
+
+struct DmaState {
+    DmaAllocator allocator;
+    DmaChannelState channels[AT91_DMA_CHANNEL_COUNT];
+
+    uint32_t status[AT91_DMA_CONTROLLER_COUNT]; // EBCISR bits read but not handled yet
+};
+
+static DmaState dmaState;
+
+static const uint32_t dmaControllerIds[] = { AT91C_ID_DMAC0, AT91C_ID_DMAC1 };
+static const uint32_t dmaControllerIndexes[] = { 0, 1 };
+
+static uint32_t AT91_Dma_GetChannelMask(int32_t channel) {
+    auto index = channel % AT91_DMA_CHANNELS_PER_CONTROLLER;
+
+    return (1 << (AT91_DMAC::DMAC_BTC_Pos + index)) | (1 << (AT91_DMAC::DMAC_CBTC_Pos + index)) | (1 << (AT91_DMAC::DMAC_ERR_Pos + index));
+}
+
+static uint32_t AT91_Dma_ReadStatus(uint32_t controller) {
+    dmaState.status[controller] |= AT91::DMAC(controller).DMAC_EBCISR;
+
+    return dmaState.status[controller];
+}
+
+// Adds up the buffers from current to the next one that raises its interrupt (or to the end of the list) and moves
+// current past them. Descriptors are read through the uncached alias, the DMAC fetched them from memory.
+static size_t AT91_Dma_CountDescriptors(DmaChannelState* channelState, bool toEnd) {
+    size_t bytes = 0;
+
+    for (auto i = 0; i < AT91_DMA_MAX_DESCRIPTORS && channelState->current != nullptr; i++) {
+        auto descriptor = channelState->current;
+
+        bytes += (descriptor->CTRLA & AT91_DMAC_Channel::DMAC_BTSIZE) << ((descriptor->CTRLA >> AT91_DMA_CTRLA_SRC_WIDTH_Pos) & AT91_DMA_CTRLA_WIDTH_MASK);
+
+        channelState->current = descriptor->DSCR != 0 ? reinterpret_cast<const AT91_DMAC_Descriptor*>(AT91_Cache_GetUncachableAddress(descriptor->DSCR)) : nullptr;
+
+        if (!toEnd && !(descriptor->CTRLB & AT91_DMAC_Channel::DMAC_IEN))
+            break;
+    }
+
+    return bytes;
+}
+
+void AT91_Dma_InterruptHandler(void* param) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    auto state = &dmaState;
+    auto controller = *reinterpret_cast<const uint32_t*>(param);
+
+    // only channels started with a handler have their interrupts unmasked
+    auto status = AT91_Dma_ReadStatus(controller) & AT91::DMAC(controller).DMAC_EBCIMR;
+
+    for (auto index = 0; index < AT91_DMA_CHANNELS_PER_CONTROLLER; index++) {
+        auto channel = controller * AT91_DMA_CHANNELS_PER_CONTROLLER + index;
+        auto channelState = &state->channels[channel];
+        auto bits = status & AT91_Dma_GetChannelMask(channel);
+
+        if (bits == 0)
+            continue;
+
+        state->status[controller] &= ~bits;
+
+        if (bits & (1 << (AT91_DMAC::DMAC_ERR_Pos + index))) {
+            DmaAllocator_RecordError(&state->allocator, channel);
+
+            if (channelState->handler != nullptr)
+                channelState->handler(channel, AT91_Dma_Event::Error, channelState->param);
+        }
+        else {
+            DmaAllocator_RecordTransfer(&state->allocator, channel, AT91_Dma_CountDescriptors(channelState, false));
+
+            if (channelState->handler != nullptr)
+                channelState->handler(channel, AT91_Dma_Event::Completed, channelState->param);
+        }
+    }
+}
+
+int32_t AT91_Dma_AcquireChannel(uint32_t candidates, const void* owner) {
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    auto state = &dmaState;
+
+    if (state->allocator.channelCount == 0)
+        DmaAllocator_Initialize(&state->allocator, AT91_DMA_CHANNEL_COUNT);
+
+    auto channel = DmaAllocator_Acquire(&state->allocator, candidates, owner);
+
+    if (channel == AT91_DMA_CHANNEL_NONE)
+        return AT91_DMA_CHANNEL_NONE;
+
+    auto controller = channel / AT91_DMA_CHANNELS_PER_CONTROLLER;
+    auto controllerChannels = (state->allocator.acquired >> (controller * AT91_DMA_CHANNELS_PER_CONTROLLER)) & 0xFF;
+
+    auto& dmac = AT91::DMAC(controller);
+
+    if (controllerChannels == (1 << (channel % AT91_DMA_CHANNELS_PER_CONTROLLER))) {
+        AT91_PMC &pmc = AT91::PMC();
+
+        pmc.EnablePeriphClock(dmaControllerIds[controller]);
+
+        dmac.DMAC_EN = AT91_DMAC::DMAC_ENABLE;
+
+        AT91_InterruptInternal_Activate(dmaControllerIds[controller], (uint32_t*)&AT91_Dma_InterruptHandler, (void*)&dmaControllerIndexes[controller]);
+    }
+
+    AT91_Dma_Stop(channel);
+
+    state->channels[channel].handler = nullptr;
+    state->channels[channel].param = nullptr;
+
+    return channel;
+}
+
+void AT91_Dma_ReleaseChannel(int32_t channel, const void* owner) {
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    auto state = &dmaState;
+
+    if (owner == nullptr || DmaAllocator_GetOwner(&state->allocator, channel) != owner)
+        return;
+
+    AT91_Dma_Stop(channel);
+
+    state->channels[channel].handler = nullptr;
+
+    DmaAllocator_Release(&state->allocator, channel, owner);
+
+    auto controller = channel / AT91_DMA_CHANNELS_PER_CONTROLLER;
+
+    if (((state->allocator.acquired >> (controller * AT91_DMA_CHANNELS_PER_CONTROLLER)) & 0xFF) == 0) {
+        AT91_PMC &pmc = AT91::PMC();
+
+        AT91_InterruptInternal_Deactivate(dmaControllerIds[controller]);
+
+        AT91::DMAC(controller).DMAC_EN = 0;
+
+        pmc.DisablePeriphClock(dmaControllerIds[controller]);
+
+        state->status[controller] = 0;
+    }
+}
+
+// cfg is the channel's DMAC_CFG (handshake interfaces, SOD, FIFO). A first descriptor without DSCR is a single buffer
+// and is loaded straight into the channel, it may be a local. Otherwise the channel fetches the whole list from memory
+// starting at first, which then has to stay valid, word aligned and seen by the DMAC until the transfer is stopped.
+TinyCLR_Result AT91_Dma_Start(int32_t channel, const AT91_DMAC_Descriptor* first, uint32_t cfg, AT91_Dma_EventHandler handler, void* param) {
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    auto state = &dmaState;
+
+    if (first == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    if (!DmaAllocator_IsAcquired(&state->allocator, channel))
+        return TinyCLR_Result::InvalidOperation;
+
+    auto controller = channel / AT91_DMA_CHANNELS_PER_CONTROLLER;
+    auto index = channel % AT91_DMA_CHANNELS_PER_CONTROLLER;
+
+    auto& dmac = AT91::DMAC(controller);
+    auto& ch = dmac.DMAC_CH[index];
+
+    if (dmac.DMAC_CHSR & (1 << index))
+        return TinyCLR_Result::Busy;
+
+    auto channelState = &state->channels[channel];
+
+    channelState->handler = handler;
+    channelState->param = param;
+    channelState->first = *first;
+    channelState->current = &channelState->first;
+
+    AT91_Dma_ReadStatus(controller);
+
+    state->status[controller] &= ~AT91_Dma_GetChannelMask(channel);
+
+    if (first->DSCR == 0) {
+        ch.DMAC_SADDR = first->SADDR;
+        ch.DMAC_DADDR = first->DADDR;
+        ch.DMAC_DSCR = 0;
+        ch.DMAC_CTRLA = first->CTRLA;
+        ch.DMAC_CTRLB = first->CTRLB | AT91_DMAC_Channel::DMAC_SRC_DSCR | AT91_DMAC_Channel::DMAC_DST_DSCR;
+    }
+    else {
+        AT91_Cache_DrainWriteBuffers();
+
+        ch.DMAC_CTRLB = 0;
+        ch.DMAC_DSCR = AT91_Cache_GetCachableAddress((size_t)first);
+    }
+
+    ch.DMAC_CFG = cfg;
+
+    if (handler != nullptr)
+        dmac.DMAC_EBCIER = AT91_Dma_GetChannelMask(channel);
+    else
+        dmac.DMAC_EBCIDR = AT91_Dma_GetChannelMask(channel);
+
+    dmac.DMAC_CHER = (1 << index);
+
+    return TinyCLR_Result::Success;
+}
+
+void AT91_Dma_Stop(int32_t channel) {
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    auto state = &dmaState;
+
+    if (!DmaAllocator_IsAcquired(&state->allocator, channel))
+        return;
+
+    auto controller = channel / AT91_DMA_CHANNELS_PER_CONTROLLER;
+    auto index = channel % AT91_DMA_CHANNELS_PER_CONTROLLER;
+
+    auto& dmac = AT91::DMAC(controller);
+
+    dmac.DMAC_EBCIDR = AT91_Dma_GetChannelMask(channel);
+    dmac.DMAC_CHDR = (1 << index);
+
+    while (dmac.DMAC_CHSR & (1 << index));
+
+    AT91_Dma_ReadStatus(controller);
+
+    state->status[controller] &= ~AT91_Dma_GetChannelMask(channel);
+    state->channels[channel].current = nullptr;
+}
+
+bool AT91_Dma_IsBusy(int32_t channel) {
+    if (!DmaAllocator_IsAcquired(&dmaState.allocator, channel))
+        return false;
+
+    return (AT91::DMAC(channel / AT91_DMA_CHANNELS_PER_CONTROLLER).DMAC_CHSR & (1 << (channel % AT91_DMA_CHANNELS_PER_CONTROLLER))) != 0;
+}
+
+// Polls a list to its end, a ring never ends and is stopped instead. Returns false when the controller reported an
+// access error, the channel is then disabled.
+bool AT91_Dma_Wait(int32_t channel) {
+    auto state = &dmaState;
+
+    if (!DmaAllocator_IsAcquired(&state->allocator, channel))
+        return false;
+
+    auto controller = channel / AT91_DMA_CHANNELS_PER_CONTROLLER;
+    auto index = channel % AT91_DMA_CHANNELS_PER_CONTROLLER;
+    auto error = static_cast<uint32_t>(1 << (AT91_DMAC::DMAC_ERR_Pos + index));
+
+    auto& dmac = AT91::DMAC(controller);
+
+    while (true) {
+        DISABLE_INTERRUPTS_SCOPED(irq);
+
+        if (!(dmac.DMAC_CHSR & (1 << index)) || (AT91_Dma_ReadStatus(controller) & error))
+            break;
+    }
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    auto channelState = &state->channels[channel];
+    auto failed = (AT91_Dma_ReadStatus(controller) & error) != 0;
+
+    if (failed) {
+        dmac.DMAC_CHDR = (1 << index);
+
+        while (dmac.DMAC_CHSR & (1 << index));
+
+        DmaAllocator_RecordError(&state->allocator, channel);
+    }
+    else if (channelState->current != nullptr) {
+        DmaAllocator_RecordTransfer(&state->allocator, channel, AT91_Dma_CountDescriptors(channelState, true));
+    }
+
+    channelState->current = nullptr;
+
+    state->status[controller] &= ~AT91_Dma_GetChannelMask(channel);
+
+    return !failed;
+}
+
+// where the channel is writing now, a ring receiver works out how far it got in the current buffer from this
+uint32_t AT91_Dma_GetDestinationAddress(int32_t channel) {
+    if (!DmaAllocator_IsAcquired(&dmaState.allocator, channel))
+        return 0;
+
+    return AT91::DMAC(channel / AT91_DMA_CHANNELS_PER_CONTROLLER).DMAC_CH[channel % AT91_DMA_CHANNELS_PER_CONTROLLER].DMAC_DADDR;
+}
+
+const DmaAllocator_Statistics* AT91_Dma_GetStatistics(int32_t channel) {
+    return DmaAllocator_GetStatistics(&dmaState.allocator, channel);
+}
@@ -234,6 +234,19 @@ struct AT91SAM9X35_LCDC {
 #define LCDC_LCDSR_DISPSTS (0x1u << 2) /**< \brief (LCDC_LCDSR) LCD Controller DISP Signal Status */
 #define LCDC_LCDSR_PWMSTS (0x1u << 3) /**< \brief (LCDC_LCDSR) LCD Controller PWM Signal Status */
 #define LCDC_LCDSR_SIPSTS (0x1u << 4) /**< \brief (LCDC_LCDSR) Synchronization In Progress */
+/* -------- LCDC_LCDIER : (LCDC Offset: 0x0000002C) LCD Controller Interrupt Enable Register -------- */
+#define LCDC_LCDIER_BASEIE (0x1u << 8) /**< \brief (LCDC_LCDIER) Base Layer Interrupt Enable */
+/* -------- LCDC_LCDIDR : (LCDC Offset: 0x00000030) LCD Controller Interrupt Disable Register -------- */
+#define LCDC_LCDIDR_BASEID (0x1u << 8) /**< \brief (LCDC_LCDIDR) Base Layer Interrupt Disable */
+/* -------- LCDC_LCDISR : (LCDC Offset: 0x00000038) LCD Controller Interrupt Status Register -------- */
+#define LCDC_LCDISR_BASE (0x1u << 8) /**< \brief (LCDC_LCDISR) Base Layer Raw Interrupt Status */
+/* -------- LCDC_BASECTRL : (LCDC Offset: 0x00000048) Base Layer Control Register -------- */
+#define LCDC_BASECTRL_DFETCH (0x1u << 0) /**< \brief (LCDC_BASECTRL) Transfer Descriptor Fetch Enable */
+#define LCDC_BASECTRL_DSCRIEN (0x1u << 3) /**< \brief (LCDC_BASECTRL) Descriptor Loaded Interrupt Enable */
+/* -------- LCDC_BASEIER : (LCDC Offset: 0x00000050) Base Layer Interrupt Enable Register -------- */
+#define LCDC_BASEIER_DSCR (0x1u << 3) /**< \brief (LCDC_BASEIER) Descriptor Interrupt Enable */
+/* -------- LCDC_BASEISR : (LCDC Offset: 0x0000005C) Base Layer Interrupt Status Register -------- */
+#define LCDC_BASEISR_DSCR (0x1u << 3) /**< \brief (LCDC_BASEISR) Transfer Descriptor Loaded */
 
 /** Frequency of the board main oscillator */
 #define BOARD_MAINOSC           12000000
@@ -734,6 +747,17 @@ uint32_t displayInitializeCount = 0;
 uint16_t* m_AT91_Display_VituralRam = nullptr;
 size_t m_AT91_DisplayBufferSize = 0;
 
+// With double buffering the controller scans m_AT91_Display_FrontRam while drawing goes to m_AT91_Display_VituralRam
+uint16_t* m_AT91_Display_FrontRam = nullptr;
+volatile bool m_AT91_Display_FlipPending = false;
+AT91_Display_FlipHandler m_AT91_Display_FlipHandler = nullptr;
+
+// Framebuffer rows drawn since the last flip, and the rows the back buffer has been missing since then
+int32_t m_AT91_Display_DirtyTop = 0;
+int32_t m_AT91_Display_DirtyBottom = 0;
+int32_t m_AT91_Display_StaleTop = 0;
+int32_t m_AT91_Display_StaleBottom = 0;
+
 uint8_t m_AT91_Display_TextBuffer[LCD_MAX_COLUMN][LCD_MAX_ROW];
 
 AT91_LCD_Rotation m_AT91_Display_CurrentRotation = AT91_LCD_Rotation::rotateNormal_0;
@@ -767,6 +791,139 @@ static TinyCLR_Api_Info displayApi[TOTAL_DISPLAY_CONTROLLERS];
 
 static Layer baseLayer;
 
+// the buffer the controller scans, the only one without double buffering
+static uint16_t* AT91_Display_GetScanoutBuffer() {
+    return m_AT91_Display_FrontRam != nullptr ? m_AT91_Display_FrontRam : m_AT91_Display_VituralRam;
+}
+
+static void AT91_Display_MarkDirtyRows(int32_t top, int32_t bottom) {
+    int32_t screenHeight = m_AT91_DisplayHeight;
+
+    if (m_AT91_Display_FrontRam == nullptr)
+        return;
+
+    if (top < 0)
+        top = 0;
+
+    if (bottom > screenHeight)
+        bottom = screenHeight;
+
+    if (top >= bottom)
+        return;
+
+    if (m_AT91_Display_DirtyTop >= m_AT91_Display_DirtyBottom) {
+        m_AT91_Display_DirtyTop = top;
+        m_AT91_Display_DirtyBottom = bottom;
+    }
+    else {
+        if (top < m_AT91_Display_DirtyTop)
+            m_AT91_Display_DirtyTop = top;
+
+        if (bottom > m_AT91_Display_DirtyBottom)
+            m_AT91_Display_DirtyBottom = bottom;
+    }
+}
+
+// Framebuffer rows covered by a rectangle of the rotated screen
+static void AT91_Display_MarkDirty(int32_t x, int32_t y, int32_t width, int32_t height) {
+    int32_t screenHeight = m_AT91_DisplayHeight;
+
+    switch (m_AT91_Display_CurrentRotation) {
+    case AT91_LCD_Rotation::rotateCCW_90:
+        AT91_Display_MarkDirtyRows(screenHeight - x - width, screenHeight - x);
+        break;
+
+    case AT91_LCD_Rotation::rotateCW_90:
+        AT91_Display_MarkDirtyRows(x, x + width);
+        break;
+
+    case AT91_LCD_Rotation::rotate_180:
+        AT91_Display_MarkDirtyRows(screenHeight - y - height, screenHeight - y);
+        break;
+
+    default:
+        AT91_Display_MarkDirtyRows(y, y + height);
+        break;
+    }
+}
+
+// The back buffer stays on screen until a pending flip is taken. After that it is brought up to date with the rows
+// drawn in the frame that was just presented.
+static void AT91_Display_BeginDraw() {
+    if (m_AT91_Display_FrontRam == nullptr)
+        return;
+
+    while (m_AT91_Display_FlipPending);
+
+    if (m_AT91_Display_StaleTop < m_AT91_Display_StaleBottom) {
+        auto offset = m_AT91_Display_StaleTop * m_AT91_DisplayWidth;
+
+        memcpy(m_AT91_Display_VituralRam + offset, m_AT91_Display_FrontRam + offset, (m_AT91_Display_StaleBottom - m_AT91_Display_StaleTop) * m_AT91_DisplayWidth * 2);
+
+        m_AT91_Display_StaleTop = 0;
+        m_AT91_Display_StaleBottom = 0;
+    }
+}
+
+static void AT91_Display_FlipCompleted() {
+    m_AT91_Display_FlipPending = false;
+
+    if (m_AT91_Display_FlipHandler != nullptr)
+        m_AT91_Display_FlipHandler(&displayControllers[0], AT91_Time_GetCurrentProcessorTime());
+}
+
+void AT91_Display_InterruptHandler(void* param) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    AT91SAM9X35_LCDC *lcd = (AT91SAM9X35_LCDC*)AT91C_BASE_LCDC;
+
+    // both status registers are cleared by reading them
+    auto status = lcd->LCDC_LCDISR;
+    auto baseStatus = lcd->LCDC_BASEISR;
+
+    if ((status & LCDC_LCDISR_BASE) && (baseStatus & LCDC_BASEISR_DSCR)) {
+        lcd->LCDC_LCDIDR = LCDC_LCDIDR_BASEID;
+
+        AT91_Display_FlipCompleted();
+    }
+}
+
+// The base layer fetches its descriptor again at the end of every frame, so the next fetch takes the new address and
+// raises the descriptor loaded interrupt. A fetch already flagged is cleared after the write, at worst the flip is
+// reported a frame late.
+static void AT91_Display_SetScanoutBuffer(uint16_t* buffer) {
+    AT91SAM9X35_LCDC *lcd = (AT91SAM9X35_LCDC*)AT91C_BASE_LCDC;
+    LCDCDescriptor *DMApointerForBase = &baseLayer.dmaD;
+
+    DMApointerForBase->addr = (uint32_t)AT91_Cache_GetCachableAddress((size_t)buffer);
+
+    AT91_Cache_CleanRange(DMApointerForBase, sizeof(LCDCDescriptor));
+
+    (void)lcd->LCDC_BASEISR;
+
+    lcd->LCDC_LCDIER = LCDC_LCDIER_BASEIE;
+}
+
+// Hands what was drawn to the controller for the next vertical blanking, drawing goes to the old front buffer from then on
+static void AT91_Display_Present() {
+    if (m_AT91_Display_FrontRam == nullptr || m_AT91_DisplayEnable == false || m_AT91_Display_DirtyTop >= m_AT91_Display_DirtyBottom)
+        return;
+
+    auto front = m_AT91_Display_VituralRam;
+
+    m_AT91_Display_VituralRam = m_AT91_Display_FrontRam;
+    m_AT91_Display_FrontRam = front;
+
+    m_AT91_Display_StaleTop = m_AT91_Display_DirtyTop;
+    m_AT91_Display_StaleBottom = m_AT91_Display_DirtyBottom;
+    m_AT91_Display_DirtyTop = 0;
+    m_AT91_Display_DirtyBottom = 0;
+
+    m_AT91_Display_FlipPending = true;
+
+    AT91_Display_SetScanoutBuffer(front);
+}
+
 void AT91_Display_SetBaseLayerDMA() {
     AT91SAM9X35_LCDC *lcd = (AT91SAM9X35_LCDC*)AT91C_BASE_LCDC;
 
@@ -783,12 +940,16 @@ void AT91_Display_SetBaseLayerDMA() {
     if (m_AT91_Display_VituralRam == nullptr)
         return;
 
-    DMApointerForBase->addr = (uint32_t)((uint32_t*)m_AT91_Display_VituralRam);
-    DMApointerForBase->ctrl = 0x1;
+    DMApointerForBase->addr = (uint32_t)AT91_Cache_GetCachableAddress((size_t)AT91_Display_GetScanoutBuffer());
+    DMApointerForBase->ctrl = LCDC_BASECTRL_DFETCH | LCDC_BASECTRL_DSCRIEN;
     DMApointerForBase->next = (uint32_t)DMApointerForBase;
 
+    // the LCDC fetches the descriptor from SDRAM
+    AT91_Cache_CleanRange(DMApointerForBase, sizeof(LCDCDescriptor));
+
     lcd->LCDC_BASEADDR = DMApointerForBase->addr;
-    lcd->LCDC_BASECTRL = 0x1;
+    lcd->LCDC_BASECTRL = DMApointerForBase->ctrl;
+    lcd->LCDC_BASEIER = LCDC_BASEIER_DSCR;
     lcd->LCDC_BASENEXT = (uint32_t)DMApointerForBase;
     lcd->LCDC_BASECFG4 = 0x100;
     lcd->LCDC_BASECHER = 0x3;
@@ -890,8 +1051,12 @@ bool AT91_Display_Uninitialize() {
 
     AT91SAM9X35_LCDC *lcd = (AT91SAM9X35_LCDC*)AT91C_BASE_LCDC;
 
+    lcd->LCDC_LCDIDR = LCDC_LCDIDR_BASEID;
     lcd->LCDC_LCDEN &= ~(LCDC_LCDEN_CLKEN | LCDC_LCDEN_PWMEN);
 
+    // the controller stops before taking a pending flip, the new buffer is scanned from the next initialization
+    m_AT91_Display_FlipPending = false;
+
     pmc.DisablePeriphClock(AT91C_ID_LCDC);
 
     m_AT91_DisplayEnable = false;
@@ -1034,7 +1199,11 @@ void AT91_Display_Clear() {
     if (m_AT91_DisplayEnable == false || m_AT91_Display_VituralRam == nullptr)
         return;
 
+    AT91_Display_BeginDraw();
+
     memset((uint32_t*)m_AT91_Display_VituralRam, 0, m_AT91_DisplayBufferSize);
+
+    AT91_Display_MarkDirtyRows(0, m_AT91_DisplayHeight);
 }
 
 bool AT91_Display_SetPinConfiguration(bool enable) {
@@ -1287,9 +1456,11 @@ TinyCLR_Result AT91_Display_Release(const TinyCLR_Display_Controller* self) {
         m_AT91_DisplayEnable = false;
 
         if (m_AT91_Display_VituralRam != nullptr) {
+            AT91_Display_SetDoubleBuffering(self, false);
+
             auto memoryProvider = (const TinyCLR_Memory_Manager*)apiManager->FindDefault(apiManager, TinyCLR_Api_Type::MemoryManager);
 
-            memoryProvider->Free(memoryProvider, m_AT91_Display_VituralRam);
+            memoryProvider->Free(memoryProvider, (void*)AT91_Cache_GetCachableAddress((size_t)m_AT91_Display_VituralRam));
 
             m_AT91_Display_VituralRam = nullptr;
         }
@@ -1356,17 +1527,24 @@ TinyCLR_Result AT91_Display_SetConfiguration(const TinyCLR_Display_Controller* s
         auto memoryProvider = (const TinyCLR_Memory_Manager*)apiManager->FindDefault(apiManager, TinyCLR_Api_Type::MemoryManager);
 
         if (m_AT91_Display_VituralRam != nullptr) {
-            memoryProvider->Free(memoryProvider, m_AT91_Display_VituralRam);
+            AT91_Display_SetDoubleBuffering(self, false);
+
+            memoryProvider->Free(memoryProvider, (void*)AT91_Cache_GetCachableAddress((size_t)m_AT91_Display_VituralRam));
 
             m_AT91_Display_VituralRam = nullptr;
         }
 
-        m_AT91_Display_VituralRam = (uint16_t*)((uint8_t*)memoryProvider->Allocate(memoryProvider, m_AT91_DisplayBufferSize));
+        auto frameBuffer = memoryProvider->Allocate(memoryProvider, m_AT91_DisplayBufferSize);
 
-        if (m_AT91_Display_VituralRam == nullptr) {
+        if (frameBuffer == nullptr) {
             return TinyCLR_Result::OutOfMemory;
         }
 
+        // the LCDC reads the framebuffer on its own, it is drawn through the uncached SDRAM alias so no write stays in the DCache
+        AT91_Cache_CleanInvalidateRange(frameBuffer, m_AT91_DisplayBufferSize);
+
+        m_AT91_Display_VituralRam = (uint16_t*)AT91_Cache_GetUncachableAddress((size_t)frameBuffer);
+
         if (displayEnablePins.number != PIN_NONE) {
             if (m_AT91_DisplayOutputEnableIsFixed) {
                 AT91_Gpio_EnableOutputPin(displayEnablePins.number, m_AT91_DisplayOutputEnablePolarity);
@@ -1413,7 +1591,13 @@ TinyCLR_Result AT91_Display_GetConfiguration(const TinyCLR_Display_Controller* s
 }
 
 TinyCLR_Result AT91_Display_DrawBuffer(const TinyCLR_Display_Controller* self, uint32_t x, uint32_t y, uint32_t width, uint32_t height, const uint8_t* data) {
+    AT91_Display_BeginDraw();
+
     AT91_Display_BitBltEx(x, y, width, height, (uint32_t*)data);
+
+    AT91_Display_MarkDirty(x, y, width, height);
+    AT91_Display_Present();
+
     return TinyCLR_Result::Success;
 }
 
@@ -1430,17 +1614,97 @@ TinyCLR_Result AT91_Display_DrawPixel(const TinyCLR_Display_Controller* self, ui
     if (y >= m_AT91_DisplayHeight)
         return TinyCLR_Result::InvalidOperation;
 
+    AT91_Display_BeginDraw();
+
     loc = m_AT91_Display_VituralRam + (y *m_AT91_DisplayWidth) + (x);
 
     *loc = rgb565;
 
+    AT91_Display_MarkDirtyRows(y, y + 1);
+
     return TinyCLR_Result::Success;
 }
 
 TinyCLR_Result AT91_Display_DrawString(const TinyCLR_Display_Controller* self, const char* data, size_t length) {
+    AT91_Display_BeginDraw();
+
     for (size_t i = 0; i < length; i++)
         AT91_Display_WriteFormattedChar(data[i]);
 
+    AT91_Display_MarkDirtyRows(0, m_AT91_DisplayHeight);
+    AT91_Display_Present();
+
+    return TinyCLR_Result::Success;
+}
+
+// A second framebuffer is drawn while the first one is on screen, DrawBuffer and DrawString flip them at the next
+// vertical blanking. The back buffer starts as a copy of the screen.
+TinyCLR_Result AT91_Display_SetDoubleBuffering(const TinyCLR_Display_Controller* self, bool enable) {
+    if (m_AT91_Display_VituralRam == nullptr)
+        return TinyCLR_Result::InvalidOperation;
+
+    if (enable == (m_AT91_Display_FrontRam != nullptr))
+        return TinyCLR_Result::Success;
+
+    auto memoryProvider = (const TinyCLR_Memory_Manager*)apiManager->FindDefault(apiManager, TinyCLR_Api_Type::MemoryManager);
+
+    if (enable) {
+        auto frameBuffer = memoryProvider->Allocate(memoryProvider, m_AT91_DisplayBufferSize);
+
+        if (frameBuffer == nullptr)
+            return TinyCLR_Result::OutOfMemory;
+
+        AT91_Cache_CleanInvalidateRange(frameBuffer, m_AT91_DisplayBufferSize);
+
+        auto back = (uint16_t*)AT91_Cache_GetUncachableAddress((size_t)frameBuffer);
+
+        memcpy(back, m_AT91_Display_VituralRam, m_AT91_DisplayBufferSize);
+
+        m_AT91_Display_FrontRam = m_AT91_Display_VituralRam;
+        m_AT91_Display_VituralRam = back;
+
+        m_AT91_Display_DirtyTop = m_AT91_Display_DirtyBottom = 0;
+        m_AT91_Display_StaleTop = m_AT91_Display_StaleBottom = 0;
+
+        AT91_InterruptInternal_Activate(AT91C_ID_LCDC, (uint32_t*)&AT91_Display_InterruptHandler, nullptr);
+    }
+    else {
+        while (m_AT91_Display_FlipPending);
+
+        AT91_Display_Present();
+
+        while (m_AT91_Display_FlipPending);
+
+        AT91_InterruptInternal_Deactivate(AT91C_ID_LCDC);
+
+        // the back buffer is only newer when it could not be presented because the display is off
+        if (m_AT91_Display_DirtyTop < m_AT91_Display_DirtyBottom) {
+            AT91_Display_BeginDraw();
+
+            memoryProvider->Free(memoryProvider, (void*)AT91_Cache_GetCachableAddress((size_t)m_AT91_Display_FrontRam));
+        }
+        else {
+            memoryProvider->Free(memoryProvider, (void*)AT91_Cache_GetCachableAddress((size_t)m_AT91_Display_VituralRam));
+
+            m_AT91_Display_VituralRam = m_AT91_Display_FrontRam;
+        }
+
+        m_AT91_Display_FrontRam = nullptr;
+    }
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result AT91_Display_WaitForFlip(const TinyCLR_Display_Controller* self) {
+    while (m_AT91_Display_FlipPending);
+
+    return TinyCLR_Result::Success;
+}
+
+// Called from the interrupt once the controller scans the newly presented buffer
+TinyCLR_Result AT91_Display_SetFlipHandler(const TinyCLR_Display_Controller* self, AT91_Display_FlipHandler handler) {
+    m_AT91_Display_FlipHandler = handler;
+
     return TinyCLR_Result::Success;
 }
 
@@ -199,11 +199,20 @@ static const uint32_t c_Bootstrap_Register_End = 0xFFFFFFFF;
 static const uint32_t c_RLP_Virtual_Address_Cached = 0xA0000000; // Added for RLP Support of Memory MMU
 static const uint32_t c_RLP_Virtual_Address_Uncached = 0xB0000000; // Added for RLP Support of Memory MMU
 
+static bool AT91_MMU_IsCachable(AT91_MMU_CachePolicy policy) {
+    return (static_cast<uint32_t>(policy) & 0x2) != 0;
+}
+
+static bool AT91_MMU_IsBuffered(AT91_MMU_CachePolicy policy) {
+    return (static_cast<uint32_t>(policy) & 0x1) != 0;
+}
+
 
 void AT91_MMU_Initialize() {
 
     uint32_t c_Bootstrap_SDRAM_Begin = ((uint32_t)&Load$$SDRAM$$Base);
-    uint32_t c_Bootstrap_SDRAM_End = c_Bootstrap_SDRAM_Begin + ((uint32_t)&Image$$SDRAM$$Length) - ARM9_MMU::c_TTB_size;
+    uint32_t c_Bootstrap_SDRAM_Size = ((uint32_t)&Image$$SDRAM$$Length);
+    uint32_t c_Bootstrap_SDRAM_End = c_Bootstrap_SDRAM_Begin + c_Bootstrap_SDRAM_Size - ARM9_MMU::c_TTB_size;
     uint32_t c_Bootstrap_SRAM_Begin = ((uint32_t)&Load$$SRAM$$Base);;
     uint32_t c_Bootstrap_SRAM_End = c_Bootstrap_SRAM_Begin + ((uint32_t)&Image$$SRAM$$Length);
     uint32_t* c_Bootstrap_BaseOfTTBs = (uint32_t*)(c_Bootstrap_SDRAM_End);
@@ -234,8 +243,20 @@ void AT91_MMU_Initialize() {
         c_Bootstrap_SDRAM_End - c_Bootstrap_SDRAM_Begin,        // length to be mapped
         ARM9_MMU::c_AP__Manager,                                // AP
         0,                                                      // Domain
-        true,                                                   // Cacheable
-        false,                                                  // Buffered
+        AT91_MMU_IsCachable(AT91_MMU_SDRAM_CACHE_POLICY),       // Cacheable
+        AT91_MMU_IsBuffered(AT91_MMU_SDRAM_CACHE_POLICY),       // Buffered
+        false);                                                 // Extended
+
+    // Alias of the whole SDRAM for memory shared with bus masters (uncachable)
+    ARM9_MMU::GenerateL1_Sections(
+        c_Bootstrap_BaseOfTTBs,                                 // base of TTBs
+        AT91_MMU_SDRAM_UNCACHED_ALIAS,                          // mapped address
+        c_Bootstrap_SDRAM_Begin,                                // physical address
+        c_Bootstrap_SDRAM_Size,                                 // length to be mapped
+        ARM9_MMU::c_AP__Manager,                                // AP
+        0,                                                      // Domain
+        AT91_MMU_IsCachable(AT91_MMU_SDRAM_UNCACHED_POLICY),    // Cacheable
+        AT91_MMU_IsBuffered(AT91_MMU_SDRAM_UNCACHED_POLICY),    // Buffered
         false);                                                 // Extended
 
 
@@ -247,8 +268,8 @@ void AT91_MMU_Initialize() {
         c_Bootstrap_SRAM_End - c_Bootstrap_SRAM_Begin,          // length to be mapped
         ARM9_MMU::c_AP__Manager,                                // AP
         0,                                                      // Domain
-        true,                                                   // Cacheable
-        false,                                                  // Buffered
+        AT91_MMU_IsCachable(AT91_MMU_SRAM_CACHE_POLICY),        // Cacheable
+        AT91_MMU_IsBuffered(AT91_MMU_SRAM_CACHE_POLICY),        // Buffered
         false);                                                 // Extended
 
     // Direct map SRAM (cachable)
@@ -259,8 +280,8 @@ void AT91_MMU_Initialize() {
         c_Bootstrap_SRAM_End - c_Bootstrap_SRAM_Begin,          // length to be mapped
         ARM9_MMU::c_AP__Manager,                                // AP
         0,                                                      // Domain
-        true,                                                   // Cacheable
-        false,                                                  // Buffered
+        AT91_MMU_IsCachable(AT91_MMU_SRAM_CACHE_POLICY),        // Cacheable
+        AT91_MMU_IsBuffered(AT91_MMU_SRAM_CACHE_POLICY),        // Buffered
         false);                                                 // Extended
 
     // Direct map for the LCD registers(0xF8038000)
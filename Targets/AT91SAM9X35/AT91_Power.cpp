@@ -112,6 +112,9 @@ TinyCLR_Result AT91_Power_Reset(const TinyCLR_Power_Controller* self, bool runCo
         //See section 1.9 of UM10211.pdf. A write-back buffer holds the last written value. Two writes guarantee it'll appear after a reset.
         *((volatile uint32_t*)RAM_BOOTLOADER_HOLD_ADDRESS) = RAM_BOOTLOADER_HOLD_VALUE;
         *((volatile uint32_t*)RAM_BOOTLOADER_HOLD_ADDRESS) = RAM_BOOTLOADER_HOLD_VALUE;
+
+        // SDRAM can be mapped write-back, the value must leave the DCache before the reset
+        AT91_Cache_CleanRange((const void*)RAM_BOOTLOADER_HOLD_ADDRESS, sizeof(uint32_t));
     }
 #endif
 
@@ -22,147 +22,88 @@
 #define TRANSFER_CMD_TIMEOUT 2000000
 
 // DMA
-#define MAX_GPDMA_CHANNELS 8
 #define DMA_SIZE        BLOCK_LENGTH    /* DMA_SIZE is the same BLOCK_LENGTH defined in mci.h */
 
 /* DMA mode */
-#define M2M                0x00
 #define M2P                0x01
 #define P2M                0x02
-#define P2P                0x03
-
-#define DMAC_CFG_SRC_PER_Pos 0
-#define DMAC_CFG_SRC_PER_Msk (0xfu << DMAC_CFG_SRC_PER_Pos) /**< \brief (DMAC_CFG) Source with Peripheral identifier */
-#define DMAC_CFG_SRC_PER(value) ((DMAC_CFG_SRC_PER_Msk & ((value) << DMAC_CFG_SRC_PER_Pos)))
 
 #define HSMCI_RECEIVE_DATA_ADDRESS 0xF0008030
 #define HSMCI_TRANSMIT_DATA_ADDRESS 0xF0008034
 
-#define DMAC0_PERHERIAL 20
-#define DMAC0_INTERRUP_ID DMAC0_PERHERIAL
-
-#define DMAC0_EBCIER_REG                    (*(volatile uint32_t *)(0xFFFFEC18))
-#define DMAC0_EN_REG                         (*(volatile uint32_t *)(0xFFFFEC04))
-#define DMAC0_CHER_REG                         (*(volatile uint32_t *)(0xFFFFEC28)) //DMAC0 Channel Handler Enable Register
-#define DMAC0_CHDR_REG                         (*(volatile uint32_t *)(0xFFFFEC2C)) //DMAC0 Channel Handler Disable Register
-#define DMAC0_EBCISR_REG                     (*(volatile uint32_t *)(0xFFFFEC24)) //DMAC0 Error, Buffer Transfer and Chained Buffer Transfer Status Register
-#define DMAC0_CTRLA_REG                     (*(volatile uint32_t *)(0xFFFFEC48)) //Control A Register
-#define DMAC0_CTRLB_REG                     (*(volatile uint32_t *)(0xFFFFEC4C)) //Control B Register
-#define DMAC0_CFG_REG                         (*(volatile uint32_t *)(0xFFFFEC50)) //Config Register
-#define DMAC0_SREQ_REG                                          (*(volatile uint32_t *)(0xFFFFEC08)) //DMAC0 Software Single Request Register
-#define DMAC0_LAST_REG                                          (*(volatile uint32_t *)(0xFFFFEC10)) //DMAC0 Software Single Request Register
-#define DMAC0_CHSR_REG                                          (*(volatile uint32_t *)(0xFFFFEC30)) //DMAC0 Channel Handler Status Register
-#define DMAC0_DSCR_REG                                          (*(volatile uint32_t *)(0xFFFFEC44)) //DMAC0 Channel Handler Status Register
-
-#define HSMCI_SR_REG                         (*(volatile uint32_t *)(0xF0008040)) //HSMCI Status Register
+#define HSMCI_DMA_INTERFACE 0
 
-#define GPDMA_Source_Register_Channel            (*(volatile uint32_t *)(0xFFFFEC3C)) // chanel 0 default
-#define GPDMA_Destination_Register_Channel        (*(volatile uint32_t *)(0xFFFFEC40)) // chanel 0 default
+static int32_t sdCardDmaChannel = AT91_DMA_CHANNEL_NONE;
+static uint8_t sdCardDmaOwner;
 
+bool DMA_Init(void);
+void DMA_Uninit(void);
 void DMA_Config(uint32_t DMAMode, uint8_t* pData);
-void DMA_Init(void);
-void DMA_EnableChannel(void);
-void DMA_DiableChannel(void);
-void DMA_Enable(void);
 
 /******************************************************************************
 ** Function name:        DMA_Init
 **
-** Descriptions:        Setup GPDMA clock and install interrupt handler
+** Descriptions:        Take a DMAC0 channel for the MCI from the DMA service
 **
 ** parameters:            None
-** Returned value:        true or false, false if ISR can't be installed.
+** Returned value:        true or false, false if every channel is taken.
 **
 ******************************************************************************/
-void DMA_Init(void) {
-    AT91_PMC &pmc = AT91::PMC();
-    pmc.EnablePeriphClock(AT91C_ID_DMAC0);
+bool DMA_Init(void) {
+    if (sdCardDmaChannel == AT91_DMA_CHANNEL_NONE)
+        sdCardDmaChannel = AT91_Dma_AcquireChannel(AT91_DMA_DMAC0_CHANNELS, &sdCardDmaOwner);
+
+    return sdCardDmaChannel != AT91_DMA_CHANNEL_NONE;
+}
 
-    DMA_Enable();
+void DMA_Uninit(void) {
+    AT91_Dma_ReleaseChannel(sdCardDmaChannel, &sdCardDmaOwner);
+
+    sdCardDmaChannel = AT91_DMA_CHANNEL_NONE;
 }
 
 /******************************************************************************
-** Function name:        DMA_Move
+** Function name:        DMA_Config
 **
-** Descriptions:        Setup GPDMA for MCI DMA transfer
-**                        including mode, M2P or M2M, or P2M,
-**                        src and dest. address, control reg. etc.
+** Descriptions:        Setup the DMA channel for MCI DMA transfer
+**                        M2P or P2M, src and dest. address, control reg.
 **
-** parameters:            Channel number, DMA mode
-** Returned value:        true or false
+** parameters:            DMA mode, data buffer
+** Returned value:        None
 **
 ******************************************************************************/
-void DMA_EnableChannel() {
-    DMAC0_CHER_REG |= (1 << 0);                         // Enable chanel 0
-    while ((DMAC0_CHSR_REG & (1 << 0)) == 0);
-
-}
-void DMA_DiableChannel() {
-    DMAC0_CHDR_REG |= (1 << 0);                         // Enable chanel 0
-    while ((DMAC0_CHSR_REG & (1 << 0)) == 1);
-}
-
-void DMA_Enable() {
-    DMAC0_EN_REG = 0x01;    /* Enable DMA channels, little endian */
-    while (!(DMAC0_EN_REG & 0x01));
-}
-
 void DMA_Config(uint32_t DMAMode, uint8_t* pData) {
-    volatile uint32_t error_status = DMAC0_EBCISR_REG; // dump register
-
-    if (DMAMode == P2M) // for read
-    {
-        DMAC0_CFG_REG =     /*HSMCI0_PERHERIAL*/(DMAC_CFG_SRC_PER(0) << 0) |                 // SRC_PER code
-            (0 << 4) |                                            // DST_PER code
-            (1 << 16) |                                                // Stop on done
-            (0 << 28) |                         // FIFOCFG defines the watermark of the DMA channel FIFO.
-            (1 << 9);                        // SRC_H2SEL is set to true to enable hardware handshaking on the destination.
+    AT91_DMAC_Descriptor descriptor;
+    uint32_t cfg;
 
-        GPDMA_Source_Register_Channel = HSMCI_RECEIVE_DATA_ADDRESS;
+    // a channel left running by a failed command is stopped before it is loaded again
+    if (AT91_Dma_IsBusy(sdCardDmaChannel))
+        AT91_Dma_Stop(sdCardDmaChannel);
+    else
+        AT91_Dma_Wait(sdCardDmaChannel);
 
-        GPDMA_Destination_Register_Channel = (uint32_t)pData;
+    descriptor.CTRLA = (512 >> 2) |                     // BTSIZE is programmed with block_length/4.
+        AT91_DMAC_Channel::DMAC_SRC_WIDTH_WORD |
+        AT91_DMAC_Channel::DMAC_DST_WIDTH_WORD;
+    descriptor.DSCR = 0;                                // no more DMA descriptor is needed
 
-        DMAC0_CTRLA_REG = (512 >> 2) |                                                               //BTSIZE is programmed with block_length/4.
-            (0 << 16) |                         //SCSIZE must be set according to the value of HSMCI_DMA, CHKSIZE field. 4
-            (0 << 20) |                        //DCSIZE must be set according to the value of HSMCI_DMA, CHKSIZE field. 4
-            (2 << 24) |                         //SRC_WIDTH is set to WORD.
-            (2 << 28);                        //DST_WIDTH is set to WORD.
+    if (DMAMode == P2M) { // for read
+        descriptor.SADDR = HSMCI_RECEIVE_DATA_ADDRESS;
+        descriptor.DADDR = (uint32_t)pData;
+        descriptor.CTRLB = AT91_DMAC_Channel::DMAC_FC_PER2MEM | AT91_DMAC_Channel::DMAC_SRC_INCR_FIXED;
 
-        DMAC0_CTRLB_REG = (1 << 16) |                                                               // both DST_DSCR and SRC_DSCR are set to 1: 1 is disable
-            (1 << 20) |                        // both DST_DSCR and SRC_DSCR are set to 1
-            (2 << 21) |                        // FC field is programmed with peripheral to memory flow control mode. P2M
-            (2 << 24) |                         // SCR_INCR is set to INCR => fixed
-            (0 << 28);                        // DST_INCR is set to INCR=>inscrease
-
-        DMAC0_DSCR_REG = 0; //Set the DMAC Channel Descriptor Address Register as 0 as no more DMA descriptor is needed
+        cfg = (HSMCI_DMA_INTERFACE << AT91_DMAC_Channel::DMAC_SRC_PER_Pos) | AT91_DMAC_Channel::DMAC_SRC_H2SEL | AT91_DMAC_Channel::DMAC_SOD;
     }
-    if (DMAMode == M2P) // for write
-    {
-        DMAC0_CFG_REG =     /*HSMCI0_PERHERIAL*/(0 << 0) |                                                    // SRC_PER code
-            (DMAC_CFG_SRC_PER(0) << 4) |                                  // DST_PER code
-            (1 << 16) |                                    // Stop on done
-            (0 << 28) |                                   // FIFOCFG defines the watermark of the DMA channel FIFO.
-            (1 << 13);                                    // DST_H2SEL is set to true to enable hardware handshaking on the destination.
-
-        GPDMA_Source_Register_Channel = (uint32_t)pData;
-        GPDMA_Destination_Register_Channel = HSMCI_TRANSMIT_DATA_ADDRESS;
-
-        DMAC0_CTRLA_REG = (512 >> 2) |                                                                       //BTSIZE is programmed with block_length/4.
-            (0 << 16) |                         //SCSIZE must be set according to the value of HSMCI_DMA, CHKSIZE field. 4
-            (0 << 20) |                        //DCSIZE must be set according to the value of HSMCI_DMA, CHKSIZE field. 4
-            (2 << 24) |                         //SRC_WIDTH is set to WORD.
-            (2 << 28);                        //DST_WIDTH is set to WORD.
-
-        DMAC0_CTRLB_REG = (1 << 16) |                                               // both DST_DSCR and SRC_DSCR are set to 1: 1 is disable
-            (1 << 20) |                        // both DST_DSCR and SRC_DSCR are set to 1
-            (1 << 21) |                        // FC field is programmed with peripheral to memory flow control mode. M2P
-            (0 << 24) |                         // SCR_INCR is set to INCR => increase
-            (2 << 28);                        // DST_INCR is set to INCR=> fixed
-        DMAC0_DSCR_REG = 0;//Set the DMAC Channel Descriptor Address Register as 0 as no more DMA descriptor is needed
+    else { // for write
+        descriptor.SADDR = (uint32_t)pData;
+        descriptor.DADDR = HSMCI_TRANSMIT_DATA_ADDRESS;
+        descriptor.CTRLB = AT91_DMAC_Channel::DMAC_FC_MEM2PER | AT91_DMAC_Channel::DMAC_DST_INCR_FIXED;
 
+        cfg = (HSMCI_DMA_INTERFACE << AT91_DMAC_Channel::DMAC_DST_PER_Pos) | AT91_DMAC_Channel::DMAC_DST_H2SEL | AT91_DMAC_Channel::DMAC_SOD;
     }
 
-    DMA_EnableChannel();
+    // polled, the MCI interrupt tells when the data is through
+    AT91_Dma_Start(sdCardDmaChannel, &descriptor, cfg, nullptr, nullptr);
 }
 
 // MCI
@@ -2440,7 +2381,8 @@ TinyCLR_Result AT91_SdCard_Acquire(const TinyCLR_Storage_Controller* self) {
         AT91_PMC &pmc = AT91::PMC();
         pmc.EnablePeriphClock(AT91C_ID_HSMCI0);
 
-        DMA_Init();
+        if (!DMA_Init())
+            return TinyCLR_Result::SharingViolation;
 
         MCI_Init(&mciDrv, (AT91PS_MCI)AT91C_BASE_MCI, AT91C_ID_HSMCI0, MCI_SD_SLOTA);
 
@@ -2455,11 +2397,12 @@ TinyCLR_Result AT91_SdCard_Acquire(const TinyCLR_Storage_Controller* self) {
 
         auto memoryProvider = (const TinyCLR_Memory_Manager*)apiManager->FindDefault(apiManager, TinyCLR_Api_Type::MemoryManager);
 
-        state->pBuffer = (uint8_t*)memoryProvider->Allocate(memoryProvider, AT91_SD_SECTOR_SIZE + 4);
+        state->pBuffer = (uint8_t*)memoryProvider->Allocate(memoryProvider, AT91_SD_SECTOR_SIZE + AT91_CACHE_LINE_SIZE);
 
+        // the DMA buffer has whole cache lines to itself so it can be invalidated without losing anything around it
         uint32_t alignAddress = (uint32_t)state->pBuffer;
 
-        while (alignAddress % 4 > 0) {
+        while (alignAddress % AT91_CACHE_LINE_SIZE > 0) {
             alignAddress++;
         }
 
@@ -2505,10 +2448,11 @@ TinyCLR_Result AT91_SdCard_Release(const TinyCLR_Storage_Controller* self) {
         AT91_PMC &pmc = AT91::PMC();
 
         pmc.DisablePeriphClock(AT91C_ID_HSMCI0); /* Disable clock to the Mci block */
-        pmc.DisablePeriphClock(AT91C_ID_DMAC0); /* Disable clock to the Dma block */
 
         AT91_InterruptInternal_Deactivate(AT91C_ID_HSMCI0); /* Disable Interrupt */
 
+        DMA_Uninit();
+
         auto memoryProvider = (const TinyCLR_Memory_Manager*)apiManager->FindDefault(apiManager, TinyCLR_Api_Type::MemoryManager);
 
         memoryProvider->Free(memoryProvider, state->pBuffer);
@@ -2553,7 +2497,7 @@ TinyCLR_Result AT91_SdCard_Write(const TinyCLR_Storage_Controller* self, uint64_
     while (sectorCount > 0) {
         memcpy(state->pBufferAligned, pData, AT91_SD_SECTOR_SIZE);
 
-        AT91_Cache_DisableCaches();
+        AT91_Cache_CleanRange(state->pBufferAligned, AT91_SD_SECTOR_SIZE);
 
         if (SD_ReadyToTransfer(pSd, timeout) == false) {
             return TinyCLR_Result::InvalidOperation;
@@ -2571,8 +2515,6 @@ TinyCLR_Result AT91_SdCard_Write(const TinyCLR_Storage_Controller* self, uint64_
             }
         }
 
-        AT91_Cache_EnableCaches();
-
         if (error) {
             return TinyCLR_Result::InvalidOperation;
         }
@@ -2615,7 +2557,7 @@ TinyCLR_Result AT91_SdCard_Read(const TinyCLR_Storage_Controller* self, uint64_t
     while (sectorCount > 0) {
         memset(state->pBufferAligned, 0, AT91_SD_SECTOR_SIZE);
 
-        AT91_Cache_DisableCaches();
+        AT91_Cache_CleanInvalidateRange(state->pBufferAligned, AT91_SD_SECTOR_SIZE);
 
         if (SD_ReadyToTransfer(pSd, timeout) == false) {
             return TinyCLR_Result::InvalidOperation;
@@ -2634,7 +2576,7 @@ TinyCLR_Result AT91_SdCard_Read(const TinyCLR_Storage_Controller* self, uint64_t
             }
         }
 
-        AT91_Cache_EnableCaches();
+        AT91_Cache_InvalidateRange(state->pBufferAligned, AT91_SD_SECTOR_SIZE);
 
         if (error) {
             return TinyCLR_Result::InvalidOperation;
@@ -208,6 +208,8 @@ void AT91_Startup_Initialize() {
         }
     }
 
+    // the code copied above can still be in the DCache when SDRAM and SRAM are write-back
+    AT91_Cache_FlushCaches();
 }
 
 const TinyCLR_Startup_UsbDebuggerConfiguration AT91_Startup_UsbDebuggerConfiguration = {
@@ -18,6 +18,20 @@
 
 #define USART_EVENT_POST_DEBOUNCE_TICKS (10 * 10000) // 10ms between each events
 
+// Received bytes are collected by DMA into two buffers per USART, the receiver time-out hands over a partly filled one
+// once the line has been idle for AT91_UART_DMA_RX_TIMEOUT bit periods. Transmit DMA runs straight from the TX ring.
+// The DBGU and the UARTs have no receiver time-out, they still receive by interrupt.
+#ifndef AT91_UART_DMA_RX_BUFFER_SIZE
+#define AT91_UART_DMA_RX_BUFFER_SIZE 128
+#endif
+
+#ifndef AT91_UART_DMA_RX_TIMEOUT
+#define AT91_UART_DMA_RX_TIMEOUT 20
+#endif
+
+#define AT91_UART_DMA_MAX_TRANSFER_SIZE 0xFFFF
+#define AT91_UART_DMA_MEMORY_SIZE ((2 * AT91_UART_DMA_RX_BUFFER_SIZE + 2 * sizeof(AT91_DMAC_Descriptor) + AT91_CACHE_LINE_SIZE - 1) & ~(AT91_CACHE_LINE_SIZE - 1))
+
 static const uint32_t uartTxDefaultBuffersSize[] = AT91_UART_DEFAULT_TX_BUFFER_SIZE;
 static const uint32_t uartRxDefaultBuffersSize[] = AT91_UART_DEFAULT_RX_BUFFER_SIZE;
 
@@ -52,6 +66,17 @@ struct UartState {
     uint32_t errorEvent;
     uint64_t lastEventTime;
     size_t lastEventRxBufferCount;
+
+    bool rxDma;
+    bool txDma;
+    uint8_t* rxDmaMemory;
+    uint8_t* rxDmaBuffers[2];
+    AT91_DMAC_Descriptor* rxDmaDescriptors;
+    uint32_t rxDmaActive;
+    size_t rxDmaTail;
+    size_t txDmaLength;
+    int32_t rxDmaChannel;
+    int32_t txDmaChannel;
 };
 
 static UartState uartStates[TOTAL_UART_CONTROLLERS];
@@ -257,9 +282,9 @@ TinyCLR_Result AT91_Uart_PinConfiguration(int controllerIndex, bool enable) {
     AT91_Gpio_PeripheralSelection ctsPinMode = AT91_Uart_GetCtsAlternateFunction(controllerIndex);
     AT91_Gpio_PeripheralSelection rtsPinMode = AT91_Uart_GetRtsAlternateFunction(controllerIndex);
 
-    AT91_Uart_TxBufferEmptyInterruptEnable(controllerIndex, enable);
+    AT91_Uart_TxBufferEmptyInterruptEnable(controllerIndex, enable && !state->txDma);
 
-    AT91_Uart_RxBufferFullInterruptEnable(controllerIndex, enable);
+    AT91_Uart_RxBufferFullInterruptEnable(controllerIndex, enable && !state->rxDma);
 
     if (enable) {
         // Connect pin to UART
@@ -299,6 +324,337 @@ void AT91_Uart_SetErrorEvent(int32_t controllerIndex, TinyCLR_Uart_Error error)
         state->errorEventHandler(state->controller, error, AT91_Time_GetCurrentProcessorTime());
 }
 
+// Engine: DMAC0/DMAC1, the channels come from the DMA service on the controller the USART handshakes on.
+struct UartDmaInterface {
+    uint32_t candidates;
+    uint32_t txInterface;
+    uint32_t rxInterface;
+    bool receive;
+};
+
+static const UartDmaInterface uartDmaInterfaces[] = {
+    { AT91_DMA_DMAC1_CHANNELS, 8, 9, false },   // DBGU
+    { AT91_DMA_DMAC0_CHANNELS, 3, 4, true },    // USART0
+    { AT91_DMA_DMAC0_CHANNELS, 5, 6, true },    // USART1
+    { AT91_DMA_DMAC1_CHANNELS, 12, 13, true },  // USART2
+    { AT91_DMA_DMAC0_CHANNELS, 10, 11, false }, // UART0
+    { AT91_DMA_DMAC1_CHANNELS, 10, 11, false }, // UART1
+};
+
+static bool AT91_Uart_DmaCanTransmit(int32_t controllerIndex) {
+    return controllerIndex < SIZEOF_ARRAY(uartDmaInterfaces);
+}
+
+static bool AT91_Uart_DmaCanReceive(int32_t controllerIndex) {
+    return controllerIndex < SIZEOF_ARRAY(uartDmaInterfaces) && uartDmaInterfaces[controllerIndex].receive;
+}
+
+static void AT91_Uart_DmaReceive(int32_t controllerIndex);
+static void AT91_Uart_DmaTransmitDone(int32_t controllerIndex);
+
+// both run from the DMAC interrupt with interrupts disabled
+static void AT91_Uart_DmaReceiveEventHandler(int32_t channel, AT91_Dma_Event event, void* param) {
+    auto state = reinterpret_cast<UartState*>(param);
+
+    if (state->rxDma)
+        AT91_Uart_DmaReceive(state->controllerIndex);
+}
+
+static void AT91_Uart_DmaTransmitEventHandler(int32_t channel, AT91_Dma_Event event, void* param) {
+    auto state = reinterpret_cast<UartState*>(param);
+
+    if (state->txDma && state->txDmaLength > 0)
+        AT91_Uart_DmaTransmitDone(state->controllerIndex);
+}
+
+static void AT91_Uart_DmaStartReceive(int32_t controllerIndex) {
+    auto state = &uartStates[controllerIndex];
+    auto& dma = uartDmaInterfaces[controllerIndex];
+    auto descriptors = state->rxDmaDescriptors;
+
+    AT91_USART &usart = AT91::USART(controllerIndex);
+
+    // two descriptors pointing at each other, the channel never stops and raises BTC after each buffer
+    for (auto i = 0; i < 2; i++) {
+        descriptors[i].SADDR = (uint32_t)&usart.US_RHR;
+        descriptors[i].DADDR = AT91_Cache_GetCachableAddress((size_t)state->rxDmaBuffers[i]);
+        descriptors[i].CTRLA = AT91_UART_DMA_RX_BUFFER_SIZE | AT91_DMAC_Channel::DMAC_SRC_WIDTH_BYTE | AT91_DMAC_Channel::DMAC_DST_WIDTH_BYTE;
+        descriptors[i].CTRLB = AT91_DMAC_Channel::DMAC_FC_PER2MEM | AT91_DMAC_Channel::DMAC_SRC_INCR_FIXED;
+        descriptors[i].DSCR = AT91_Cache_GetCachableAddress((size_t)&descriptors[i ^ 1]);
+    }
+
+    AT91_Dma_Stop(state->rxDmaChannel);
+    AT91_Dma_Start(state->rxDmaChannel, &descriptors[0], (dma.rxInterface << AT91_DMAC_Channel::DMAC_SRC_PER_Pos) | AT91_DMAC_Channel::DMAC_SRC_H2SEL | AT91_DMAC_Channel::DMAC_FIFOCFG_ASAP, AT91_Uart_DmaReceiveEventHandler, state);
+}
+
+static size_t AT91_Uart_DmaGetReceivePosition(int32_t controllerIndex) {
+    auto state = &uartStates[controllerIndex];
+
+    // once a buffer is full DADDR is already in the other one, which reads as past the end of this one
+    auto position = AT91_Dma_GetDestinationAddress(state->rxDmaChannel) - AT91_Cache_GetCachableAddress((size_t)state->rxDmaBuffers[state->rxDmaActive]);
+
+    return std::min(static_cast<size_t>(position), static_cast<size_t>(AT91_UART_DMA_RX_BUFFER_SIZE));
+}
+
+static void AT91_Uart_DmaStopReceive(int32_t controllerIndex) {
+    AT91_Dma_Stop(uartStates[controllerIndex].rxDmaChannel);
+}
+
+static void AT91_Uart_DmaStartTransmit(int32_t controllerIndex, uint32_t address, size_t length) {
+    auto state = &uartStates[controllerIndex];
+    auto& dma = uartDmaInterfaces[controllerIndex];
+
+    AT91_DMAC_Descriptor descriptor;
+
+    AT91_USART &usart = AT91::USART(controllerIndex);
+
+    descriptor.SADDR = address;
+    descriptor.DADDR = (uint32_t)&usart.US_THR;
+    descriptor.DSCR = 0;
+    descriptor.CTRLA = length | AT91_DMAC_Channel::DMAC_SRC_WIDTH_BYTE | AT91_DMAC_Channel::DMAC_DST_WIDTH_BYTE;
+    descriptor.CTRLB = AT91_DMAC_Channel::DMAC_FC_MEM2PER | AT91_DMAC_Channel::DMAC_DST_INCR_FIXED;
+
+    AT91_Dma_Start(state->txDmaChannel, &descriptor, (dma.txInterface << AT91_DMAC_Channel::DMAC_DST_PER_Pos) | AT91_DMAC_Channel::DMAC_DST_H2SEL | AT91_DMAC_Channel::DMAC_SOD | AT91_DMAC_Channel::DMAC_FIFOCFG_ASAP, AT91_Uart_DmaTransmitEventHandler, state);
+}
+
+static void AT91_Uart_DmaStopTransmit(int32_t controllerIndex) {
+    AT91_Dma_Stop(uartStates[controllerIndex].txDmaChannel);
+}
+
+static void AT91_Uart_StoreReceivedData(int32_t controllerIndex, const uint8_t* data, size_t length) {
+    AT91_USART &usart = AT91::USART(controllerIndex);
+
+    auto state = &uartStates[controllerIndex];
+    auto canPostEvent = AT91_Uart_CanPostEvent(controllerIndex);
+    size_t stored = 0;
+
+    while (stored < length && state->rxBufferCount < state->rxBufferSize) {
+        state->RxBuffer[state->rxBufferIn++] = data[stored++];
+
+        state->rxBufferCount++;
+
+        if (state->rxBufferIn == state->rxBufferSize)
+            state->rxBufferIn = 0;
+    }
+
+    if (stored < length) {
+        if (canPostEvent) AT91_Uart_SetErrorEvent(controllerIndex, TinyCLR_Uart_Error::BufferFull);
+    }
+
+    if (stored > 0 && state->dataReceivedEventHandler != nullptr) {
+        if (canPostEvent) {
+            if (state->rxBufferCount > state->lastEventRxBufferCount) {
+                state->dataReceivedEventHandler(state->controller, state->rxBufferCount - state->lastEventRxBufferCount, AT91_Time_GetCurrentProcessorTime());
+            }
+            else {
+                state->dataReceivedEventHandler(state->controller, stored, AT91_Time_GetCurrentProcessorTime());
+            }
+
+            state->lastEventRxBufferCount = state->rxBufferCount;
+        }
+    }
+
+    // Control rts by software - enable / disable when internal buffer reach 3/4
+    if (state->handshaking && (state->rxBufferCount >= ((state->rxBufferSize * 3) / 4))) {
+        usart.US_CR = AT91_USART::US_RTSDIS;// Write rts to 1
+    }
+}
+
+// Moves what the DMA wrote since the last call into the RX ring. A full buffer is handed back to the DMA and the
+// other one becomes active, so this runs on buffer completion as well as on the receiver time-out.
+static void AT91_Uart_DmaReceive(int32_t controllerIndex) {
+    auto state = &uartStates[controllerIndex];
+
+    for (auto i = 0; i < 2; i++) {
+        auto head = AT91_Uart_DmaGetReceivePosition(controllerIndex);
+
+        if (head > state->rxDmaTail)
+            AT91_Uart_StoreReceivedData(controllerIndex, state->rxDmaBuffers[state->rxDmaActive] + state->rxDmaTail, head - state->rxDmaTail);
+
+        state->rxDmaTail = head;
+
+        if (head < AT91_UART_DMA_RX_BUFFER_SIZE)
+            break;
+
+        // the descriptors are circular, the channel refills this buffer once it gets back to it
+        state->rxDmaActive ^= 1;
+        state->rxDmaTail = 0;
+    }
+}
+
+static void AT91_Uart_DmaTransmit(int32_t controllerIndex) {
+    auto state = &uartStates[controllerIndex];
+
+    if (state->txDmaLength > 0 || state->txBufferCount == 0)
+        return;
+
+    // the ring is sent in contiguous pieces, the wrapped part follows when this one is done
+    auto length = std::min(state->txBufferCount, state->txBufferSize - state->txBufferOut);
+    auto data = &state->TxBuffer[state->txBufferOut];
+
+    length = std::min(length, static_cast<size_t>(AT91_UART_DMA_MAX_TRANSFER_SIZE));
+
+    AT91_Cache_CleanRange(data, length);
+
+    state->txDmaLength = length;
+
+    AT91_Uart_DmaStartTransmit(controllerIndex, AT91_Cache_GetCachableAddress((size_t)data), length);
+}
+
+static void AT91_Uart_DmaTransmitDone(int32_t controllerIndex) {
+    auto state = &uartStates[controllerIndex];
+
+    state->txBufferOut += state->txDmaLength;
+    state->txBufferCount -= state->txDmaLength;
+
+    if (state->txBufferOut >= state->txBufferSize)
+        state->txBufferOut -= state->txBufferSize;
+
+    state->txDmaLength = 0;
+
+    AT91_Uart_DmaTransmit(controllerIndex);
+}
+
+static TinyCLR_Result AT91_Uart_DmaAllocate(int32_t controllerIndex) {
+    auto state = &uartStates[controllerIndex];
+
+    state->rxDmaMemory = nullptr;
+
+    if (!AT91_Uart_DmaCanReceive(controllerIndex))
+        return TinyCLR_Result::Success;
+
+    auto memoryProvider = (const TinyCLR_Memory_Manager*)apiManager->FindDefault(apiManager, TinyCLR_Api_Type::MemoryManager);
+
+    state->rxDmaMemory = (uint8_t*)memoryProvider->Allocate(memoryProvider, AT91_UART_DMA_MEMORY_SIZE + AT91_CACHE_LINE_SIZE);
+
+    if (state->rxDmaMemory == nullptr)
+        return TinyCLR_Result::OutOfMemory;
+
+    // whole cache lines, nothing else may be written back over what the DMA stores through the uncached alias
+    auto memory = ((size_t)state->rxDmaMemory + AT91_CACHE_LINE_SIZE - 1) & ~(AT91_CACHE_LINE_SIZE - 1);
+
+    AT91_Cache_CleanInvalidateRange((void*)memory, AT91_UART_DMA_MEMORY_SIZE);
+
+    memory = AT91_Cache_GetUncachableAddress(memory);
+
+    state->rxDmaBuffers[0] = (uint8_t*)memory;
+    state->rxDmaBuffers[1] = (uint8_t*)memory + AT91_UART_DMA_RX_BUFFER_SIZE;
+    state->rxDmaDescriptors = (AT91_DMAC_Descriptor*)(memory + 2 * AT91_UART_DMA_RX_BUFFER_SIZE);
+
+    return TinyCLR_Result::Success;
+}
+
+static void AT91_Uart_DmaStart(int32_t controllerIndex) {
+    AT91_USART &usart = AT91::USART(controllerIndex);
+
+    auto state = &uartStates[controllerIndex];
+
+    // the hardware handshake only stops the transmitter between bytes written by the interrupt
+    state->txDma = !state->handshaking && AT91_Uart_DmaCanTransmit(controllerIndex);
+    state->rxDma = state->rxDmaMemory != nullptr;
+    state->txDmaLength = 0;
+
+    // without a free channel that direction stays on the interrupt
+    if (state->txDma) {
+        state->txDmaChannel = AT91_Dma_AcquireChannel(uartDmaInterfaces[controllerIndex].candidates, state);
+        state->txDma = state->txDmaChannel != AT91_DMA_CHANNEL_NONE;
+    }
+
+    if (state->rxDma) {
+        state->rxDmaChannel = AT91_Dma_AcquireChannel(uartDmaInterfaces[controllerIndex].candidates, state);
+        state->rxDma = state->rxDmaChannel != AT91_DMA_CHANNEL_NONE;
+    }
+
+    if (state->rxDma) {
+        state->rxDmaActive = 0;
+        state->rxDmaTail = 0;
+
+        AT91_Uart_DmaStartReceive(controllerIndex);
+
+        usart.US_RTOR = AT91_UART_DMA_RX_TIMEOUT;
+        usart.US_CR = AT91_USART::US_STTTO;
+        usart.US_IER = AT91_USART::US_TIMEOUT | AT91_USART::US_OVRE | AT91_USART::US_FRAME | AT91_USART::US_PARE;
+    }
+}
+
+static void AT91_Uart_DmaStop(int32_t controllerIndex) {
+    AT91_USART &usart = AT91::USART(controllerIndex);
+
+    auto state = &uartStates[controllerIndex];
+
+    if (state->rxDma) {
+        AT91_Uart_DmaStopReceive(controllerIndex);
+
+        usart.US_RTOR = 0;
+
+        state->rxDma = false;
+    }
+
+    if (state->txDma) {
+        AT91_Uart_DmaStopTransmit(controllerIndex);
+
+        // whatever was not sent yet from the current piece is dropped
+        if (state->txDmaLength > 0) {
+            state->txBufferOut = (state->txBufferOut + state->txDmaLength) % state->txBufferSize;
+            state->txBufferCount -= state->txDmaLength;
+            state->txDmaLength = 0;
+        }
+
+        state->txDma = false;
+    }
+
+    AT91_Dma_ReleaseChannel(state->rxDmaChannel, state);
+    AT91_Dma_ReleaseChannel(state->txDmaChannel, state);
+
+    state->rxDmaChannel = AT91_DMA_CHANNEL_NONE;
+    state->txDmaChannel = AT91_DMA_CHANNEL_NONE;
+}
+
+static void AT91_Uart_DmaInterruptHandler(int32_t controllerIndex, uint32_t sr) {
+    AT91_USART &usart = AT91::USART(controllerIndex);
+
+    auto state = &uartStates[controllerIndex];
+
+    if (state->rxDma) {
+        if (sr & (AT91_USART::US_OVRE | AT91_USART::US_FRAME | AT91_USART::US_PARE)) {
+            auto canPostEvent = AT91_Uart_CanPostEvent(controllerIndex);
+
+            if (sr & AT91_USART::US_OVRE)
+                if (canPostEvent) AT91_Uart_SetErrorEvent(controllerIndex, TinyCLR_Uart_Error::Overrun);
+
+            if (sr & AT91_USART::US_FRAME)
+                if (canPostEvent) AT91_Uart_SetErrorEvent(controllerIndex, TinyCLR_Uart_Error::Frame);
+
+            if (sr & AT91_USART::US_PARE)
+                if (canPostEvent) AT91_Uart_SetErrorEvent(controllerIndex, TinyCLR_Uart_Error::ReceiveParity);
+
+            // the receiver keeps running, a reset would lose the position of the DMA
+            usart.US_CR = AT91_USART::US_RSTSTA;
+        }
+
+        if (sr & AT91_USART::US_TIMEOUT)
+            usart.US_CR = AT91_USART::US_STTTO; // rearmed by the next character
+
+        if (sr & (AT91_USART::US_TIMEOUT | AT91_USART::US_ENDRX))
+            AT91_Uart_DmaReceive(controllerIndex);
+    }
+
+    if (state->txDma && (sr & AT91_USART::US_ENDTX)) {
+        usart.US_IDR = AT91_USART::US_ENDTX;
+
+        AT91_Uart_DmaTransmitDone(controllerIndex);
+    }
+}
+
+static void AT91_Uart_StartTransmit(int32_t controllerIndex) {
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    if (uartStates[controllerIndex].txDma)
+        AT91_Uart_DmaTransmit(controllerIndex);
+    else
+        AT91_Uart_TxBufferEmptyInterruptEnable(controllerIndex, true);
+}
+
 void AT91_Uart_ReceiveData(int32_t controllerIndex, uint32_t sr) {
     AT91_USART &usart = AT91::USART(controllerIndex);
 
@@ -392,11 +748,15 @@ void AT91_Uart_InterruptHandler(void *param) {
 
     uint32_t sr = usart.US_CSR;
 
-    if (sr & AT91_USART::US_RXRDY || sr & AT91_USART::US_OVRE || sr & AT91_USART::US_FRAME || sr & AT91_USART::US_PARE) {
-        AT91_Uart_ReceiveData(controllerIndex, sr);
+    auto state = &uartStates[controllerIndex];
+
+    if (state->rxDma || state->txDma) {
+        AT91_Uart_DmaInterruptHandler(controllerIndex, sr & usart.US_IMR);
     }
 
-    auto state = &uartStates[controllerIndex];
+    if (!state->rxDma && (sr & AT91_USART::US_RXRDY || sr & AT91_USART::US_OVRE || sr & AT91_USART::US_FRAME || sr & AT91_USART::US_PARE)) {
+        AT91_Uart_ReceiveData(controllerIndex, sr);
+    }
 
     if (state->handshaking) {
         bool ctsState = ((sr & AT91_USART::US_CTS) > 0) ? false : true;
@@ -413,7 +773,7 @@ void AT91_Uart_InterruptHandler(void *param) {
         }
     }
 
-    if (sr & AT91_USART::US_TXRDY) {
+    if (!state->txDma && (sr & AT91_USART::US_TXRDY)) {
         AT91_Uart_TransmitData(controllerIndex);
     }
 
@@ -472,6 +832,14 @@ TinyCLR_Result AT91_Uart_Acquire(const TinyCLR_Uart_Controller* self) {
         if (AT91_Uart_SetReadBufferSize(self, uartRxDefaultBuffersSize[controllerIndex]) != TinyCLR_Result::Success)
             return TinyCLR_Result::OutOfMemory;
 
+        state->rxDma = false;
+        state->txDma = false;
+        state->rxDmaChannel = AT91_DMA_CHANNEL_NONE;
+        state->txDmaChannel = AT91_DMA_CHANNEL_NONE;
+
+        if (AT91_Uart_DmaAllocate(controllerIndex) != TinyCLR_Result::Success)
+            return TinyCLR_Result::OutOfMemory;
+
         AT91_PMC &pmc = AT91::PMC();
 
         int32_t uartId = AT91_Uart_GetPeripheralId(controllerIndex);
@@ -504,6 +872,8 @@ TinyCLR_Result AT91_Uart_SetActiveSettings(const TinyCLR_Uart_Controller* self,
     // Disable interrupts
     usart.US_IDR = 0xFFFFFFFF;
 
+    AT91_Uart_DmaStop(controllerIndex);
+
     // Reset receiver and transmitter
     usart.US_CR = (AT91_USART::US_RSTRX | AT91_USART::US_RSTTX | AT91_USART::US_RXDIS | AT91_USART::US_TXDIS);
 
@@ -600,6 +970,8 @@ TinyCLR_Result AT91_Uart_SetActiveSettings(const TinyCLR_Uart_Controller* self,
 
     usart.US_MR = USMR;
 
+    AT91_Uart_DmaStart(controllerIndex);
+
     usart.US_CR = AT91_USART::US_RXEN;
     usart.US_CR = AT91_USART::US_TXEN;
 
@@ -634,6 +1006,8 @@ TinyCLR_Result AT91_Uart_Release(const TinyCLR_Uart_Controller* self) {
 
         AT91_InterruptInternal_Deactivate(uartId);
 
+        AT91_Uart_DmaStop(controllerIndex);
+
         AT91_Uart_PinConfiguration(controllerIndex, false);
 
         pmc.DisablePeriphClock(uartId);
@@ -643,8 +1017,13 @@ TinyCLR_Result AT91_Uart_Release(const TinyCLR_Uart_Controller* self) {
 
             memoryProvider->Free(memoryProvider, state->TxBuffer);
             memoryProvider->Free(memoryProvider, state->RxBuffer);
+
+            if (state->rxDmaMemory != nullptr)
+                memoryProvider->Free(memoryProvider, state->rxDmaMemory);
         }
 
+        state->rxDmaMemory = nullptr;
+
         state->handshaking = false;
     }
 
@@ -690,7 +1069,7 @@ TinyCLR_Result AT91_Uart_Flush(const TinyCLR_Uart_Controller* self) {
     auto state = reinterpret_cast<UartState*>(self->ApiInfo->State);
 
     if (state->initializeCount && !AT91_Interrupt_IsDisabled()) {
-        AT91_Uart_TxBufferEmptyInterruptEnable(state->controllerIndex, true);
+        AT91_Uart_StartTransmit(state->controllerIndex);
 
         while (state->txBufferCount > 0) {
             AT91_Time_Delay(nullptr, 1);
@@ -776,7 +1155,7 @@ TinyCLR_Result AT91_Uart_Write(const TinyCLR_Uart_Controller* self, const uint8_
     }
 
     if (length > 0) {
-        AT91_Uart_TxBufferEmptyInterruptEnable(controllerIndex, true); // Enable Tx to start transfer
+        AT91_Uart_StartTransmit(controllerIndex); // Enable Tx to start transfer
     }
 
     return TinyCLR_Result::Success;
@@ -867,8 +1246,16 @@ TinyCLR_Result AT91_Uart_ClearReadBuffer(const TinyCLR_Uart_Controller* self) {
 }
 
 TinyCLR_Result AT91_Uart_ClearWriteBuffer(const TinyCLR_Uart_Controller* self) {
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
     auto state = reinterpret_cast<UartState*>(self->ApiInfo->State);
 
+    if (state->txDma && state->txDmaLength > 0) {
+        AT91_Uart_DmaStopTransmit(state->controllerIndex);
+
+        state->txDmaLength = 0;
+    }
+
     state->txBufferCount = state->txBufferIn = state->txBufferOut = 0;
 
     return TinyCLR_Result::Success;
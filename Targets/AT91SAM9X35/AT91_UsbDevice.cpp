@@ -133,6 +133,10 @@
 #define UDPHS_EPTSETSTA_KILL_BANK (0x1u << 9) /**< \brief (UDPHS_EPTSETSTA) KILL Bank Set (for IN Endpoint) */
 #define UDPHS_EPTSETSTA_TX_PK_RDY (0x1u << 11) /**< \brief (UDPHS_EPTSETSTA) TX Packet Ready Set */
 
+/* -------- UDPHS_EPTCLRSTA : (UDPHS Offset: N/A) UDPHS Endpoint Clear Status Register -------- */
+#define UDPHS_EPTCLRSTA_FRCESTALL (0x1u << 5) /**< \brief (UDPHS_EPTCLRSTA) Stall Handshake Request Clear */
+#define UDPHS_EPTCLRSTA_TOGGLESQ (0x1u << 6) /**< \brief (UDPHS_EPTCLRSTA) Data Toggle Clear */
+
 /* -------- UDPHS_CTRL : (UDPHS Offset: 0x00) UDPHS Control Register -------- */
 #define UDPHS_CTRL_DEV_ADDR_Pos 0
 #define UDPHS_CTRL_DEV_ADDR_Msk (0x7fu << UDPHS_CTRL_DEV_ADDR_Pos) /**< \brief (UDPHS_CTRL) UDPHS address */
@@ -933,6 +937,20 @@ bool AT91_UsbDevice_RxEnable(UsClientState* usClientState, int32_t endpoint) {
     return true;
 }
 
+bool AT91_UsbDevice_SetEndpointStall(UsClientState* usClientState, int32_t endpoint, bool stall) {
+    struct AT91_UDPHS *pUdp = (struct AT91_UDPHS *) AT91C_BASE_UDP;
+
+    if (endpoint == 0 || endpoint >= usClientState->totalEndpointsCount)
+        return false;
+
+    if (stall)
+        pUdp->UDPHS_EPT[endpoint].UDPHS_EPTSETSTA = UDPHS_EPTSETSTA_FRCESTALL;
+    else
+        pUdp->UDPHS_EPT[endpoint].UDPHS_EPTCLRSTA = UDPHS_EPTCLRSTA_FRCESTALL | UDPHS_EPTCLRSTA_TOGGLESQ;
+
+    return true;
+}
+
 bool TinyCLR_UsbClient_Initialize(UsClientState* usClientState) {
     return AT91_UsbDevice_Initialize(usClientState);
 }
@@ -949,6 +967,10 @@ bool TinyCLR_UsbClient_RxEnable(UsClientState* usClientState, int32_t endpoint)
     return AT91_UsbDevice_RxEnable(usClientState, endpoint);
 }
 
+bool TinyCLR_UsbClient_SetEndpointStall(UsClientState* usClientState, int32_t endpoint, bool stall) {
+    return AT91_UsbDevice_SetEndpointStall(usClientState, endpoint, stall);
+}
+
 void TinyCLR_UsbClient_Delay(uint64_t microseconds) {
     AT91_Time_Delay(nullptr, microseconds);
 }
@@ -21,6 +21,8 @@
 #include <inc\LPC177x_8x.h>
 #endif
 
+#include "../../Drivers/DmaAllocator/DmaAllocator.h"
+
 #define SIZEOF_ARRAY(arr) (sizeof(arr) / sizeof(arr[0]))
 #define CONCAT2(a, b) a##b
 #define CONCAT(a, b) CONCAT2(a, b)
@@ -57,6 +59,8 @@ TinyCLR_Result LPC17_Can_SetMessageReceivedHandler(const TinyCLR_Can_Controller*
 TinyCLR_Result LPC17_Can_SetErrorReceivedHandler(const TinyCLR_Can_Controller* self, TinyCLR_Can_ErrorReceivedHandler handler);
 TinyCLR_Result LPC17_Can_SetExplicitFilters(const TinyCLR_Can_Controller* self, const uint32_t* filters, size_t count);
 TinyCLR_Result LPC17_Can_SetGroupFilters(const TinyCLR_Can_Controller* self, const uint32_t* lowerBounds, const uint32_t* upperBounds, size_t count);
+TinyCLR_Result LPC17_Can_SetFullCanFilters(const TinyCLR_Can_Controller* self, const uint32_t* ids, size_t count);
+TinyCLR_Result LPC17_Can_ReadFullCanMessage(const TinyCLR_Can_Controller* self, uint32_t id, TinyCLR_Can_Message& message, bool& received);
 TinyCLR_Result LPC17_Can_ClearReadBuffer(const TinyCLR_Can_Controller* self);
 TinyCLR_Result LPC17_Can_IsWritingAllowed(const TinyCLR_Can_Controller* self, bool& allowed);
 size_t LPC17_Can_GetWriteErrorCount(const TinyCLR_Can_Controller* self);
@@ -86,6 +90,53 @@ uint32_t LPC17_Dac_GetResolutionInBits(const TinyCLR_Dac_Controller* self);
 int32_t LPC17_Dac_GetMinValue(const TinyCLR_Dac_Controller* self);
 int32_t LPC17_Dac_GetMaxValue(const TinyCLR_Dac_Controller* self);
 
+// DMA
+#define LPC17_DMA_CHANNEL_COUNT 8
+#define LPC17_DMA_CHANNEL_NONE DMA_ALLOCATOR_CHANNEL_NONE
+#define LPC17_DMA_ANY_CHANNEL 0xFF
+
+#define LPC17_DMA_CONTROL_TRANSFER_SIZE_MASK 0xFFF
+#define LPC17_DMA_CONTROL_SWIDTH_BIT 18
+#define LPC17_DMA_CONTROL_DWIDTH_BIT 21
+#define LPC17_DMA_CONTROL_SI (1 << 26)
+#define LPC17_DMA_CONTROL_DI (1 << 27)
+#define LPC17_DMA_CONTROL_I (1U << 31)
+
+#define LPC17_DMA_CONFIG_SRCPERIPHERAL_BIT 1
+#define LPC17_DMA_CONFIG_DESTPERIPHERAL_BIT 6
+#define LPC17_DMA_CONFIG_M2P (1 << 11)
+#define LPC17_DMA_CONFIG_P2M (2 << 11)
+#define LPC17_DMA_CONFIG_M2P_DEST_CONTROL (5 << 11)
+#define LPC17_DMA_CONFIG_P2M_SRC_CONTROL (6 << 11)
+#define LPC17_DMA_CONFIG_L (1 << 16)
+
+// One GPDMA linked list item, as the controller reads it. next is the following item or 0; linking the last item back
+// to the first makes a ring, two items with LPC17_DMA_CONTROL_I is a double buffer. Items after the first are read by
+// the controller and have to stay valid until the transfer is stopped.
+struct LPC17_Dma_Descriptor {
+    uint32_t source;
+    uint32_t destination;
+    uint32_t next;
+    uint32_t control;
+};
+
+enum class LPC17_Dma_Event : uint8_t {
+    Completed,
+    Error
+};
+
+// Called from the DMA interrupt for every item with LPC17_DMA_CONTROL_I, and on an error
+typedef void(*LPC17_Dma_EventHandler)(int32_t channel, LPC17_Dma_Event event, void* param);
+
+int32_t LPC17_Dma_AcquireChannel(uint32_t candidates, const void* owner);
+void LPC17_Dma_ReleaseChannel(int32_t channel, const void* owner);
+TinyCLR_Result LPC17_Dma_Start(int32_t channel, const LPC17_Dma_Descriptor* first, uint32_t config, LPC17_Dma_EventHandler handler, void* param);
+void LPC17_Dma_Stop(int32_t channel);
+bool LPC17_Dma_IsBusy(int32_t channel);
+bool LPC17_Dma_Wait(int32_t channel);
+const DmaAllocator_Statistics* LPC17_Dma_GetStatistics(int32_t channel);
+bool LPC17_Dma_IsReachable(const void* buffer, size_t length);
+
 // GPIO
 enum class LPC17_Gpio_Direction : uint8_t {
     Input = 0,
@@ -249,6 +300,25 @@ TinyCLR_Result LPC17_SdCard_Close(const TinyCLR_Storage_Controller* self);
 
 TinyCLR_Result LPC17_SdCard_Reset();
 
+////////////////////////////////////////////////////////////////////////////////
+//Signal Capture
+////////////////////////////////////////////////////////////////////////////////
+#define TARGET_SIGNAL_CAPTURE_SUPPORTED
+
+bool LPC17_SignalCapture_IsPinSupported(uint32_t pin);
+TinyCLR_Result LPC17_SignalCapture_Read(uint32_t pin, bool waitForInitialState, TinyCLR_Gpio_PinValue& initialState, uint32_t* timestamps, size_t& count, uint64_t timeoutMicroseconds, uint32_t& startTime, uint32_t& frequency);
+
+////////////////////////////////////////////////////////////////////////////////
+//Signal Generator
+////////////////////////////////////////////////////////////////////////////////
+#define TARGET_SIGNAL_GENERATOR_SUPPORTED
+
+typedef void(*LPC17_SignalGenerator_CompletedHandler)(uint32_t pin);
+
+TinyCLR_Result LPC17_SignalGenerator_Write(uint32_t pin, TinyCLR_Gpio_PinValue idleState, const uint64_t* durations, size_t count, LPC17_SignalGenerator_CompletedHandler handler);
+TinyCLR_Result LPC17_SignalGenerator_Abort();
+bool LPC17_SignalGenerator_IsBusy();
+
 ////////////////////////////////////////////////////////////////////////////////
 //SPI
 ////////////////////////////////////////////////////////////////////////////////
@@ -428,6 +498,19 @@ TinyCLR_Result LPC17_Display_DrawBuffer(const TinyCLR_Display_Controller* self,
 TinyCLR_Result LPC17_Display_DrawPixel(const TinyCLR_Display_Controller* self, uint32_t x, uint32_t y, uint64_t color);
 TinyCLR_Result LPC17_Display_WriteString(const TinyCLR_Display_Controller* self, const char* buffer, size_t length);
 
+#define TARGET_DISPLAY_COMPRESSED_SUPPORTED
+
+TinyCLR_Result LPC17_Display_DrawRle(const TinyCLR_Display_Controller* self, int32_t x, int32_t y, int32_t width, int32_t height, const uint8_t* data, size_t length);
+TinyCLR_Result LPC17_Display_DrawIndexed(const TinyCLR_Display_Controller* self, int32_t x, int32_t y, int32_t width, int32_t height, const uint8_t* data, const uint16_t* palette, size_t paletteCount);
+
+#define TARGET_DISPLAY_DOUBLE_BUFFER_SUPPORTED
+
+typedef void(*LPC17_Display_FlipHandler)(const TinyCLR_Display_Controller* self, uint64_t timestamp);
+
+TinyCLR_Result LPC17_Display_SetDoubleBuffering(const TinyCLR_Display_Controller* self, bool enable);
+TinyCLR_Result LPC17_Display_WaitForFlip(const TinyCLR_Display_Controller* self);
+TinyCLR_Result LPC17_Display_SetFlipHandler(const TinyCLR_Display_Controller* self, LPC17_Display_FlipHandler handler);
+
 //Startup
 void LPC17_Startup_Initialize();
 void LPC17_Startup_GetHeap(uint8_t*& start, size_t& length);
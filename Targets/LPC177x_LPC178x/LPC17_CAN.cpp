@@ -26,7 +26,7 @@ static const uint32_t canDefaultBuffersSize[] = LPC17_CAN_BUFFER_DEFAULT_SIZE;
 
 #define CAN_TRANSFER_TIMEOUT 0xFFFF
 
-#define CAN_MEM_BASE        0xE0038000
+#define CAN_MEM_BASE        LPC_CANAF_RAM_BASE
 
 /* Acceptance filter mode in AFMR register */
 #define ACCF_OFF                0x01
@@ -1984,6 +1984,10 @@ struct LPC17_Can_Filter {
     uint32_t *lowerBoundFilters;
     uint32_t *upperBoundFilters;
     uint32_t groupFiltersSize;
+
+    uint32_t *fullCanIds;
+    uint32_t fullCanSize;
+    uint32_t fullCanFirstObject;
 };
 
 typedef struct {
@@ -2068,57 +2072,196 @@ void CAN_DisableGroupFilters(int32_t controllerIndex) {
     }
 }
 
+void CAN_DisableFullCanFilters(int32_t controllerIndex) {
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    auto state = &canStates[controllerIndex];
+
+    auto memoryProvider = (const TinyCLR_Memory_Manager*)apiManager->FindDefault(apiManager, TinyCLR_Api_Type::MemoryManager);
+
+    if (state->canDataFilter.fullCanSize && state->canDataFilter.fullCanIds != nullptr) {
+        memoryProvider->Free(memoryProvider, state->canDataFilter.fullCanIds);
+
+        state->canDataFilter.fullCanSize = 0;
+    }
+}
+
 /******************************************************************************
 ** Function name:        CAN_SetACCF_Lookup
 **
-** Descriptions:        Initialize CAN, install CAN interrupt handler
+** Descriptions:        Compile the filters of both controllers into the
+**                      acceptance filter RAM
 **
-** parameters:            bitrate
-** Returned value:        true or false, false if initialization failed.
+** parameters:            None
+** Returned value:        true or false, false if the filters do not fit.
 **
 ******************************************************************************/
-void CAN_SetACCF_Lookup(void) {
-    uint32_t address = 0;
-    uint32_t i;
-    uint32_t ID_high, ID_low;
+// The filters take ids without a frame format, so an id up to 0x7FF is entered in both the standard and the extended
+// sections, the same way the software filter matches it. Every section is sorted by controller then id, the
+// controller number is in the top bits so each controller's sorted filters are written one after the other.
+// A controller without filters gets groups covering every id, the acceptance filter applies to both controllers.
+#define ACCF_RAM_WORDS              512
+#define ACCF_STD_ID_MAX             0x7FF
+#define ACCF_EXT_ID_MAX             0x1FFFFFFF
+#define ACCF_STD_DISABLE            (1 << 12)
+#define ACCF_FULLCAN_OBJECT_WORDS   3
+
+struct CanLookupWriter {
+    uint32_t address;
+    uint32_t pending;
+    bool hasPending;
+};
+
+static void CAN_WriteLookupWord(CanLookupWriter& writer, uint32_t value) {
+    *((volatile uint32_t *)(CAN_MEM_BASE + writer.address)) = value;
+
+    writer.address += 4;
+}
+
+// standard entries are 16 bit, the first of a pair goes in the upper half
+static void CAN_WriteLookupHalf(CanLookupWriter& writer, uint32_t entry) {
+    if (!writer.hasPending) {
+        writer.pending = entry;
+        writer.hasPending = true;
+
+        return;
+    }
+
+    CAN_WriteLookupWord(writer, (writer.pending << 16) | entry);
+
+    writer.hasPending = false;
+}
+
+// an odd section ends with a disabled copy of its last entry, it still sorts after it
+static void CAN_FlushLookupHalf(CanLookupWriter& writer) {
+    if (writer.hasPending)
+        CAN_WriteLookupHalf(writer, writer.pending | ACCF_STD_DISABLE);
+}
+
+static bool CAN_HasFilters(CanState* state) {
+    return state->canDataFilter.matchFiltersSize > 0 || state->canDataFilter.groupFiltersSize > 0;
+}
+
+static uint32_t CAN_CountLookupWords() {
+    uint32_t fullCan = 0, standard = 0, standardGroups = 0, extended = 0, extendedGroups = 0;
+
+    for (auto controllerIndex = 0; controllerIndex < TOTAL_CAN_CONTROLLERS; controllerIndex++) {
+        auto& filter = canStates[controllerIndex].canDataFilter;
+
+        fullCan += filter.fullCanSize;
+
+        if (!CAN_HasFilters(&canStates[controllerIndex])) {
+            standardGroups++;
+            extendedGroups++;
+
+            continue;
+        }
+
+        for (auto i = 0; i < filter.matchFiltersSize; i++)
+            if (filter.matchFilters[i] <= ACCF_STD_ID_MAX)
+                standard++;
+
+        for (auto i = 0; i < filter.groupFiltersSize; i++)
+            if (filter.lowerBoundFilters[i] <= ACCF_STD_ID_MAX)
+                standardGroups++;
+
+        extended += filter.matchFiltersSize;
+        extendedGroups += filter.groupFiltersSize;
+    }
+
+    return (fullCan + 1) / 2 + (standard + 1) / 2 + standardGroups + extended + extendedGroups * 2 + fullCan * ACCF_FULLCAN_OBJECT_WORDS;
+}
+
+bool CAN_SetACCF_Lookup(void) {
+    if (CAN_CountLookupWords() > ACCF_RAM_WORDS)
+        return false;
+
+    CanLookupWriter writer = { 0, 0, false };
+    uint32_t fullCanObjects = 0;
+
+    // FullCAN standard frame, the section starts at 0
+    for (auto controllerIndex = 0; controllerIndex < TOTAL_CAN_CONTROLLERS; controllerIndex++) {
+        auto& filter = canStates[controllerIndex].canDataFilter;
+
+        filter.fullCanFirstObject = fullCanObjects;
+
+        for (auto i = 0; i < filter.fullCanSize; i++)
+            CAN_WriteLookupHalf(writer, (controllerIndex << 13) | filter.fullCanIds[i]);
+
+        fullCanObjects += filter.fullCanSize;
+    }
+
+    CAN_FlushLookupHalf(writer);
 
     // Set explicit standard Frame
-    SFF_sa = address;
-    for (i = 0; i < ACCF_IDEN_NUM; i += 2) {
-        ID_low = (i << 29) | (EXP_STD_ID << 16);
-        ID_high = ((i + 1) << 13) | (EXP_STD_ID << 0);
-        *((volatile uint32_t *)(CAN_MEM_BASE + address)) = ID_low | ID_high;
-        address += 4;
+    SFF_sa = writer.address;
+
+    for (auto controllerIndex = 0; controllerIndex < TOTAL_CAN_CONTROLLERS; controllerIndex++) {
+        auto& filter = canStates[controllerIndex].canDataFilter;
+
+        if (CAN_HasFilters(&canStates[controllerIndex]))
+            for (auto i = 0; i < filter.matchFiltersSize && filter.matchFilters[i] <= ACCF_STD_ID_MAX; i++)
+                CAN_WriteLookupHalf(writer, (controllerIndex << 13) | filter.matchFilters[i]);
     }
 
+    CAN_FlushLookupHalf(writer);
+
     // Set group standard Frame
-    SFF_GRP_sa = address;
-    for (i = 0; i < ACCF_IDEN_NUM; i += 2) {
-        ID_low = (i << 29) | (GRP_STD_ID << 16);
-        ID_high = ((i + 1) << 13) | (GRP_STD_ID << 0);
-        *((volatile uint32_t *)(CAN_MEM_BASE + address)) = ID_low | ID_high;
-        address += 4;
+    SFF_GRP_sa = writer.address;
+
+    for (auto controllerIndex = 0; controllerIndex < TOTAL_CAN_CONTROLLERS; controllerIndex++) {
+        auto& filter = canStates[controllerIndex].canDataFilter;
+
+        if (!CAN_HasFilters(&canStates[controllerIndex])) {
+            CAN_WriteLookupWord(writer, (controllerIndex << 29) | (controllerIndex << 13) | ACCF_STD_ID_MAX);
+
+            continue;
+        }
+
+        for (auto i = 0; i < filter.groupFiltersSize && filter.lowerBoundFilters[i] <= ACCF_STD_ID_MAX; i++) {
+            auto upperBound = filter.upperBoundFilters[i] < ACCF_STD_ID_MAX ? filter.upperBoundFilters[i] : ACCF_STD_ID_MAX;
+
+            CAN_WriteLookupWord(writer, (controllerIndex << 29) | (filter.lowerBoundFilters[i] << 16) | (controllerIndex << 13) | upperBound);
+        }
     }
 
     // Set explicit extended Frame
-    EFF_sa = address;
-    for (i = 0; i < ACCF_IDEN_NUM; i++) {
-        ID_low = (i << 29) | (EXP_EXT_ID << 0);
-        *((volatile uint32_t *)(CAN_MEM_BASE + address)) = ID_low;
-        address += 4;
+    EFF_sa = writer.address;
+
+    for (auto controllerIndex = 0; controllerIndex < TOTAL_CAN_CONTROLLERS; controllerIndex++) {
+        auto& filter = canStates[controllerIndex].canDataFilter;
+
+        if (CAN_HasFilters(&canStates[controllerIndex]))
+            for (auto i = 0; i < filter.matchFiltersSize; i++)
+                CAN_WriteLookupWord(writer, (controllerIndex << 29) | (filter.matchFilters[i] & ACCF_EXT_ID_MAX));
     }
 
     // Set group extended Frame
-    EFF_GRP_sa = address;
-    for (i = 0; i < ACCF_IDEN_NUM; i++) {
-        ID_low = (i << 29) | (GRP_EXT_ID << 0);
-        *((volatile uint32_t *)(CAN_MEM_BASE + address)) = ID_low;
-        address += 4;
+    EFF_GRP_sa = writer.address;
+
+    for (auto controllerIndex = 0; controllerIndex < TOTAL_CAN_CONTROLLERS; controllerIndex++) {
+        auto& filter = canStates[controllerIndex].canDataFilter;
+
+        if (!CAN_HasFilters(&canStates[controllerIndex])) {
+            CAN_WriteLookupWord(writer, (controllerIndex << 29));
+            CAN_WriteLookupWord(writer, (controllerIndex << 29) | ACCF_EXT_ID_MAX);
+
+            continue;
+        }
+
+        for (auto i = 0; i < filter.groupFiltersSize; i++) {
+            CAN_WriteLookupWord(writer, (controllerIndex << 29) | (filter.lowerBoundFilters[i] & ACCF_EXT_ID_MAX));
+            CAN_WriteLookupWord(writer, (controllerIndex << 29) | (filter.upperBoundFilters[i] & ACCF_EXT_ID_MAX));
+        }
     }
 
-    // Set End of Table
-    ENDofTable = address;
-    return;
+    // Set End of Table, the FullCAN message objects follow it
+    ENDofTable = writer.address;
+
+    for (auto i = 0; i < fullCanObjects * ACCF_FULLCAN_OBJECT_WORDS; i++)
+        CAN_WriteLookupWord(writer, 0);
+
+    return true;
 }
 
 /******************************************************************************
@@ -2147,8 +2290,9 @@ void CAN_SetACCF(uint32_t ACCFMode) {
     case ACCF_ON:
     case ACCF_FULLCAN:
         AFMR = ACCF_OFF;
-        CAN_SetACCF_Lookup();
-        AFMR = ACCFMode;
+
+        // too many filters for the table, CAN_ISR_Rx filters in software
+        AFMR = CAN_SetACCF_Lookup() ? ACCFMode : ACCF_BYPASS;
         break;
 
     default:
@@ -2157,6 +2301,19 @@ void CAN_SetACCF(uint32_t ACCFMode) {
     return;
 }
 
+// called whenever the filters of either controller change
+void CAN_UpdateACCF() {
+    auto filters = false;
+    auto fullCan = false;
+
+    for (auto controllerIndex = 0; controllerIndex < TOTAL_CAN_CONTROLLERS; controllerIndex++) {
+        filters |= CAN_HasFilters(&canStates[controllerIndex]);
+        fullCan |= canStates[controllerIndex].canDataFilter.fullCanSize > 0;
+    }
+
+    CAN_SetACCF(fullCan ? ACCF_FULLCAN : (filters ? ACCF_ON : ACCF_BYPASS));
+}
+
 bool InsertionSort2CheckOverlap(uint32_t *lowerBounds, uint32_t *upperBounds, int32_t length) {
 
     uint32_t i, j, tmp, tmp2;
@@ -2446,6 +2603,7 @@ TinyCLR_Result LPC17_Can_Acquire(const TinyCLR_Can_Controller* self) {
 
         state->canDataFilter.matchFiltersSize = 0;
         state->canDataFilter.groupFiltersSize = 0;
+        state->canDataFilter.fullCanSize = 0;
 
         state->canRxMessagesFifo = nullptr;
 
@@ -2455,7 +2613,7 @@ TinyCLR_Result LPC17_Can_Acquire(const TinyCLR_Can_Controller* self) {
         if (controllerIndex == 1)
             LPC_SC->PCONP |= (1 << 14);    // Enable clock to the peripheral
 
-        CAN_SetACCF(ACCF_BYPASS);
+        CAN_UpdateACCF();
     }
 
     state->initializeCount++;
@@ -2487,6 +2645,9 @@ TinyCLR_Result LPC17_Can_Release(const TinyCLR_Can_Controller* self) {
 
         CAN_DisableExplicitFilters(controllerIndex);
         CAN_DisableGroupFilters(controllerIndex);
+        CAN_DisableFullCanFilters(controllerIndex);
+
+        CAN_UpdateACCF();
 
         LPC17_Gpio_ClosePin(canTxPins[controllerIndex].number);
         LPC17_Gpio_ClosePin(canRxPins[controllerIndex].number);
@@ -2732,6 +2893,8 @@ TinyCLR_Result LPC17_Can_SetExplicitFilters(const TinyCLR_Can_Controller* self,
 
         state->canDataFilter.matchFiltersSize = count;
         state->canDataFilter.matchFilters = _matchFilters;
+
+        CAN_UpdateACCF();
     }
 
     return TinyCLR_Result::Success;
@@ -2775,8 +2938,95 @@ TinyCLR_Result LPC17_Can_SetGroupFilters(const TinyCLR_Can_Controller* self, con
         state->canDataFilter.groupFiltersSize = count;
         state->canDataFilter.lowerBoundFilters = _lowerBoundFilters;
         state->canDataFilter.upperBoundFilters = _upperBoundFilters;
+
+        CAN_UpdateACCF();
+    }
+
+    return TinyCLR_Result::Success;
+}
+
+// FullCAN: frames with these standard ids are stored by the acceptance filter into its own RAM, one message object per
+// id, and never reach the receive buffer or interrupt. Read the latest frame of an id with LPC17_Can_ReadFullCanMessage.
+TinyCLR_Result LPC17_Can_SetFullCanFilters(const TinyCLR_Can_Controller* self, const uint32_t* ids, size_t count) {
+    uint32_t *_fullCanIds = nullptr;
+
+    for (auto i = 0; i < count; i++)
+        if (ids[i] > ACCF_STD_ID_MAX)
+            return TinyCLR_Result::ArgumentOutOfRange;
+
+    if (count > 0) {
+        auto memoryProvider = (const TinyCLR_Memory_Manager*)apiManager->FindDefault(apiManager, TinyCLR_Api_Type::MemoryManager);
+
+        _fullCanIds = (uint32_t*)memoryProvider->Allocate(memoryProvider, count * sizeof(uint32_t));
+
+        if (!_fullCanIds)
+            return TinyCLR_Result::OutOfMemory;
+
+        memcpy(_fullCanIds, ids, count * sizeof(uint32_t));
+
+        std::sort(_fullCanIds, _fullCanIds + count);
     }
 
+    {
+        DISABLE_INTERRUPTS_SCOPED(irq);
+
+        auto state = reinterpret_cast<CanState*>(self->ApiInfo->State);
+        auto controllerIndex = state->controllerIndex;
+
+        CAN_DisableFullCanFilters(controllerIndex);
+
+        state->canDataFilter.fullCanSize = count;
+        state->canDataFilter.fullCanIds = _fullCanIds;
+
+        CAN_UpdateACCF();
+    }
+
+    return (count == 0 || AFMR == ACCF_FULLCAN) ? TinyCLR_Result::Success : TinyCLR_Result::OutOfMemory;
+}
+
+// received is false when no frame with the id arrived since the last read
+TinyCLR_Result LPC17_Can_ReadFullCanMessage(const TinyCLR_Can_Controller* self, uint32_t id, TinyCLR_Can_Message& message, bool& received) {
+    auto state = reinterpret_cast<CanState*>(self->ApiInfo->State);
+
+    received = false;
+
+    if (AFMR != ACCF_FULLCAN || state->canDataFilter.fullCanSize == 0)
+        return TinyCLR_Result::InvalidOperation;
+
+    auto index = BinarySearch(state->canDataFilter.fullCanIds, 0, state->canDataFilter.fullCanSize - 1, id);
+
+    if (index < 0)
+        return TinyCLR_Result::ArgumentInvalid;
+
+    auto object = (volatile uint32_t *)(CAN_MEM_BASE + ENDofTable + (state->canDataFilter.fullCanFirstObject + index) * ACCF_FULLCAN_OBJECT_WORDS * 4);
+
+    // SEM is 11 once the acceptance filter finished storing a frame, 01 while it is storing one
+    if (((object[0] >> 24) & 0x3) != 0x3)
+        return TinyCLR_Result::Success;
+
+    uint32_t frame, dataA, dataB;
+
+    do {
+        object[0] &= ~(0x3 << 24);
+
+        frame = object[0];
+        dataA = object[1];
+        dataB = object[2];
+    } while (((object[0] >> 24) & 0x3) != 0); // stored again while reading
+
+    auto data32 = (uint32_t*)message.Data;
+
+    message.ArbitrationId = frame & ACCF_STD_ID_MAX;
+    message.IsExtendedId = false;
+    message.IsRemoteTransmissionRequest = (frame & 0x40000000) != 0;
+    message.Length = (frame >> 16) & 0x0F;
+    message.Timestamp = LPC17_Time_GetCurrentProcessorTime();
+
+    data32[0] = dataA;
+    data32[1] = dataB;
+
+    received = true;
+
     return TinyCLR_Result::Success;
 }
 
@@ -0,0 +1,284 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "LPC17.h"
+
+// The eight GPDMA channels are handed out to the drivers that need them (SD, SPI, UART...) through the shared
+// allocator, lower channels have the higher priority and are given out first. A channel is loaded from the first
+// descriptor and follows the list on its own. Channels started with a handler report through the DMA interrupt,
+// the others are polled with LPC17_Dma_Wait. The controller and its interrupt are on while any channel is held.
+#define LPC17_DMA_CONFIG_ENABLE 0x1
+
+#define LPC17_DMA_CCONFIG_E (1 << 0)
+#define LPC17_DMA_CCONFIG_IE (1 << 14)
+#define LPC17_DMA_CCONFIG_ITC (1 << 15)
+#define LPC17_DMA_CCONFIG_A (1 << 17)
+#define LPC17_DMA_CCONFIG_H (1 << 18)
+
+#define LPC17_DMA_CONTROL_WIDTH_MASK 0x7
+
+// Bounds the walk over a descriptor list when counting bytes, a ring is never followed to its end
+#define LPC17_DMA_MAX_DESCRIPTORS 64
+
+// Memory every driver may hand to the GPDMA: the peripheral SRAM and the external memory. Flash and the main SRAM
+// are left to the CPU.
+#define LPC17_DMA_PERIPHERAL_SRAM_START 0x20000000
+#define LPC17_DMA_PERIPHERAL_SRAM_END 0x20008000
+#define LPC17_DMA_EXTERNAL_MEMORY_START 0x80000000
+#define LPC17_DMA_EXTERNAL_MEMORY_END 0xE0000000
+
+struct DmaChannelState {
+    LPC17_Dma_EventHandler handler;
+    void* param;
+
+    LPC17_Dma_Descriptor first;
+    const LPC17_Dma_Descriptor* current; // first item not counted in the statistics yet
+};
+
+struct DmaState {
+    DmaAllocator allocator;
+    DmaChannelState channels[LPC17_DMA_CHANNEL_COUNT];
+};
+
+static DmaState dmaState;
+
+static LPC_GPDMACH_TypeDef* LPC17_Dma_GetChannel(int32_t channel) {
+    return reinterpret_cast<LPC_GPDMACH_TypeDef*>(LPC_GPDMACH0_BASE + (LPC_GPDMACH1_BASE - LPC_GPDMACH0_BASE) * channel);
+}
+
+// Adds up the items from current to the next one that raises the terminal count (or to the end of the list) and
+// moves current past them
+static size_t LPC17_Dma_CountDescriptors(DmaChannelState* channelState, bool toEnd) {
+    size_t bytes = 0;
+
+    for (auto i = 0; i < LPC17_DMA_MAX_DESCRIPTORS && channelState->current != nullptr; i++) {
+        auto descriptor = channelState->current;
+
+        bytes += (descriptor->control & LPC17_DMA_CONTROL_TRANSFER_SIZE_MASK) << ((descriptor->control >> LPC17_DMA_CONTROL_SWIDTH_BIT) & LPC17_DMA_CONTROL_WIDTH_MASK);
+
+        channelState->current = reinterpret_cast<const LPC17_Dma_Descriptor*>(descriptor->next);
+
+        if (!toEnd && (descriptor->control & LPC17_DMA_CONTROL_I))
+            break;
+    }
+
+    return bytes;
+}
+
+void LPC17_Dma_InterruptHandler(void* param) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    auto state = &dmaState;
+
+    // only channels started with a handler have their interrupts unmasked
+    uint32_t tc = LPC_GPDMA->IntTCStat;
+    uint32_t err = LPC_GPDMA->IntErrStat;
+
+    LPC_GPDMA->IntTCClear = tc;
+    LPC_GPDMA->IntErrClr = err;
+
+    for (auto channel = 0; channel < LPC17_DMA_CHANNEL_COUNT; channel++) {
+        auto bit = static_cast<uint32_t>(1 << channel);
+        auto channelState = &state->channels[channel];
+
+        if (err & bit) {
+            DmaAllocator_RecordError(&state->allocator, channel);
+
+            if (channelState->handler != nullptr)
+                channelState->handler(channel, LPC17_Dma_Event::Error, channelState->param);
+        }
+        else if (tc & bit) {
+            DmaAllocator_RecordTransfer(&state->allocator, channel, LPC17_Dma_CountDescriptors(channelState, false));
+
+            if (channelState->handler != nullptr)
+                channelState->handler(channel, LPC17_Dma_Event::Completed, channelState->param);
+        }
+    }
+}
+
+int32_t LPC17_Dma_AcquireChannel(uint32_t candidates, const void* owner) {
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    auto state = &dmaState;
+
+    if (state->allocator.channelCount == 0)
+        DmaAllocator_Initialize(&state->allocator, LPC17_DMA_CHANNEL_COUNT);
+
+    auto powered = DmaAllocator_GetAcquiredCount(&state->allocator) > 0;
+    auto channel = DmaAllocator_Acquire(&state->allocator, candidates, owner);
+
+    if (channel == LPC17_DMA_CHANNEL_NONE)
+        return LPC17_DMA_CHANNEL_NONE;
+
+    if (!powered) {
+        LPC_SC->PCONP |= PCONP_PCGPDMA;
+
+        LPC_GPDMA->Config = LPC17_DMA_CONFIG_ENABLE;
+
+        while (!(LPC_GPDMA->Config & LPC17_DMA_CONFIG_ENABLE));
+
+        LPC_GPDMA->IntTCClear = 0xFF;
+        LPC_GPDMA->IntErrClr = 0xFF;
+
+        LPC17_InterruptInternal_Activate(DMA_IRQn, (uint32_t*)&LPC17_Dma_InterruptHandler, 0);
+    }
+
+    LPC17_Dma_GetChannel(channel)->CConfig = 0;
+
+    LPC_GPDMA->IntTCClear = (1 << channel);
+    LPC_GPDMA->IntErrClr = (1 << channel);
+
+    state->channels[channel].handler = nullptr;
+    state->channels[channel].param = nullptr;
+    state->channels[channel].current = nullptr;
+
+    return channel;
+}
+
+void LPC17_Dma_ReleaseChannel(int32_t channel, const void* owner) {
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    auto state = &dmaState;
+
+    if (owner == nullptr || DmaAllocator_GetOwner(&state->allocator, channel) != owner)
+        return;
+
+    LPC17_Dma_Stop(channel);
+
+    state->channels[channel].handler = nullptr;
+
+    DmaAllocator_Release(&state->allocator, channel, owner);
+
+    if (DmaAllocator_GetAcquiredCount(&state->allocator) == 0) {
+        LPC17_InterruptInternal_Deactivate(DMA_IRQn);
+
+        LPC_GPDMA->Config = 0;
+
+        LPC_SC->PCONP &= ~PCONP_PCGPDMA;
+    }
+}
+
+// config holds the peripherals and flow control (LPC17_DMA_CONFIG_*), the enable and interrupt bits are set here.
+// The first descriptor is copied into the channel and may be a local unless a ring links back to it.
+TinyCLR_Result LPC17_Dma_Start(int32_t channel, const LPC17_Dma_Descriptor* first, uint32_t config, LPC17_Dma_EventHandler handler, void* param) {
+    auto state = &dmaState;
+
+    if (first == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    if (!DmaAllocator_IsAcquired(&state->allocator, channel))
+        return TinyCLR_Result::InvalidOperation;
+
+    auto ch = LPC17_Dma_GetChannel(channel);
+
+    if (ch->CConfig & LPC17_DMA_CCONFIG_E)
+        return TinyCLR_Result::Busy;
+
+    auto channelState = &state->channels[channel];
+
+    channelState->handler = handler;
+    channelState->param = param;
+    channelState->first = *first;
+    channelState->current = &channelState->first;
+
+    LPC_GPDMA->IntTCClear = (1 << channel);
+    LPC_GPDMA->IntErrClr = (1 << channel);
+
+    ch->CSrcAddr = first->source;
+    ch->CDestAddr = first->destination;
+    ch->CLLI = first->next;
+    ch->CControl = first->control;
+    ch->CConfig = (config & ~(LPC17_DMA_CCONFIG_E | LPC17_DMA_CCONFIG_IE | LPC17_DMA_CCONFIG_ITC | LPC17_DMA_CCONFIG_H)) | (handler != nullptr ? (LPC17_DMA_CCONFIG_IE | LPC17_DMA_CCONFIG_ITC) : 0) | LPC17_DMA_CCONFIG_E;
+
+    return TinyCLR_Result::Success;
+}
+
+// Halts the channel so a peripheral to memory transfer drains its FIFO, then disables it
+void LPC17_Dma_Stop(int32_t channel) {
+    if (!DmaAllocator_IsAcquired(&dmaState.allocator, channel))
+        return;
+
+    auto ch = LPC17_Dma_GetChannel(channel);
+
+    if (ch->CConfig & LPC17_DMA_CCONFIG_E) {
+        ch->CConfig |= LPC17_DMA_CCONFIG_H;
+
+        while (ch->CConfig & LPC17_DMA_CCONFIG_A);
+    }
+
+    ch->CConfig = 0;
+
+    LPC_GPDMA->IntTCClear = (1 << channel);
+    LPC_GPDMA->IntErrClr = (1 << channel);
+
+    dmaState.channels[channel].current = nullptr;
+}
+
+bool LPC17_Dma_IsBusy(int32_t channel) {
+    if (!DmaAllocator_IsAcquired(&dmaState.allocator, channel))
+        return false;
+
+    return (LPC17_Dma_GetChannel(channel)->CConfig & LPC17_DMA_CCONFIG_E) != 0;
+}
+
+// Polls a list to its end, a ring never ends and is stopped instead. Returns false when the controller reported a bus
+// error, the channel is then disabled.
+bool LPC17_Dma_Wait(int32_t channel) {
+    auto state = &dmaState;
+
+    if (!DmaAllocator_IsAcquired(&state->allocator, channel))
+        return false;
+
+    auto ch = LPC17_Dma_GetChannel(channel);
+    auto bit = static_cast<uint32_t>(1 << channel);
+
+    // the raw status still shows an error on channels without interrupts
+    while ((ch->CConfig & LPC17_DMA_CCONFIG_E) && !(LPC_GPDMA->RawIntErrStat & bit));
+
+    auto error = (LPC_GPDMA->RawIntErrStat & bit) != 0;
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    auto channelState = &state->channels[channel];
+
+    if (error) {
+        ch->CConfig = 0;
+
+        DmaAllocator_RecordError(&state->allocator, channel);
+    }
+    else if (channelState->current != nullptr) {
+        DmaAllocator_RecordTransfer(&state->allocator, channel, LPC17_Dma_CountDescriptors(channelState, true));
+    }
+
+    channelState->current = nullptr;
+
+    LPC_GPDMA->IntTCClear = bit;
+    LPC_GPDMA->IntErrClr = bit;
+
+    return !error;
+}
+
+const DmaAllocator_Statistics* LPC17_Dma_GetStatistics(int32_t channel) {
+    return DmaAllocator_GetStatistics(&dmaState.allocator, channel);
+}
+
+bool LPC17_Dma_IsReachable(const void* buffer, size_t length) {
+    auto start = reinterpret_cast<uint32_t>(buffer);
+    auto end = start + length;
+
+    if (end < start)
+        return false;
+
+    return (start >= LPC17_DMA_PERIPHERAL_SRAM_START && end <= LPC17_DMA_PERIPHERAL_SRAM_END) || (start >= LPC17_DMA_EXTERNAL_MEMORY_START && end <= LPC17_DMA_EXTERNAL_MEMORY_END);
+}
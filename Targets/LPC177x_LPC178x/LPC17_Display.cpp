@@ -370,6 +370,17 @@ uint32_t displayInitializeCount = 0;
 uint16_t* m_LPC17_Display_VituralRam = nullptr;
 size_t m_LPC17_DisplayBufferSize = 0;
 
+// With double buffering the controller scans m_LPC17_Display_FrontRam while drawing goes to m_LPC17_Display_VituralRam
+uint16_t* m_LPC17_Display_FrontRam = nullptr;
+volatile bool m_LPC17_Display_FlipPending = false;
+LPC17_Display_FlipHandler m_LPC17_Display_FlipHandler = nullptr;
+
+// Framebuffer rows drawn since the last flip, and the rows the back buffer has been missing since then
+int32_t m_LPC17_Display_DirtyTop = 0;
+int32_t m_LPC17_Display_DirtyBottom = 0;
+int32_t m_LPC17_Display_StaleTop = 0;
+int32_t m_LPC17_Display_StaleBottom = 0;
+
 uint8_t m_LPC17_Display_TextBuffer[LCD_MAX_COLUMN][LCD_MAX_ROW];
 
 LPC17xx_LCD_Rotation m_LPC17_Display_CurrentRotation = LPC17xx_LCD_Rotation::rotateNormal_0;
@@ -401,6 +412,133 @@ uint32_t* LPC17_Display_GetFrameBuffer();
 static TinyCLR_Display_Controller displayControllers[TOTAL_DISPLAY_CONTROLLERS];
 static TinyCLR_Api_Info displayApi[TOTAL_DISPLAY_CONTROLLERS];
 
+// the buffer the controller scans, the only one without double buffering
+static uint16_t* LPC17_Display_GetScanoutBuffer() {
+    return m_LPC17_Display_FrontRam != nullptr ? m_LPC17_Display_FrontRam : m_LPC17_Display_VituralRam;
+}
+
+static void LPC17_Display_MarkDirtyRows(int32_t top, int32_t bottom) {
+    int32_t screenHeight = m_LPC17_DisplayHeight;
+
+    if (m_LPC17_Display_FrontRam == nullptr)
+        return;
+
+    if (top < 0)
+        top = 0;
+
+    if (bottom > screenHeight)
+        bottom = screenHeight;
+
+    if (top >= bottom)
+        return;
+
+    if (m_LPC17_Display_DirtyTop >= m_LPC17_Display_DirtyBottom) {
+        m_LPC17_Display_DirtyTop = top;
+        m_LPC17_Display_DirtyBottom = bottom;
+    }
+    else {
+        if (top < m_LPC17_Display_DirtyTop)
+            m_LPC17_Display_DirtyTop = top;
+
+        if (bottom > m_LPC17_Display_DirtyBottom)
+            m_LPC17_Display_DirtyBottom = bottom;
+    }
+}
+
+// Framebuffer rows covered by a rectangle of the rotated screen
+static void LPC17_Display_MarkDirty(int32_t x, int32_t y, int32_t width, int32_t height) {
+    int32_t screenHeight = m_LPC17_DisplayHeight;
+
+    switch (m_LPC17_Display_CurrentRotation) {
+    case LPC17xx_LCD_Rotation::rotateCCW_90:
+        LPC17_Display_MarkDirtyRows(screenHeight - x - width, screenHeight - x);
+        break;
+
+    case LPC17xx_LCD_Rotation::rotateCW_90:
+        LPC17_Display_MarkDirtyRows(x, x + width);
+        break;
+
+    case LPC17xx_LCD_Rotation::rotate_180:
+        LPC17_Display_MarkDirtyRows(screenHeight - y - height, screenHeight - y);
+        break;
+
+    default:
+        LPC17_Display_MarkDirtyRows(y, y + height);
+        break;
+    }
+}
+
+// The back buffer stays on screen until a pending flip is taken. After that it is brought up to date with the rows
+// drawn in the frame that was just presented.
+static void LPC17_Display_BeginDraw() {
+    if (m_LPC17_Display_FrontRam == nullptr)
+        return;
+
+    while (m_LPC17_Display_FlipPending);
+
+    if (m_LPC17_Display_StaleTop < m_LPC17_Display_StaleBottom) {
+        auto offset = m_LPC17_Display_StaleTop * m_LPC17_DisplayWidth;
+
+        memcpy(m_LPC17_Display_VituralRam + offset, m_LPC17_Display_FrontRam + offset, (m_LPC17_Display_StaleBottom - m_LPC17_Display_StaleTop) * m_LPC17_DisplayWidth * 2);
+
+        m_LPC17_Display_StaleTop = 0;
+        m_LPC17_Display_StaleBottom = 0;
+    }
+}
+
+static void LPC17_Display_FlipCompleted() {
+    m_LPC17_Display_FlipPending = false;
+
+    if (m_LPC17_Display_FlipHandler != nullptr)
+        m_LPC17_Display_FlipHandler(&displayControllers[0], LPC17_Time_GetCurrentProcessorTime());
+}
+
+#define LPC17_DISPLAY_INT_LNBU (1 << 2)
+
+void LPC17_Display_InterruptHandler(void* param) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    LPC17xx_LCDC & LCDC = *(LPC17xx_LCDC *)LPC17xx_LCDC::c_LCDC_Base;
+
+    if (LCDC.LCD_INTSTAT & LPC17_DISPLAY_INT_LNBU) {
+        LCDC.LCD_INTMSK &= ~LPC17_DISPLAY_INT_LNBU;
+        LCDC.LCD_INTCLR = LPC17_DISPLAY_INT_LNBU;
+
+        LPC17_Display_FlipCompleted();
+    }
+}
+
+// The upper panel base address is taken at the start of the next frame and the LNBU interrupt reports it. One raised
+// for the frame already started is cleared after the write, at worst the flip is reported a frame late.
+static void LPC17_Display_SetScanoutBuffer(uint16_t* buffer) {
+    LPC17xx_LCDC & LCDC = *(LPC17xx_LCDC *)LPC17xx_LCDC::c_LCDC_Base;
+
+    LCDC.LCD_UPBASE = (uint32_t)buffer;
+
+    LCDC.LCD_INTCLR = LPC17_DISPLAY_INT_LNBU;
+    LCDC.LCD_INTMSK |= LPC17_DISPLAY_INT_LNBU;
+}
+
+// Hands what was drawn to the controller for the next vertical blanking, drawing goes to the old front buffer from then on
+static void LPC17_Display_Present() {
+    if (m_LPC17_Display_FrontRam == nullptr || m_LPC17_DisplayEnable == false || m_LPC17_Display_DirtyTop >= m_LPC17_Display_DirtyBottom)
+        return;
+
+    auto front = m_LPC17_Display_VituralRam;
+
+    m_LPC17_Display_VituralRam = m_LPC17_Display_FrontRam;
+    m_LPC17_Display_FrontRam = front;
+
+    m_LPC17_Display_StaleTop = m_LPC17_Display_DirtyTop;
+    m_LPC17_Display_StaleBottom = m_LPC17_Display_DirtyBottom;
+    m_LPC17_Display_DirtyTop = 0;
+    m_LPC17_Display_DirtyBottom = 0;
+
+    m_LPC17_Display_FlipPending = true;
+
+    LPC17_Display_SetScanoutBuffer(front);
+}
+
 bool LPC17_Display_Initialize() {
     int32_t i;
     uint32_t * p32;
@@ -451,7 +589,7 @@ bool LPC17_Display_Initialize() {
     if (m_LPC17_Display_VituralRam == nullptr)
         return false;
 
-    LCDC.LCD_UPBASE = (uint32_t)&m_LPC17_Display_VituralRam[0];
+    LCDC.LCD_UPBASE = (uint32_t)LPC17_Display_GetScanoutBuffer();
 
     LPC17_Time_Delay(nullptr, 1000 * 10);
 
@@ -469,6 +607,9 @@ bool LPC17_Display_Uninitialize() {
 
     LPC17xx_LCDC & LCDC = *(LPC17xx_LCDC *)LPC17xx_LCDC::c_LCDC_Base;
 
+    // the controller stops before taking a pending flip, the new buffer is scanned from the next initialization
+    m_LPC17_Display_FlipPending = false;
+
     if (m_LPC17_DisplayEnable == false)
         return true;
 
@@ -616,7 +757,11 @@ void LPC17_Display_Clear() {
     if (m_LPC17_DisplayEnable == false || m_LPC17_Display_VituralRam == nullptr)
         return;
 
+    LPC17_Display_BeginDraw();
+
     memset((uint32_t*)m_LPC17_Display_VituralRam, 0, m_LPC17_DisplayBufferSize);
+
+    LPC17_Display_MarkDirtyRows(0, m_LPC17_DisplayHeight);
 }
 
 const LPC17_Gpio_Pin g_Display_ControllerPins[] = LPC17_DISPLAY_CONTROLLER_PINS;
@@ -867,6 +1012,8 @@ TinyCLR_Result LPC17_Display_Release(const TinyCLR_Display_Controller* self) {
         m_LPC17_DisplayEnable = false;
 
         if (m_LPC17_Display_VituralRam != nullptr) {
+            LPC17_Display_SetDoubleBuffering(self, false);
+
             auto memoryProvider = (const TinyCLR_Memory_Manager*)apiManager->FindDefault(apiManager, TinyCLR_Api_Type::MemoryManager);
 
             memoryProvider->Free(memoryProvider, m_LPC17_Display_VituralRam);
@@ -935,6 +1082,8 @@ TinyCLR_Result LPC17_Display_SetConfiguration(const TinyCLR_Display_Controller*
         auto memoryProvider = (const TinyCLR_Memory_Manager*)apiManager->FindDefault(apiManager, TinyCLR_Api_Type::MemoryManager);
 
         if (m_LPC17_Display_VituralRam != nullptr) {
+            LPC17_Display_SetDoubleBuffering(self, false);
+
             memoryProvider->Free(memoryProvider, m_LPC17_Display_VituralRam);
 
             m_LPC17_Display_VituralRam = nullptr;
@@ -990,7 +1139,150 @@ TinyCLR_Result LPC17_Display_GetConfiguration(const TinyCLR_Display_Controller*
 }
 
 TinyCLR_Result LPC17_Display_DrawBuffer(const TinyCLR_Display_Controller* self, uint32_t x, uint32_t y, uint32_t width, uint32_t height, const uint8_t* data) {
+    LPC17_Display_BeginDraw();
+
     LPC17_Display_BitBltEx(x, y, width, height, (uint32_t*)data);
+
+    LPC17_Display_MarkDirty(x, y, width, height);
+    LPC17_Display_Present();
+
+    return TinyCLR_Result::Success;
+}
+
+// Address of the pixel at (x, y) in the rotated screen and the distance to the next pixel on its row
+static uint16_t* LPC17_Display_GetPixelAddress(int32_t x, int32_t y, int32_t& step) {
+    int32_t screenWidth = m_LPC17_DisplayWidth;
+    int32_t screenHeight = m_LPC17_DisplayHeight;
+
+    switch (m_LPC17_Display_CurrentRotation) {
+    case LPC17xx_LCD_Rotation::rotateCCW_90:
+        step = -screenWidth;
+        return m_LPC17_Display_VituralRam + (screenHeight - 1 - x) * screenWidth + y;
+
+    case LPC17xx_LCD_Rotation::rotateCW_90:
+        step = screenWidth;
+        return m_LPC17_Display_VituralRam + x * screenWidth + (screenWidth - 1 - y);
+
+    case LPC17xx_LCD_Rotation::rotate_180:
+        step = -1;
+        return m_LPC17_Display_VituralRam + (screenHeight - 1 - y) * screenWidth + (screenWidth - 1 - x);
+
+    default:
+        step = 1;
+        return m_LPC17_Display_VituralRam + y * screenWidth + x;
+    }
+}
+
+// The image is a list of runs, each starting with a header byte. With bit 7 set the RGB565 pixel that follows is
+// repeated (header & 0x7F) + 1 times, otherwise (header + 1) RGB565 pixels follow as they are. Pixels are little
+// endian and a run may carry on to the next row. Whatever falls outside the screen is decoded but not written.
+TinyCLR_Result LPC17_Display_DrawRle(const TinyCLR_Display_Controller* self, int32_t x, int32_t y, int32_t width, int32_t height, const uint8_t* data, size_t length) {
+    if (self != &displayControllers[0])
+        return TinyCLR_Result::NotSupported;
+
+    if (m_LPC17_DisplayEnable == false)
+        return TinyCLR_Result::InvalidOperation;
+
+    if (data == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    if (width <= 0 || height <= 0)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    int32_t screenWidth, screenHeight;
+
+    LPC17_Display_GetRotatedDimensions(&screenWidth, &screenHeight);
+
+    LPC17_Display_BeginDraw();
+    LPC17_Display_MarkDirty(x, y, width, height);
+
+    uint16_t* to = nullptr;
+    uint16_t color = 0;
+    int32_t row = 0, col = 0, step = 0;
+    size_t i = 0;
+    auto visible = false;
+
+    while (row < height) {
+        if (i >= length)
+            return TinyCLR_Result::ArgumentOutOfRange;
+
+        auto header = data[i++];
+        auto repeat = (header & 0x80) != 0;
+        int32_t count = (header & 0x7F) + 1;
+
+        if (length - i < (repeat ? 2 : static_cast<size_t>(count) * 2))
+            return TinyCLR_Result::ArgumentOutOfRange;
+
+        for (auto n = 0; n < count && row < height; n++) {
+            if (n == 0 || !repeat) {
+                color = data[i] | (data[i + 1] << 8);
+                i += 2;
+            }
+
+            if (col == 0) {
+                visible = (y + row) >= 0 && (y + row) < screenHeight;
+                to = LPC17_Display_GetPixelAddress(x, y + row, step);
+            }
+
+            if (visible && (x + col) >= 0 && (x + col) < screenWidth)
+                *to = color;
+
+            to += step;
+
+            if (++col == width) {
+                col = 0;
+                row++;
+            }
+        }
+    }
+
+    LPC17_Display_Present();
+
+    return TinyCLR_Result::Success;
+}
+
+// One byte per pixel, each looked up in a table of RGB565 colors. Indexes past the end of the table leave the pixel as
+// it is, so they can be used for transparency.
+TinyCLR_Result LPC17_Display_DrawIndexed(const TinyCLR_Display_Controller* self, int32_t x, int32_t y, int32_t width, int32_t height, const uint8_t* data, const uint16_t* palette, size_t paletteCount) {
+    if (self != &displayControllers[0])
+        return TinyCLR_Result::NotSupported;
+
+    if (m_LPC17_DisplayEnable == false)
+        return TinyCLR_Result::InvalidOperation;
+
+    if (data == nullptr || palette == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    if (width <= 0 || height <= 0 || paletteCount == 0)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    int32_t screenWidth, screenHeight;
+
+    LPC17_Display_GetRotatedDimensions(&screenWidth, &screenHeight);
+
+    LPC17_Display_BeginDraw();
+
+    auto first = x < 0 ? -x : 0;
+    auto last = (x + width) > screenWidth ? screenWidth - x : width;
+
+    for (auto row = 0; row < height; row++, data += width) {
+        if ((y + row) < 0 || (y + row) >= screenHeight || first >= last)
+            continue;
+
+        int32_t step;
+        auto to = LPC17_Display_GetPixelAddress(x + first, y + row, step);
+
+        for (auto col = first; col < last; col++, to += step) {
+            auto index = data[col];
+
+            if (index < paletteCount)
+                *to = palette[index];
+        }
+    }
+
+    LPC17_Display_MarkDirty(x, y, width, height);
+    LPC17_Display_Present();
+
     return TinyCLR_Result::Success;
 }
 
@@ -1007,17 +1299,93 @@ TinyCLR_Result LPC17_Display_DrawPixel(const TinyCLR_Display_Controller* self, u
     if (y >= m_LPC17_DisplayHeight)
         return TinyCLR_Result::InvalidOperation;
 
+    LPC17_Display_BeginDraw();
+
     loc = m_LPC17_Display_VituralRam + (y *m_LPC17_DisplayWidth) + (x);
 
     *loc = rgb565;
 
+    LPC17_Display_MarkDirtyRows(y, y + 1);
+
     return TinyCLR_Result::Success;
 }
 
 TinyCLR_Result LPC17_Display_DrawString(const TinyCLR_Display_Controller* self, const char* data, size_t length) {
+    LPC17_Display_BeginDraw();
+
     for (size_t i = 0; i < length; i++)
         LPC17_Display_WriteFormattedChar(data[i]);
 
+    LPC17_Display_MarkDirtyRows(0, m_LPC17_DisplayHeight);
+    LPC17_Display_Present();
+
+    return TinyCLR_Result::Success;
+}
+
+// A second framebuffer is drawn while the first one is on screen, DrawBuffer and DrawString flip them at the next
+// vertical blanking. The back buffer starts as a copy of the screen.
+TinyCLR_Result LPC17_Display_SetDoubleBuffering(const TinyCLR_Display_Controller* self, bool enable) {
+    if (m_LPC17_Display_VituralRam == nullptr)
+        return TinyCLR_Result::InvalidOperation;
+
+    if (enable == (m_LPC17_Display_FrontRam != nullptr))
+        return TinyCLR_Result::Success;
+
+    auto memoryProvider = (const TinyCLR_Memory_Manager*)apiManager->FindDefault(apiManager, TinyCLR_Api_Type::MemoryManager);
+
+    if (enable) {
+        auto back = (uint16_t*)memoryProvider->Allocate(memoryProvider, m_LPC17_DisplayBufferSize);
+
+        if (back == nullptr)
+            return TinyCLR_Result::OutOfMemory;
+
+        memcpy(back, m_LPC17_Display_VituralRam, m_LPC17_DisplayBufferSize);
+
+        m_LPC17_Display_FrontRam = m_LPC17_Display_VituralRam;
+        m_LPC17_Display_VituralRam = back;
+
+        m_LPC17_Display_DirtyTop = m_LPC17_Display_DirtyBottom = 0;
+        m_LPC17_Display_StaleTop = m_LPC17_Display_StaleBottom = 0;
+
+        LPC17_InterruptInternal_Activate(LCD_IRQn, (uint32_t*)&LPC17_Display_InterruptHandler, 0);
+    }
+    else {
+        while (m_LPC17_Display_FlipPending);
+
+        LPC17_Display_Present();
+
+        while (m_LPC17_Display_FlipPending);
+
+        LPC17_InterruptInternal_Deactivate(LCD_IRQn);
+
+        // the back buffer is only newer when it could not be presented because the display is off
+        if (m_LPC17_Display_DirtyTop < m_LPC17_Display_DirtyBottom) {
+            LPC17_Display_BeginDraw();
+
+            memoryProvider->Free(memoryProvider, m_LPC17_Display_FrontRam);
+        }
+        else {
+            memoryProvider->Free(memoryProvider, m_LPC17_Display_VituralRam);
+
+            m_LPC17_Display_VituralRam = m_LPC17_Display_FrontRam;
+        }
+
+        m_LPC17_Display_FrontRam = nullptr;
+    }
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result LPC17_Display_WaitForFlip(const TinyCLR_Display_Controller* self) {
+    while (m_LPC17_Display_FlipPending);
+
+    return TinyCLR_Result::Success;
+}
+
+// Called from the interrupt once the controller scans the newly presented buffer
+TinyCLR_Result LPC17_Display_SetFlipHandler(const TinyCLR_Display_Controller* self, LPC17_Display_FlipHandler handler) {
+    m_LPC17_Display_FlipHandler = handler;
+
     return TinyCLR_Result::Success;
 }
 
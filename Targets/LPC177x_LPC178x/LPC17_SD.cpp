@@ -243,8 +243,6 @@
 #define BLOCK_NUM            0x80
 #define FIFO_SIZE            16
 
-#define MAX_GPDMA_CHANNELS 8
-
 #define DMA_SRC            (0x20008000 - 512)
 
 #define DMA_DST            DMA_SRC
@@ -253,174 +251,104 @@
 #define DMA_SIZE        BLOCK_LENGTH
 
 /* DMA mode */
-#define M2M                0x00
 #define M2P                0x01
 #define P2M                0x02
-#define P2P                0x03
-
-/* General-purpose DMA Controller */
-#define DMA_BASE_ADDR        0x20080000
-#define GPDMA_INT_STAT         (*(volatile unsigned long *)(DMA_BASE_ADDR + 0x000))
-#define GPDMA_INT_TCSTAT       (*(volatile unsigned long *)(DMA_BASE_ADDR + 0x004))
-#define GPDMA_INT_TCCLR        (*(volatile unsigned long *)(DMA_BASE_ADDR + 0x008))
-#define GPDMA_INT_ERR_STAT     (*(volatile unsigned long *)(DMA_BASE_ADDR + 0x00C))
-#define GPDMA_INT_ERR_CLR      (*(volatile unsigned long *)(DMA_BASE_ADDR + 0x010))
-#define GPDMA_RAW_INT_TCSTAT   (*(volatile unsigned long *)(DMA_BASE_ADDR + 0x014))
-#define GPDMA_RAW_INT_ERR_STAT (*(volatile unsigned long *)(DMA_BASE_ADDR + 0x018))
-#define GPDMA_ENABLED_CHNS     (*(volatile unsigned long *)(DMA_BASE_ADDR + 0x01C))
-#define GPDMA_SOFT_BREQ        (*(volatile unsigned long *)(DMA_BASE_ADDR + 0x020))
-#define GPDMA_SOFT_SREQ        (*(volatile unsigned long *)(DMA_BASE_ADDR + 0x024))
-#define GPDMA_SOFT_LBREQ       (*(volatile unsigned long *)(DMA_BASE_ADDR + 0x028))
-#define GPDMA_SOFT_LSREQ       (*(volatile unsigned long *)(DMA_BASE_ADDR + 0x02C))
-#define GPDMA_CONFIG           (*(volatile unsigned long *)(DMA_BASE_ADDR + 0x030))
-#define GPDMA_SYNC             (*(volatile unsigned long *)(DMA_BASE_ADDR + 0x034))
-
-/* DMA channel 0 registers */
-#define GPDMA_CH0_SRC      (*(volatile unsigned long *)(DMA_BASE_ADDR + 0x100))
-#define GPDMA_CH0_DEST     (*(volatile unsigned long *)(DMA_BASE_ADDR + 0x104))
-#define GPDMA_CH0_LLI      (*(volatile unsigned long *)(DMA_BASE_ADDR + 0x108))
-#define GPDMA_CH0_CTRL     (*(volatile unsigned long *)(DMA_BASE_ADDR + 0x10C))
-#define GPDMA_CH0_CFG      (*(volatile unsigned long *)(DMA_BASE_ADDR + 0x110))
-
-/* DMA channel 1 registers */
-#define GPDMA_CH1_SRC      (*(volatile unsigned long *)(DMA_BASE_ADDR + 0x120))
-#define GPDMA_CH1_DEST     (*(volatile unsigned long *)(DMA_BASE_ADDR + 0x124))
-#define GPDMA_CH1_LLI      (*(volatile unsigned long *)(DMA_BASE_ADDR + 0x128))
-#define GPDMA_CH1_CTRL     (*(volatile unsigned long *)(DMA_BASE_ADDR + 0x12C))
-#define GPDMA_CH1_CFG      (*(volatile unsigned long *)(DMA_BASE_ADDR + 0x130))
-
-
-#define GPDMA_Source_Register_Channel(ChannelNumber)            (*(volatile unsigned long *)(DMA_BASE_ADDR + 0x100 + (ChannelNumber * 0x20)))
-#define GPDMA_Destination_Register_Channel(ChannelNumber)        (*(volatile unsigned long *)(DMA_BASE_ADDR + 0x104 + (ChannelNumber * 0x20)))
-#define GPDMA_LinkedListItem_Register_Channel(ChannelNumber)    (*(volatile unsigned long *)(DMA_BASE_ADDR + 0x108 + (ChannelNumber * 0x20)))
-#define GPDMA_Control_Register_Channel(ChannelNumber)            (*(volatile unsigned long *)(DMA_BASE_ADDR + 0x10C + (ChannelNumber * 0x20)))
-#define GPDMA_Config_Register_Channel(ChannelNumber)            (*(volatile unsigned long *)(DMA_BASE_ADDR + 0x110 + (ChannelNumber * 0x20)))
-
-/******************************************************************************
-** Function name:        DMAHandler
-**
-** Descriptions:        DMA interrupt handler for MCI
-**
-** parameters:            None
-** Returned value:        None
-**
-******************************************************************************/
 
-void DMAHandler(void * p) {
-    uint32_t regVal;
-    static uint32_t DMATCCount, DMAErrCount;
+/* The channel comes from the shared GPDMA service, the MCI is the flow controller so a whole multiple block
+** transfer is a single item and its transfer size only counts in the DMA statistics */
+#define DMA_MCI_REQUEST        1
+#define DMA_MCI_CONTROL        ((0x04 << 12) | (0x02 << 15) | (0x02 << LPC17_DMA_CONTROL_SWIDTH_BIT) | (0x02 << LPC17_DMA_CONTROL_DWIDTH_BIT))
 
-    regVal = GPDMA_INT_TCSTAT;
-    if (regVal) {
-        DMATCCount++;
-        GPDMA_INT_TCCLR |= regVal;
-    }
+/* Blocks per READ_MULTIPLE_BLOCK or WRITE_MULTIPLE_BLOCK, the transfer size field holds up to 4095 words */
+#define MCI_MAX_BLOCKS        16
 
-    regVal = GPDMA_INT_ERR_STAT;
-    if (regVal) {
-        DMAErrCount++;
-        GPDMA_INT_ERR_CLR |= regVal;
-    }
-}
+static int32_t sdCardDmaChannel = LPC17_DMA_CHANNEL_NONE;
+static uint8_t sdCardDmaOwner;
 
 /******************************************************************************
 ** Function name:        DMA_Init
 **
-** Descriptions:        Setup GPDMA clock and install interrupt handler
+** Descriptions:        Take a GPDMA channel from the DMA service
 **
 ** parameters:            None
-** Returned value:        true or false, false if ISR can't be installed.
+** Returned value:        true or false, false if no channel is free.
 **
 ******************************************************************************/
-void DMA_Init(void) {
-    LPC_SC->PCONP |= (1 << 29);
+bool DMA_Init(void) {
+    if (sdCardDmaChannel == LPC17_DMA_CHANNEL_NONE)
+        sdCardDmaChannel = LPC17_Dma_AcquireChannel(LPC17_DMA_ANY_CHANNEL, &sdCardDmaOwner);
 
-    GPDMA_INT_TCCLR = 0xFF;
-    GPDMA_INT_ERR_CLR = 0xFF;
+    return sdCardDmaChannel != LPC17_DMA_CHANNEL_NONE;
+}
 
-    GPDMA_CONFIG = 0x01;
+void DMA_Uninit(void) {
+    LPC17_Dma_ReleaseChannel(sdCardDmaChannel, &sdCardDmaOwner);
 
-    while (!(GPDMA_CONFIG & 0x01));
+    sdCardDmaChannel = LPC17_DMA_CHANNEL_NONE;
+}
 
-    LPC17_InterruptInternal_Activate(DMA_IRQn, (uint32_t*)&DMAHandler, (void*)0);
+/* A word aligned caller buffer the GPDMA reaches and that stays clear of DMA_SRC is used in place, anything else
+** goes through DMA_SRC a block at a time */
+bool DMA_IsReachable(const uint8_t *buffer, uint32_t length) {
+    uint32_t start = reinterpret_cast<uint32_t>(buffer);
+    uint32_t end = start + length;
+
+    if (start & 0x3)
+        return false;
+
+    if (start < DMA_SRC + DMA_SIZE && end > DMA_SRC)
+        return false;
+
+    return LPC17_Dma_IsReachable(buffer, length);
 }
 
 /******************************************************************************
 ** Function name:        DMA_Move
 **
 ** Descriptions:        Setup GPDMA for MCI DMA transfer
-**                        including mode, M2P or M2M, or P2M,
-**                        src and dest. address, control reg. etc.
+**                        M2P or P2M, src and dest. address,
+**                        control reg. etc.
 **
-** parameters:            Channel number, DMA mode
+** parameters:            DMA mode, memory address, length in bytes
 ** Returned value:        true or false
 **
 ******************************************************************************/
-uint32_t DMA_Move(uint32_t ChannelNum, uint32_t DMAMode) {
-
-    GPDMA_INT_TCCLR = 0xFF;
-    GPDMA_INT_ERR_CLR = 0xFF;
-
-    if (DMAMode == M2M) {
-        GPDMA_Source_Register_Channel(ChannelNum) = DMA_SRC;
-        GPDMA_Destination_Register_Channel(ChannelNum) = DMA_DST;
-
-        GPDMA_Control_Register_Channel(ChannelNum) = (0x80000000) |
-            (0x01 << 27) |
-            (0x01 << 26) |
-            (0x02 << 21) |
-            (0x02 << 18) |
-            (0x04 << 15) |
-            (0x04 << 12) |
-            (DMA_SIZE & 0x0FFF);
-    }
-    else if (DMAMode == M2P) {
-        GPDMA_Source_Register_Channel(ChannelNum) = DMA_SRC;
-        GPDMA_Destination_Register_Channel(ChannelNum) = DMA_MCIFIFO;
-
-        GPDMA_Control_Register_Channel(ChannelNum) = (0x80000000) |
-            (0x01 << 26) |
-            (0x02 << 21) |
-            (0x02 << 18) |
-            (0x02 << 15) |
-            (0x04 << 12) |
-            (DMA_SIZE & 0x0FFF);
-
-
-        GPDMA_Config_Register_Channel(ChannelNum) = (0x01 << 16) |
-            (0x05 << 11) |
-            (0x01 << 6) |
-            (0x00 << 1) |
-            (0x01 << 0);
-    }
-    else if (DMAMode == P2M) {
+uint32_t DMA_Move(uint32_t DMAMode, uint32_t address, uint32_t length) {
+    LPC17_Dma_Descriptor descriptor;
+    uint32_t config;
 
-        GPDMA_Source_Register_Channel(ChannelNum) = DMA_MCIFIFO;
-        GPDMA_Destination_Register_Channel(ChannelNum) = DMA_DST;
+    descriptor.next = 0;
 
-        GPDMA_Control_Register_Channel(ChannelNum) = (0x80000000) |
-            (0x01 << 27) |
-            (0x02 << 21) |
-            (0x02 << 18) |
-            (0x04 << 15) |
-            (0x02 << 12) |
-            (DMA_SIZE & 0x0FFF);
+    if (DMAMode == M2P) {
+        descriptor.source = address;
+        descriptor.destination = DMA_MCIFIFO;
+        descriptor.control = DMA_MCI_CONTROL | ((length / 4) & LPC17_DMA_CONTROL_TRANSFER_SIZE_MASK) | LPC17_DMA_CONTROL_SI;
 
-        GPDMA_Config_Register_Channel(ChannelNum) = (0x01 << 16) |
-            (0x06 << 11) |
-            (0x00 << 6) |
-            (0x01 << 1) |
-            (0x01 << 0);
+        config = LPC17_DMA_CONFIG_L | LPC17_DMA_CONFIG_M2P_DEST_CONTROL | (DMA_MCI_REQUEST << LPC17_DMA_CONFIG_DESTPERIPHERAL_BIT);
+    }
+    else if (DMAMode == P2M) {
+        descriptor.source = DMA_MCIFIFO;
+        descriptor.destination = address;
+        descriptor.control = DMA_MCI_CONTROL | ((length / 4) & LPC17_DMA_CONTROL_TRANSFER_SIZE_MASK) | LPC17_DMA_CONTROL_DI;
+
+        config = LPC17_DMA_CONFIG_L | LPC17_DMA_CONFIG_P2M_SRC_CONTROL | (DMA_MCI_REQUEST << LPC17_DMA_CONFIG_SRCPERIPHERAL_BIT);
     }
     else {
         return (false);
     }
 
-    GPDMA_CONFIG = 0x01;
+    // a block that failed on the MCI side can leave the channel running, a finished one is collected for the statistics
+    if (LPC17_Dma_IsBusy(sdCardDmaChannel))
+        LPC17_Dma_Stop(sdCardDmaChannel);
+    else
+        LPC17_Dma_Wait(sdCardDmaChannel);
 
-    while (!(GPDMA_CONFIG & 0x01));
+    return LPC17_Dma_Start(sdCardDmaChannel, &descriptor, config, nullptr, nullptr) == TinyCLR_Result::Success;
+}
 
-    return (true);
+/* The MCI data end can come before the channel has drained the FIFO into memory */
+bool DMA_Wait(void) {
+    return LPC17_Dma_Wait(sdCardDmaChannel);
 }
 
 // MCI
@@ -447,7 +375,9 @@ uint32_t DMA_Move(uint32_t ChannelNum, uint32_t DMAMode) {
 #define SEND_STATUS            13        /* SEND_STATUS */
 #define SET_BLOCK_LEN        16        /* SET_BLOCK_LEN */
 #define READ_SINGLE_BLOCK    17        /* READ_SINGLE_BLOCK */
+#define READ_MULTIPLE_BLOCK    18        /* READ_MULTIPLE_BLOCK */
 #define WRITE_BLOCK            24        /* WRITE_BLOCK */
+#define WRITE_MULTIPLE_BLOCK    25        /* WRITE_MULTIPLE_BLOCK */
 #define SEND_APP_OP_COND    41        /* ACMD41 for SD card */
 #define APP_CMD                55        /* APP_CMD, the following will a ACMD */
 
@@ -552,16 +482,17 @@ extern uint32_t MCI_Send_Status(void);
 extern bool MCI_Set_BlockLen(uint32_t blockLength);
 extern bool MCI_Send_ACMD_Bus_Width(uint32_t buswidth);
 extern bool MCI_Send_Stop(void);
+extern bool MCI_Stop_Transmission(void);
 
 typedef void(*MCI_DATA_END_CALLBACK)();
 
-extern bool MCI_Write_Block(uint32_t blockNum, MCI_DATA_END_CALLBACK MCI_DATA_END_Callback);
-extern bool MCI_Read_Block(uint32_t blockNum, MCI_DATA_END_CALLBACK MCI_DATA_END_Callback);
+extern bool MCI_Write_Block(uint32_t blockNum, uint32_t blockCount, uint8_t *buffer, MCI_DATA_END_CALLBACK MCI_DATA_END_Callback);
+extern bool MCI_Read_Block(uint32_t blockNum, uint32_t blockCount, uint8_t *buffer, MCI_DATA_END_CALLBACK MCI_DATA_END_Callback);
 
 bool MCI_And_Card_initialize();
 
-bool MCI_ReadSector(uint32_t sector, uint8_t *readbuffer);
-bool MCI_WriteSector(uint32_t sector, uint8_t *writebuffer);
+bool MCI_ReadSector(uint32_t sector, uint8_t *readbuffer, uint32_t count);
+bool MCI_WriteSector(uint32_t sector, uint8_t *writebuffer, uint32_t count);
 
 uint64_t sdMediaSize = 0;
 uint32_t sdSectorsPerBlock = 0;
@@ -619,6 +550,7 @@ volatile uint32_t DataStartbitErrCount = 0;
 volatile uint32_t DataEndCount = 0;
 volatile uint32_t DataBlockEndCount = 0;
 volatile uint32_t MCI_Block_End_Flag = 0;
+volatile uint32_t MCI_Multiple_Block_Flag = 0;
 
 volatile uint32_t DataTxActiveCount = 0;
 volatile uint32_t DataRxActiveCount = 0;
@@ -824,11 +756,29 @@ void MCI_DATA_END_InterruptService(void) {
     {
         DataEndCount++;
         MCI_CLEAR = MCI_DATA_END;
+
+        /* a multiple block transfer is over once the whole data length has moved, not at its first block end */
+        if (MCI_Multiple_Block_Flag) {
+            MCI_CLEAR = MCI_DATA_BLK_END;
+            MCI_Multiple_Block_Flag = 0;
+            MCI_TXDisable();
+            if (MCI_DATA_END_Callback) {
+                MCI_DATA_END_Callback_temp = MCI_DATA_END_Callback;
+                MCI_DATA_END_Callback = NULL;
+                MCI_DATA_END_Callback_temp();
+            }
+            MCI_Block_End_Flag = 0;
+        }
+
         return;
     }
     if (MCIStatus &  MCI_DATA_BLK_END) {
         DataBlockEndCount++;
         MCI_CLEAR = MCI_DATA_BLK_END;
+
+        if (MCI_Multiple_Block_Flag)
+            return;
+
         MCI_TXDisable();
         if (MCI_DATA_END_Callback) {
             MCI_DATA_END_Callback_temp = MCI_DATA_END_Callback;
@@ -1749,20 +1699,55 @@ bool MCI_Send_Stop(void) {
     return (false);
 }
 
+/******************************************************************************
+** Function name:        MCI_Stop_Transmission
+**
+** Descriptions:        CMD12, STOP_TRANSMISSION, ends a multiple block read
+**                        or write. The card may still be programming after a
+**                        write, MCI_CheckStatus waits for the transfer state
+**                        before the next block command.
+**
+** parameters:            None
+** Returned value:        true or false, true if the card answered.
+**
+******************************************************************************/
+bool MCI_Stop_Transmission(void) {
+    uint32_t retryCount;
+    uint32_t respStatus;
+    uint32_t respValue[4];
+
+    retryCount = 0x20;
+    while (retryCount > 0) {
+        MCI_CLEAR = 0x7FF;
+        MCI_SendCmd(STOP_TRANSMISSION, 0x00000000, EXPECT_SHORT_RESP, 0);
+        respStatus = MCI_GetCmdResp(STOP_TRANSMISSION, EXPECT_SHORT_RESP, (uint32_t *)respValue);
+        if (!respStatus) {
+            return(true);
+        }
+
+        LPC17_Time_Delay(nullptr, 1000);
+
+        retryCount--;
+    }
+    return (false);
+}
+
 /******************************************************************************
 ** Function name:        MCI_Send_Write_Block
 **
 ** Descriptions:        CMD24, WRITE_BLOCK, send this cmd in the TRANS state
-**                        to write a block of data to the card.
+**                        to write a block of data to the card. CMD25,
+**                        WRITE_MULTIPLE_BLOCK, for more than one block.
 **
-** parameters:            block number
+** parameters:            block number, block count
 ** Returned value:        Response value
 **
 ******************************************************************************/
-uint32_t MCI_Send_Write_Block(uint32_t blockNum) {
+uint32_t MCI_Send_Write_Block(uint32_t blockNum, uint32_t blockCount) {
     uint32_t i, retryCount;
     uint32_t respStatus;
     uint32_t respValue[4];
+    uint32_t cmd = blockCount > 1 ? WRITE_MULTIPLE_BLOCK : WRITE_BLOCK;
 
     if (!isSDHC)
         blockNum *= BLOCK_LENGTH;
@@ -1770,8 +1755,8 @@ uint32_t MCI_Send_Write_Block(uint32_t blockNum) {
     retryCount = 0x20;
     while (retryCount > 0) {
         MCI_CLEAR = 0x7FF;
-        MCI_SendCmd(WRITE_BLOCK, blockNum, EXPECT_SHORT_RESP, 0);
-        respStatus = MCI_GetCmdResp(WRITE_BLOCK, EXPECT_SHORT_RESP, (uint32_t *)&respValue[0]);
+        MCI_SendCmd(cmd, blockNum, EXPECT_SHORT_RESP, 0);
+        respStatus = MCI_GetCmdResp(cmd, EXPECT_SHORT_RESP, (uint32_t *)&respValue[0]);
         /* it should be in the transfer state, bit 9~12 is 0x0100 and bit 8 is 1 */
         if (!respStatus && ((respValue[0] & (0x0F << 8)) == 0x0900)) {
             return(true);
@@ -1788,16 +1773,18 @@ uint32_t MCI_Send_Write_Block(uint32_t blockNum) {
 ** Function name:        MCI_Send_Read_Block
 **
 ** Descriptions:        CMD17, READ_SINGLE_BLOCK, send this cmd in the TRANS
-**                        state to read a block of data from the card.
+**                        state to read a block of data from the card. CMD18,
+**                        READ_MULTIPLE_BLOCK, for more than one block.
 **
-** parameters:            block number
+** parameters:            block number, block count
 ** Returned value:        Response value
 **
 ******************************************************************************/
-uint32_t MCI_Send_Read_Block(uint32_t blockNum) {
+uint32_t MCI_Send_Read_Block(uint32_t blockNum, uint32_t blockCount) {
     uint32_t i, retryCount;
     uint32_t respStatus;
     uint32_t respValue[4];
+    uint32_t cmd = blockCount > 1 ? READ_MULTIPLE_BLOCK : READ_SINGLE_BLOCK;
 
     if (!isSDHC)
         blockNum *= BLOCK_LENGTH;
@@ -1806,8 +1793,8 @@ uint32_t MCI_Send_Read_Block(uint32_t blockNum) {
 
     while (retryCount > 0) {
         MCI_CLEAR = 0x7FF;
-        MCI_SendCmd(READ_SINGLE_BLOCK, blockNum, EXPECT_SHORT_RESP, 0);
-        respStatus = MCI_GetCmdResp(READ_SINGLE_BLOCK, EXPECT_SHORT_RESP, (uint32_t *)&respValue[0]);
+        MCI_SendCmd(cmd, blockNum, EXPECT_SHORT_RESP, 0);
+        respStatus = MCI_GetCmdResp(cmd, EXPECT_SHORT_RESP, (uint32_t *)&respValue[0]);
         /* it should be in the transfer state, bit 9~12 is 0x0100 and bit 8 is 1 */
         if (!respStatus && ((respValue[0] & (0x0F << 8)) == 0x0900)) {
             return(true);
@@ -1828,13 +1815,13 @@ uint32_t MCI_Send_Read_Block(uint32_t blockNum) {
 **                        interrupt will occurs, data can be written continuously
 **                        into the FIFO until the block data length is reached.
 **
-** parameters:            block number
+** parameters:            block number, block count, buffer the GPDMA reads
 ** Returned value:        true or false, if cmd times out, return false and no
 **                        need to continue.
 **
 ******************************************************************************/
 
-bool MCI_Write_Block(uint32_t blockNum, MCI_DATA_END_CALLBACK Write_end_Callback) {
+bool MCI_Write_Block(uint32_t blockNum, uint32_t blockCount, uint8_t *buffer, MCI_DATA_END_CALLBACK Write_end_Callback) {
     uint32_t i;
     uint32_t DataCtrl = 0;
 
@@ -1847,17 +1834,18 @@ bool MCI_Write_Block(uint32_t blockNum, MCI_DATA_END_CALLBACK Write_end_Callback
     }
 
     MCI_DATA_TMR = DATA_TIMER_VALUE;
-    MCI_DATA_LEN = BLOCK_LENGTH;
+    MCI_DATA_LEN = BLOCK_LENGTH * blockCount;
     MCI_Block_End_Flag = 1;
+    MCI_Multiple_Block_Flag = blockCount > 1 ? 1 : 0;
 
     MCI_DATA_END_Callback = Write_end_Callback;
 
     MCI_TXEnable();
-    if (MCI_Send_Write_Block(blockNum) == false) {
+    if (MCI_Send_Write_Block(blockNum, blockCount) == false) {
         return (false);
     }
 
-    DMA_Move(0, M2P);
+    DMA_Move(M2P, reinterpret_cast<uint32_t>(buffer), BLOCK_LENGTH * blockCount);
 
     DataCtrl = ((1 << 0) | (1 << 3) | (DATA_BLOCK_LEN << 4));
 
@@ -1876,13 +1864,13 @@ bool MCI_Write_Block(uint32_t blockNum, MCI_DATA_END_CALLBACK Write_end_Callback
 **                        continuously into the FIFO until the block data
 **                        length is reached.
 **
-** parameters:            block number
+** parameters:            block number, block count, buffer the GPDMA writes
 ** Returned value:        true or false, if cmd times out, return false and no
 **                        need to continue.
 **
 **
 ******************************************************************************/
-bool MCI_Read_Block(uint32_t blockNum, MCI_DATA_END_CALLBACK read_end_Callback) {
+bool MCI_Read_Block(uint32_t blockNum, uint32_t blockCount, uint8_t *buffer, MCI_DATA_END_CALLBACK read_end_Callback) {
     uint32_t i;
     uint32_t DataCtrl = 0;
 
@@ -1897,16 +1885,17 @@ bool MCI_Read_Block(uint32_t blockNum, MCI_DATA_END_CALLBACK read_end_Callback)
     MCI_RXEnable();
 
     MCI_DATA_TMR = DATA_TIMER_VALUE;
-    MCI_DATA_LEN = BLOCK_LENGTH;
+    MCI_DATA_LEN = BLOCK_LENGTH * blockCount;
     MCI_Block_End_Flag = 1;
+    MCI_Multiple_Block_Flag = blockCount > 1 ? 1 : 0;
 
     MCI_DATA_END_Callback = read_end_Callback;
 
-    if (MCI_Send_Read_Block(blockNum) == false) {
+    if (MCI_Send_Read_Block(blockNum, blockCount) == false) {
         return (false);
     }
 
-    DMA_Move(0, P2M);
+    DMA_Move(P2M, reinterpret_cast<uint32_t>(buffer), BLOCK_LENGTH * blockCount);
 
     DataCtrl = ((1 << 0) | (1 << 1) | (1 << 3) | (DATA_BLOCK_LEN << 4));
 
@@ -1930,7 +1919,8 @@ bool MCI_And_Card_initialize(void) {
     sdMediaSize = 0;
     sdSectorsPerBlock = 0;
 
-    DMA_Init();
+    if (!DMA_Init())
+        return false;
 
     MCI_Init();
 
@@ -1998,19 +1988,26 @@ void Read_end_Callback() {
 
 bool MCI_ReadSector(
     uint32_t sector,
-    uint8_t *buff) {
+    uint8_t *buff,
+    uint32_t count) {
     uint32_t i;
     uint8_t temp;
 
-    ReadBlock = (uint8_t *)(DMA_DST);
+    /* a run of blocks goes straight into the caller's buffer, otherwise one block comes through DMA_DST */
+    bool direct = DMA_IsReachable(buff, count * BLOCK_LENGTH);
+
+    if (!direct && count != 1)
+        return false;
+
+    ReadBlock = direct ? buff : (uint8_t *)(DMA_DST);
 
-    if (MCI_Read_Block(sector, Read_end_Callback) == false) {
+    if (MCI_Read_Block(sector, count, ReadBlock, Read_end_Callback) == false) {
         return false; // Error
     }
 
     temp = 0;
     i = 0;
-    while (i < READ_TIME_OUT) {
+    while (i < READ_TIME_OUT * count) {
         if (Read_Flag == 1) {
             temp = 1;
             break;
@@ -2021,10 +2018,17 @@ bool MCI_ReadSector(
     }
     Read_Flag = 0;
 
+    if (count > 1 && MCI_Stop_Transmission() == false)
+        temp = 0;
+
     if (temp == 0)
         return false; // Error
 
-    memcpy(buff, ReadBlock, BLOCK_LENGTH);
+    if (!DMA_Wait())
+        return false; // Error
+
+    if (!direct)
+        memcpy(buff, ReadBlock, BLOCK_LENGTH);
 
     return true;// No Error
 }
@@ -2046,15 +2050,24 @@ void Write_end_Callback() {
 
 bool MCI_WriteSector(
     uint32_t sector,        /* Sector number (LBA) */
-    uint8_t *buff    /* Data to be written */) {
+    uint8_t *buff,    /* Data to be written */
+    uint32_t count    /* Number of sectors */) {
     uint32_t i;
     uint8_t temp;
 
-    WriteBlock = (uint8_t *)(DMA_SRC);
-    memcpy(WriteBlock, buff, BLOCK_LENGTH);
+    /* a run of blocks goes straight from the caller's buffer, otherwise one block goes through DMA_SRC */
+    bool direct = DMA_IsReachable(buff, count * BLOCK_LENGTH);
+
+    if (!direct && count != 1)
+        return false;
 
+    WriteBlock = direct ? buff : (uint8_t *)(DMA_SRC);
 
-    if (MCI_Write_Block(sector, Write_end_Callback) == false) {
+    if (!direct)
+        memcpy(WriteBlock, buff, BLOCK_LENGTH);
+
+
+    if (MCI_Write_Block(sector, count, WriteBlock, Write_end_Callback) == false) {
         /* Fatal error */
         return false; // Error
     }
@@ -2062,7 +2075,7 @@ bool MCI_WriteSector(
     temp = 0;
     i = 0;
 
-    while (i < WRITE_TIME_OUT) {
+    while (i < WRITE_TIME_OUT * count) {
         if (Flag_write == 1) {
             temp = 1;
             break;
@@ -2074,6 +2087,9 @@ bool MCI_WriteSector(
 
     Flag_write = 0;
 
+    if (count > 1 && MCI_Stop_Transmission() == false)
+        temp = 0;
+
     if (temp == 0)
         return false; // Error
 
@@ -2267,9 +2283,7 @@ TinyCLR_Result LPC17_SdCard_Release(const TinyCLR_Storage_Controller* self) {
 
         LPC_SC->PCONP &= ~(1 << 28); /* Disable clock to the Mci block */
 
-        LPC_SC->PCONP &= ~(1 << 29); /* Disable clock to the Dma block */
-
-        LPC17_InterruptInternal_Deactivate(DMA_IRQn); /* Disable Interrupt */
+        DMA_Uninit(); /* Give the Dma channel back */
 
         auto memoryProvider = (const TinyCLR_Memory_Manager*)apiManager->FindDefault(apiManager, TinyCLR_Api_Type::MemoryManager);
 
@@ -2301,10 +2315,15 @@ TinyCLR_Result LPC17_SdCard_Write(const TinyCLR_Storage_Controller* self, uint64
     uint8_t* pData = (uint8_t*)data;
 
     while (sectorCount) {
-        if (MCI_WriteSector(sectorNum, &pData[index]) == true) {
-            index += LPC17_SD_SECTOR_SIZE;
-            sectorNum++;
-            sectorCount--;
+        auto blocks = sectorCount < MCI_MAX_BLOCKS ? sectorCount : MCI_MAX_BLOCKS;
+
+        if (!DMA_IsReachable(&pData[index], blocks * LPC17_SD_SECTOR_SIZE))
+            blocks = 1;
+
+        if (MCI_WriteSector(sectorNum, &pData[index], blocks) == true) {
+            index += LPC17_SD_SECTOR_SIZE * blocks;
+            sectorNum += blocks;
+            sectorCount -= blocks;
         }
         else {
             return TinyCLR_Result::InvalidOperation;
@@ -2329,10 +2348,15 @@ TinyCLR_Result LPC17_SdCard_Read(const TinyCLR_Storage_Controller* self, uint64_
     auto sectorNum = address;
 
     while (sectorCount) {
-        if (MCI_ReadSector(sectorNum, &data[index]) == true) {
-            index += LPC17_SD_SECTOR_SIZE;
-            sectorNum++;
-            sectorCount--;
+        auto blocks = sectorCount < MCI_MAX_BLOCKS ? sectorCount : MCI_MAX_BLOCKS;
+
+        if (!DMA_IsReachable(&data[index], blocks * LPC17_SD_SECTOR_SIZE))
+            blocks = 1;
+
+        if (MCI_ReadSector(sectorNum, &data[index], blocks) == true) {
+            index += LPC17_SD_SECTOR_SIZE * blocks;
+            sectorNum += blocks;
+            sectorCount -= blocks;
         }
         else {
             return TinyCLR_Result::InvalidOperation;
@@ -14,6 +14,7 @@
 // limitations under the License.
 
 #include <string.h>
+#include <algorithm>
 #include <LPC17.h>
 
 #define DATA_BIT_LENGTH_16  16
@@ -401,6 +402,11 @@ struct LPC17xx_SPI {
     volatile uint32_t SSPxDR;
     volatile uint32_t SSPxSR;
     volatile uint32_t SSPxCPSR;
+    volatile uint32_t SSPxIMSC;
+    volatile uint32_t SSPxRIS;
+    volatile uint32_t SSPxMIS;
+    volatile uint32_t SSPxICR;
+    volatile uint32_t SSPxDMACR;
 
     static const uint32_t CONTROLREG_BitEnable = 0x00000004;
     static const uint32_t CONTROLREG_MODE_Master = 0x00000020;
@@ -408,6 +414,18 @@ struct LPC17xx_SPI {
     static const uint32_t CONTROLREG_POL_1 = 0x00000010;
 };
 
+// Transfers of at least LPC17_SPI_DMA_THRESHOLD bytes are moved by two GPDMA channels, one for each FIFO, while the CPU
+// only waits for the receive channel to finish. Shorter ones stay on the polled loop, the channel setup costs more there.
+#ifndef LPC17_SPI_DMA_THRESHOLD
+#define LPC17_SPI_DMA_THRESHOLD 32
+#endif
+
+#define LPC17_SPI_DMA_MAX_SEGMENT_SIZE 0xFFF // CControl transfer size
+
+#define LPC17_SPI_DMA_REQUEST_TX(controllerIndex) (2 + (controllerIndex) * 2)
+#define LPC17_SPI_DMA_REQUEST_RX(controllerIndex) (3 + (controllerIndex) * 2)
+
+
 static const LPC17_Gpio_Pin spiMisoPins[] = LPC17_SPI_MISO_PINS;
 static const LPC17_Gpio_Pin spiMosiPins[] = LPC17_SPI_MOSI_PINS;
 static const LPC17_Gpio_Pin spiClkPins[] = LPC17_SPI_SCLK_PINS;
@@ -436,10 +454,17 @@ struct SpiState {
     bool tableInitialized;
 
     uint16_t initializeCount;
+
+    int32_t dmaTxChannel;
+    int32_t dmaRxChannel;
 };
 
 static SpiState spiStates[TOTAL_SPI_CONTROLLERS];
 
+// Source of the idle frames on a read only transfer, not const so it stays in RAM where the GPDMA can read it
+static uint8_t spiDmaFill = 0xFF;
+static uint8_t spiDmaDiscard;
+
 static TinyCLR_Spi_Controller spiControllers[TOTAL_SPI_CONTROLLERS];
 static TinyCLR_Api_Info spiApi[TOTAL_SPI_CONTROLLERS];
 
@@ -533,10 +558,119 @@ bool LPC17_Spi_Transaction_Stop(int32_t controllerIndex) {
     return true;
 }
 
+static bool LPC17_Spi_DmaIsAvailable(int32_t controllerIndex) {
+    auto state = &spiStates[controllerIndex];
+
+    if (state->dmaTxChannel == LPC17_DMA_CHANNEL_NONE || state->dmaRxChannel == LPC17_DMA_CHANNEL_NONE)
+        return false;
+
+    if (std::max(state->writeLength, state->readLength) < LPC17_SPI_DMA_THRESHOLD)
+        return false;
+
+    if (state->writeBuffer != nullptr && !LPC17_Dma_IsReachable(state->writeBuffer, state->writeLength))
+        return false;
+
+    if (state->readBuffer != nullptr && !LPC17_Dma_IsReachable(state->readBuffer, state->readLength))
+        return false;
+
+    if (!LPC17_Dma_IsReachable(&spiDmaFill, sizeof(spiDmaFill)) || !LPC17_Dma_IsReachable(&spiDmaDiscard, sizeof(spiDmaDiscard)))
+        return false;
+
+    return true;
+}
+
+// tx is stepped through when txIncrement, otherwise its one byte is sent length times. Without rx the received bytes
+// are dropped into a discard byte, the receive channel still runs so the FIFO never overruns.
+static bool LPC17_Spi_DmaTransferSegment(int32_t controllerIndex, const uint8_t* tx, bool txIncrement, uint8_t* rx, size_t length) {
+    auto state = &spiStates[controllerIndex];
+
+    LPC17xx_SPI & SPI = *(LPC17xx_SPI*)(size_t)((controllerIndex == 0) ? (LPC17xx_SPI::c_SPI0_Base) : ((controllerIndex == 1) ? (LPC17xx_SPI::c_SPI1_Base) : (LPC17xx_SPI::c_SPI2_Base)));
+
+    LPC17_Dma_Descriptor rxDescriptor;
+    LPC17_Dma_Descriptor txDescriptor;
+
+    // byte wide single transfers on both sides, the SSP asks for every frame
+    rxDescriptor.source = reinterpret_cast<uint32_t>(&SPI.SSPxDR);
+    rxDescriptor.destination = rx != nullptr ? reinterpret_cast<uint32_t>(rx) : reinterpret_cast<uint32_t>(&spiDmaDiscard);
+    rxDescriptor.next = 0;
+    rxDescriptor.control = length | (rx != nullptr ? LPC17_DMA_CONTROL_DI : 0);
+
+    txDescriptor.source = reinterpret_cast<uint32_t>(tx);
+    txDescriptor.destination = reinterpret_cast<uint32_t>(&SPI.SSPxDR);
+    txDescriptor.next = 0;
+    txDescriptor.control = length | (txIncrement ? LPC17_DMA_CONTROL_SI : 0);
+
+    if (LPC17_Dma_Start(state->dmaRxChannel, &rxDescriptor, LPC17_DMA_CONFIG_P2M | (LPC17_SPI_DMA_REQUEST_RX(controllerIndex) << LPC17_DMA_CONFIG_SRCPERIPHERAL_BIT), nullptr, nullptr) != TinyCLR_Result::Success)
+        return false;
+
+    if (LPC17_Dma_Start(state->dmaTxChannel, &txDescriptor, LPC17_DMA_CONFIG_M2P | (LPC17_SPI_DMA_REQUEST_TX(controllerIndex) << LPC17_DMA_CONFIG_DESTPERIPHERAL_BIT), nullptr, nullptr) != TinyCLR_Result::Success) {
+        LPC17_Dma_Stop(state->dmaRxChannel);
+
+        return false;
+    }
+
+    // every frame sent is also received, so the receive channel is the last one to finish
+    auto received = LPC17_Dma_Wait(state->dmaRxChannel);
+    auto sent = received ? LPC17_Dma_Wait(state->dmaTxChannel) : false;
+
+    if (!received || !sent) {
+        LPC17_Dma_Stop(state->dmaTxChannel);
+        LPC17_Dma_Stop(state->dmaRxChannel);
+    }
+
+    return received && sent;
+}
+
+// Same frames as the polled loop: max(writeLength, readLength) of them, the last write byte is repeated past the end of
+// the write buffer and the first readLength received bytes are kept. It is split where either buffer ends.
+static bool LPC17_Spi_DmaTransfer(int32_t controllerIndex) {
+    auto state = &spiStates[controllerIndex];
+
+    LPC17xx_SPI & SPI = *(LPC17xx_SPI*)(size_t)((controllerIndex == 0) ? (LPC17xx_SPI::c_SPI0_Base) : ((controllerIndex == 1) ? (LPC17xx_SPI::c_SPI1_Base) : (LPC17xx_SPI::c_SPI2_Base)));
+
+    auto write = state->writeBuffer;
+    auto writeLength = write != nullptr ? state->writeLength : 0;
+    auto read = state->readBuffer;
+    auto readLength = read != nullptr ? state->readLength : 0;
+    auto total = std::max(writeLength, readLength);
+    auto fill = writeLength > 0 ? &write[writeLength - 1] : &spiDmaFill;
+    auto result = true;
+
+    volatile uint32_t stale;
+
+    // anything left in the receive FIFO would shift the data
+    while (SPI.SSPxSR & 0x4)
+        stale = SPI.SSPxDR;
+
+    SPI.SSPxDMACR = SSP0DMACR_RXDMAE | SSP0DMACR_TXDMAE;
+
+    for (size_t position = 0; position < total && result;) {
+        auto length = std::min(total - position, static_cast<size_t>(LPC17_SPI_DMA_MAX_SEGMENT_SIZE));
+
+        if (position < writeLength)
+            length = std::min(length, writeLength - position);
+
+        if (position < readLength)
+            length = std::min(length, readLength - position);
+
+        result = LPC17_Spi_DmaTransferSegment(controllerIndex, position < writeLength ? &write[position] : fill, position < writeLength, position < readLength ? &read[position] : nullptr, length);
+
+        position += length;
+    }
+
+    while (SPI.SSPxSR & 0x10);//BSY
+
+    SPI.SSPxDMACR = 0;
+
+    return result;
+}
 
 bool LPC17_Spi_Transaction_nWrite8_nRead8(int32_t controllerIndex) {
     auto state = &spiStates[controllerIndex];
 
+    if (LPC17_Spi_DmaIsAvailable(controllerIndex))
+        return LPC17_Spi_DmaTransfer(controllerIndex);
+
     LPC17xx_SPI & SPI = *(LPC17xx_SPI*)(size_t)((controllerIndex == 0) ? (LPC17xx_SPI::c_SPI0_Base) : ((controllerIndex == 1) ? (LPC17xx_SPI::c_SPI1_Base) : (LPC17xx_SPI::c_SPI2_Base)));
 
     uint8_t Data8;
@@ -659,19 +793,12 @@ TinyCLR_Result LPC17_Spi_WriteRead(const TinyCLR_Spi_Controller* self, const uin
     state->writeBuffer = (uint8_t*)writeBuffer;
     state->writeLength = writeLength;
 
-    if (state->dataBitLength == DATA_BIT_LENGTH_16) {
-        if (!LPC17_Spi_Transaction_nWrite16_nRead16(controllerIndex))
-            return TinyCLR_Result::InvalidOperation;
-    }
-    else {
-        if (!LPC17_Spi_Transaction_nWrite8_nRead8(controllerIndex))
-            return TinyCLR_Result::InvalidOperation;
-    }
+    auto success = state->dataBitLength == DATA_BIT_LENGTH_16 ? LPC17_Spi_Transaction_nWrite16_nRead16(controllerIndex) : LPC17_Spi_Transaction_nWrite8_nRead8(controllerIndex);
 
-    if (!LPC17_Spi_Transaction_Stop(controllerIndex))
+    // stop on failure too, a chip select left asserted would wedge the bus for the next device
+    if (!LPC17_Spi_Transaction_Stop(controllerIndex) || !success)
         return TinyCLR_Result::InvalidOperation;
 
-
     return TinyCLR_Result::Success;
 }
 
@@ -691,16 +818,9 @@ TinyCLR_Result LPC17_Spi_Read(const TinyCLR_Spi_Controller* self, uint8_t* buffe
     state->writeBuffer = nullptr;
     state->writeLength = 0;
 
-    if (state->dataBitLength == DATA_BIT_LENGTH_16) {
-        if (!LPC17_Spi_Transaction_nWrite16_nRead16(controllerIndex))
-            return TinyCLR_Result::InvalidOperation;
-    }
-    else {
-        if (!LPC17_Spi_Transaction_nWrite8_nRead8(controllerIndex))
-            return TinyCLR_Result::InvalidOperation;
-    }
+    auto success = state->dataBitLength == DATA_BIT_LENGTH_16 ? LPC17_Spi_Transaction_nWrite16_nRead16(controllerIndex) : LPC17_Spi_Transaction_nWrite8_nRead8(controllerIndex);
 
-    if (!LPC17_Spi_Transaction_Stop(controllerIndex))
+    if (!LPC17_Spi_Transaction_Stop(controllerIndex) || !success)
         return TinyCLR_Result::InvalidOperation;
 
     return TinyCLR_Result::Success;
@@ -722,16 +842,9 @@ TinyCLR_Result LPC17_Spi_Write(const TinyCLR_Spi_Controller* self, const uint8_t
     state->writeBuffer = (uint8_t*)buffer;
     state->writeLength = length;
 
-    if (state->dataBitLength == DATA_BIT_LENGTH_16) {
-        if (!LPC17_Spi_Transaction_nWrite16_nRead16(controllerIndex))
-            return TinyCLR_Result::InvalidOperation;
-    }
-    else {
-        if (!LPC17_Spi_Transaction_nWrite8_nRead8(controllerIndex))
-            return TinyCLR_Result::InvalidOperation;
-    }
+    auto success = state->dataBitLength == DATA_BIT_LENGTH_16 ? LPC17_Spi_Transaction_nWrite16_nRead16(controllerIndex) : LPC17_Spi_Transaction_nWrite8_nRead8(controllerIndex);
 
-    if (!LPC17_Spi_Transaction_Stop(controllerIndex))
+    if (!LPC17_Spi_Transaction_Stop(controllerIndex) || !success)
         return TinyCLR_Result::InvalidOperation;
 
     return TinyCLR_Result::Success;
@@ -914,6 +1027,19 @@ TinyCLR_Result LPC17_Spi_Acquire(const TinyCLR_Spi_Controller* self) {
         LPC17_Gpio_ConfigurePin(clkPin, LPC17_Gpio_Direction::Input, clkMode, LPC17_Gpio_ResistorMode::Inactive, LPC17_Gpio_Hysteresis::Disable, LPC17_Gpio_InputPolarity::NotInverted, LPC17_Gpio_SlewRate::StandardMode, LPC17_Gpio_OutputType::PushPull);
         LPC17_Gpio_ConfigurePin(misoPin, LPC17_Gpio_Direction::Input, misoMode, LPC17_Gpio_ResistorMode::Inactive, LPC17_Gpio_Hysteresis::Disable, LPC17_Gpio_InputPolarity::NotInverted, LPC17_Gpio_SlewRate::StandardMode, LPC17_Gpio_OutputType::PushPull);
         LPC17_Gpio_ConfigurePin(mosiPin, LPC17_Gpio_Direction::Input, mosiMode, LPC17_Gpio_ResistorMode::Inactive, LPC17_Gpio_Hysteresis::Disable, LPC17_Gpio_InputPolarity::NotInverted, LPC17_Gpio_SlewRate::StandardMode, LPC17_Gpio_OutputType::PushPull);
+
+        // the receive channel is taken first so it gets the higher priority, without both channels every transfer is polled
+        state->dmaRxChannel = LPC17_Dma_AcquireChannel(LPC17_DMA_ANY_CHANNEL, state);
+        state->dmaTxChannel = LPC17_Dma_AcquireChannel(LPC17_DMA_ANY_CHANNEL, state);
+
+        if (state->dmaTxChannel == LPC17_DMA_CHANNEL_NONE) {
+            LPC17_Dma_ReleaseChannel(state->dmaRxChannel, state);
+
+            state->dmaRxChannel = LPC17_DMA_CHANNEL_NONE;
+        }
+
+        // SSP requests share their lines with the timer matches, select the SSP
+        LPC_SC->DMAREQSEL &= ~((1 << LPC17_SPI_DMA_REQUEST_TX(controllerIndex)) | (1 << LPC17_SPI_DMA_REQUEST_RX(controllerIndex)));
     }
 
     state->initializeCount++;
@@ -951,6 +1077,12 @@ TinyCLR_Result LPC17_Spi_Release(const TinyCLR_Spi_Controller* self) {
         state->clockFrequency = 0;
         state->dataBitLength = 0;
 
+        LPC17_Dma_ReleaseChannel(state->dmaTxChannel, state);
+        LPC17_Dma_ReleaseChannel(state->dmaRxChannel, state);
+
+        state->dmaTxChannel = LPC17_DMA_CHANNEL_NONE;
+        state->dmaRxChannel = LPC17_DMA_CHANNEL_NONE;
+
 
         int32_t clkPin = spiClkPins[controllerIndex].number;
         int32_t misoPin = spiMisoPins[controllerIndex].number;
@@ -0,0 +1,127 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "LPC17.h"
+
+#ifdef INCLUDE_SIGNALS
+
+// TIMER2 latches its counter into CR0/CR1 on both edges of CAP2.0/CAP2.1, so an edge is timestamped by hardware
+// even though the capture registers are collected by polling
+#ifndef LPC17_SIGNAL_CAPTURE_PINS
+#define LPC17_SIGNAL_CAPTURE_PINS { { PIN(0, 4), PF(3) }, { PIN(0, 5), PF(3) } }
+#endif
+
+#define LPC17_SIGNAL_CAPTURE_CLOCK_HZ (LPC17_SYSTEM_CLOCK_HZ / 2)
+#define LPC17_SIGNAL_CAPTURE_PCONP_PCTIM2 (1 << 22)
+
+#define LPC17_SIGNAL_CAPTURE_CCR_RISING 0x1
+#define LPC17_SIGNAL_CAPTURE_CCR_FALLING 0x2
+#define LPC17_SIGNAL_CAPTURE_CCR_INTERRUPT 0x4
+#define LPC17_SIGNAL_CAPTURE_IR_CR0 (1 << 4)
+
+static const LPC17_Gpio_Pin signalCapturePins[] = LPC17_SIGNAL_CAPTURE_PINS;
+
+static int32_t LPC17_SignalCapture_GetChannel(uint32_t pin) {
+    for (auto i = 0; i < SIZEOF_ARRAY(signalCapturePins) && i < 2; i++)
+        if (signalCapturePins[i].number == pin)
+            return i;
+
+    return -1;
+}
+
+bool LPC17_SignalCapture_IsPinSupported(uint32_t pin) {
+    return LPC17_SignalCapture_GetChannel(pin) >= 0;
+}
+
+TinyCLR_Result LPC17_SignalCapture_Read(uint32_t pin, bool waitForInitialState, TinyCLR_Gpio_PinValue& initialState, uint32_t* timestamps, size_t& count, uint64_t timeoutMicroseconds, uint32_t& startTime, uint32_t& frequency) {
+    auto channel = LPC17_SignalCapture_GetChannel(pin);
+
+    if (channel < 0)
+        return TinyCLR_Result::NotSupported;
+
+    if (timestamps == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    if (count == 0)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    if (LPC_SC->PCONP & LPC17_SIGNAL_CAPTURE_PCONP_PCTIM2)
+        return TinyCLR_Result::SharingViolation;
+
+    // the pin was opened by the caller as a GPIO input, it keeps the caller's pull and is given back as one when done
+    auto driveMode = LPC17_Gpio_GetDriveMode(nullptr, pin);
+    auto pull = driveMode == TinyCLR_Gpio_PinDriveMode::InputPullUp ? LPC17_Gpio_ResistorMode::PullUp : (driveMode == TinyCLR_Gpio_PinDriveMode::InputPullDown ? LPC17_Gpio_ResistorMode::PullDown : LPC17_Gpio_ResistorMode::Inactive);
+
+    LPC17_Gpio_ConfigurePin(pin, LPC17_Gpio_Direction::Input, signalCapturePins[channel].pinFunction, pull, LPC17_Gpio_Hysteresis::Disable, LPC17_Gpio_InputPolarity::NotInverted, LPC17_Gpio_SlewRate::StandardMode, LPC17_Gpio_OutputType::PushPull);
+
+    LPC_SC->PCONP |= LPC17_SIGNAL_CAPTURE_PCONP_PCTIM2;
+
+    LPC_TIM2->TCR = 2; // reset
+    LPC_TIM2->CTCR = 0; // timer mode
+    LPC_TIM2->PR = 0;
+    LPC_TIM2->MCR = 0;
+    LPC_TIM2->IR = 0x3F;
+    LPC_TIM2->TCR = 1; // run
+
+    auto irFlag = static_cast<uint32_t>(LPC17_SIGNAL_CAPTURE_IR_CR0 << channel);
+    auto captureRegister = channel == 0 ? &LPC_TIM2->CR0 : &LPC_TIM2->CR1;
+
+    TinyCLR_Gpio_PinValue state;
+
+    {
+        DISABLE_INTERRUPTS_SCOPED(irq);
+
+        // the interrupt flag is only used as a "captured" status, the timer interrupt itself stays disabled
+        LPC_TIM2->CCR = (LPC17_SIGNAL_CAPTURE_CCR_RISING | LPC17_SIGNAL_CAPTURE_CCR_FALLING | LPC17_SIGNAL_CAPTURE_CCR_INTERRUPT) << (channel * 3);
+
+        startTime = LPC_TIM2->TC;
+
+        LPC17_Gpio_Read(nullptr, pin, state);
+    }
+
+    auto skip = waitForInitialState && state != initialState;
+    size_t captured = 0;
+    auto endTime = LPC17_Time_GetCurrentProcessorTime() + timeoutMicroseconds * 10;
+
+    while (captured < count && LPC17_Time_GetCurrentProcessorTime() < endTime) {
+        if (LPC_TIM2->IR & irFlag) {
+            LPC_TIM2->IR = irFlag;
+
+            if (skip) {
+                // the first edge brought the pin into the requested state, measure from there
+                startTime = *captureRegister;
+                skip = false;
+            }
+            else {
+                timestamps[captured++] = *captureRegister;
+            }
+        }
+    }
+
+    LPC_TIM2->CCR = 0;
+    LPC_TIM2->TCR = 0;
+    LPC_TIM2->IR = 0x3F;
+
+    LPC_SC->PCONP &= ~LPC17_SIGNAL_CAPTURE_PCONP_PCTIM2;
+
+    if (!waitForInitialState)
+        initialState = state;
+
+    count = skip ? 0 : captured;
+    frequency = LPC17_SIGNAL_CAPTURE_CLOCK_HZ;
+
+    return TinyCLR_Result::Success;
+}
+
+#endif
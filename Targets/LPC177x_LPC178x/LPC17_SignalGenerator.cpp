@@ -0,0 +1,175 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "LPC17.h"
+
+#ifdef INCLUDE_SIGNALS
+
+// TIMER3 free runs and MR0 is moved forward by one duration on every match, so the edges are placed on absolute
+// counter values and interrupt latency never accumulates. The match interrupt writes the pin through SET/CLR first.
+#ifndef LPC17_SIGNAL_GENERATOR_MAX_EDGES
+#define LPC17_SIGNAL_GENERATOR_MAX_EDGES 512
+#endif
+
+#define LPC17_SIGNAL_GENERATOR_CLOCK_HZ (LPC17_SYSTEM_CLOCK_HZ / 2)
+#define LPC17_SIGNAL_GENERATOR_PCONP_PCTIM3 (1 << 23)
+
+#define LPC17_SIGNAL_GENERATOR_MCR_MR0I 0x1
+#define LPC17_SIGNAL_GENERATOR_IR_MR0 0x1
+
+struct SignalGeneratorState {
+    volatile bool isBusy;
+
+    uint32_t pin;
+    uint32_t mask;
+    volatile uint32_t* activeRegister;
+    volatile uint32_t* idleRegister;
+
+    size_t count;
+    size_t edge;
+
+    LPC17_SignalGenerator_CompletedHandler handler;
+
+    uint32_t ticks[LPC17_SIGNAL_GENERATOR_MAX_EDGES];
+};
+
+static SignalGeneratorState signalGeneratorState;
+
+static void LPC17_SignalGenerator_Stop() {
+    LPC_TIM3->TCR = 0;
+    LPC_TIM3->MCR = 0;
+    LPC_TIM3->IR = 0x3F;
+
+    LPC17_InterruptInternal_Deactivate(TIMER3_IRQn);
+
+    LPC_SC->PCONP &= ~LPC17_SIGNAL_GENERATOR_PCONP_PCTIM3;
+
+    signalGeneratorState.isBusy = false;
+}
+
+void LPC17_SignalGenerator_InterruptHandler(void* param) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    auto state = &signalGeneratorState;
+    auto edge = state->edge + 1;
+
+    // odd edges go back to idle, the last one always does
+    *((edge < state->count && (edge & 1) == 0) ? state->activeRegister : state->idleRegister) = state->mask;
+
+    LPC_TIM3->IR = LPC17_SIGNAL_GENERATOR_IR_MR0;
+
+    state->edge = edge;
+
+    if (edge < state->count) {
+        LPC_TIM3->MR0 += state->ticks[edge];
+
+        return;
+    }
+
+    LPC17_SignalGenerator_Stop();
+
+    if (state->handler != nullptr)
+        state->handler(state->pin);
+}
+
+// durations are in 100ns units, the pin starts at the opposite of idleState, toggles after every duration and is left at
+// idleState. The durations are converted to timer ticks before starting, the caller's buffer is not used afterwards.
+// Every duration must be longer than the interrupt latency, a missed match waits for the 32 bit counter to wrap.
+TinyCLR_Result LPC17_SignalGenerator_Write(uint32_t pin, TinyCLR_Gpio_PinValue idleState, const uint64_t* durations, size_t count, LPC17_SignalGenerator_CompletedHandler handler) {
+    auto state = &signalGeneratorState;
+
+    if (durations == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    if (count == 0 || count > LPC17_SIGNAL_GENERATOR_MAX_EDGES)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    if (state->isBusy)
+        return TinyCLR_Result::InvalidOperation;
+
+    if (LPC_SC->PCONP & LPC17_SIGNAL_GENERATOR_PCONP_PCTIM3)
+        return TinyCLR_Result::SharingViolation;
+
+    for (auto i = 0; i < count; i++) {
+        if (durations[i] >= 0xFFFFFFFF)
+            return TinyCLR_Result::ArgumentOutOfRange;
+
+        auto ticks = durations[i] * LPC17_SIGNAL_GENERATOR_CLOCK_HZ / 10000000;
+
+        if (ticks > 0x7FFFFFFF)
+            return TinyCLR_Result::ArgumentOutOfRange;
+
+        state->ticks[i] = ticks > 0 ? static_cast<uint32_t>(ticks) : 1;
+    }
+
+    auto port = reinterpret_cast<LPC_GPIO_TypeDef*>(LPC_GPIO0_BASE + 0x20 * (pin / 32));
+
+    state->pin = pin;
+    state->mask = 1 << (pin % 32);
+    state->idleRegister = idleState == TinyCLR_Gpio_PinValue::High ? &port->SET : &port->CLR;
+    state->activeRegister = idleState == TinyCLR_Gpio_PinValue::High ? &port->CLR : &port->SET;
+    state->count = count;
+    state->edge = 0;
+    state->handler = handler;
+
+    LPC17_Gpio_ConfigurePin(pin, LPC17_Gpio_Direction::Output, LPC17_Gpio_PinFunction::PinFunction0, LPC17_Gpio_ResistorMode::Inactive, LPC17_Gpio_Hysteresis::Disable, LPC17_Gpio_InputPolarity::NotInverted, LPC17_Gpio_SlewRate::StandardMode, LPC17_Gpio_OutputType::PushPull);
+
+    *state->idleRegister = state->mask;
+
+    LPC_SC->PCONP |= LPC17_SIGNAL_GENERATOR_PCONP_PCTIM3;
+
+    LPC_TIM3->TCR = 2; // reset
+    LPC_TIM3->CTCR = 0; // timer mode
+    LPC_TIM3->PR = 0;
+    LPC_TIM3->MR0 = state->ticks[0];
+    LPC_TIM3->MCR = LPC17_SIGNAL_GENERATOR_MCR_MR0I;
+    LPC_TIM3->IR = 0x3F;
+
+    state->isBusy = true;
+
+    LPC17_InterruptInternal_Activate(TIMER3_IRQn, (uint32_t*)&LPC17_SignalGenerator_InterruptHandler, 0);
+
+    {
+        DISABLE_INTERRUPTS_SCOPED(irq);
+
+        *state->activeRegister = state->mask;
+
+        LPC_TIM3->TCR = 1; // run
+    }
+
+    return TinyCLR_Result::Success;
+}
+
+bool LPC17_SignalGenerator_IsBusy() {
+    return signalGeneratorState.isBusy;
+}
+
+TinyCLR_Result LPC17_SignalGenerator_Abort() {
+    auto state = &signalGeneratorState;
+
+    if (!state->isBusy)
+        return TinyCLR_Result::Success;
+
+    {
+        DISABLE_INTERRUPTS_SCOPED(irq);
+
+        LPC17_SignalGenerator_Stop();
+
+        *state->idleRegister = state->mask;
+    }
+
+    return TinyCLR_Result::Success;
+}
+
+#endif
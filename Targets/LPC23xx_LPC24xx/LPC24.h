@@ -511,6 +511,11 @@ TinyCLR_Result LPC24_Display_DrawBuffer(const TinyCLR_Display_Controller* self,
 TinyCLR_Result LPC24_Display_DrawPixel(const TinyCLR_Display_Controller* self, uint32_t x, uint32_t y, uint64_t color);
 TinyCLR_Result LPC24_Display_WriteString(const TinyCLR_Display_Controller* self, const char* buffer, size_t length);
 
+#define TARGET_DISPLAY_COMPRESSED_SUPPORTED
+
+TinyCLR_Result LPC24_Display_DrawRle(const TinyCLR_Display_Controller* self, int32_t x, int32_t y, int32_t width, int32_t height, const uint8_t* data, size_t length);
+TinyCLR_Result LPC24_Display_DrawIndexed(const TinyCLR_Display_Controller* self, int32_t x, int32_t y, int32_t width, int32_t height, const uint8_t* data, const uint16_t* palette, size_t paletteCount);
+
 //Startup
 void LPC24_Startup_Initialize();
 void LPC24_Startup_GetHeap(uint8_t*& start, size_t& length);
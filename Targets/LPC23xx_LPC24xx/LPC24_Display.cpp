@@ -1033,6 +1033,133 @@ TinyCLR_Result LPC24_Display_DrawBuffer(const TinyCLR_Display_Controller* self,
     return TinyCLR_Result::Success;
 }
 
+// Address of the pixel at (x, y) in the rotated screen and the distance to the next pixel on its row
+static uint16_t* LPC24_Display_GetPixelAddress(int32_t x, int32_t y, int32_t& step) {
+    int32_t screenWidth = m_LPC24_DisplayWidth;
+    int32_t screenHeight = m_LPC24_DisplayHeight;
+
+    switch (m_LPC24_Display_CurrentRotation) {
+    case LPC24xx_LCD_Rotation::rotateCCW_90:
+        step = -screenWidth;
+        return m_LPC24_Display_VituralRam + (screenHeight - 1 - x) * screenWidth + y;
+
+    case LPC24xx_LCD_Rotation::rotateCW_90:
+        step = screenWidth;
+        return m_LPC24_Display_VituralRam + x * screenWidth + (screenWidth - 1 - y);
+
+    case LPC24xx_LCD_Rotation::rotate_180:
+        step = -1;
+        return m_LPC24_Display_VituralRam + (screenHeight - 1 - y) * screenWidth + (screenWidth - 1 - x);
+
+    default:
+        step = 1;
+        return m_LPC24_Display_VituralRam + y * screenWidth + x;
+    }
+}
+
+// The image is a list of runs, each starting with a header byte. With bit 7 set the RGB565 pixel that follows is
+// repeated (header & 0x7F) + 1 times, otherwise (header + 1) RGB565 pixels follow as they are. Pixels are little
+// endian and a run may carry on to the next row. Whatever falls outside the screen is decoded but not written.
+TinyCLR_Result LPC24_Display_DrawRle(const TinyCLR_Display_Controller* self, int32_t x, int32_t y, int32_t width, int32_t height, const uint8_t* data, size_t length) {
+    if (self != &displayControllers[0])
+        return TinyCLR_Result::NotSupported;
+
+    if (m_LPC24_DisplayEnable == false)
+        return TinyCLR_Result::InvalidOperation;
+
+    if (data == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    if (width <= 0 || height <= 0)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    int32_t screenWidth, screenHeight;
+
+    LPC24_Display_GetRotatedDimensions(&screenWidth, &screenHeight);
+
+    uint16_t* to = nullptr;
+    uint16_t color = 0;
+    int32_t row = 0, col = 0, step = 0;
+    size_t i = 0;
+    auto visible = false;
+
+    while (row < height) {
+        if (i >= length)
+            return TinyCLR_Result::ArgumentOutOfRange;
+
+        auto header = data[i++];
+        auto repeat = (header & 0x80) != 0;
+        int32_t count = (header & 0x7F) + 1;
+
+        if (length - i < (repeat ? 2 : static_cast<size_t>(count) * 2))
+            return TinyCLR_Result::ArgumentOutOfRange;
+
+        for (auto n = 0; n < count && row < height; n++) {
+            if (n == 0 || !repeat) {
+                color = data[i] | (data[i + 1] << 8);
+                i += 2;
+            }
+
+            if (col == 0) {
+                visible = (y + row) >= 0 && (y + row) < screenHeight;
+                to = LPC24_Display_GetPixelAddress(x, y + row, step);
+            }
+
+            if (visible && (x + col) >= 0 && (x + col) < screenWidth)
+                *to = color;
+
+            to += step;
+
+            if (++col == width) {
+                col = 0;
+                row++;
+            }
+        }
+    }
+
+    return TinyCLR_Result::Success;
+}
+
+// One byte per pixel, each looked up in a table of RGB565 colors. Indexes past the end of the table leave the pixel as
+// it is, so they can be used for transparency.
+TinyCLR_Result LPC24_Display_DrawIndexed(const TinyCLR_Display_Controller* self, int32_t x, int32_t y, int32_t width, int32_t height, const uint8_t* data, const uint16_t* palette, size_t paletteCount) {
+    if (self != &displayControllers[0])
+        return TinyCLR_Result::NotSupported;
+
+    if (m_LPC24_DisplayEnable == false)
+        return TinyCLR_Result::InvalidOperation;
+
+    if (data == nullptr || palette == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    if (width <= 0 || height <= 0 || paletteCount == 0)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    int32_t screenWidth, screenHeight;
+
+    LPC24_Display_GetRotatedDimensions(&screenWidth, &screenHeight);
+
+    auto first = x < 0 ? -x : 0;
+    auto last = (x + width) > screenWidth ? screenWidth - x : width;
+
+    for (auto row = 0; row < height; row++, data += width) {
+        if ((y + row) < 0 || (y + row) >= screenHeight || first >= last)
+            continue;
+
+        int32_t step;
+        auto to = LPC24_Display_GetPixelAddress(x + first, y + row, step);
+
+        for (auto col = first; col < last; col++, to += step) {
+            auto index = data[col];
+
+            if (index < paletteCount)
+                *to = palette[index];
+        }
+    }
+
+    return TinyCLR_Result::Success;
+}
+
 TinyCLR_Result LPC24_Display_DrawPixel(const TinyCLR_Display_Controller* self, uint32_t x, uint32_t y, uint64_t color) {
     uint16_t rgb565 = ((color & 0xF80000) >> 8) | ((color & 0x00FC00) >> 5) | ((color & 0x0000F8) >> 3);
 
@@ -252,6 +252,18 @@
 #define DMA_MCIFIFO        0xE008C080
 #define DMA_SIZE        BLOCK_LENGTH
 
+/* Memory the GPDMA moves words to and from: the USB RAM below DMA_SRC, the Ethernet RAM and the external memory.
+** A caller buffer there is used in place, anything else goes through DMA_SRC a block at a time */
+#define DMA_USB_RAM_BASE            0x7FD00000
+#define DMA_ETHERNET_RAM_BASE       0x7FE00000
+#define DMA_ETHERNET_RAM_END        0x7FE04000
+#define DMA_EXTERNAL_MEMORY_BASE    0x80000000
+#define DMA_EXTERNAL_MEMORY_END     0xE0000000
+
+/* Blocks per READ_MULTIPLE_BLOCK or WRITE_MULTIPLE_BLOCK, the MCI is the flow controller so a run is a single
+** GPDMA transfer whatever its length */
+#define MCI_MAX_BLOCKS        16
+
 /* DMA mode */
 #define M2M                0x00
 #define M2P                0x01
@@ -344,6 +356,18 @@ void DMA_Init(void) {
     LPC24_InterruptInternal_Activate(LPC24XX_VIC::c_IRQ_INDEX_DMA, (uint32_t*)&DMAHandler, (void*)0);
 }
 
+bool DMA_IsReachable(const uint8_t *buffer, uint32_t length) {
+    uint32_t start = reinterpret_cast<uint32_t>(buffer);
+    uint32_t end = start + length;
+
+    if (start & 0x3)
+        return false;
+
+    return (start >= DMA_USB_RAM_BASE && end <= DMA_SRC)
+        || (start >= DMA_ETHERNET_RAM_BASE && end <= DMA_ETHERNET_RAM_END)
+        || (start >= DMA_EXTERNAL_MEMORY_BASE && end <= DMA_EXTERNAL_MEMORY_END);
+}
+
 /******************************************************************************
 ** Function name:        DMA_Move
 **
@@ -351,11 +375,12 @@ void DMA_Init(void) {
 **                        including mode, M2P or M2M, or P2M,
 **                        src and dest. address, control reg. etc.
 **
-** parameters:            Channel number, DMA mode
+** parameters:            Channel number, DMA mode, memory address, length
+**                        in bytes
 ** Returned value:        true or false
 **
 ******************************************************************************/
-uint32_t DMA_Move(uint32_t ChannelNum, uint32_t DMAMode) {
+uint32_t DMA_Move(uint32_t ChannelNum, uint32_t DMAMode, uint32_t address, uint32_t length) {
 
     GPDMA_INT_TCCLR = 0xFF;
     GPDMA_INT_ERR_CLR = 0xFF;
@@ -374,7 +399,7 @@ uint32_t DMA_Move(uint32_t ChannelNum, uint32_t DMAMode) {
             (DMA_SIZE & 0x0FFF);
     }
     else if (DMAMode == M2P) {
-        GPDMA_Source_Register_Channel(ChannelNum) = DMA_SRC;
+        GPDMA_Source_Register_Channel(ChannelNum) = address;
         GPDMA_Destination_Register_Channel(ChannelNum) = DMA_MCIFIFO;
 
         GPDMA_Control_Register_Channel(ChannelNum) = (0x80000000) |
@@ -383,7 +408,7 @@ uint32_t DMA_Move(uint32_t ChannelNum, uint32_t DMAMode) {
             (0x02 << 18) |
             (0x02 << 15) |
             (0x04 << 12) |
-            (DMA_SIZE & 0x0FFF);
+            ((length / 4) & 0x0FFF);
 
 
         GPDMA_Config_Register_Channel(ChannelNum) = (0x01 << 16) |
@@ -395,7 +420,7 @@ uint32_t DMA_Move(uint32_t ChannelNum, uint32_t DMAMode) {
     else if (DMAMode == P2M) {
 
         GPDMA_Source_Register_Channel(ChannelNum) = DMA_MCIFIFO;
-        GPDMA_Destination_Register_Channel(ChannelNum) = DMA_DST;
+        GPDMA_Destination_Register_Channel(ChannelNum) = address;
 
         GPDMA_Control_Register_Channel(ChannelNum) = (0x80000000) |
             (0x01 << 27) |
@@ -403,7 +428,7 @@ uint32_t DMA_Move(uint32_t ChannelNum, uint32_t DMAMode) {
             (0x02 << 18) |
             (0x04 << 15) |
             (0x02 << 12) |
-            (DMA_SIZE & 0x0FFF);
+            ((length / 4) & 0x0FFF);
 
         GPDMA_Config_Register_Channel(ChannelNum) = (0x01 << 16) |
             (0x06 << 11) |
@@ -422,6 +447,13 @@ uint32_t DMA_Move(uint32_t ChannelNum, uint32_t DMAMode) {
     return (true);
 }
 
+/* The MCI data end can come before channel 0 has drained the FIFO into memory */
+bool DMA_Wait(void) {
+    while (GPDMA_ENABLED_CHNS & 0x01);
+
+    return (GPDMA_RAW_INT_ERR_STAT & 0x01) == 0;
+}
+
 // MCI
 #define TIME_OUT 2000
 #define READ_TIME_OUT 100
@@ -446,7 +478,9 @@ uint32_t DMA_Move(uint32_t ChannelNum, uint32_t DMAMode) {
 #define SEND_STATUS            13        /* SEND_STATUS */
 #define SET_BLOCK_LEN        16        /* SET_BLOCK_LEN */
 #define READ_SINGLE_BLOCK    17        /* READ_SINGLE_BLOCK */
+#define READ_MULTIPLE_BLOCK    18        /* READ_MULTIPLE_BLOCK */
 #define WRITE_BLOCK            24        /* WRITE_BLOCK */
+#define WRITE_MULTIPLE_BLOCK    25        /* WRITE_MULTIPLE_BLOCK */
 #define SEND_APP_OP_COND    41        /* ACMD41 for SD card */
 #define APP_CMD                55        /* APP_CMD, the following will a ACMD */
 
@@ -551,16 +585,17 @@ extern uint32_t MCI_Send_Status(void);
 extern bool MCI_Set_BlockLen(uint32_t blockLength);
 extern bool MCI_Send_ACMD_Bus_Width(uint32_t buswidth);
 extern bool MCI_Send_Stop(void);
+extern bool MCI_Stop_Transmission(void);
 
 typedef void(*MCI_DATA_END_CALLBACK)();
 
-extern bool MCI_Write_Block(uint32_t blockNum, MCI_DATA_END_CALLBACK MCI_DATA_END_Callback);
-extern bool MCI_Read_Block(uint32_t blockNum, MCI_DATA_END_CALLBACK MCI_DATA_END_Callback);
+extern bool MCI_Write_Block(uint32_t blockNum, uint32_t blockCount, uint8_t *buffer, MCI_DATA_END_CALLBACK MCI_DATA_END_Callback);
+extern bool MCI_Read_Block(uint32_t blockNum, uint32_t blockCount, uint8_t *buffer, MCI_DATA_END_CALLBACK MCI_DATA_END_Callback);
 
 bool MCI_And_Card_initialize();
 
-bool MCI_ReadSector(uint32_t sector, uint8_t *readbuffer);
-bool MCI_WriteSector(uint32_t sector, uint8_t *writebuffer);
+bool MCI_ReadSector(uint32_t sector, uint8_t *readbuffer, uint32_t count);
+bool MCI_WriteSector(uint32_t sector, uint8_t *writebuffer, uint32_t count);
 
 uint64_t sdMediaSize = 0;
 uint32_t sdSectorsPerBlock = 0;
@@ -618,6 +653,7 @@ volatile uint32_t DataStartbitErrCount = 0;
 volatile uint32_t DataEndCount = 0;
 volatile uint32_t DataBlockEndCount = 0;
 volatile uint32_t MCI_Block_End_Flag = 0;
+volatile uint32_t MCI_Multiple_Block_Flag = 0;
 
 volatile uint32_t DataTxActiveCount = 0;
 volatile uint32_t DataRxActiveCount = 0;
@@ -823,11 +859,29 @@ void MCI_DATA_END_InterruptService(void) {
     {
         DataEndCount++;
         MCI_CLEAR = MCI_DATA_END;
+
+        /* a multiple block transfer is over once the whole data length has moved, not at its first block end */
+        if (MCI_Multiple_Block_Flag) {
+            MCI_CLEAR = MCI_DATA_BLK_END;
+            MCI_Multiple_Block_Flag = 0;
+            MCI_TXDisable();
+            if (MCI_DATA_END_Callback) {
+                MCI_DATA_END_Callback_temp = MCI_DATA_END_Callback;
+                MCI_DATA_END_Callback = NULL;
+                MCI_DATA_END_Callback_temp();
+            }
+            MCI_Block_End_Flag = 0;
+        }
+
         return;
     }
     if (MCIStatus &  MCI_DATA_BLK_END) {
         DataBlockEndCount++;
         MCI_CLEAR = MCI_DATA_BLK_END;
+
+        if (MCI_Multiple_Block_Flag)
+            return;
+
         MCI_TXDisable();
         if (MCI_DATA_END_Callback) {
             MCI_DATA_END_Callback_temp = MCI_DATA_END_Callback;
@@ -1749,20 +1803,55 @@ bool MCI_Send_Stop(void) {
     return (false);
 }
 
+/******************************************************************************
+** Function name:        MCI_Stop_Transmission
+**
+** Descriptions:        CMD12, STOP_TRANSMISSION, ends a multiple block read
+**                        or write. The card may still be programming after a
+**                        write, MCI_CheckStatus waits for the transfer state
+**                        before the next block command.
+**
+** parameters:            None
+** Returned value:        true or false, true if the card answered.
+**
+******************************************************************************/
+bool MCI_Stop_Transmission(void) {
+    uint32_t retryCount;
+    uint32_t respStatus;
+    uint32_t respValue[4];
+
+    retryCount = 0x20;
+    while (retryCount > 0) {
+        MCI_CLEAR = 0x7FF;
+        MCI_SendCmd(STOP_TRANSMISSION, 0x00000000, EXPECT_SHORT_RESP, 0);
+        respStatus = MCI_GetCmdResp(STOP_TRANSMISSION, EXPECT_SHORT_RESP, (uint32_t *)respValue);
+        if (!respStatus) {
+            return(true);
+        }
+
+        LPC24_Time_Delay(nullptr, 1000);
+
+        retryCount--;
+    }
+    return (false);
+}
+
 /******************************************************************************
 ** Function name:        MCI_Send_Write_Block
 **
 ** Descriptions:        CMD24, WRITE_BLOCK, send this cmd in the TRANS state
-**                        to write a block of data to the card.
+**                        to write a block of data to the card. CMD25,
+**                        WRITE_MULTIPLE_BLOCK, for more than one block.
 **
-** parameters:            block number
+** parameters:            block number, block count
 ** Returned value:        Response value
 **
 ******************************************************************************/
-uint32_t MCI_Send_Write_Block(uint32_t blockNum) {
+uint32_t MCI_Send_Write_Block(uint32_t blockNum, uint32_t blockCount) {
     uint32_t i, retryCount;
     uint32_t respStatus;
     uint32_t respValue[4];
+    uint32_t cmd = blockCount > 1 ? WRITE_MULTIPLE_BLOCK : WRITE_BLOCK;
 
     if (!isSDHC)
         blockNum *= BLOCK_LENGTH;
@@ -1770,8 +1859,8 @@ uint32_t MCI_Send_Write_Block(uint32_t blockNum) {
     retryCount = 0x20;
     while (retryCount > 0) {
         MCI_CLEAR = 0x7FF;
-        MCI_SendCmd(WRITE_BLOCK, blockNum, EXPECT_SHORT_RESP, 0);
-        respStatus = MCI_GetCmdResp(WRITE_BLOCK, EXPECT_SHORT_RESP, (uint32_t *)&respValue[0]);
+        MCI_SendCmd(cmd, blockNum, EXPECT_SHORT_RESP, 0);
+        respStatus = MCI_GetCmdResp(cmd, EXPECT_SHORT_RESP, (uint32_t *)&respValue[0]);
         /* it should be in the transfer state, bit 9~12 is 0x0100 and bit 8 is 1 */
         if (!respStatus && ((respValue[0] & (0x0F << 8)) == 0x0900)) {
             return(true);
@@ -1788,24 +1877,26 @@ uint32_t MCI_Send_Write_Block(uint32_t blockNum) {
 ** Function name:        MCI_Send_Read_Block
 **
 ** Descriptions:        CMD17, READ_SINGLE_BLOCK, send this cmd in the TRANS
-**                        state to read a block of data from the card.
+**                        state to read a block of data from the card. CMD18,
+**                        READ_MULTIPLE_BLOCK, for more than one block.
 **
-** parameters:            block number
+** parameters:            block number, block count
 ** Returned value:        Response value
 **
 ******************************************************************************/
-uint32_t MCI_Send_Read_Block(uint32_t blockNum) {
+uint32_t MCI_Send_Read_Block(uint32_t blockNum, uint32_t blockCount) {
     uint32_t i, retryCount;
     uint32_t respStatus;
     uint32_t respValue[4];
+    uint32_t cmd = blockCount > 1 ? READ_MULTIPLE_BLOCK : READ_SINGLE_BLOCK;
 
     if (!isSDHC)
         blockNum *= BLOCK_LENGTH;
     retryCount = 0x20;
     while (retryCount > 0) {
         MCI_CLEAR = 0x7FF;
-        MCI_SendCmd(READ_SINGLE_BLOCK, blockNum, EXPECT_SHORT_RESP, 0);
-        respStatus = MCI_GetCmdResp(READ_SINGLE_BLOCK, EXPECT_SHORT_RESP, (uint32_t *)&respValue[0]);
+        MCI_SendCmd(cmd, blockNum, EXPECT_SHORT_RESP, 0);
+        respStatus = MCI_GetCmdResp(cmd, EXPECT_SHORT_RESP, (uint32_t *)&respValue[0]);
         /* it should be in the transfer state, bit 9~12 is 0x0100 and bit 8 is 1 */
         if (!respStatus && ((respValue[0] & (0x0F << 8)) == 0x0900)) {
             return(true);
@@ -1826,13 +1917,13 @@ uint32_t MCI_Send_Read_Block(uint32_t blockNum) {
 **                        interrupt will occurs, data can be written continuously
 **                        into the FIFO until the block data length is reached.
 **
-** parameters:            block number
+** parameters:            block number, block count, buffer the GPDMA reads
 ** Returned value:        true or false, if cmd times out, return false and no
 **                        need to continue.
 **
 ******************************************************************************/
 
-bool MCI_Write_Block(uint32_t blockNum, MCI_DATA_END_CALLBACK Write_end_Callback) {
+bool MCI_Write_Block(uint32_t blockNum, uint32_t blockCount, uint8_t *buffer, MCI_DATA_END_CALLBACK Write_end_Callback) {
     uint32_t i;
     uint32_t DataCtrl = 0;
 
@@ -1845,17 +1936,18 @@ bool MCI_Write_Block(uint32_t blockNum, MCI_DATA_END_CALLBACK Write_end_Callback
     }
 
     MCI_DATA_TMR = DATA_TIMER_VALUE;
-    MCI_DATA_LEN = BLOCK_LENGTH;
+    MCI_DATA_LEN = BLOCK_LENGTH * blockCount;
     MCI_Block_End_Flag = 1;
+    MCI_Multiple_Block_Flag = blockCount > 1 ? 1 : 0;
 
     MCI_DATA_END_Callback = Write_end_Callback;
 
     MCI_TXEnable();
-    if (MCI_Send_Write_Block(blockNum) == false) {
+    if (MCI_Send_Write_Block(blockNum, blockCount) == false) {
         return (false);
     }
 
-    DMA_Move(0, M2P);
+    DMA_Move(0, M2P, reinterpret_cast<uint32_t>(buffer), BLOCK_LENGTH * blockCount);
     GPDMA_CH0_CFG = 0x10001 | (0x00 << 1) | (0x04 << 6) | (0x05 << 11);
     DataCtrl = ((1 << 0) | (1 << 3) | (DATA_BLOCK_LEN << 4));
 
@@ -1874,13 +1966,13 @@ bool MCI_Write_Block(uint32_t blockNum, MCI_DATA_END_CALLBACK Write_end_Callback
 **                        continuously into the FIFO until the block data
 **                        length is reached.
 **
-** parameters:            block number
+** parameters:            block number, block count, buffer the GPDMA writes
 ** Returned value:        true or false, if cmd times out, return false and no
 **                        need to continue.
 **
 **
 ******************************************************************************/
-bool MCI_Read_Block(uint32_t blockNum, MCI_DATA_END_CALLBACK read_end_Callback) {
+bool MCI_Read_Block(uint32_t blockNum, uint32_t blockCount, uint8_t *buffer, MCI_DATA_END_CALLBACK read_end_Callback) {
     uint32_t i;
     uint32_t DataCtrl = 0;
 
@@ -1895,16 +1987,17 @@ bool MCI_Read_Block(uint32_t blockNum, MCI_DATA_END_CALLBACK read_end_Callback)
     MCI_RXEnable();
 
     MCI_DATA_TMR = DATA_TIMER_VALUE;
-    MCI_DATA_LEN = BLOCK_LENGTH;
+    MCI_DATA_LEN = BLOCK_LENGTH * blockCount;
     MCI_Block_End_Flag = 1;
+    MCI_Multiple_Block_Flag = blockCount > 1 ? 1 : 0;
 
     MCI_DATA_END_Callback = read_end_Callback;
 
-    if (MCI_Send_Read_Block(blockNum) == false) {
+    if (MCI_Send_Read_Block(blockNum, blockCount) == false) {
         return (false);
     }
 
-    DMA_Move(0, P2M);
+    DMA_Move(0, P2M, reinterpret_cast<uint32_t>(buffer), BLOCK_LENGTH * blockCount);
     GPDMA_CH0_CFG = 0x10001 | (0x04 << 1) | (0x00 << 6) | (0x06 << 11);
     DataCtrl = ((1 << 0) | (1 << 1) | (1 << 3) | (DATA_BLOCK_LEN << 4));
 
@@ -1996,19 +2089,26 @@ void Read_end_Callback() {
 
 bool MCI_ReadSector(
     uint32_t sector,
-    uint8_t *buff) {
+    uint8_t *buff,
+    uint32_t count) {
     uint32_t i;
     uint8_t temp;
 
-    ReadBlock = (uint8_t *)(DMA_DST);
+    /* a run of blocks goes straight into the caller's buffer, otherwise one block comes through DMA_DST */
+    bool direct = DMA_IsReachable(buff, count * BLOCK_LENGTH);
+
+    if (!direct && count != 1)
+        return false;
 
-    if (MCI_Read_Block(sector, Read_end_Callback) == false) {
+    ReadBlock = direct ? buff : (uint8_t *)(DMA_DST);
+
+    if (MCI_Read_Block(sector, count, ReadBlock, Read_end_Callback) == false) {
         return false; // Error
     }
 
     temp = 0;
     i = 0;
-    while (i < READ_TIME_OUT) {
+    while (i < READ_TIME_OUT * count) {
         if (Read_Flag == 1) {
             temp = 1;
             break;
@@ -2019,10 +2119,17 @@ bool MCI_ReadSector(
     }
     Read_Flag = 0;
 
+    if (count > 1 && MCI_Stop_Transmission() == false)
+        temp = 0;
+
     if (temp == 0)
         return false; // Error
 
-    memcpy(buff, ReadBlock, BLOCK_LENGTH);
+    if (!DMA_Wait())
+        return false; // Error
+
+    if (!direct)
+        memcpy(buff, ReadBlock, BLOCK_LENGTH);
 
     return true;// No Error
 }
@@ -2044,15 +2151,24 @@ void Write_end_Callback() {
 
 bool MCI_WriteSector(
     uint32_t sector,        /* Sector number (LBA) */
-    uint8_t *buff    /* Data to be written */) {
+    uint8_t *buff,    /* Data to be written */
+    uint32_t count    /* Number of sectors */) {
     uint32_t i;
     uint8_t temp;
 
-    WriteBlock = (uint8_t *)(DMA_SRC);
-    memcpy(WriteBlock, buff, BLOCK_LENGTH);
+    /* a run of blocks goes straight from the caller's buffer, otherwise one block goes through DMA_SRC */
+    bool direct = DMA_IsReachable(buff, count * BLOCK_LENGTH);
+
+    if (!direct && count != 1)
+        return false;
 
+    WriteBlock = direct ? buff : (uint8_t *)(DMA_SRC);
 
-    if (MCI_Write_Block(sector, Write_end_Callback) == false) {
+    if (!direct)
+        memcpy(WriteBlock, buff, BLOCK_LENGTH);
+
+
+    if (MCI_Write_Block(sector, count, WriteBlock, Write_end_Callback) == false) {
         /* Fatal error */
         return false; // Error
     }
@@ -2060,7 +2176,7 @@ bool MCI_WriteSector(
     temp = 0;
     i = 0;
 
-    while (i < WRITE_TIME_OUT) {
+    while (i < WRITE_TIME_OUT * count) {
         if (Flag_write == 1) {
             temp = 1;
             break;
@@ -2072,6 +2188,9 @@ bool MCI_WriteSector(
 
     Flag_write = 0;
 
+    if (count > 1 && MCI_Stop_Transmission() == false)
+        temp = 0;
+
     if (temp == 0)
         return false; // Error
 
@@ -2297,10 +2416,15 @@ TinyCLR_Result LPC24_SdCard_Write(const TinyCLR_Storage_Controller* self, uint64
     uint8_t* pData = (uint8_t*)data;
 
     while (sectorCount) {
-        if (MCI_WriteSector(sectorNum, &pData[index]) == true) {
-            index += LPC24_SD_SECTOR_SIZE;
-            sectorNum++;
-            sectorCount--;
+        auto blocks = sectorCount < MCI_MAX_BLOCKS ? sectorCount : MCI_MAX_BLOCKS;
+
+        if (!DMA_IsReachable(&pData[index], blocks * LPC24_SD_SECTOR_SIZE))
+            blocks = 1;
+
+        if (MCI_WriteSector(sectorNum, &pData[index], blocks) == true) {
+            index += LPC24_SD_SECTOR_SIZE * blocks;
+            sectorNum += blocks;
+            sectorCount -= blocks;
         }
         else {
             return TinyCLR_Result::InvalidOperation;
@@ -2324,10 +2448,15 @@ TinyCLR_Result LPC24_SdCard_Read(const TinyCLR_Storage_Controller* self, uint64_
     auto sectorNum = address;
 
     while (sectorCount) {
-        if (MCI_ReadSector(sectorNum, &data[index]) == true) {
-            index += LPC24_SD_SECTOR_SIZE;
-            sectorNum++;
-            sectorCount--;
+        auto blocks = sectorCount < MCI_MAX_BLOCKS ? sectorCount : MCI_MAX_BLOCKS;
+
+        if (!DMA_IsReachable(&data[index], blocks * LPC24_SD_SECTOR_SIZE))
+            blocks = 1;
+
+        if (MCI_ReadSector(sectorNum, &data[index], blocks) == true) {
+            index += LPC24_SD_SECTOR_SIZE * blocks;
+            sectorNum += blocks;
+            sectorCount -= blocks;
         }
         else {
             return TinyCLR_Result::InvalidOperation;
@@ -497,6 +497,18 @@ void LPC24_UsbDevice_ResetEP(uint32_t EPNum, int8_t in) {
     LPC24_UsbDevice_WrCmdDat(CMD_SET_EP_STAT(LPC24_UsbDevice_EPAdr(EPNum, in)), DAT_WR_BYTE(0));
 }
 
+// Clearing ST also resets the data toggle
+bool LPC24_UsbDevice_SetEndpointStall(UsClientState* usClientState, int32_t endpoint, bool stall) {
+    if (endpoint == 0 || endpoint >= LPC24_USB_ENDPOINT_COUNT || usClientState->queues[endpoint] == 0)
+        return false;
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    LPC24_UsbDevice_WrCmdDat(CMD_SET_EP_STAT(LPC24_UsbDevice_EPAdr(endpoint, usClientState->isTxQueue[endpoint] ? 1 : 0)), DAT_WR_BYTE(stall ? EP_STAT_ST : 0));
+
+    return true;
+}
+
 void USB_HW_Configure(bool cfg) {
     LPC24_UsbDevice_WrCmdDat(CMD_CFG_DEV, DAT_WR_BYTE(cfg ? CONF_DVICE : 0));
 
@@ -859,6 +871,10 @@ bool TinyCLR_UsbClient_RxEnable(UsClientState* usClientState, int32_t endpoint)
     return LPC24_UsbDevice_RxEnable(usClientState, endpoint);
 }
 
+bool TinyCLR_UsbClient_SetEndpointStall(UsClientState* usClientState, int32_t endpoint, bool stall) {
+    return LPC24_UsbDevice_SetEndpointStall(usClientState, endpoint, stall);
+}
+
 void TinyCLR_UsbClient_Delay(uint64_t microseconds) {
     LPC24_Time_Delay(nullptr, microseconds);
 }
@@ -981,8 +981,18 @@ ITStatus CAN_GetITStatus(CAN_TypeDef* CANx, uint32_t CAN_IT) {
 }
 
 
+// the TX and RX0 interrupts of a controller share its state, sections mask up to the more urgent of the two
+static uint32_t CAN_GetMaskPriority(int32_t controllerIndex) {
+    auto tx = NVIC_GetPriority(controllerIndex == 0 ? CAN1_TX_IRQn : CAN2_TX_IRQn);
+    auto rx = NVIC_GetPriority(controllerIndex == 0 ? CAN1_RX0_IRQn : CAN2_RX0_IRQn);
+
+    return tx < rx ? tx : rx;
+}
+
+#define CAN_MASK_INTERRUPTS_SCOPED(name, controllerIndex) STM32F4_MaskInterrupts_RaiiHelper name(CAN_GetMaskPriority(controllerIndex))
+
 bool CAN_ErrorHandler(uint8_t controllerIndex) {
-    DISABLE_INTERRUPTS_SCOPED(irq);
+    CAN_MASK_INTERRUPTS_SCOPED(irq, controllerIndex);
 
     auto state = &canStates[controllerIndex];
 
@@ -1114,7 +1124,7 @@ TinyCLR_Result STM32F4_Can_SetWriteBufferSize(const TinyCLR_Can_Controller* self
 }
 
 void STM32_Can_RxInterruptHandler(int32_t controllerIndex) {
-    DISABLE_INTERRUPTS_SCOPED(irq);
+    CAN_MASK_INTERRUPTS_SCOPED(irq, controllerIndex);
 
     auto state = reinterpret_cast<CanState*>(&canStates[controllerIndex]);
 
@@ -1394,7 +1404,7 @@ TinyCLR_Result STM32F4_Can_ReadMessage(const TinyCLR_Can_Controller* self, TinyC
     uint32_t* data32 = (uint32_t*)data;
 
     if (state->can_rx_count) {
-        DISABLE_INTERRUPTS_SCOPED(irq);
+        CAN_MASK_INTERRUPTS_SCOPED(irq, state->controllerIndex);
 
         can_msg = &state->canRxMessagesFifo[state->can_rx_out];
         state->can_rx_out++;
@@ -1531,7 +1541,7 @@ TinyCLR_Result STM32F4_Can_SetExplicitFilters(const TinyCLR_Can_Controller* self
     std::sort(_matchFilters, _matchFilters + count);
 
     {
-        DISABLE_INTERRUPTS_SCOPED(irq);
+        CAN_MASK_INTERRUPTS_SCOPED(irq, state->controllerIndex);
 
         auto state = reinterpret_cast<CanState*>(self->ApiInfo->State);
 
@@ -1573,7 +1583,7 @@ TinyCLR_Result STM32F4_Can_SetGroupFilters(const TinyCLR_Can_Controller* self, c
     }
 
     {
-        DISABLE_INTERRUPTS_SCOPED(irq);
+        CAN_MASK_INTERRUPTS_SCOPED(irq, state->controllerIndex);
 
         auto state = reinterpret_cast<CanState*>(self->ApiInfo->State);
 
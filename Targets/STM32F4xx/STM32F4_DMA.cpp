@@ -0,0 +1,275 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "STM32F4.h"
+
+// The streams of DMA1 and DMA2 are handed out to the drivers that need them (ADC, DAC, signal capture...) through the
+// shared allocator. Every stream has its own interrupt, it is on while the stream is held. A controller is clocked
+// while any of its streams is held.
+#define STM32F4_DMA_STREAMS_PER_CONTROLLER 8
+
+// Stream flags relative to the stream's position in LISR/HISR
+#define STM32F4_DMA_FLAGS_ALL (DMA_LISR_FEIF0 | DMA_LISR_DMEIF0 | DMA_LISR_TEIF0 | DMA_LISR_HTIF0 | DMA_LISR_TCIF0)
+
+struct DmaStreamState {
+    STM32F4_Dma_EventHandler handler;
+    void* param;
+
+    size_t bytes; // moved by one complete pass over a buffer
+};
+
+struct DmaState {
+    DmaAllocator allocator;
+    DmaStreamState streams[STM32F4_DMA_STREAM_COUNT];
+};
+
+static DmaState dmaState;
+
+static const IRQn_Type dmaStreamIrqs[STM32F4_DMA_STREAM_COUNT] = {
+    DMA1_Stream0_IRQn, DMA1_Stream1_IRQn, DMA1_Stream2_IRQn, DMA1_Stream3_IRQn, DMA1_Stream4_IRQn, DMA1_Stream5_IRQn, DMA1_Stream6_IRQn, DMA1_Stream7_IRQn,
+    DMA2_Stream0_IRQn, DMA2_Stream1_IRQn, DMA2_Stream2_IRQn, DMA2_Stream3_IRQn, DMA2_Stream4_IRQn, DMA2_Stream5_IRQn, DMA2_Stream6_IRQn, DMA2_Stream7_IRQn
+};
+
+static const int32_t dmaStreamIndexes[STM32F4_DMA_STREAM_COUNT] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 };
+static const uint32_t dmaFlagShifts[] = { 0, 6, 16, 22 };
+
+static DMA_TypeDef* STM32F4_Dma_GetController(int32_t stream) {
+    return stream < STM32F4_DMA_STREAMS_PER_CONTROLLER ? DMA1 : DMA2;
+}
+
+static DMA_Stream_TypeDef* STM32F4_Dma_GetStream(int32_t stream) {
+    auto base = stream < STM32F4_DMA_STREAMS_PER_CONTROLLER ? DMA1_Stream0_BASE : DMA2_Stream0_BASE;
+
+    return reinterpret_cast<DMA_Stream_TypeDef*>(base + (DMA1_Stream1_BASE - DMA1_Stream0_BASE) * (stream % STM32F4_DMA_STREAMS_PER_CONTROLLER));
+}
+
+static uint32_t STM32F4_Dma_ReadFlags(int32_t stream) {
+    auto dma = STM32F4_Dma_GetController(stream);
+    auto index = stream % STM32F4_DMA_STREAMS_PER_CONTROLLER;
+
+    return ((index < 4 ? dma->LISR : dma->HISR) >> dmaFlagShifts[index % 4]) & STM32F4_DMA_FLAGS_ALL;
+}
+
+static void STM32F4_Dma_ClearFlags(int32_t stream, uint32_t flags) {
+    auto dma = STM32F4_Dma_GetController(stream);
+    auto index = stream % STM32F4_DMA_STREAMS_PER_CONTROLLER;
+
+    if (index < 4)
+        dma->LIFCR = flags << dmaFlagShifts[index % 4];
+    else
+        dma->HIFCR = flags << dmaFlagShifts[index % 4];
+}
+
+static uint32_t STM32F4_Dma_GetClockEnable(int32_t stream) {
+    return stream < STM32F4_DMA_STREAMS_PER_CONTROLLER ? RCC_AHB1ENR_DMA1EN : RCC_AHB1ENR_DMA2EN;
+}
+
+void STM32F4_Dma_InterruptHandler(void* param) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    auto stream = *reinterpret_cast<const int32_t*>(param);
+    auto state = &dmaState;
+    auto streamState = &state->streams[stream];
+    auto flags = STM32F4_Dma_ReadFlags(stream);
+
+    STM32F4_Dma_ClearFlags(stream, flags);
+
+    // the handler may stop or release the stream, nothing of it is used after the last call
+    auto handler = streamState->handler;
+    auto handlerParam = streamState->param;
+
+    if (flags & DMA_LISR_TEIF0) {
+        DmaAllocator_RecordError(&state->allocator, stream);
+
+        if (handler != nullptr)
+            handler(stream, STM32F4_Dma_Event::Error, handlerParam);
+
+        return;
+    }
+
+    if ((flags & DMA_LISR_HTIF0) && handler != nullptr)
+        handler(stream, STM32F4_Dma_Event::HalfCompleted, handlerParam);
+
+    if (flags & DMA_LISR_TCIF0) {
+        DmaAllocator_RecordTransfer(&state->allocator, stream, streamState->bytes);
+
+        if (handler != nullptr)
+            handler(stream, STM32F4_Dma_Event::Completed, handlerParam);
+    }
+}
+
+int32_t STM32F4_Dma_AcquireStream(uint32_t candidates, const void* owner) {
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    auto state = &dmaState;
+
+    if (state->allocator.channelCount == 0)
+        DmaAllocator_Initialize(&state->allocator, STM32F4_DMA_STREAM_COUNT);
+
+    auto stream = DmaAllocator_Acquire(&state->allocator, candidates, owner);
+
+    if (stream == STM32F4_DMA_STREAM_NONE)
+        return STM32F4_DMA_STREAM_NONE;
+
+    RCC->AHB1ENR |= STM32F4_Dma_GetClockEnable(stream);
+
+    STM32F4_Dma_Stop(stream);
+
+    state->streams[stream].handler = nullptr;
+    state->streams[stream].param = nullptr;
+
+    STM32F4_InterruptInternal_Activate(dmaStreamIrqs[stream], (uint32_t*)&STM32F4_Dma_InterruptHandler, (void*)&dmaStreamIndexes[stream]);
+
+    return stream;
+}
+
+void STM32F4_Dma_ReleaseStream(int32_t stream, const void* owner) {
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    auto state = &dmaState;
+
+    if (owner == nullptr || DmaAllocator_GetOwner(&state->allocator, stream) != owner)
+        return;
+
+    STM32F4_Dma_Stop(stream);
+
+    STM32F4_InterruptInternal_Deactivate(dmaStreamIrqs[stream]);
+
+    state->streams[stream].handler = nullptr;
+
+    DmaAllocator_Release(&state->allocator, stream, owner);
+
+    auto controller = stream / STM32F4_DMA_STREAMS_PER_CONTROLLER;
+
+    if (((state->allocator.acquired >> (controller * STM32F4_DMA_STREAMS_PER_CONTROLLER)) & 0xFF) == 0)
+        RCC->AHB1ENR &= ~STM32F4_Dma_GetClockEnable(stream);
+}
+
+TinyCLR_Result STM32F4_Dma_Start(int32_t stream, const STM32F4_Dma_Transfer* transfer, STM32F4_Dma_EventHandler handler, void* param) {
+    auto state = &dmaState;
+
+    if (transfer == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    if (!DmaAllocator_IsAcquired(&state->allocator, stream))
+        return TinyCLR_Result::InvalidOperation;
+
+    if (transfer->count == 0 || transfer->count > 0xFFFF)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto s = STM32F4_Dma_GetStream(stream);
+
+    if (s->CR & DMA_SxCR_EN)
+        return TinyCLR_Result::Busy;
+
+    auto streamState = &state->streams[stream];
+
+    streamState->handler = handler;
+    streamState->param = param;
+    streamState->bytes = transfer->count << ((transfer->control & DMA_SxCR_PSIZE) >> DMA_SxCR_PSIZE_Pos);
+
+    STM32F4_Dma_ClearFlags(stream, STM32F4_DMA_FLAGS_ALL);
+
+    s->PAR = transfer->peripheral;
+    s->M0AR = transfer->memory0;
+    s->M1AR = transfer->memory1;
+    s->NDTR = transfer->count;
+    s->FCR = transfer->fifoControl;
+    s->CR = (transfer->control & ~(DMA_SxCR_EN | DMA_SxCR_TCIE | DMA_SxCR_TEIE | DMA_SxCR_DMEIE | (handler == nullptr ? DMA_SxCR_HTIE : 0))) | (handler != nullptr ? (DMA_SxCR_TCIE | DMA_SxCR_TEIE) : 0);
+
+    s->CR |= DMA_SxCR_EN;
+
+    return TinyCLR_Result::Success;
+}
+
+void STM32F4_Dma_Stop(int32_t stream) {
+    if (!DmaAllocator_IsAcquired(&dmaState.allocator, stream))
+        return;
+
+    auto s = STM32F4_Dma_GetStream(stream);
+
+    s->CR = 0;
+    while (s->CR & DMA_SxCR_EN);
+
+    STM32F4_Dma_ClearFlags(stream, STM32F4_DMA_FLAGS_ALL);
+}
+
+bool STM32F4_Dma_IsBusy(int32_t stream) {
+    if (!DmaAllocator_IsAcquired(&dmaState.allocator, stream))
+        return false;
+
+    return (STM32F4_Dma_GetStream(stream)->CR & DMA_SxCR_EN) != 0;
+}
+
+// Polls a one shot transfer to its end, a circular one never ends and is stopped instead. Returns false on a
+// transfer error.
+bool STM32F4_Dma_Wait(int32_t stream) {
+    auto state = &dmaState;
+
+    if (!DmaAllocator_IsAcquired(&state->allocator, stream))
+        return false;
+
+    auto s = STM32F4_Dma_GetStream(stream);
+
+    while ((s->CR & DMA_SxCR_EN) && !(STM32F4_Dma_ReadFlags(stream) & DMA_LISR_TEIF0));
+
+    auto flags = STM32F4_Dma_ReadFlags(stream);
+
+    if (flags & DMA_LISR_TEIF0) {
+        s->CR = 0;
+        while (s->CR & DMA_SxCR_EN);
+
+        DmaAllocator_RecordError(&state->allocator, stream);
+    }
+    else if (flags & DMA_LISR_TCIF0) {
+        DmaAllocator_RecordTransfer(&state->allocator, stream, state->streams[stream].bytes);
+    }
+
+    STM32F4_Dma_ClearFlags(stream, flags);
+
+    return !(flags & DMA_LISR_TEIF0);
+}
+
+// items still to be moved in the current pass
+size_t STM32F4_Dma_GetRemaining(int32_t stream) {
+    if (!DmaAllocator_IsAcquired(&dmaState.allocator, stream))
+        return 0;
+
+    return STM32F4_Dma_GetStream(stream)->NDTR;
+}
+
+// the buffer the stream is moving now in double buffer mode, 0 or 1
+uint32_t STM32F4_Dma_GetCurrentMemory(int32_t stream) {
+    if (!DmaAllocator_IsAcquired(&dmaState.allocator, stream))
+        return 0;
+
+    return (STM32F4_Dma_GetStream(stream)->CR & DMA_SxCR_CT) ? 1 : 0;
+}
+
+// only the buffer that is not current may be replaced while the stream runs
+void STM32F4_Dma_SetMemory(int32_t stream, uint32_t memory, uint32_t address) {
+    if (!DmaAllocator_IsAcquired(&dmaState.allocator, stream))
+        return;
+
+    auto s = STM32F4_Dma_GetStream(stream);
+
+    if (memory == 0)
+        s->M0AR = address;
+    else
+        s->M1AR = address;
+}
+
+const DmaAllocator_Statistics* STM32F4_Dma_GetStatistics(int32_t stream) {
+    return DmaAllocator_GetStatistics(&dmaState.allocator, stream);
+}
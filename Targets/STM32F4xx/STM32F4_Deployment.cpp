@@ -23,8 +23,15 @@
 #define STM32F4_FLASH               ((FLASH_TypeDef *) FLASH_R_BASE)
 #endif
 
-#if STM32F4_SUPPLY_VOLTAGE_MV < 2100
-#error 16 bit Flash programming not allowed for voltages below 2.1V
+// Program parallelism allowed by the supply voltage range (external VPP is needed for x64)
+#if STM32F4_SUPPLY_VOLTAGE_MV >= 2700 && defined(STM32F4_FLASH_EXTERNAL_VPP)
+#define STM32F4_FLASH_PROGRAM_SIZE      8
+#elif STM32F4_SUPPLY_VOLTAGE_MV >= 2700
+#define STM32F4_FLASH_PROGRAM_SIZE      4
+#elif STM32F4_SUPPLY_VOLTAGE_MV >= 2100
+#define STM32F4_FLASH_PROGRAM_SIZE      2
+#else
+#define STM32F4_FLASH_PROGRAM_SIZE      1
 #endif
 #if STM32F4_AHB_CLOCK_HZ < 1000000
 #error Flash programming not allowed for HCLK below 1MHz
@@ -33,6 +40,16 @@
 static const uint32_t STM32F4_FLASH_KEY1 = 0x45670123;
 static const uint32_t STM32F4_FLASH_KEY2 = 0xcdef89ab;
 
+#ifndef FLASH_CR_ERRIE
+#define FLASH_CR_ERRIE              ((uint32_t)0x02000000)
+#endif
+
+#define STM32F4_FLASH_SR_ERRORS     (FLASH_SR_SOP | FLASH_SR_WRPERR | FLASH_SR_PGAERR | FLASH_SR_PGPERR | FLASH_SR_PGSERR)
+
+#ifndef STM32F4_FLASH_ERASE_QUEUE_SIZE
+#define STM32F4_FLASH_ERASE_QUEUE_SIZE 16
+#endif
+
 struct DeploymentSector {
     uint32_t id;
     uint32_t address;
@@ -55,12 +72,22 @@ struct DeploymentState {
     TinyCLR_Storage_Descriptor storageDescriptor;
     TinyCLR_Startup_DeploymentConfiguration deploymentConfiguration;
 
+    // sectors waiting for the background erase, the head is the one being erased
+    uint32_t eraseQueue[STM32F4_FLASH_ERASE_QUEUE_SIZE];
+    size_t eraseQueueIn;
+    volatile size_t eraseQueueCount;
+    volatile size_t eraseErrorCount;
+    volatile bool eraseBusy;
+    STM32F4_Flash_EraseCompletedHandler eraseCompletedHandler;
+
     bool isOpened = false;
     bool tableInitialized = false;
 };
 
 static DeploymentState deploymentStates[TOTAL_DEPLOYMENT_CONTROLLERS];
 
+static STM32F4_Flash_BenchmarkHandler flashBenchmarkHandler = nullptr;
+
 const char* flashApiNames[TOTAL_DEPLOYMENT_CONTROLLERS] = {
     "GHIElectronics.TinyCLR.NativeApis.STM32F4.StorageController\\0"
 };
@@ -139,6 +166,16 @@ TinyCLR_Result __section("SectionForFlashOperations") STM32F4_Flash_Read(const T
     return TinyCLR_Result::Success;
 }
 
+uint32_t __section("SectionForFlashOperations") STM32F4_Flash_GetProgramSize(uint32_t address, uint32_t end) {
+    uint32_t size = STM32F4_FLASH_PROGRAM_SIZE;
+
+    // unaligned head and short tail fall back to a narrower parallelism
+    while (size > 1 && ((address & (size - 1)) != 0 || end - address < size))
+        size >>= 1;
+
+    return size;
+}
+
 TinyCLR_Result __section("SectionForFlashOperations") STM32F4_Flash_Write(const TinyCLR_Storage_Controller* self, uint64_t address, size_t& count, const uint8_t* data, uint64_t timeout) {
     if (data == nullptr) return TinyCLR_Result::ArgumentNull;
 
@@ -146,37 +183,108 @@ TinyCLR_Result __section("SectionForFlashOperations") STM32F4_Flash_Write(const
 
     if (bytePerSector <= 0) return TinyCLR_Result::IndexOutOfRange;
 
+    auto state = reinterpret_cast<DeploymentState*>(self->ApiInfo->State);
+
+    while (state->eraseBusy);
+
+    auto benchmarkHandler = flashBenchmarkHandler;
+    auto startTime = benchmarkHandler != nullptr ? STM32F4_Time_GetCurrentProcessorTime() : 0;
+    size_t programmed = 0;
+    size_t skipped = 0;
+
     if (STM32F4_FLASH->CR & FLASH_CR_LOCK) { // unlock
         STM32F4_FLASH->KEYR = STM32F4_FLASH_KEY1;
         STM32F4_FLASH->KEYR = STM32F4_FLASH_KEY2;
     }
 
-    uint32_t* addressStart = reinterpret_cast<uint32_t*>(address);
-    uint32_t* addressEnd = reinterpret_cast<uint32_t*>(address + count);
-    uint32_t* pBuf = (uint32_t*)data;
+    while (STM32F4_FLASH->SR & FLASH_SR_BSY);
+
+    STM32F4_FLASH->SR = FLASH_SR_EOP | STM32F4_FLASH_SR_ERRORS;
 
-    // enable programming
-    STM32F4_FLASH->CR = FLASH_CR_PG | FLASH_CR_PSIZE_1;
+    auto result = TinyCLR_Result::Success;
+    uint32_t addressStart = static_cast<uint32_t>(address);
+    uint32_t addressEnd = static_cast<uint32_t>(address + count);
+    uint32_t currentSize = 0;
 
     while (addressStart < addressEnd) {
-        if (*addressStart != *pBuf) {
-            // write data
-            *addressStart = *pBuf;
-            // wait for completion
-            while (STM32F4_FLASH->SR & FLASH_SR_BSY);
-            // check
-            if (*addressStart != *pBuf) {
-                return TinyCLR_Result::InvalidOperation;
+        auto size = STM32F4_Flash_GetProgramSize(addressStart, addressEnd);
+        auto flash = reinterpret_cast<volatile uint8_t*>(addressStart);
+        auto changed = false;
+
+        for (auto i = 0; i < size; i++) {
+            auto value = flash[i];
+
+            if (value != data[i]) {
+                changed = true;
+
+                // bits can only be cleared, the sector has to be erased first
+                if ((value & data[i]) != data[i]) {
+                    result = TinyCLR_Result::InvalidOperation;
+
+                    goto end_programming;
+                }
             }
         }
-        addressStart++;
-        pBuf++;
+
+        if (changed) {
+            if (size != currentSize) {
+                // PSIZE must not change while an operation is running
+                while (STM32F4_FLASH->SR & FLASH_SR_BSY);
+
+                STM32F4_FLASH->CR = FLASH_CR_PG | (size == 8 ? FLASH_CR_PSIZE : size == 4 ? FLASH_CR_PSIZE_1 : size == 2 ? FLASH_CR_PSIZE_0 : 0);
+
+                currentSize = size;
+            }
+
+            // write data, back to back writes are stalled by the controller until the previous one completes,
+            // errors are collected from the status register once the batch is done instead of reading back every word
+            switch (size) {
+            case 8:
+                *reinterpret_cast<volatile uint32_t*>(addressStart) = data[0] | (data[1] << 8) | (data[2] << 16) | (data[3] << 24);
+                *reinterpret_cast<volatile uint32_t*>(addressStart + 4) = data[4] | (data[5] << 8) | (data[6] << 16) | (data[7] << 24);
+                break;
+
+            case 4:
+                *reinterpret_cast<volatile uint32_t*>(addressStart) = data[0] | (data[1] << 8) | (data[2] << 16) | (data[3] << 24);
+                break;
+
+            case 2:
+                *reinterpret_cast<volatile uint16_t*>(addressStart) = data[0] | (data[1] << 8);
+                break;
+
+            default:
+                *flash = data[0];
+                break;
+            }
+
+            programmed += size;
+        }
+        else {
+            skipped += size;
+        }
+
+        addressStart += size;
+        data += size;
     }
 
+end_programming:
+    // wait for completion
+    while (STM32F4_FLASH->SR & FLASH_SR_BSY);
+
+    if (STM32F4_FLASH->SR & STM32F4_FLASH_SR_ERRORS)
+        result = TinyCLR_Result::InvalidOperation;
+
     // reset & lock the controller
     STM32F4_FLASH->CR = FLASH_CR_LOCK;
 
-    return TinyCLR_Result::Success;
+    if (benchmarkHandler != nullptr)
+        benchmarkHandler(self, programmed, skipped, result, STM32F4_Time_GetCurrentProcessorTime() - startTime);
+
+    return result;
+}
+
+void STM32F4_Flash_SetBenchmarkHandler(STM32F4_Flash_BenchmarkHandler handler) {
+    flashBenchmarkHandler = handler;
 }
 
 TinyCLR_Result __section("SectionForFlashOperations") STM32F4_Flash_IsErased(const TinyCLR_Storage_Controller* self, uint64_t address, size_t count, bool& erased) {
@@ -203,36 +311,138 @@ TinyCLR_Result __section("SectionForFlashOperations") STM32F4_Flash_IsErased(con
     return TinyCLR_Result::Success;
 }
 
-TinyCLR_Result __section("SectionForFlashOperations") STM32F4_Flash_Erase(const TinyCLR_Storage_Controller* self, uint64_t address, size_t& count, uint64_t timeout) {
-    auto sector = address; //address is sector. Use sector for clear
-    auto state = reinterpret_cast<DeploymentState*>(self->ApiInfo->State);
-
-    if (sector >= state->regionCount) return TinyCLR_Result::IndexOutOfRange;
-
+uint32_t __section("SectionForFlashOperations") STM32F4_Flash_GetSectorNumber(size_t sector) {
     uint32_t num = deploymentSectors[sector].id;
 
     if (num > 11) num += 4;
 
+    return num;
+}
+
+void __section("SectionForFlashOperations") STM32F4_Flash_StartErase(size_t sector, bool interruptEnable) {
     if (STM32F4_FLASH->CR & FLASH_CR_LOCK) { // unlock
         STM32F4_FLASH->KEYR = STM32F4_FLASH_KEY1;
         STM32F4_FLASH->KEYR = STM32F4_FLASH_KEY2;
     }
 
+    // clear flags left from a previous operation
+    STM32F4_FLASH->SR = FLASH_SR_EOP | STM32F4_FLASH_SR_ERRORS;
+
     // enable erasing
-    uint32_t cr = num * FLASH_CR_SNB_0 | FLASH_CR_SER;
+    uint32_t cr = STM32F4_Flash_GetSectorNumber(sector) * FLASH_CR_SNB_0 | FLASH_CR_SER;
+
+    if (interruptEnable)
+        cr |= FLASH_CR_EOPIE | FLASH_CR_ERRIE;
+
     STM32F4_FLASH->CR = cr;
     // start erase
     cr |= FLASH_CR_STRT;
     STM32F4_FLASH->CR = cr;
     // assure busy flag is set up (see STM32F4 errata)
     STM32F4_FLASH->CR = cr;
+}
+
+TinyCLR_Result __section("SectionForFlashOperations") STM32F4_Flash_Erase(const TinyCLR_Storage_Controller* self, uint64_t address, size_t& count, uint64_t timeout) {
+    auto sector = address; //address is sector. Use sector for clear
+    auto state = reinterpret_cast<DeploymentState*>(self->ApiInfo->State);
+
+    if (sector >= state->regionCount) return TinyCLR_Result::IndexOutOfRange;
+
+    // let a queued background erase finish before taking the controller
+    while (state->eraseBusy);
+
+    STM32F4_Flash_StartErase(sector, false);
+
     // wait for completion
     while (STM32F4_FLASH->SR & FLASH_SR_BSY);
 
+    auto error = STM32F4_FLASH->SR & STM32F4_FLASH_SR_ERRORS;
+
     // reset & lock the controller
     STM32F4_FLASH->CR = FLASH_CR_LOCK;
 
-    TinyCLR_Result::Success;
+    return error == 0 ? TinyCLR_Result::Success : TinyCLR_Result::InvalidOperation;
+}
+
+void __section("SectionForFlashOperations") STM32F4_Flash_EraseInterruptHandler(void* param) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    auto state = &deploymentStates[0];
+    auto sr = STM32F4_FLASH->SR;
+    auto sector = state->eraseQueue[state->eraseQueueIn];
+
+    STM32F4_FLASH->SR = FLASH_SR_EOP | STM32F4_FLASH_SR_ERRORS;
+
+    state->eraseQueueIn = (state->eraseQueueIn + 1) % STM32F4_FLASH_ERASE_QUEUE_SIZE;
+    state->eraseQueueCount--;
+
+    if (sr & STM32F4_FLASH_SR_ERRORS)
+        state->eraseErrorCount++;
+
+    if (state->eraseQueueCount > 0) {
+        // chain the next sector while still in the interrupt, the controller stays unlocked
+        STM32F4_Flash_StartErase(state->eraseQueue[state->eraseQueueIn], true);
+    }
+    else {
+        // reset & lock the controller
+        STM32F4_FLASH->CR = FLASH_CR_LOCK;
+
+        STM32F4_InterruptInternal_Deactivate(FLASH_IRQn);
+
+        state->eraseBusy = false;
+    }
+
+    if (state->eraseCompletedHandler != nullptr)
+        state->eraseCompletedHandler(&deploymentControllers[0], sector, (sr & STM32F4_FLASH_SR_ERRORS) == 0 ? TinyCLR_Result::Success : TinyCLR_Result::InvalidOperation, state->eraseQueueCount);
+}
+
+TinyCLR_Result STM32F4_Flash_EraseAsync(const TinyCLR_Storage_Controller* self, uint64_t sector, STM32F4_Flash_EraseCompletedHandler handler) {
+    auto state = reinterpret_cast<DeploymentState*>(self->ApiInfo->State);
+
+    if (sector >= state->regionCount) return TinyCLR_Result::IndexOutOfRange;
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    if (state->eraseQueueCount == STM32F4_FLASH_ERASE_QUEUE_SIZE) return TinyCLR_Result::Busy;
+
+    if (state->eraseQueueCount > 0 && state->eraseCompletedHandler != handler) return TinyCLR_Result::SharingViolation;
+
+    state->eraseQueue[(state->eraseQueueIn + state->eraseQueueCount) % STM32F4_FLASH_ERASE_QUEUE_SIZE] = sector;
+    state->eraseQueueCount++;
+    state->eraseCompletedHandler = handler;
+
+    if (!state->eraseBusy) {
+        state->eraseBusy = true;
+        state->eraseErrorCount = 0;
+
+        STM32F4_InterruptInternal_Activate(FLASH_IRQn, (uint32_t*)&STM32F4_Flash_EraseInterruptHandler, 0);
+
+        STM32F4_Flash_StartErase(sector, true);
+    }
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result STM32F4_Flash_WaitForErase(const TinyCLR_Storage_Controller* self, uint64_t timeout) {
+    auto state = reinterpret_cast<DeploymentState*>(self->ApiInfo->State);
+
+    // timeout in microseconds
+    while (state->eraseBusy) {
+        if (timeout == 0)
+            return TinyCLR_Result::TimedOut;
+
+        STM32F4_Time_Delay(nullptr, 1);
+
+        timeout--;
+    }
+
+    return state->eraseErrorCount == 0 ? TinyCLR_Result::Success : TinyCLR_Result::InvalidOperation;
+}
+
+bool STM32F4_Flash_IsEraseBusy(const TinyCLR_Storage_Controller* self) {
+    auto state = reinterpret_cast<DeploymentState*>(self->ApiInfo->State);
+
+    return state->eraseBusy;
 }
 
 TinyCLR_Result STM32F4_Flash_Acquire(const TinyCLR_Storage_Controller* self) {
@@ -26,6 +26,12 @@ static const STM32F4_Gpio_PinConfiguration gpioPins[] = STM32F4_GPIO_PINS;
 
 #define DEBOUNCE_DEFAULT_TICKS     (20*10000) // 20ms in ticks
 
+// Every interrupt line queues its edges, the runtime handler is called once per edge unless Device.h defines
+// STM32F4_GPIO_EDGE_BATCHING, then once per batch and the edges are read with STM32F4_Gpio_ReadEdges.
+#ifndef STM32F4_GPIO_EDGE_FIFO_SIZE
+#define STM32F4_GPIO_EDGE_FIFO_SIZE 16
+#endif
+
 #define PIN_RESERVED 1
 
 // indexed port configuration access
@@ -39,6 +45,12 @@ struct GpioInterruptState {
     TinyCLR_Gpio_PinChangedHandler handler;
     TinyCLR_Gpio_PinValue currentValue;
     TinyCLR_Gpio_PinChangeEdge edge;
+
+    STM32F4_Gpio_Edge edges[STM32F4_GPIO_EDGE_FIFO_SIZE];
+    size_t edgeOut;
+    size_t edgeCount;
+    uint32_t edgeOverflows;
+    bool notified;
 };
 
 struct GpioState {
@@ -117,6 +129,302 @@ TinyCLR_Result STM32F4_Gpio_Release(const TinyCLR_Gpio_Controller* self) {
     return TinyCLR_Result::Success;
 }
 
+// lines 5..9 and 10..15 share one interrupt each
+static IRQn_Type STM32F4_Gpio_GetInterruptIrq(uint32_t num) {
+    if (num < 5)
+        return static_cast<IRQn_Type>(EXTI0_IRQn + num);
+
+    return num < 10 ? EXTI9_5_IRQn : EXTI15_10_IRQn;
+}
+
+// the edge FIFO of a line is filled by its EXTI interrupt and, with timer debounce, by the debounce interrupt
+static uint32_t STM32F4_Gpio_GetMaskPriority(uint32_t num) {
+    auto priority = NVIC_GetPriority(STM32F4_Gpio_GetInterruptIrq(num));
+
+#ifdef STM32F4_GPIO_DEBOUNCE_TIM12
+    auto timerPriority = NVIC_GetPriority(TIM8_BRK_TIM12_IRQn);
+
+    if (timerPriority < priority)
+        priority = timerPriority;
+#endif
+
+    return priority;
+}
+
+#define GPIO_MASK_INTERRUPTS_SCOPED(name, num) STM32F4_MaskInterrupts_RaiiHelper name(STM32F4_Gpio_GetMaskPriority(num))
+
+static bool STM32F4_Gpio_IsEdgeExpected(GpioInterruptState* interruptState, TinyCLR_Gpio_PinValue value) {
+    auto edge = value == TinyCLR_Gpio_PinValue::High ? TinyCLR_Gpio_PinChangeEdge::RisingEdge : TinyCLR_Gpio_PinChangeEdge::FallingEdge;
+    auto expectedEdgeInterger = static_cast<uint32_t>(interruptState->edge);
+    auto currentEdgeInterger = static_cast<uint32_t>(edge);
+
+    return (expectedEdgeInterger & currentEdgeInterger) || (expectedEdgeInterger == 0);
+}
+
+// called with the line masked
+static void STM32F4_Gpio_QueueEdge(GpioInterruptState* interruptState, TinyCLR_Gpio_PinValue value, uint64_t timestamp) {
+    if (interruptState->edgeCount == STM32F4_GPIO_EDGE_FIFO_SIZE) {
+        interruptState->edgeOverflows++;
+
+        return;
+    }
+
+    auto& edge = interruptState->edges[(interruptState->edgeOut + interruptState->edgeCount) % STM32F4_GPIO_EDGE_FIFO_SIZE];
+
+    edge.timestamp = timestamp;
+    edge.value = value;
+
+    interruptState->edgeCount++;
+}
+
+static bool STM32F4_Gpio_DequeueEdge(uint32_t num, STM32F4_Gpio_Edge& edge) {
+    auto interruptState = &gpioInterruptState[num];
+
+    GPIO_MASK_INTERRUPTS_SCOPED(irq, num);
+
+    if (interruptState->edgeCount == 0) {
+        interruptState->notified = false;
+
+        return false;
+    }
+
+    edge = interruptState->edges[interruptState->edgeOut];
+
+    interruptState->edgeOut = (interruptState->edgeOut + 1) % STM32F4_GPIO_EDGE_FIFO_SIZE;
+    interruptState->edgeCount--;
+
+    // the batch is read out, the next edge starts a new one
+    if (interruptState->edgeCount == 0)
+        interruptState->notified = false;
+
+    return true;
+}
+
+// Runs in interrupt context with the line unmasked, so the runtime handler never runs inside a critical section
+static void STM32F4_Gpio_DeliverEdges(uint32_t num) {
+    auto interruptState = &gpioInterruptState[num];
+    auto handler = interruptState->handler;
+
+    if (handler == nullptr)
+        return;
+
+#ifdef STM32F4_GPIO_EDGE_BATCHING
+    STM32F4_Gpio_Edge edge;
+
+    {
+        GPIO_MASK_INTERRUPTS_SCOPED(irq, num);
+
+        if (interruptState->notified || interruptState->edgeCount == 0)
+            return;
+
+        // one event per batch, the edges themselves are collected with STM32F4_Gpio_ReadEdges
+        interruptState->notified = true;
+
+        edge = interruptState->edges[interruptState->edgeOut];
+    }
+
+    handler(interruptState->controller, interruptState->pin, edge.value == TinyCLR_Gpio_PinValue::High ? TinyCLR_Gpio_PinChangeEdge::RisingEdge : TinyCLR_Gpio_PinChangeEdge::FallingEdge, edge.timestamp);
+#else
+    STM32F4_Gpio_Edge edge;
+
+    while (STM32F4_Gpio_DequeueEdge(num, edge))
+        handler(interruptState->controller, interruptState->pin, edge.value == TinyCLR_Gpio_PinValue::High ? TinyCLR_Gpio_PinChangeEdge::RisingEdge : TinyCLR_Gpio_PinChangeEdge::FallingEdge, edge.timestamp);
+#endif
+}
+
+TinyCLR_Result STM32F4_Gpio_ReadEdges(uint32_t pin, STM32F4_Gpio_Edge* edges, size_t& count, uint32_t& overflows) {
+    if (pin >= TOTAL_GPIO_PINS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    if (edges == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    auto num = pin & 0x0F;
+    auto interruptState = &gpioInterruptState[num];
+
+    if (interruptState->pin != pin || interruptState->handler == nullptr)
+        return TinyCLR_Result::InvalidOperation;
+
+    size_t read = 0;
+
+    while (read < count && STM32F4_Gpio_DequeueEdge(num, edges[read]))
+        read++;
+
+    {
+        GPIO_MASK_INTERRUPTS_SCOPED(irq, num);
+
+        overflows = interruptState->edgeOverflows;
+        interruptState->edgeOverflows = 0;
+    }
+
+    count = read;
+
+    return TinyCLR_Result::Success;
+}
+
+#ifdef STM32F4_GPIO_DEBOUNCE_TIM12
+// TIM12 counts at 10kHz. A line that sees an edge is taken off EXTI until its debounce time has passed on the timer,
+// then its settled level is sampled once and reported if it changed, stamped with the time of the first edge.
+#define STM32F4_GPIO_DEBOUNCE_TIMER_HZ 10000
+#define STM32F4_GPIO_DEBOUNCE_MAX_TICKS 0x7FFF
+
+#if STM32F4_APB1_CLOCK_HZ == STM32F4_AHB_CLOCK_HZ
+#define STM32F4_GPIO_DEBOUNCE_CLOCK_HZ (STM32F4_APB1_CLOCK_HZ)
+#else
+#define STM32F4_GPIO_DEBOUNCE_CLOCK_HZ (STM32F4_APB1_CLOCK_HZ * 2)
+#endif
+
+static uint16_t gpioDebounceDeadline[TOTAL_GPIO_INTERRUPT_PINS];
+static uint32_t gpioDebouncePending;
+static bool gpioDebounceTimerOwned;
+
+void STM32F4_Gpio_DebounceInterrupt(void* param);
+
+// CC1 is moved to the nearest deadline, called with interrupts disabled
+static void STM32F4_Gpio_ScheduleDebounce() {
+    if (gpioDebouncePending == 0) {
+        TIM12->DIER = 0;
+
+        return;
+    }
+
+    uint16_t now = TIM12->CNT;
+    uint16_t nearest = STM32F4_GPIO_DEBOUNCE_MAX_TICKS;
+
+    for (auto num = 0; num < TOTAL_GPIO_INTERRUPT_PINS; num++) {
+        if (gpioDebouncePending & (1 << num)) {
+            auto remaining = static_cast<int16_t>(gpioDebounceDeadline[num] - now);
+
+            if (remaining < nearest)
+                nearest = remaining > 0 ? remaining : 0;
+        }
+    }
+
+    // at least one tick ahead, a compare value the counter already passed would wait a full wrap
+    TIM12->CCR1 = static_cast<uint16_t>(now + (nearest > 0 ? nearest : 1));
+    TIM12->SR = ~TIM_SR_CC1IF;
+    TIM12->DIER = TIM_DIER_CC1IE;
+}
+
+// TIM12 is also PWM controller 11, it is only taken when nothing else clocked it and kept until the GPIO reset
+static bool STM32F4_Gpio_AcquireDebounceTimer() {
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    if (gpioDebounceTimerOwned)
+        return true;
+
+    if (RCC->APB1ENR & RCC_APB1ENR_TIM12EN)
+        return false;
+
+    RCC->APB1ENR |= RCC_APB1ENR_TIM12EN;
+
+    TIM12->CR1 = 0;
+    TIM12->DIER = 0;
+    TIM12->PSC = STM32F4_GPIO_DEBOUNCE_CLOCK_HZ / STM32F4_GPIO_DEBOUNCE_TIMER_HZ - 1;
+    TIM12->ARR = 0xFFFF;
+    TIM12->EGR = TIM_EGR_UG;
+    TIM12->SR = 0;
+    TIM12->CR1 = TIM_CR1_CEN;
+
+    STM32F4_InterruptInternal_Activate(TIM8_BRK_TIM12_IRQn, (uint32_t*)&STM32F4_Gpio_DebounceInterrupt, 0);
+
+    gpioDebounceTimerOwned = true;
+
+    return true;
+}
+
+static void STM32F4_Gpio_StartDebounce(uint32_t num, uint64_t timestamp) {
+    auto interruptState = &gpioInterruptState[num];
+    auto ticks = gpioDebounceInTicks[interruptState->pin] * STM32F4_GPIO_DEBOUNCE_TIMER_HZ / 10000000;
+
+    if (ticks < 1)
+        ticks = 1;
+
+    if (ticks > STM32F4_GPIO_DEBOUNCE_MAX_TICKS)
+        ticks = STM32F4_GPIO_DEBOUNCE_MAX_TICKS;
+
+    interruptState->lastDebounceTicks = timestamp;
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    gpioDebounceDeadline[num] = static_cast<uint16_t>(TIM12->CNT + ticks);
+    gpioDebouncePending |= 1 << num;
+
+    STM32F4_Gpio_ScheduleDebounce();
+}
+
+static void STM32F4_Gpio_StopDebounce() {
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    gpioDebouncePending = 0;
+
+    if (gpioDebounceTimerOwned) {
+        TIM12->CR1 = 0;
+        TIM12->DIER = 0;
+        TIM12->SR = 0;
+
+        STM32F4_InterruptInternal_Deactivate(TIM8_BRK_TIM12_IRQn);
+
+        RCC->APB1ENR &= ~RCC_APB1ENR_TIM12EN;
+
+        gpioDebounceTimerOwned = false;
+    }
+}
+
+void STM32F4_Gpio_DebounceInterrupt(void* param) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    uint32_t expired = 0;
+
+    {
+        DISABLE_INTERRUPTS_SCOPED(irq);
+
+        TIM12->SR = ~TIM_SR_CC1IF;
+
+        uint16_t now = TIM12->CNT;
+
+        for (auto num = 0; num < TOTAL_GPIO_INTERRUPT_PINS; num++)
+            if ((gpioDebouncePending & (1 << num)) && static_cast<int16_t>(now - gpioDebounceDeadline[num]) >= 0)
+                expired |= 1 << num;
+
+        gpioDebouncePending &= ~expired;
+
+        STM32F4_Gpio_ScheduleDebounce();
+    }
+
+    for (auto num = 0; num < TOTAL_GPIO_INTERRUPT_PINS; num++) {
+        if (!(expired & (1 << num)))
+            continue;
+
+        auto interruptState = &gpioInterruptState[num];
+        uint32_t bit = 1 << num;
+
+        {
+            GPIO_MASK_INTERRUPTS_SCOPED(irq, num);
+
+            if (interruptState->handler == nullptr)
+                continue;
+
+            TinyCLR_Gpio_PinValue value;
+
+            STM32F4_Gpio_Read(nullptr, interruptState->pin, value);
+
+            EXTI->PR = bit; // bounces seen while the line was off
+            EXTI->IMR |= bit;
+
+            if (value != interruptState->currentValue) {
+                interruptState->currentValue = value;
+
+                if (STM32F4_Gpio_IsEdgeExpected(interruptState, value))
+                    STM32F4_Gpio_QueueEdge(interruptState, value, interruptState->lastDebounceTicks);
+            }
+        }
+
+        STM32F4_Gpio_DeliverEdges(num);
+    }
+}
+#endif
+
 /*
  * Interrupt Handler
  */
@@ -124,32 +432,51 @@ void STM32F4_Gpio_ISR(int num)  // 0 <= num <= 15
 {
     INTERRUPT_STARTED_SCOPED(isr);
 
-    DISABLE_INTERRUPTS_SCOPED(irq);
-
-    bool executeIsr = false;
-
     GpioInterruptState* interruptState = &gpioInterruptState[num];
 
     uint32_t bit = 1 << num;
 
-    STM32F4_Gpio_Read(nullptr, interruptState->pin, interruptState->currentValue); // read value as soon as possible
+    TinyCLR_Gpio_PinValue value;
+
+    STM32F4_Gpio_Read(nullptr, interruptState->pin, value); // read value as soon as possible
 
     EXTI->PR = bit;   // reset pending bit
 
-    auto edge = interruptState->currentValue == TinyCLR_Gpio_PinValue::High ? TinyCLR_Gpio_PinChangeEdge::RisingEdge : TinyCLR_Gpio_PinChangeEdge::FallingEdge;
-    auto expectedEdgeInterger = static_cast<uint32_t>(interruptState->edge);
-    auto currentEdgeInterger = static_cast<uint32_t>(edge);
+    auto now = STM32F4_Time_GetCurrentProcessorTime(); // the only time read, it stamps the edge and drives the debounce
 
-    if (interruptState->handler && ((expectedEdgeInterger & currentEdgeInterger) || (expectedEdgeInterger == 0))) {        
-        if ((STM32F4_Time_GetCurrentProcessorTime() - interruptState->lastDebounceTicks) >= gpioDebounceInTicks[interruptState->pin]) {
-            executeIsr = true;
+    {
+        GPIO_MASK_INTERRUPTS_SCOPED(irq, num);
+
+        if (interruptState->handler == nullptr)
+            return;
+
+#ifdef STM32F4_GPIO_DEBOUNCE_TIM12
+        if (gpioDebounceInTicks[interruptState->pin] > 0 && gpioDebounceTimerOwned) {
+            // the line stays off until the timer samples the settled level
+            EXTI->IMR &= ~bit;
+
+            STM32F4_Gpio_StartDebounce(num, now);
+
+            return;
         }
+#endif
 
-        interruptState->lastDebounceTicks = STM32F4_Time_GetCurrentProcessorTime();
-    
-        if (executeIsr)
-            interruptState->handler(interruptState->controller, interruptState->pin, edge, STM32F4_Time_GetCurrentProcessorTime());
+        interruptState->currentValue = value;
+
+        if (!STM32F4_Gpio_IsEdgeExpected(interruptState, value))
+            return;
+
+        auto debounced = (now - interruptState->lastDebounceTicks) >= gpioDebounceInTicks[interruptState->pin];
+
+        interruptState->lastDebounceTicks = now;
+
+        if (!debounced)
+            return;
+
+        STM32F4_Gpio_QueueEdge(interruptState, value, now);
     }
+
+    STM32F4_Gpio_DeliverEdges(num);
 }
 
 void STM32F4_Gpio_Interrupt0(void* param) // EXTI0
@@ -207,7 +534,7 @@ TinyCLR_Result STM32F4_Gpio_SetPinChangedHandler(const TinyCLR_Gpio_Controller*
 
     GpioInterruptState* interruptState = &gpioInterruptState[num];
 
-    DISABLE_INTERRUPTS_SCOPED(irq);
+    GPIO_MASK_INTERRUPTS_SCOPED(irq, num);
 
     auto state = reinterpret_cast<GpioState*>(self->ApiInfo->State);
 
@@ -217,14 +544,27 @@ TinyCLR_Result STM32F4_Gpio_SetPinChangedHandler(const TinyCLR_Gpio_Controller*
         if ((SYSCFG->EXTICR[idx] & mask) != config) {
             if (EXTI->IMR & bit)
                 return TinyCLR_Result::SharingViolation; // interrupt in use
+        }
 
+#ifdef STM32F4_GPIO_DEBOUNCE_TIM12
+        if (gpioDebounceInTicks[pin] > 0 && !STM32F4_Gpio_AcquireDebounceTimer())
+            return TinyCLR_Result::SharingViolation; // TIM12 in use
+#endif
+
+        if ((SYSCFG->EXTICR[idx] & mask) != config)
             SYSCFG->EXTICR[idx] = SYSCFG->EXTICR[idx] & ~mask | config;
-        }
+
         interruptState->controller = &gpioControllers[controllerIndex];
         interruptState->pin = (uint8_t)pin;
         interruptState->handler = handler;
         interruptState->lastDebounceTicks = STM32F4_Time_GetCurrentProcessorTime();
         interruptState->edge = edge;
+        interruptState->edgeOut = 0;
+        interruptState->edgeCount = 0;
+        interruptState->edgeOverflows = 0;
+        interruptState->notified = false;
+
+        STM32F4_Gpio_Read(nullptr, pin, interruptState->currentValue);
 
         EXTI->RTSR &= ~bit;
         EXTI->FTSR &= ~bit;
@@ -241,6 +581,10 @@ TinyCLR_Result STM32F4_Gpio_SetPinChangedHandler(const TinyCLR_Gpio_Controller*
     else if ((SYSCFG->EXTICR[idx] & mask) == config) {
         EXTI->IMR &= ~bit; // disable interrupt
         interruptState->handler = 0;
+
+#ifdef STM32F4_GPIO_DEBOUNCE_TIM12
+        gpioDebouncePending &= ~bit;
+#endif
     }
     return TinyCLR_Result::Success;
 }
@@ -256,6 +600,10 @@ bool STM32F4_Gpio_DisableInterrupt(uint32_t pin) {
     if ((SYSCFG->EXTICR[idx] & mask) == config) {
         EXTI->IMR &= ~bit; // disable interrupt
         interruptState->handler = 0;
+
+#ifdef STM32F4_GPIO_DEBOUNCE_TIM12
+        gpioDebouncePending &= ~bit;
+#endif
     }
     return true;
 }
@@ -417,6 +765,14 @@ uint64_t STM32F4_Gpio_GetDebounceTimeout(const TinyCLR_Gpio_Controller* self, ui
 }
 
 TinyCLR_Result STM32F4_Gpio_SetDebounceTimeout(const TinyCLR_Gpio_Controller* self, uint32_t pin, uint64_t debounceTicks) {
+#ifdef STM32F4_GPIO_DEBOUNCE_TIM12
+    auto interruptState = &gpioInterruptState[pin & 0x0F];
+
+    // a pin already reporting edges needs the timer now, the others take it with their handler
+    if (debounceTicks > 0 && interruptState->handler != nullptr && interruptState->pin == pin && !STM32F4_Gpio_AcquireDebounceTimer())
+        return TinyCLR_Result::SharingViolation;
+
+#endif
     gpioDebounceInTicks[pin] = debounceTicks;
 
     return TinyCLR_Result::Success;
@@ -445,6 +801,11 @@ void STM32F4_Gpio_Reset() {
     }
 
     EXTI->IMR = 0; // disable all external interrups;
+
+#ifdef STM32F4_GPIO_DEBOUNCE_TIM12
+    STM32F4_Gpio_StopDebounce();
+#endif
+
     STM32F4_InterruptInternal_Activate(EXTI0_IRQn, (uint32_t*)&STM32F4_Gpio_Interrupt0, 0);
     STM32F4_InterruptInternal_Activate(EXTI1_IRQn, (uint32_t*)&STM32F4_Gpio_Interrupt1, 0);
     STM32F4_InterruptInternal_Activate(EXTI2_IRQn, (uint32_t*)&STM32F4_Gpio_Interrupt2, 0);
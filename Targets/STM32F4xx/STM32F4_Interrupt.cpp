@@ -14,6 +14,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <string.h>
 #include "STM32F4.h"
 
 #define DISABLED_MASK  0x00000001
@@ -23,6 +24,10 @@
 TinyCLR_Interrupt_StartStopHandler STM32F4_Interrupt_Started;
 TinyCLR_Interrupt_StartStopHandler STM32F4_Interrupt_Ended;
 
+#ifdef STM32F4_INTERRUPT_PRIORITIES
+static const STM32F4_Interrupt_Priority interruptPriorities[] = STM32F4_INTERRUPT_PRIORITIES;
+#endif
+
 struct InterruptState {
     uint32_t controllerIndex;
     bool tableInitialized;
@@ -125,6 +130,8 @@ bool STM32F4_InterruptInternal_Activate(uint32_t index, uint32_t *isr, void* isr
 
     __DMB(); // ensure table is written
 
+    NVIC_SetPriority(static_cast<IRQn_Type>(id), STM32F4_InterruptInternal_GetPriority(index));
+
     NVIC->ICPR[id >> 5] = 1 << (id & 0x1F); // clear pending bit
     NVIC->ISER[id >> 5] = 1 << (id & 0x1F); // set enable bit
 
@@ -138,18 +145,356 @@ bool STM32F4_InterruptInternal_Deactivate(uint32_t index) {
 
     return true;
 }
+
+uint32_t STM32F4_InterruptInternal_GetPriority(uint32_t index) {
+#ifdef STM32F4_INTERRUPT_PRIORITIES
+    for (auto i = 0; i < SIZEOF_ARRAY(interruptPriorities); i++)
+        if (interruptPriorities[i].irq == index)
+            return interruptPriorities[i].priority;
+#endif
+
+    return STM32F4_INTERRUPT_DEFAULT_PRIORITY;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Interrupt Trace
+//////////////////////////////////////////////////////////////////////////////
+#ifdef STM32F4_INTERRUPT_TRACE
+struct InterruptTraceEntry {
+    uint32_t count;
+    uint32_t minimumCycles;
+    uint32_t maximumCycles;
+    uint64_t totalCycles;
+};
+
+struct InterruptTraceSection {
+    uint32_t worstCycles;
+    uint32_t callerAddress;
+};
+
+static InterruptTraceEntry interruptTraceEntries[STM32F4_INTERRUPT_TRACE_EXCEPTIONS];
+static InterruptTraceSection interruptTraceSections[2];
+
+static void STM32F4_InterruptTrace_AddHandler(uint32_t startCycles) {
+    auto cycles = DWT->CYCCNT - startCycles;
+    auto exception = __get_IPSR() & 0x1FF;
+
+    if (exception >= STM32F4_INTERRUPT_TRACE_EXCEPTIONS)
+        return;
+
+    auto state = __get_PRIMASK();
+
+    __disable_irq();
+
+    auto& entry = interruptTraceEntries[exception];
+
+    if (entry.count == 0 || cycles < entry.minimumCycles)
+        entry.minimumCycles = cycles;
+
+    if (cycles > entry.maximumCycles)
+        entry.maximumCycles = cycles;
+
+    entry.totalCycles += cycles;
+    entry.count++;
+
+    __set_PRIMASK(state);
+}
+
+// called before the section gives interrupts back
+static void STM32F4_InterruptTrace_AddSection(STM32F4_InterruptTrace_SectionType type, uint32_t startCycles, uint32_t callerAddress) {
+    auto cycles = DWT->CYCCNT - startCycles;
+    auto state = __get_PRIMASK();
+
+    __disable_irq();
+
+    auto& section = interruptTraceSections[static_cast<uint32_t>(type)];
+
+    if (cycles > section.worstCycles) {
+        section.worstCycles = cycles;
+        section.callerAddress = callerAddress;
+    }
+
+    __set_PRIMASK(state);
+}
+
+void STM32F4_InterruptTrace_Reset() {
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    memset(interruptTraceEntries, 0, sizeof(interruptTraceEntries));
+    memset(interruptTraceSections, 0, sizeof(interruptTraceSections));
+}
+
+bool STM32F4_InterruptTrace_GetStatistics(uint32_t exception, STM32F4_InterruptTrace_Statistics& statistics) {
+    if (exception >= STM32F4_INTERRUPT_TRACE_EXCEPTIONS)
+        return false;
+
+    InterruptTraceEntry entry;
+
+    {
+        DISABLE_INTERRUPTS_SCOPED(irq);
+
+        entry = interruptTraceEntries[exception];
+    }
+
+    statistics.count = entry.count;
+    statistics.minimumCycles = entry.minimumCycles;
+    statistics.averageCycles = entry.count > 0 ? static_cast<uint32_t>(entry.totalCycles / entry.count) : 0;
+    statistics.maximumCycles = entry.maximumCycles;
+
+    return entry.count > 0;
+}
+
+void STM32F4_InterruptTrace_GetLongestSection(STM32F4_InterruptTrace_SectionType type, uint32_t& cycles, uint32_t& callerAddress) {
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    auto& section = interruptTraceSections[static_cast<uint32_t>(type)];
+
+    cycles = section.worstCycles;
+    callerAddress = section.callerAddress;
+}
+
+static size_t STM32F4_InterruptTrace_AppendText(char* buffer, size_t length, size_t position, const char* text) {
+    while (*text && position < length)
+        buffer[position++] = *text++;
+
+    return position;
+}
+
+static size_t STM32F4_InterruptTrace_AppendNumber(char* buffer, size_t length, size_t position, uint32_t value, uint32_t radix) {
+    char digits[11];
+    auto count = 0;
+
+    do {
+        digits[count++] = "0123456789ABCDEF"[value % radix];
+        value /= radix;
+    } while (value > 0);
+
+    while (count > 0 && position < length)
+        buffer[position++] = digits[--count];
+
+    return position;
+}
+
+// Entries 0 to STM32F4_INTERRUPT_TRACE_EXCEPTIONS - 1 are the exceptions, the two after them the longest sections.
+// Returns the length of the line, zero for an exception that never ran.
+static size_t STM32F4_InterruptTrace_FormatEntry(uint32_t index, char* buffer, size_t length) {
+    size_t position = 0;
+
+    if (index < STM32F4_INTERRUPT_TRACE_EXCEPTIONS) {
+        STM32F4_InterruptTrace_Statistics statistics;
+
+        if (!STM32F4_InterruptTrace_GetStatistics(index, statistics))
+            return 0;
+
+        if (index < 16) {
+            position = STM32F4_InterruptTrace_AppendText(buffer, length, position, index == 15 ? "SysTick" : "Exception ");
+
+            if (index != 15)
+                position = STM32F4_InterruptTrace_AppendNumber(buffer, length, position, index, 10);
+        }
+        else {
+            position = STM32F4_InterruptTrace_AppendText(buffer, length, position, "IRQ ");
+            position = STM32F4_InterruptTrace_AppendNumber(buffer, length, position, index - 16, 10);
+        }
+
+        position = STM32F4_InterruptTrace_AppendText(buffer, length, position, " count ");
+        position = STM32F4_InterruptTrace_AppendNumber(buffer, length, position, statistics.count, 10);
+        position = STM32F4_InterruptTrace_AppendText(buffer, length, position, " min ");
+        position = STM32F4_InterruptTrace_AppendNumber(buffer, length, position, statistics.minimumCycles, 10);
+        position = STM32F4_InterruptTrace_AppendText(buffer, length, position, " avg ");
+        position = STM32F4_InterruptTrace_AppendNumber(buffer, length, position, statistics.averageCycles, 10);
+        position = STM32F4_InterruptTrace_AppendText(buffer, length, position, " max ");
+        position = STM32F4_InterruptTrace_AppendNumber(buffer, length, position, statistics.maximumCycles, 10);
+    }
+    else if (index < STM32F4_INTERRUPT_TRACE_EXCEPTIONS + 2) {
+        auto type = static_cast<STM32F4_InterruptTrace_SectionType>(index - STM32F4_INTERRUPT_TRACE_EXCEPTIONS);
+        uint32_t cycles, callerAddress;
+
+        STM32F4_InterruptTrace_GetLongestSection(type, cycles, callerAddress);
+
+        position = STM32F4_InterruptTrace_AppendText(buffer, length, position, type == STM32F4_InterruptTrace_SectionType::Disabled ? "Longest disabled " : "Longest masked ");
+        position = STM32F4_InterruptTrace_AppendNumber(buffer, length, position, cycles, 10);
+        position = STM32F4_InterruptTrace_AppendText(buffer, length, position, " at 0x");
+        position = STM32F4_InterruptTrace_AppendNumber(buffer, length, position, callerAddress, 16);
+    }
+    else {
+        return 0;
+    }
+
+    return STM32F4_InterruptTrace_AppendText(buffer, length, position, " cycles\r\n");
+}
+
+// Formats every traced exception and both longest sections, one line each, truncated to length.
+size_t STM32F4_InterruptTrace_Format(char* buffer, size_t length) {
+    size_t position = 0;
+
+    for (auto i = 0; i < STM32F4_INTERRUPT_TRACE_EXCEPTIONS + 2 && position < length; i++)
+        position += STM32F4_InterruptTrace_FormatEntry(i, buffer + position, length - position);
+
+    return position;
+}
+
+// Writes the formatted trace to the debugger transport when it is a UART. The text goes out between debugger packets,
+// so use it from a board that is not attached to the debugger. Needs interrupts enabled to drain the UART.
+TinyCLR_Result STM32F4_InterruptTrace_Dump() {
+    const TinyCLR_Api_Info* api;
+    const void* configuration;
+
+    STM32F4_Startup_GetDebuggerTransportApi(api, configuration);
+
+    if (api == nullptr || api->Type != TinyCLR_Api_Type::UartController)
+        return TinyCLR_Result::NotSupported;
+
+    auto uart = reinterpret_cast<const TinyCLR_Uart_Controller*>(api->Implementation);
+
+    char line[80];
+
+    for (auto i = 0; i < STM32F4_INTERRUPT_TRACE_EXCEPTIONS + 2; i++) {
+        auto length = STM32F4_InterruptTrace_FormatEntry(i, line, sizeof(line));
+        size_t written = 0;
+
+        while (written < length) {
+            auto count = length - written;
+
+            if (uart->Write(uart, reinterpret_cast<const uint8_t*>(line + written), count) != TinyCLR_Result::Success)
+                return TinyCLR_Result::InvalidOperation;
+
+            written += count;
+        }
+    }
+
+    return TinyCLR_Result::Success;
+}
+#endif
+
+STM32F4_MaskInterrupts_RaiiHelper::STM32F4_MaskInterrupts_RaiiHelper(uint32_t priority) {
+    basePriority = __get_BASEPRI();
+    usesPrimask = priority == 0;
+
+#ifdef STM32F4_INTERRUPT_TRACE
+    startCycles = DWT->CYCCNT;
+    callerAddress = reinterpret_cast<uint32_t>(__builtin_return_address(0));
+#endif
+
+    if (usesPrimask) {
+        primask = __get_PRIMASK();
+
+        __disable_irq();
+    }
+    else {
+        __set_BASEPRI_MAX(priority << (8 - __NVIC_PRIO_BITS));
+    }
+}
+
+STM32F4_MaskInterrupts_RaiiHelper::~STM32F4_MaskInterrupts_RaiiHelper() {
+#ifdef STM32F4_INTERRUPT_TRACE
+    // only the outermost section is timed
+    if (usesPrimask ? (primask & DISABLED_MASK) == 0 : basePriority == 0)
+        STM32F4_InterruptTrace_AddSection(usesPrimask ? STM32F4_InterruptTrace_SectionType::Disabled : STM32F4_InterruptTrace_SectionType::Masked, startCycles, callerAddress);
+#endif
+
+    if (usesPrimask) {
+        if ((primask & DISABLED_MASK) == 0)
+            __enable_irq();
+    }
+    else {
+        __set_BASEPRI(basePriority);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//Latency measurement
+//////////////////////////////////////////////////////////////////////////////
+static volatile uint32_t latencyEntryCycles;
+
+static void STM32F4_InterruptInternal_LatencyHandler(void* param) {
+    // only the entry time matters, this interrupt never reaches the runtime
+    latencyEntryCycles = DWT->CYCCNT;
+}
+
+// Pends an unused interrupt, activated one priority level above the default, from inside sectionCycles long
+// critical sections. Reports the worst cycles from pending to handler entry with all interrupts disabled and with
+// MASK_INTERRUPTS_SCOPED at the default priority, as the drivers now do. Needs the cycle counter, Time_Initialize
+// starts it.
+void STM32F4_InterruptInternal_MeasureLatency(uint32_t index, uint32_t iterations, uint32_t sectionCycles, uint32_t& disabledWorstCycles, uint32_t& maskedWorstCycles) {
+    disabledWorstCycles = 0;
+    maskedWorstCycles = 0;
+
+    STM32F4_InterruptInternal_Activate(index, (uint32_t*)&STM32F4_InterruptInternal_LatencyHandler, 0);
+
+    NVIC_SetPriority(static_cast<IRQn_Type>(index), STM32F4_INTERRUPT_DEFAULT_PRIORITY - 1);
+
+    for (auto i = 0U; i < iterations; i++) {
+        for (auto masked = 0; masked < 2; masked++) {
+            uint32_t triggered;
+
+            if (masked) {
+                STM32F4_MaskInterrupts_RaiiHelper section(STM32F4_INTERRUPT_DEFAULT_PRIORITY);
+
+                triggered = DWT->CYCCNT;
+                latencyEntryCycles = 0;
+                NVIC->STIR = index;
+
+                while (DWT->CYCCNT - triggered < sectionCycles);
+            }
+            else {
+                DISABLE_INTERRUPTS_SCOPED(section);
+
+                triggered = DWT->CYCCNT;
+                latencyEntryCycles = 0;
+                NVIC->STIR = index;
+
+                while (DWT->CYCCNT - triggered < sectionCycles);
+            }
+
+            while (latencyEntryCycles == 0);
+
+            auto latency = latencyEntryCycles - triggered;
+            auto& worst = masked ? maskedWorstCycles : disabledWorstCycles;
+
+            if (latency > worst)
+                worst = latency;
+        }
+    }
+
+    STM32F4_InterruptInternal_Deactivate(index);
+}
+
+#ifdef STM32F4_INTERRUPT_TRACE
+STM32F4_InterruptStarted_RaiiHelper::STM32F4_InterruptStarted_RaiiHelper() {
+    startCycles = DWT->CYCCNT;
+
+    STM32F4_Interrupt_Started();
+};
+
+STM32F4_InterruptStarted_RaiiHelper::~STM32F4_InterruptStarted_RaiiHelper() {
+    STM32F4_Interrupt_Ended();
+
+    STM32F4_InterruptTrace_AddHandler(startCycles);
+};
+#else
 STM32F4_InterruptStarted_RaiiHelper::STM32F4_InterruptStarted_RaiiHelper() { STM32F4_Interrupt_Started(); };
 STM32F4_InterruptStarted_RaiiHelper::~STM32F4_InterruptStarted_RaiiHelper() { STM32F4_Interrupt_Ended(); };
+#endif
 
 STM32F4_DisableInterrupts_RaiiHelper::STM32F4_DisableInterrupts_RaiiHelper() {
     state = __get_PRIMASK();
 
     __disable_irq();
+
+#ifdef STM32F4_INTERRUPT_TRACE
+    startCycles = DWT->CYCCNT;
+    callerAddress = reinterpret_cast<uint32_t>(__builtin_return_address(0));
+#endif
 }
 STM32F4_DisableInterrupts_RaiiHelper::~STM32F4_DisableInterrupts_RaiiHelper() {
     uint32_t Cp = state;
 
     if ((Cp & DISABLED_MASK) == 0) {
+#ifdef STM32F4_INTERRUPT_TRACE
+        STM32F4_InterruptTrace_AddSection(STM32F4_InterruptTrace_SectionType::Disabled, startCycles, callerAddress);
+#endif
+
         __enable_irq();
     }
 }
@@ -165,6 +510,11 @@ void STM32F4_DisableInterrupts_RaiiHelper::Acquire() {
         state = __get_PRIMASK();
 
         __disable_irq();
+
+#ifdef STM32F4_INTERRUPT_TRACE
+        startCycles = DWT->CYCCNT;
+        callerAddress = reinterpret_cast<uint32_t>(__builtin_return_address(0));
+#endif
     }
 }
 
@@ -172,6 +522,10 @@ void STM32F4_DisableInterrupts_RaiiHelper::Release() {
     uint32_t Cp = state;
 
     if ((Cp & DISABLED_MASK) == 0) {
+#ifdef STM32F4_INTERRUPT_TRACE
+        STM32F4_InterruptTrace_AddSection(STM32F4_InterruptTrace_SectionType::Disabled, startCycles, callerAddress);
+#endif
+
         state = __get_PRIMASK();
         __enable_irq();
     }
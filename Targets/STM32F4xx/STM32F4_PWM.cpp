@@ -149,6 +149,26 @@ void STM32F4_Pwm_AddApi(const TinyCLR_Api_Manager* apiManager) {
     }
 }
 
+// A timer that is clocked while none of this controller's channels is open belongs to another driver,
+// the ADC scan trigger or the DAC playback for example, until that driver gates its clock again.
+static bool STM32F4_Pwm_IsTimerTaken(PwmState* state) {
+    ptr_TIM_TypeDef treg = state->timReg;
+
+    __IO uint32_t* enReg = &RCC->APB1ENR;
+    if ((uint32_t)treg & 0x10000) enReg = &RCC->APB2ENR;
+    int enBit = 1 << (((uint32_t)treg >> 10) & 0x1F);
+
+    if (!(*enReg & enBit))
+        return false;
+
+    for (auto p = 0; p < PWM_PER_CONTROLLER; p++) {
+        if (state->isOpened[p])
+            return false;
+    }
+
+    return true;
+}
+
 TinyCLR_Result STM32F4_Pwm_OpenChannel(const TinyCLR_Pwm_Controller* self, uint32_t channel) {
     auto state = reinterpret_cast<PwmState*>(self->ApiInfo->State);
 
@@ -156,6 +176,9 @@ TinyCLR_Result STM32F4_Pwm_OpenChannel(const TinyCLR_Pwm_Controller* self, uint3
 
     auto actualPin = STM32F4_Pwm_GetGpioPinForChannel(self, channel);
 
+    if (STM32F4_Pwm_IsTimerTaken(state))
+        return TinyCLR_Result::SharingViolation;
+
     if (!STM32F4_GpioInternal_OpenPin(actualPin->number))
         return TinyCLR_Result::SharingViolation;
 
@@ -446,6 +469,15 @@ TinyCLR_Result STM32F4_Pwm_SetDesiredFrequency(const TinyCLR_Pwm_Controller* sel
 TinyCLR_Result STM32F4_Pwm_Acquire(const TinyCLR_Pwm_Controller* self) {
     auto state = reinterpret_cast<PwmState*>(self->ApiInfo->State);
 
+#ifdef STM32F4_TIME_TIM2
+    // TIM2 is the native time base
+    if (state->timReg == TIM2)
+        return TinyCLR_Result::SharingViolation;
+#endif
+
+    if (STM32F4_Pwm_IsTimerTaken(state))
+        return TinyCLR_Result::SharingViolation;
+
     if (state->initializeCount == 0)
         STM32F4_Pwm_ResetController(state->controllerIndex);
 
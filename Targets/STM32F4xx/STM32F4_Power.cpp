@@ -85,7 +85,12 @@ TinyCLR_Result STM32F4_Power_Sleep(const TinyCLR_Power_Controller* self, TinyCLR
     default:
         PWR->CR |= PWR_CR_CWUF;
 
+        STM32F4_Time_EnterSleep();
+
         __WFI(); // sleep and wait for interrupt
+
+        STM32F4_Time_ExitSleep();
+
         return TinyCLR_Result::Success;
     }
 }
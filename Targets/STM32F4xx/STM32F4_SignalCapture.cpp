@@ -0,0 +1,172 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "STM32F4.h"
+
+#ifdef INCLUDE_SIGNALS
+
+// TIM5 is a 32 bit timer available on every STM32F4, each channel captures both edges of its pin and DMA1
+// (channel 6) moves the captured counter values straight into the caller's buffer
+#ifndef STM32F4_SIGNAL_CAPTURE_PINS
+#define STM32F4_SIGNAL_CAPTURE_PINS { { PIN(A, 0), AF(2) }, { PIN(A, 1), AF(2) }, { PIN(A, 2), AF(2) }, { PIN(A, 3), AF(2) } }
+#endif
+
+#define STM32F4_SIGNAL_CAPTURE_DMA_CHANNEL 6
+#define STM32F4_SIGNAL_CAPTURE_MAX_COUNT 0xFFFF
+
+#if STM32F4_APB1_CLOCK_HZ == STM32F4_AHB_CLOCK_HZ
+#define STM32F4_SIGNAL_CAPTURE_CLOCK_HZ (STM32F4_APB1_CLOCK_HZ)
+#else
+#define STM32F4_SIGNAL_CAPTURE_CLOCK_HZ (STM32F4_APB1_CLOCK_HZ * 2)
+#endif
+
+static const STM32F4_Gpio_Pin signalCapturePins[] = STM32F4_SIGNAL_CAPTURE_PINS;
+
+// TIM5_CH1..CH4 requests are on DMA1 streams 2, 4, 0 and 1
+static const uint32_t signalCaptureDmaStreams[] = {
+    STM32F4_DMA_STREAM(1, 2),
+    STM32F4_DMA_STREAM(1, 4),
+    STM32F4_DMA_STREAM(1, 0),
+    STM32F4_DMA_STREAM(1, 1)
+};
+
+static int32_t STM32F4_SignalCapture_GetChannel(uint32_t pin) {
+    for (auto i = 0; i < SIZEOF_ARRAY(signalCapturePins) && i < 4; i++)
+        if (signalCapturePins[i].number == pin)
+            return i;
+
+    return -1;
+}
+
+bool STM32F4_SignalCapture_IsPinSupported(uint32_t pin) {
+    return STM32F4_SignalCapture_GetChannel(pin) >= 0;
+}
+
+TinyCLR_Result STM32F4_SignalCapture_Read(uint32_t pin, bool waitForInitialState, TinyCLR_Gpio_PinValue& initialState, uint32_t* timestamps, size_t& count, uint64_t timeoutMicroseconds, uint32_t& startTime, uint32_t& frequency) {
+    auto channel = STM32F4_SignalCapture_GetChannel(pin);
+
+    if (channel < 0)
+        return TinyCLR_Result::NotSupported;
+
+    if (timestamps == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    if (count == 0 || count >= STM32F4_SIGNAL_CAPTURE_MAX_COUNT)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    if (RCC->APB1ENR & RCC_APB1ENR_TIM5EN)
+        return TinyCLR_Result::SharingViolation;
+
+    auto dmaStream = STM32F4_Dma_AcquireStream(signalCaptureDmaStreams[channel], &signalCaptureDmaStreams[channel]);
+
+    if (dmaStream == STM32F4_DMA_STREAM_NONE)
+        return TinyCLR_Result::SharingViolation;
+
+    // the pin was opened by the caller as a GPIO input, it keeps the caller's pull and is given back as one when done
+    auto driveMode = STM32F4_Gpio_GetDriveMode(nullptr, pin);
+    auto pull = driveMode == TinyCLR_Gpio_PinDriveMode::InputPullUp ? STM32F4_Gpio_PullDirection::PullUp : (driveMode == TinyCLR_Gpio_PinDriveMode::InputPullDown ? STM32F4_Gpio_PullDirection::PullDown : STM32F4_Gpio_PullDirection::None);
+
+    STM32F4_GpioInternal_ConfigurePin(pin, STM32F4_Gpio_PortMode::AlternateFunction, STM32F4_Gpio_OutputType::PushPull, STM32F4_Gpio_OutputSpeed::VeryHigh, pull, signalCapturePins[channel].alternateFunction);
+
+    RCC->APB1ENR |= RCC_APB1ENR_TIM5EN;
+
+    TIM5->CR1 = 0;
+    TIM5->PSC = 0;
+    TIM5->ARR = 0xFFFFFFFF;
+    TIM5->CCER = 0;
+    TIM5->CCMR1 = 0;
+    TIM5->CCMR2 = 0;
+
+    // CCxS = 01, input capture on TIx without filter
+    if (channel < 2)
+        TIM5->CCMR1 = TIM_CCMR1_CC1S_0 << (channel * 8);
+    else
+        TIM5->CCMR2 = TIM_CCMR2_CC3S_0 << ((channel - 2) * 8);
+
+    TIM5->EGR = TIM_EGR_UG;
+    TIM5->CR1 = TIM_CR1_CEN;
+
+
+    STM32F4_Dma_Transfer transfer;
+
+    // one extra slot for the edge that is dropped when waiting for the initial state
+    transfer.control = STM32F4_DMA_CONTROL_CHANNEL(STM32F4_SIGNAL_CAPTURE_DMA_CHANNEL) | DMA_SxCR_PL_1 | DMA_SxCR_MSIZE_1 | DMA_SxCR_PSIZE_1 | DMA_SxCR_MINC;
+    transfer.peripheral = reinterpret_cast<uint32_t>(&TIM5->CCR1 + channel);
+    transfer.memory0 = reinterpret_cast<uint32_t>(timestamps);
+    transfer.memory1 = 0;
+    transfer.count = count + 1;
+    transfer.fifoControl = 0; // direct mode
+
+    STM32F4_Dma_Start(dmaStream, &transfer, nullptr, nullptr);
+
+    TIM5->DIER = TIM_DIER_CC1DE << channel;
+
+    TinyCLR_Gpio_PinValue state;
+
+    {
+        DISABLE_INTERRUPTS_SCOPED(irq);
+
+        // both edges: CCxP and CCxNP set
+        TIM5->CCER = (TIM_CCER_CC1E | TIM_CCER_CC1P | TIM_CCER_CC1NP) << (channel * 4);
+
+        startTime = TIM5->CNT;
+        state = STM32F4_GpioInternal_ReadPin(pin) ? TinyCLR_Gpio_PinValue::High : TinyCLR_Gpio_PinValue::Low;
+    }
+
+    auto skip = waitForInitialState && state != initialState ? 1 : 0;
+    auto needed = count + skip;
+    auto endTime = STM32F4_Time_GetCurrentProcessorTime() + timeoutMicroseconds * 10;
+
+    while ((count + 1 - STM32F4_Dma_GetRemaining(dmaStream)) < needed && STM32F4_Time_GetCurrentProcessorTime() < endTime);
+
+    TIM5->CCER = 0;
+    TIM5->DIER = 0;
+
+    STM32F4_Dma_Stop(dmaStream);
+
+    size_t captured = count + 1 - STM32F4_Dma_GetRemaining(dmaStream);
+
+    STM32F4_Dma_ReleaseStream(dmaStream, &signalCaptureDmaStreams[channel]);
+
+    TIM5->CR1 = 0;
+    RCC->APB1ENR &= ~RCC_APB1ENR_TIM5EN;
+
+    if (captured > needed)
+        captured = needed;
+
+    if (skip) {
+        if (captured == 0) {
+            count = 0;
+
+            return TinyCLR_Result::Success;
+        }
+
+        // the first edge brought the pin into the requested state, measure from there
+        startTime = timestamps[0];
+        captured--;
+
+        for (auto i = 0; i < captured; i++)
+            timestamps[i] = timestamps[i + 1];
+    }
+    else if (!waitForInitialState) {
+        initialState = state;
+    }
+
+    count = captured;
+    frequency = STM32F4_SIGNAL_CAPTURE_CLOCK_HZ;
+
+    return TinyCLR_Result::Success;
+}
+
+#endif
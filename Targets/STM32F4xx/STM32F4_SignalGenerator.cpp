@@ -0,0 +1,197 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "STM32F4.h"
+
+#ifdef INCLUDE_SIGNALS
+
+// TIM11 runs one period per duration with the following period already preloaded in ARR. Its update interrupt
+// writes the pin through BSRR before anything else, so every edge is delayed by the same interrupt latency and
+// the durations between edges stay exact to a timer tick. TIM11 is on every STM32F4 and nothing else uses its
+// interrupt, it is shared with the TIM1 trigger/commutation interrupt only.
+#ifndef STM32F4_SIGNAL_GENERATOR_MAX_EDGES
+#define STM32F4_SIGNAL_GENERATOR_MAX_EDGES 512
+#endif
+
+#if STM32F4_APB2_CLOCK_HZ == STM32F4_AHB_CLOCK_HZ
+#define STM32F4_SIGNAL_GENERATOR_CLOCK_HZ (STM32F4_APB2_CLOCK_HZ)
+#else
+#define STM32F4_SIGNAL_GENERATOR_CLOCK_HZ (STM32F4_APB2_CLOCK_HZ * 2)
+#endif
+
+struct SignalGeneratorState {
+    volatile bool isBusy;
+
+    uint32_t pin;
+    volatile uint32_t* bsrr;
+    uint32_t activeValue;
+    uint32_t idleValue;
+
+    size_t count;
+    size_t edge;
+
+    STM32F4_SignalGenerator_CompletedHandler handler;
+
+    uint16_t reloads[STM32F4_SIGNAL_GENERATOR_MAX_EDGES];
+};
+
+static SignalGeneratorState signalGeneratorState;
+
+static void STM32F4_SignalGenerator_Stop() {
+    TIM11->CR1 = 0;
+    TIM11->DIER = 0;
+    TIM11->SR = 0;
+
+    STM32F4_InterruptInternal_Deactivate(TIM1_TRG_COM_TIM11_IRQn);
+
+    RCC->APB2ENR &= ~RCC_APB2ENR_TIM11EN;
+
+    signalGeneratorState.isBusy = false;
+}
+
+void STM32F4_SignalGenerator_InterruptHandler(void* param) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    auto state = &signalGeneratorState;
+    auto edge = state->edge + 1;
+
+    // odd edges go back to idle, the last one always does
+    *state->bsrr = (edge < state->count && (edge & 1) == 0) ? state->activeValue : state->idleValue;
+
+    TIM11->SR = ~TIM_SR_UIF;
+
+    state->edge = edge;
+
+    if (edge < state->count) {
+        // the period that just started was moved into the shadow register by this update, queue the one after it
+        if (edge + 1 < state->count)
+            TIM11->ARR = state->reloads[edge + 1];
+
+        return;
+    }
+
+    STM32F4_SignalGenerator_Stop();
+
+    if (state->handler != nullptr)
+        state->handler(state->pin);
+}
+
+// durations are in 100ns units, the pin starts at the opposite of idleState, toggles after every duration and is left at
+// idleState. The durations are converted to timer ticks before starting, the caller's buffer is not used afterwards.
+// Durations shorter than the interrupt latency (around a microsecond) are stretched.
+TinyCLR_Result STM32F4_SignalGenerator_Write(uint32_t pin, TinyCLR_Gpio_PinValue idleState, const uint64_t* durations, size_t count, STM32F4_SignalGenerator_CompletedHandler handler) {
+    auto state = &signalGeneratorState;
+
+    if (durations == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    if (count == 0 || count > STM32F4_SIGNAL_GENERATOR_MAX_EDGES)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    if (state->isBusy)
+        return TinyCLR_Result::InvalidOperation;
+
+    if (RCC->APB2ENR & RCC_APB2ENR_TIM11EN)
+        return TinyCLR_Result::SharingViolation;
+
+    uint64_t longest = 0;
+
+    for (auto i = 0; i < count; i++)
+        if (durations[i] > longest)
+            longest = durations[i];
+
+    if (longest >= 0xFFFFFFFF)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    // the prescaler is the smallest one that still fits the longest duration in the 16 bit counter
+    auto longestTicks = longest * STM32F4_SIGNAL_GENERATOR_CLOCK_HZ / 10000000;
+    auto prescaler = longestTicks > 0 ? (longestTicks - 1) / 0x10000 : 0;
+
+    if (prescaler > 0xFFFF)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    for (auto i = 0; i < count; i++) {
+        auto ticks = durations[i] * STM32F4_SIGNAL_GENERATOR_CLOCK_HZ / 10000000 / (prescaler + 1);
+
+        // a zero reload stops the counter
+        state->reloads[i] = ticks > 1 ? static_cast<uint16_t>(ticks - 1) : 1;
+    }
+
+    auto port = reinterpret_cast<GPIO_TypeDef*>(GPIOA_BASE + ((pin >> 4) << 10));
+    auto bit = static_cast<uint32_t>(1 << (pin & 0x0F));
+
+    state->pin = pin;
+    state->bsrr = &port->BSRR;
+    state->idleValue = idleState == TinyCLR_Gpio_PinValue::High ? bit : (bit << 16);
+    state->activeValue = idleState == TinyCLR_Gpio_PinValue::High ? (bit << 16) : bit;
+    state->count = count;
+    state->edge = 0;
+    state->handler = handler;
+
+    STM32F4_GpioInternal_ConfigurePin(pin, STM32F4_Gpio_PortMode::GeneralPurposeOutput, STM32F4_Gpio_OutputType::PushPull, STM32F4_Gpio_OutputSpeed::VeryHigh, STM32F4_Gpio_PullDirection::None, STM32F4_Gpio_AlternateFunction::AF0);
+
+    *state->bsrr = state->idleValue;
+
+    RCC->APB2ENR |= RCC_APB2ENR_TIM11EN;
+
+    // URS: only a counter overflow raises the update interrupt, not the UG below
+    TIM11->CR1 = TIM_CR1_URS | TIM_CR1_ARPE;
+    TIM11->CNT = 0;
+    TIM11->PSC = prescaler;
+    TIM11->ARR = state->reloads[0];
+    TIM11->EGR = TIM_EGR_UG;
+    TIM11->SR = 0;
+
+    if (count > 1)
+        TIM11->ARR = state->reloads[1];
+
+    TIM11->DIER = TIM_DIER_UIE;
+
+    state->isBusy = true;
+
+    STM32F4_InterruptInternal_Activate(TIM1_TRG_COM_TIM11_IRQn, (uint32_t*)&STM32F4_SignalGenerator_InterruptHandler, 0);
+
+    {
+        DISABLE_INTERRUPTS_SCOPED(irq);
+
+        *state->bsrr = state->activeValue;
+
+        TIM11->CR1 |= TIM_CR1_CEN;
+    }
+
+    return TinyCLR_Result::Success;
+}
+
+bool STM32F4_SignalGenerator_IsBusy() {
+    return signalGeneratorState.isBusy;
+}
+
+TinyCLR_Result STM32F4_SignalGenerator_Abort() {
+    auto state = &signalGeneratorState;
+
+    if (!state->isBusy)
+        return TinyCLR_Result::Success;
+
+    {
+        DISABLE_INTERRUPTS_SCOPED(irq);
+
+        STM32F4_SignalGenerator_Stop();
+
+        *state->bsrr = state->idleValue;
+    }
+
+    return TinyCLR_Result::Success;
+}
+
+#endif
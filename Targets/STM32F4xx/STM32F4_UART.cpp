@@ -52,6 +52,7 @@ struct UartState {
     size_t rxBufferSize;
 
     USART_TypeDef_Ptr portReg;
+    IRQn_Type irq;
 
     bool handshaking;
     bool enable;
@@ -254,9 +255,10 @@ bool STM32F4_Uart_CanPostEvent(int8_t controllerIndex) {
 }
 
 void STM32F4_Uart_InterruptHandler(int8_t controllerIndex) {
-    DISABLE_INTERRUPTS_SCOPED(irq);
-
     auto state = reinterpret_cast<UartState*>(&uartStates[controllerIndex]);
+
+    MASK_INTERRUPTS_SCOPED(irq, state->irq);
+
     auto sr = (uint16_t)(state->portReg->SR);
     auto canPostEvent = STM32F4_Uart_CanPostEvent(controllerIndex);
     bool error = (state->rxBufferCount == state->rxBufferSize) || (sr & USART_SR_ORE) || (sr & USART_SR_FE) || (sr & USART_SR_PE);
@@ -549,42 +551,51 @@ TinyCLR_Result STM32F4_Uart_SetActiveSettings(const TinyCLR_Uart_Controller* sel
 
     switch (controllerIndex) {
     case 0:
-        STM32F4_InterruptInternal_Activate(USART1_IRQn, (uint32_t*)&STM32F4_Uart_Interrupt0, 0);
+        state->irq = USART1_IRQn;
+        STM32F4_InterruptInternal_Activate(state->irq, (uint32_t*)&STM32F4_Uart_Interrupt0, 0);
         break;
 
     case 1:
-        STM32F4_InterruptInternal_Activate(USART2_IRQn, (uint32_t*)&STM32F4_Uart_Interrupt1, 0);
+        state->irq = USART2_IRQn;
+        STM32F4_InterruptInternal_Activate(state->irq, (uint32_t*)&STM32F4_Uart_Interrupt1, 0);
         break;
 #if !defined(STM32F401xE) && !defined(STM32F411xE)
     case 2:
-        STM32F4_InterruptInternal_Activate(USART3_IRQn, (uint32_t*)&STM32F4_Uart_Interrupt2, 0);
+        state->irq = USART3_IRQn;
+        STM32F4_InterruptInternal_Activate(state->irq, (uint32_t*)&STM32F4_Uart_Interrupt2, 0);
         break;
 
     case 3:
-        STM32F4_InterruptInternal_Activate(UART4_IRQn, (uint32_t*)&STM32F4_Uart_Interrupt3, 0);
+        state->irq = UART4_IRQn;
+        STM32F4_InterruptInternal_Activate(state->irq, (uint32_t*)&STM32F4_Uart_Interrupt3, 0);
         break;
 
     case 4:
-        STM32F4_InterruptInternal_Activate(UART5_IRQn, (uint32_t*)&STM32F4_Uart_Interrupt4, 0);
+        state->irq = UART5_IRQn;
+        STM32F4_InterruptInternal_Activate(state->irq, (uint32_t*)&STM32F4_Uart_Interrupt4, 0);
         break;
 
     case 5:
-        STM32F4_InterruptInternal_Activate(USART6_IRQn, (uint32_t*)&STM32F4_Uart_Interrupt5, 0);
+        state->irq = USART6_IRQn;
+        STM32F4_InterruptInternal_Activate(state->irq, (uint32_t*)&STM32F4_Uart_Interrupt5, 0);
         break;
 
 #ifdef UART7
     case 6:
-        STM32F4_InterruptInternal_Activate(UART7_IRQn, (uint32_t*)&STM32F4_Uart_Interrupt6, 0);
+        state->irq = UART7_IRQn;
+        STM32F4_InterruptInternal_Activate(state->irq, (uint32_t*)&STM32F4_Uart_Interrupt6, 0);
         break;
 
 #ifdef UART8
     case 7:
-        STM32F4_InterruptInternal_Activate(UART8_IRQn, (uint32_t*)&STM32F4_Uart_Interrupt7, 0);
+        state->irq = UART8_IRQn;
+        STM32F4_InterruptInternal_Activate(state->irq, (uint32_t*)&STM32F4_Uart_Interrupt7, 0);
         break;
 
 #ifdef UART9
     case 8:
-        STM32F4_InterruptInternal_Activate(UART9_IRQn, (uint32_t*)&STM32F4_Uart_Interrupt8, 0);
+        state->irq = UART9_IRQn;
+        STM32F4_InterruptInternal_Activate(state->irq, (uint32_t*)&STM32F4_Uart_Interrupt8, 0);
         break;
 #endif
 #endif
@@ -766,10 +777,10 @@ TinyCLR_Result STM32F4_Uart_Flush(const TinyCLR_Uart_Controller* self) {
 }
 
 TinyCLR_Result STM32F4_Uart_Read(const TinyCLR_Uart_Controller* self, uint8_t* buffer, size_t& length) {
-    DISABLE_INTERRUPTS_SCOPED(irq);
-
     auto state = reinterpret_cast<UartState*>(self->ApiInfo->State);
 
+    MASK_INTERRUPTS_SCOPED(irq, state->irq);
+
     if (state->initializeCount == 0) {
         return TinyCLR_Result::NotAvailable;
     }
@@ -796,10 +807,10 @@ TinyCLR_Result STM32F4_Uart_Write(const TinyCLR_Uart_Controller* self, const uin
 
     int32_t i = 0;
 
-    DISABLE_INTERRUPTS_SCOPED(irq);
-
     auto state = reinterpret_cast<UartState*>(self->ApiInfo->State);
 
+    MASK_INTERRUPTS_SCOPED(irq, state->irq);
+
     int32_t controllerIndex = state->controllerIndex;
 
     if (state->initializeCount == 0) {
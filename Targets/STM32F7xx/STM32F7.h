@@ -19,6 +19,8 @@
 
 #include "inc/stm32f7xx.h"
 
+#include "../../Drivers/DmaAllocator/DmaAllocator.h"
+
 #undef STM32F7
 
 #define SIZEOF_ARRAY(arr) (sizeof(arr) / sizeof(arr[0]))
@@ -47,6 +49,21 @@ const TinyCLR_Startup_DeploymentConfiguration* STM32F7_Flash_GetDeploymentConfig
 void STM32F7_Flash_GetDeploymentApi(const TinyCLR_Api_Info*& api, const TinyCLR_Startup_DeploymentConfiguration*& configuration);
 void STM32F7_Deplpoyment_Reset();
 
+// Background erase: sectors are queued and erased one after another from the flash end of operation interrupt.
+// The handler is called from the interrupt for every sector with the number of sectors still queued.
+// Code executing from the same flash bank still stalls while the erase is running.
+typedef void(*STM32F7_Flash_EraseCompletedHandler)(const TinyCLR_Storage_Controller* self, uint64_t sector, TinyCLR_Result result, size_t pending);
+
+TinyCLR_Result STM32F7_Flash_EraseAsync(const TinyCLR_Storage_Controller* self, uint64_t sector, STM32F7_Flash_EraseCompletedHandler handler);
+TinyCLR_Result STM32F7_Flash_WaitForErase(const TinyCLR_Storage_Controller* self, uint64_t timeout);
+bool STM32F7_Flash_IsEraseBusy(const TinyCLR_Storage_Controller* self);
+
+// Called after every Write with the bytes actually programmed, the bytes already holding the data, the result of the Write
+// and the elapsed time in 100ns units. When the Write fails, bytes after the failing one are neither programmed nor skipped.
+typedef void(*STM32F7_Flash_BenchmarkHandler)(const TinyCLR_Storage_Controller* self, size_t programmedBytes, size_t skippedBytes, TinyCLR_Result result, uint64_t elapsedTime);
+
+void STM32F7_Flash_SetBenchmarkHandler(STM32F7_Flash_BenchmarkHandler handler);
+
 ////////////////////////////////////////////////////////////////////////////////
 //Interrupt
 ////////////////////////////////////////////////////////////////////////////////
@@ -79,6 +96,11 @@ TinyCLR_Result STM32F7_Time_Initialize(const TinyCLR_NativeTime_Controller* self
 TinyCLR_Result STM32F7_Time_Uninitialize(const TinyCLR_NativeTime_Controller* self);
 uint64_t STM32F7_Time_GetCurrentProcessorTicks(const TinyCLR_NativeTime_Controller* self);
 uint64_t STM32F7_Time_GetCurrentProcessorTime();
+void STM32F7_Time_EnterSleep();
+void STM32F7_Time_ExitSleep();
+#ifndef STM32F7_TIME_TIM2
+void STM32F7_Time_Benchmark(uint32_t iterations, uint32_t& sysTickTimeCycles, uint32_t& processorTimeCycles);
+#endif
 uint64_t STM32F7_Time_GetTimeForProcessorTicks(const TinyCLR_NativeTime_Controller* self, uint64_t ticks);
 uint64_t STM32F7_Time_GetProcessorTicksForTime(const TinyCLR_NativeTime_Controller* self, uint64_t time);
 TinyCLR_Result STM32F7_Time_SetTickCallback(const TinyCLR_NativeTime_Controller* self, TinyCLR_NativeTime_Callback callback);
@@ -116,6 +138,16 @@ uint32_t STM32F7_Adc_GetResolutionInBits(const TinyCLR_Adc_Controller* self);
 uint32_t STM32F7_Adc_GetChannelCount(const TinyCLR_Adc_Controller* self);
 void STM32F7_Adc_Reset();
 
+typedef void(*STM32F7_Adc_ScanHandler)(const TinyCLR_Adc_Controller* self, size_t available);
+
+TinyCLR_Result STM32F7_Adc_SetOversampling(const TinyCLR_Adc_Controller* self, uint32_t samples);
+TinyCLR_Result STM32F7_Adc_StartScan(const TinyCLR_Adc_Controller* self, const uint32_t* channels, size_t channelCount, uint32_t sampleRateHz, uint32_t oversample, STM32F7_Adc_ScanHandler handler);
+TinyCLR_Result STM32F7_Adc_StopScan(const TinyCLR_Adc_Controller* self);
+TinyCLR_Result STM32F7_Adc_ReadScan(const TinyCLR_Adc_Controller* self, uint16_t* buffer, size_t& length);
+TinyCLR_Result STM32F7_Adc_GetScanStatus(const TinyCLR_Adc_Controller* self, size_t& available, uint32_t& overruns);
+
+#define TARGET_ADC_SCAN_SUPPORTED
+
 ////////////////////////////////////////////////////////////////////////////////
 //CAN
 ////////////////////////////////////////////////////////////////////////////////
@@ -161,6 +193,59 @@ uint32_t STM32F7_Dac_GetResolutionInBits(const TinyCLR_Dac_Controller* self);
 uint32_t STM32F7_Dac_GetChannelCount(const TinyCLR_Dac_Controller* self);
 void STM32F7_Dac_Reset();
 
+#define STM32F7_DAC_CHANNEL_DUAL 2
+
+// Called from the DMA interrupt with the part of the buffer that was played out. In circular mode that part can be
+// refilled, in one shot mode it is the whole buffer and playback has already stopped.
+typedef void(*STM32F7_Dac_PlaybackHandler)(const TinyCLR_Dac_Controller* self, uint32_t channel, size_t offset, size_t length);
+
+TinyCLR_Result STM32F7_Dac_StartPlayback(const TinyCLR_Dac_Controller* self, uint32_t channel, const void* buffer, size_t length, uint32_t sampleRateHz, bool circular, STM32F7_Dac_PlaybackHandler handler);
+TinyCLR_Result STM32F7_Dac_StopPlayback(const TinyCLR_Dac_Controller* self);
+bool STM32F7_Dac_IsPlaying(const TinyCLR_Dac_Controller* self);
+
+////////////////////////////////////////////////////////////////////////////////
+//DMA
+////////////////////////////////////////////////////////////////////////////////
+// Streams are numbered DMA1 stream 0-7 then DMA2 stream 0-7. A request is wired to fixed streams and channels, so a
+// driver names the streams it can use with STM32F7_DMA_STREAM and its channel in the control word.
+#define STM32F7_DMA_STREAM_COUNT 16
+#define STM32F7_DMA_STREAM_NONE DMA_ALLOCATOR_CHANNEL_NONE
+#define STM32F7_DMA_STREAM(controller, stream) (1 << (((controller) - 1) * 8 + (stream)))
+#define STM32F7_DMA_CONTROL_CHANNEL(channel) ((channel) << DMA_SxCR_CHSEL_Pos)
+
+// One stream setup. control is DMA_SxCR without EN, TCIE and TEIE, those are set by the service. With DMA_SxCR_DBM the
+// stream alternates between memory0 and memory1 and reports each one as it completes, the one not being written
+// can be replaced with STM32F7_Dma_SetMemory. count is in peripheral size units.
+struct STM32F7_Dma_Transfer {
+    uint32_t control;
+    uint32_t peripheral;
+    uint32_t memory0;
+    uint32_t memory1;
+    uint32_t count;
+    uint32_t fifoControl; // 0 for direct mode
+};
+
+enum class STM32F7_Dma_Event : uint8_t {
+    HalfCompleted,
+    Completed,
+    Error
+};
+
+// Called from the stream interrupt, HalfCompleted only with DMA_SxCR_HTIE in control. The stream is disabled by the
+// hardware on an error.
+typedef void(*STM32F7_Dma_EventHandler)(int32_t stream, STM32F7_Dma_Event event, void* param);
+
+int32_t STM32F7_Dma_AcquireStream(uint32_t candidates, const void* owner);
+void STM32F7_Dma_ReleaseStream(int32_t stream, const void* owner);
+TinyCLR_Result STM32F7_Dma_Start(int32_t stream, const STM32F7_Dma_Transfer* transfer, STM32F7_Dma_EventHandler handler, void* param);
+void STM32F7_Dma_Stop(int32_t stream);
+bool STM32F7_Dma_IsBusy(int32_t stream);
+bool STM32F7_Dma_Wait(int32_t stream);
+size_t STM32F7_Dma_GetRemaining(int32_t stream);
+uint32_t STM32F7_Dma_GetCurrentMemory(int32_t stream);
+void STM32F7_Dma_SetMemory(int32_t stream, uint32_t memory, uint32_t address);
+const DmaAllocator_Statistics* STM32F7_Dma_GetStatistics(int32_t stream);
+
 ////////////////////////////////////////////////////////////////////////////////
 //GPIO
 ////////////////////////////////////////////////////////////////////////////////
@@ -180,6 +265,17 @@ TinyCLR_Result STM32F7_Gpio_SetDebounceTimeout(const TinyCLR_Gpio_Controller* se
 TinyCLR_Result STM32F7_Gpio_SetPinChangedHandler(const TinyCLR_Gpio_Controller* self, uint32_t pin, TinyCLR_Gpio_PinChangeEdge edge, TinyCLR_Gpio_PinChangedHandler handler);
 uint32_t STM32F7_Gpio_GetPinCount(const TinyCLR_Gpio_Controller* self);
 
+// Edges queued by a pin with a changed handler. Define STM32F7_GPIO_DEBOUNCE_TIM12 in Device.h to debounce on TIM12
+// instead of comparing edge times.
+struct STM32F7_Gpio_Edge {
+    uint64_t timestamp;
+    TinyCLR_Gpio_PinValue value;
+};
+
+TinyCLR_Result STM32F7_Gpio_ReadEdges(uint32_t pin, STM32F7_Gpio_Edge* edges, size_t& count, uint32_t& overflows);
+
+#define TARGET_GPIO_READ_EDGES_SUPPORTED
+
 ////////////////////////////////////////////////////////////////////////////////
 //I2C
 ////////////////////////////////////////////////////////////////////////////////
@@ -237,6 +333,25 @@ TinyCLR_Result STM32F7_SdCard_IsPresent(const TinyCLR_Storage_Controller* self,
 
 TinyCLR_Result STM32F7_SdCard_Reset();
 
+////////////////////////////////////////////////////////////////////////////////
+//Signal Capture
+////////////////////////////////////////////////////////////////////////////////
+#define TARGET_SIGNAL_CAPTURE_SUPPORTED
+
+bool STM32F7_SignalCapture_IsPinSupported(uint32_t pin);
+TinyCLR_Result STM32F7_SignalCapture_Read(uint32_t pin, bool waitForInitialState, TinyCLR_Gpio_PinValue& initialState, uint32_t* timestamps, size_t& count, uint64_t timeoutMicroseconds, uint32_t& startTime, uint32_t& frequency);
+
+////////////////////////////////////////////////////////////////////////////////
+//Signal Generator
+////////////////////////////////////////////////////////////////////////////////
+#define TARGET_SIGNAL_GENERATOR_SUPPORTED
+
+typedef void(*STM32F7_SignalGenerator_CompletedHandler)(uint32_t pin);
+
+TinyCLR_Result STM32F7_SignalGenerator_Write(uint32_t pin, TinyCLR_Gpio_PinValue idleState, const uint64_t* durations, size_t count, STM32F7_SignalGenerator_CompletedHandler handler);
+TinyCLR_Result STM32F7_SignalGenerator_Abort();
+bool STM32F7_SignalGenerator_IsBusy();
+
 ////////////////////////////////////////////////////////////////////////////////
 //SPI
 ////////////////////////////////////////////////////////////////////////////////
@@ -307,6 +422,10 @@ bool TinyCLR_UsbClient_CanReceivePackage(UsClientState* usClientState, int32_t e
 ////////////////////////////////////////////////////////////////////////////////
 class STM32F7_DisableInterrupts_RaiiHelper {
     uint32_t state;
+#ifdef STM32F7_INTERRUPT_TRACE
+    uint32_t startCycles;
+    uint32_t callerAddress;
+#endif
 
 public:
     STM32F7_DisableInterrupts_RaiiHelper();
@@ -317,7 +436,26 @@ public:
     void Release();
 };
 
+// Masks, through BASEPRI, every interrupt at the given NVIC priority or less urgent. More urgent interrupts keep running.
+class STM32F7_MaskInterrupts_RaiiHelper {
+    uint32_t basePriority;
+    uint32_t primask;
+    bool usesPrimask;
+#ifdef STM32F7_INTERRUPT_TRACE
+    uint32_t startCycles;
+    uint32_t callerAddress;
+#endif
+
+public:
+    STM32F7_MaskInterrupts_RaiiHelper(uint32_t priority);
+    ~STM32F7_MaskInterrupts_RaiiHelper();
+};
+
 class STM32F7_InterruptStarted_RaiiHelper {
+#ifdef STM32F7_INTERRUPT_TRACE
+    uint32_t startCycles;
+#endif
+
 public:
     STM32F7_InterruptStarted_RaiiHelper();
     ~STM32F7_InterruptStarted_RaiiHelper();
@@ -326,8 +464,54 @@ public:
 #define DISABLE_INTERRUPTS_SCOPED(name) STM32F7_DisableInterrupts_RaiiHelper name
 #define INTERRUPT_STARTED_SCOPED(name) STM32F7_InterruptStarted_RaiiHelper name
 
+// For driver bookkeeping shared with the driver's own interrupt: masks that interrupt and anything less urgent only
+#define MASK_INTERRUPTS_SCOPED(name, irq) STM32F7_MaskInterrupts_RaiiHelper name(NVIC_GetPriority(static_cast<IRQn_Type>(irq)))
+
+// NVIC priorities, lower is more urgent. Every interrupt is activated at STM32F7_INTERRUPT_DEFAULT_PRIORITY unless
+// Device.h lists it, e.g. #define STM32F7_INTERRUPT_PRIORITIES { { CAN1_RX0_IRQn, 2 }, { OTG_FS_IRQn, 3 } }
+// Priority 0 cannot be masked by BASEPRI, MASK_INTERRUPTS_SCOPED falls back to disabling all interrupts for it.
+#ifndef STM32F7_INTERRUPT_DEFAULT_PRIORITY
+#define STM32F7_INTERRUPT_DEFAULT_PRIORITY 8
+#endif
+
+struct STM32F7_Interrupt_Priority {
+    uint32_t irq;
+    uint32_t priority;
+};
+
 bool STM32F7_InterruptInternal_Activate(uint32_t index, uint32_t* isr, void* isrParam);
 bool STM32F7_InterruptInternal_Deactivate(uint32_t index);
+uint32_t STM32F7_InterruptInternal_GetPriority(uint32_t index);
+
+void STM32F7_InterruptInternal_MeasureLatency(uint32_t index, uint32_t iterations, uint32_t sectionCycles, uint32_t& disabledWorstCycles, uint32_t& maskedWorstCycles);
+
+////////////////////////////////////////////////////////////////////////////////
+//Interrupt Trace
+////////////////////////////////////////////////////////////////////////////////
+// Define STM32F7_INTERRUPT_TRACE in Device.h to time, with the cycle counter, every handler that uses
+// INTERRUPT_STARTED_SCOPED and every section that holds interrupts off. Handler times include any more urgent
+// handler that preempted them. Exceptions are numbered as in IPSR: SysTick is 15, IRQn is IRQn + 16.
+#ifdef STM32F7_INTERRUPT_TRACE
+#define STM32F7_INTERRUPT_TRACE_EXCEPTIONS 128
+
+struct STM32F7_InterruptTrace_Statistics {
+    uint32_t count;
+    uint32_t minimumCycles;
+    uint32_t averageCycles;
+    uint32_t maximumCycles;
+};
+
+enum class STM32F7_InterruptTrace_SectionType : uint8_t {
+    Disabled = 0,
+    Masked = 1,
+};
+
+void STM32F7_InterruptTrace_Reset();
+bool STM32F7_InterruptTrace_GetStatistics(uint32_t exception, STM32F7_InterruptTrace_Statistics& statistics);
+void STM32F7_InterruptTrace_GetLongestSection(STM32F7_InterruptTrace_SectionType type, uint32_t& cycles, uint32_t& callerAddress);
+size_t STM32F7_InterruptTrace_Format(char* buffer, size_t length);
+TinyCLR_Result STM32F7_InterruptTrace_Dump();
+#endif
 
 ////////////////////////////////////////////////////////////////////////////////
 //GPIO Internal
@@ -425,6 +609,29 @@ TinyCLR_Result STM32F7_Display_DrawBuffer(const TinyCLR_Display_Controller* self
 TinyCLR_Result STM32F7_Display_DrawPixel(const TinyCLR_Display_Controller* self, uint32_t x, uint32_t y, uint64_t color);
 TinyCLR_Result STM32F7_Display_WriteString(const TinyCLR_Display_Controller* self, const char* buffer, size_t length);
 
+#define TARGET_DISPLAY_DOUBLE_BUFFER_SUPPORTED
+
+typedef void(*STM32F7_Display_FlipHandler)(const TinyCLR_Display_Controller* self, uint64_t timestamp);
+
+TinyCLR_Result STM32F7_Display_SetDoubleBuffering(const TinyCLR_Display_Controller* self, bool enable);
+TinyCLR_Result STM32F7_Display_WaitForFlip(const TinyCLR_Display_Controller* self);
+TinyCLR_Result STM32F7_Display_SetFlipHandler(const TinyCLR_Display_Controller* self, STM32F7_Display_FlipHandler handler);
+
+#define TARGET_DISPLAY_OVERLAY_SUPPORTED
+
+enum class STM32F7_Display_OverlayFormat : uint8_t {
+    Argb8888 = 0,
+    Argb4444 = 1,
+    L8 = 2
+};
+
+TinyCLR_Result STM32F7_Display_SetOverlay(const TinyCLR_Display_Controller* self, int32_t x, int32_t y, int32_t width, int32_t height, STM32F7_Display_OverlayFormat format);
+TinyCLR_Result STM32F7_Display_RemoveOverlay(const TinyCLR_Display_Controller* self);
+TinyCLR_Result STM32F7_Display_MoveOverlay(const TinyCLR_Display_Controller* self, int32_t x, int32_t y);
+TinyCLR_Result STM32F7_Display_SetOverlayBlending(const TinyCLR_Display_Controller* self, uint8_t alpha, bool colorKeyEnable, uint32_t colorKey);
+TinyCLR_Result STM32F7_Display_SetOverlayPalette(const TinyCLR_Display_Controller* self, const uint32_t* colors, size_t count);
+TinyCLR_Result STM32F7_Display_DrawOverlay(const TinyCLR_Display_Controller* self, int32_t x, int32_t y, int32_t width, int32_t height, const uint8_t* data, size_t length);
+
 void STM32F7_Startup_OnSoftReset(const TinyCLR_Api_Manager* apiManager, const TinyCLR_Interop_Manager* interopProvider);
 void STM32F7_Startup_OnSoftResetDevice(const TinyCLR_Api_Manager* apiManager, const TinyCLR_Interop_Manager* interopProvider);
 
@@ -19,6 +19,8 @@
 #define STM32F7_AD_SAMPLE_TIME 2   // sample time = 28 cycles
 #define ADCx ADC1
 #define RCC_APB2ENR_ADCxEN RCC_APB2ENR_ADC1EN
+#define STM32F7_ADC_DMA_CHANNEL 0 // ADC1 on DMA2 stream 0 or 4 channel 0
+#define STM32F7_ADC_DMA_STREAMS (STM32F7_DMA_STREAM(2, 0) | STM32F7_DMA_STREAM(2, 4))
 #define STM32F7_ADC_CHANNEL_NONE    0xFF
 #define STM32F7_ADC_PINS { PIN(A, 0), PIN(A, 1), PIN(A, 2), PIN(A, 3), PIN(A, 4), PIN(A, 5), PIN(A, 6), PIN(A, 7), PIN(B, 0), PIN(B, 1), PIN(C, 0), PIN(C, 1), PIN(C, 2),PIN(C, 3), PIN(C, 4), PIN(C, 5), PIN_NONE, PIN_NONE}
 
@@ -26,6 +28,31 @@
 
 #define TOTAL_ADC_CONTROLLERS 1
 
+// Samples averaged by ReadChannel, can be changed at runtime with STM32F7_Adc_SetOversampling
+#ifndef STM32F7_ADC_DEFAULT_OVERSAMPLE
+#define STM32F7_ADC_DEFAULT_OVERSAMPLE 1
+#endif
+
+#define STM32F7_ADC_MAX_OVERSAMPLE 256
+
+// ADC clock cycles for one conversion: sample time (28 cycles) + 12 cycles for 12 bit resolution
+#define STM32F7_AD_CONVERSION_CYCLES (28 + 12)
+#define STM32F7_AD_CLOCK_HZ (STM32F7_APB2_CLOCK_HZ / 2)
+
+// Scan mode: TIM6 update event triggers one scan of the sequence, a DMA2 stream moves the results into a ring of two halves
+#ifndef STM32F7_ADC_SCAN_HALF_BUFFER_SIZE
+#define STM32F7_ADC_SCAN_HALF_BUFFER_SIZE 256 // samples
+#endif
+
+#define STM32F7_ADC_SCAN_MAX_CHANNELS 16
+#define STM32F7_ADC_SCAN_EXTSEL_TIM6_TRGO 13
+
+#if STM32F7_APB1_CLOCK_HZ == STM32F7_AHB_CLOCK_HZ
+#define STM32F7_ADC_SCAN_TIMER_CLOCK_HZ (STM32F7_APB1_CLOCK_HZ)
+#else
+#define STM32F7_ADC_SCAN_TIMER_CLOCK_HZ (STM32F7_APB1_CLOCK_HZ * 2)
+#endif
+
 static const uint32_t adcPins[] = STM32F7_ADC_PINS;
 
 static TinyCLR_Adc_Controller adcControllers[TOTAL_ADC_CONTROLLERS];
@@ -37,10 +64,27 @@ const char* adcApiNames[TOTAL_ADC_CONTROLLERS] = {
 
 struct AdcState {
     bool isOpen[STM32F7_AD_NUM];
+
+    uint32_t oversample;
+
+    bool isScanning;
+    uint32_t scanChannelCount;
+    uint32_t scanOversample;
+    size_t scanHalfLength;
+
+    volatile uint32_t scanCompletedHalves;
+    uint32_t scanReadHalves;
+    volatile uint32_t scanOverruns;
+
+    STM32F7_Adc_ScanHandler scanHandler;
+    int32_t scanDmaStream;
 };
 
 static AdcState adcStates[TOTAL_ADC_CONTROLLERS];
 
+// Cache line aligned so invalidating a half never discards neighbouring data
+static uint16_t __attribute__((aligned(32))) adcScanBuffer[2 * STM32F7_ADC_SCAN_HALF_BUFFER_SIZE];
+
 void STM32F7_Adc_AddApi(const TinyCLR_Api_Manager* apiManager) {
     for (int32_t i = 0; i < TOTAL_ADC_CONTROLLERS; i++) {
         adcControllers[i].ApiInfo = &adcApi[i];
@@ -64,6 +108,8 @@ void STM32F7_Adc_AddApi(const TinyCLR_Api_Manager* apiManager) {
         adcApi[i].Implementation = &adcControllers[i];
         adcApi[i].State = &adcStates[i];
 
+        adcStates[i].oversample = STM32F7_ADC_DEFAULT_OVERSAMPLE;
+
         apiManager->Add(apiManager, &adcApi[i]);
     }
 
@@ -75,7 +121,10 @@ TinyCLR_Result STM32F7_Adc_Acquire(const TinyCLR_Adc_Controller* self) {
 }
 
 TinyCLR_Result STM32F7_Adc_Release(const TinyCLR_Adc_Controller* self) {
-    return self == nullptr ? TinyCLR_Result::ArgumentNull : TinyCLR_Result::Success;
+    if (self == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    return STM32F7_Adc_StopScan(self);
 }
 
 TinyCLR_Result STM32F7_Adc_OpenChannel(const TinyCLR_Adc_Controller* self, uint32_t channel) {
@@ -129,29 +178,41 @@ TinyCLR_Result STM32F7_Adc_CloseChannel(const TinyCLR_Adc_Controller* self, uint
 }
 
 TinyCLR_Result STM32F7_Adc_ReadChannel(const TinyCLR_Adc_Controller* self, uint32_t channel, int32_t& value) {
+    auto state = reinterpret_cast<AdcState*>(self->ApiInfo->State);
+
     // check if this channel is listed in the STM32F7_AD_CHANNELS array
+    int samples = state->oversample;
+
     value = 0;
 
+    if (state->isScanning)
+        return TinyCLR_Result::InvalidOperation;
+
     for (int i = 0; i < STM32F7_AD_NUM; i++) {
         if (i == channel) { // valid channel
-            int x = ADCx->DR; // clear EOC flag
+            while (samples-- > 0) {
 
-            ADCx->SQR3 = channel; // select channel
+                int x = ADCx->DR; // clear EOC flag
 
-            // need to enable internal reference at ADC->CCR register to work with internally connected channels
-            if (channel == 16 || channel == 17) {
-                ADC->CCR |= ADC_CCR_TSVREFE; // Enable internal reference to work with temperature sensor and VREFINT channels
-            }
+                ADCx->SQR3 = channel; // select channel
+
+                // need to enable internal reference at ADC->CCR register to work with internally connected channels
+                if (channel == 16 || channel == 17) {
+                    ADC->CCR |= ADC_CCR_TSVREFE; // Enable internal reference to work with temperature sensor and VREFINT channels
+                }
+
+                ADCx->CR2 |= ADC_CR2_SWSTART; // start AD
+                while (!(ADCx->SR & ADC_SR_EOC)); // wait for completion
 
-            ADCx->CR2 |= ADC_CR2_SWSTART; // start AD
-            while (!(ADCx->SR & ADC_SR_EOC)); // wait for completion
+                // disable internally reference
+                if (channel == 16 || channel == 17) {
+                    ADC->CCR &= ~ADC_CCR_TSVREFE;
+                }
 
-            // disable internally reference
-            if (channel == 16 || channel == 17) {
-                ADC->CCR &= ~ADC_CCR_TSVREFE;
+                value += (ADCx->DR) & 0xFFF; // read result
             }
 
-            value = (ADCx->DR) & 0xFFF; // read result
+            value /= static_cast<int32_t>(state->oversample);
 
             return TinyCLR_Result::Success;
         }
@@ -161,6 +222,262 @@ TinyCLR_Result STM32F7_Adc_ReadChannel(const TinyCLR_Adc_Controller* self, uint3
     return TinyCLR_Result::ArgumentOutOfRange;
 }
 
+TinyCLR_Result STM32F7_Adc_SetOversampling(const TinyCLR_Adc_Controller* self, uint32_t samples) {
+    auto state = reinterpret_cast<AdcState*>(self->ApiInfo->State);
+
+    if (samples == 0 || samples > STM32F7_ADC_MAX_OVERSAMPLE)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    state->oversample = samples;
+
+    return TinyCLR_Result::Success;
+}
+
+static void STM32F7_Adc_ScanDmaEventHandler(int32_t stream, STM32F7_Dma_Event event, void* param) {
+    auto state = &adcStates[0];
+    auto self = &adcControllers[0];
+
+    if (event == STM32F7_Dma_Event::Error) {
+        // the stream is disabled by hardware on a transfer error, nothing more will arrive
+        state->scanOverruns++;
+
+        return;
+    }
+
+    state->scanCompletedHalves++;
+
+    if (state->scanHandler != nullptr) {
+        auto pending = state->scanCompletedHalves - state->scanReadHalves;
+
+        if (pending > 2)
+            pending = 2;
+
+        state->scanHandler(self, pending * (state->scanHalfLength / state->scanOversample));
+    }
+}
+
+TinyCLR_Result STM32F7_Adc_StartScan(const TinyCLR_Adc_Controller* self, const uint32_t* channels, size_t channelCount, uint32_t sampleRateHz, uint32_t oversample, STM32F7_Adc_ScanHandler handler) {
+    auto state = reinterpret_cast<AdcState*>(self->ApiInfo->State);
+
+    if (channels == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    if (state->isScanning)
+        return TinyCLR_Result::InvalidOperation;
+
+    if (channelCount == 0 || channelCount > STM32F7_ADC_SCAN_MAX_CHANNELS || oversample == 0 || oversample > STM32F7_ADC_MAX_OVERSAMPLE || sampleRateHz == 0)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    // one trigger converts the whole sequence once, oversampling multiplies the trigger rate
+    uint64_t triggerRate = static_cast<uint64_t>(sampleRateHz) * oversample;
+
+    if (triggerRate * channelCount * STM32F7_AD_CONVERSION_CYCLES > STM32F7_AD_CLOCK_HZ)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    uint32_t ticks = static_cast<uint32_t>(STM32F7_ADC_SCAN_TIMER_CLOCK_HZ / triggerRate);
+
+    if (ticks < 2)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    // each half holds a whole number of oversampled frames
+    auto frameLength = channelCount * oversample;
+    auto frames = STM32F7_ADC_SCAN_HALF_BUFFER_SIZE / frameLength;
+
+    if (frames == 0)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    bool useInternalReference = false;
+
+    for (size_t i = 0; i < channelCount; i++) {
+        if (channels[i] >= STM32F7_AD_NUM || !state->isOpen[channels[i]])
+            return TinyCLR_Result::InvalidOperation;
+
+        if (channels[i] == 16 || channels[i] == 17)
+            useInternalReference = true;
+    }
+
+    // the trigger timer may already be driving PWM pins, PWM in turn leaves it alone while its clock is on
+    if (RCC->APB1ENR & RCC_APB1ENR_TIM6EN)
+        return TinyCLR_Result::SharingViolation;
+
+    state->scanDmaStream = STM32F7_Dma_AcquireStream(STM32F7_ADC_DMA_STREAMS, state);
+
+    if (state->scanDmaStream == STM32F7_DMA_STREAM_NONE)
+        return TinyCLR_Result::SharingViolation;
+
+    state->scanChannelCount = channelCount;
+    state->scanOversample = oversample;
+    state->scanHalfLength = frames * frameLength;
+    state->scanCompletedHalves = 0;
+    state->scanReadHalves = 0;
+    state->scanOverruns = 0;
+    state->scanHandler = handler;
+
+    // trigger timer, update event drives TRGO
+    uint32_t prescaler = (ticks - 1) / 0x10000;
+
+    RCC->APB1ENR |= RCC_APB1ENR_TIM6EN;
+
+    TIM6->CR1 = 0;
+    TIM6->DIER = 0;
+    TIM6->PSC = prescaler;
+    TIM6->ARR = ticks / (prescaler + 1) - 1;
+    TIM6->EGR = TIM_EGR_UG;
+    TIM6->CR2 = TIM_CR2_MMS_1;
+
+    // DMA
+    STM32F7_Dma_Transfer transfer;
+
+    transfer.control = STM32F7_DMA_CONTROL_CHANNEL(STM32F7_ADC_DMA_CHANNEL) | DMA_SxCR_PL_1 | DMA_SxCR_MSIZE_0 | DMA_SxCR_PSIZE_0 | DMA_SxCR_MINC | DMA_SxCR_CIRC | DMA_SxCR_HTIE;
+    transfer.peripheral = reinterpret_cast<uint32_t>(&ADCx->DR);
+    transfer.memory0 = reinterpret_cast<uint32_t>(adcScanBuffer);
+    transfer.memory1 = 0;
+    transfer.count = 2 * state->scanHalfLength;
+    transfer.fifoControl = 0; // direct mode
+
+    STM32F7_Dma_Start(state->scanDmaStream, &transfer, STM32F7_Adc_ScanDmaEventHandler, state);
+
+    // sequence
+    uint32_t sqr[3] = { 0, 0, 0 };
+
+    for (size_t i = 0; i < channelCount; i++)
+        sqr[i / 6] |= channels[i] << ((i % 6) * 5);
+
+    ADCx->SQR3 = sqr[0];
+    ADCx->SQR2 = sqr[1];
+    ADCx->SQR1 = sqr[2] | ((channelCount - 1) << 20);
+
+    if (useInternalReference)
+        ADC->CCR |= ADC_CCR_TSVREFE;
+
+    int x = ADCx->DR; // clear EOC flag
+
+    ADCx->SR = 0;
+    ADCx->CR1 = ADC_CR1_SCAN;
+    ADCx->CR2 = ADC_CR2_ADON | ADC_CR2_DMA | ADC_CR2_DDS | ADC_CR2_EXTEN_0 | (STM32F7_ADC_SCAN_EXTSEL_TIM6_TRGO << 24);
+
+    state->isScanning = true;
+
+    TIM6->CR1 = TIM_CR1_CEN;
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result STM32F7_Adc_StopScan(const TinyCLR_Adc_Controller* self) {
+    auto state = reinterpret_cast<AdcState*>(self->ApiInfo->State);
+
+    if (!state->isScanning)
+        return TinyCLR_Result::Success;
+
+    TIM6->CR1 = 0;
+    TIM6->CR2 = 0;
+    RCC->APB1ENR &= ~RCC_APB1ENR_TIM6EN;
+
+    ADCx->CR2 = ADC_CR2_ADON;
+    ADCx->CR1 = 0;
+    ADCx->SQR1 = 0;
+    ADCx->SR = 0;
+
+    STM32F7_Dma_ReleaseStream(state->scanDmaStream, state);
+
+    state->scanDmaStream = STM32F7_DMA_STREAM_NONE;
+
+    ADC->CCR &= ~ADC_CCR_TSVREFE;
+
+    state->isScanning = false;
+    state->scanHandler = nullptr;
+
+    return TinyCLR_Result::Success;
+}
+
+// Copies every completed half into buffer as averaged frames, length is the buffer size on input and the number of samples written on output
+TinyCLR_Result STM32F7_Adc_ReadScan(const TinyCLR_Adc_Controller* self, uint16_t* buffer, size_t& length) {
+    auto state = reinterpret_cast<AdcState*>(self->ApiInfo->State);
+
+    if (buffer == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    if (!state->isScanning) {
+        length = 0;
+
+        return TinyCLR_Result::InvalidOperation;
+    }
+
+    auto halfOutputLength = state->scanHalfLength / state->scanOversample;
+
+    if (length < halfOutputLength) {
+        length = 0;
+
+        return TinyCLR_Result::ArgumentOutOfRange;
+    }
+
+    size_t written = 0;
+
+    while (written + halfOutputLength <= length) {
+        auto completed = state->scanCompletedHalves;
+
+        if (completed == state->scanReadHalves)
+            break;
+
+        // DMA already wrapped into the oldest unread half, drop what was overwritten
+        if (completed - state->scanReadHalves > 1) {
+            state->scanOverruns += completed - state->scanReadHalves - 1;
+            state->scanReadHalves = completed - 1;
+        }
+
+        auto src = &adcScanBuffer[(state->scanReadHalves % 2) * state->scanHalfLength];
+
+        // DMA wrote behind the data cache
+        SCB_InvalidateDCache_by_Addr(reinterpret_cast<uint32_t*>(src), state->scanHalfLength * sizeof(uint16_t));
+        auto dst = &buffer[written];
+
+        for (auto frame = 0; frame < state->scanHalfLength; frame += state->scanChannelCount * state->scanOversample) {
+            for (auto c = 0; c < state->scanChannelCount; c++) {
+                uint32_t sum = 0;
+
+                for (auto n = 0; n < state->scanOversample; n++)
+                    sum += src[frame + n * state->scanChannelCount + c] & 0xFFF;
+
+                *dst++ = static_cast<uint16_t>(sum / state->scanOversample);
+            }
+        }
+
+        // the half was overwritten while being copied
+        if (state->scanCompletedHalves - state->scanReadHalves > 1) {
+            state->scanOverruns++;
+            state->scanReadHalves++;
+
+            continue;
+        }
+
+        state->scanReadHalves++;
+        written += halfOutputLength;
+    }
+
+    length = written;
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result STM32F7_Adc_GetScanStatus(const TinyCLR_Adc_Controller* self, size_t& available, uint32_t& overruns) {
+    auto state = reinterpret_cast<AdcState*>(self->ApiInfo->State);
+
+    available = 0;
+    overruns = state->scanOverruns;
+
+    if (!state->isScanning)
+        return TinyCLR_Result::InvalidOperation;
+
+    auto pending = state->scanCompletedHalves - state->scanReadHalves;
+
+    if (pending > 2)
+        pending = 2;
+
+    available = pending * (state->scanHalfLength / state->scanOversample);
+
+    return TinyCLR_Result::Success;
+}
+
 uint32_t STM32F7_Adc_GetChannelCount(const TinyCLR_Adc_Controller* self) {
     return STM32F7_AD_NUM;
 }
@@ -191,6 +508,10 @@ bool STM32F7_Adc_IsChannelModeSupported(const TinyCLR_Adc_Controller* self, Tiny
 
 void STM32F7_Adc_Reset() {
     for (auto c = 0; c < TOTAL_ADC_CONTROLLERS; c++) {
+        STM32F7_Adc_StopScan(&adcControllers[c]);
+
+        adcStates[c].oversample = STM32F7_ADC_DEFAULT_OVERSAMPLE;
+
         for (auto i = 0; i < STM32F7_AD_NUM; i++) {
             STM32F7_Adc_CloseChannel(&adcControllers[c], i);
 
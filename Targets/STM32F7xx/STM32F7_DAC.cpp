@@ -24,11 +24,37 @@
 #define STM32F7_DAC_FIRST_PIN 4
 #define STM32F7_DAC_RESOLUTION_INT_BIT 12
 
+// Playback: TIM7 update event clocks one sample out of the buffer per period through DMA1 channel 7
+// stream 5 serves channel 1 and dual mode, stream 6 serves channel 2
+#define STM32F7_DAC_DMA_CHANNEL 7
+#define STM32F7_DAC_TSEL_TIM7_TRGO 2
+
+#define STM32F7_DAC_CR_CHANNEL_MASK (DAC_CR_TEN1 | DAC_CR_TSEL1 | DAC_CR_DMAEN1)
+
+#if STM32F7_APB1_CLOCK_HZ == STM32F7_AHB_CLOCK_HZ
+#define STM32F7_DAC_TIMER_CLOCK_HZ (STM32F7_APB1_CLOCK_HZ)
+#else
+#define STM32F7_DAC_TIMER_CLOCK_HZ (STM32F7_APB1_CLOCK_HZ * 2)
+#endif
+
+static const uint32_t dacDmaStreams[STM32F7_DAC_CHANNEL_NUMS] = {
+    STM32F7_DMA_STREAM(1, 5),
+    STM32F7_DMA_STREAM(1, 6)
+};
+
 static TinyCLR_Dac_Controller dacControllers[TOTAL_DAC_CONTROLLERS];
 static TinyCLR_Api_Info dacApi[TOTAL_DAC_CONTROLLERS];
 
 struct DacState {
     bool isOpened[STM32F7_DAC_CHANNEL_NUMS];
+
+    bool isPlaying;
+    uint32_t playbackChannel;
+    size_t playbackLength;
+    bool playbackCircular;
+
+    STM32F7_Dac_PlaybackHandler playbackHandler;
+    int32_t playbackDmaStream;
 };
 
 static DacState dacStates[TOTAL_DAC_CONTROLLERS];
@@ -74,7 +100,7 @@ TinyCLR_Result STM32F7_Dac_Release(const TinyCLR_Dac_Controller* self) {
     if (self == nullptr)
         return TinyCLR_Result::ArgumentNull;
 
-    return TinyCLR_Result::Success;
+    return STM32F7_Dac_StopPlayback(self);
 }
 
 TinyCLR_Result STM32F7_Dac_OpenChannel(const TinyCLR_Dac_Controller* self, uint32_t channel) {
@@ -104,6 +130,9 @@ TinyCLR_Result STM32F7_Dac_OpenChannel(const TinyCLR_Dac_Controller* self, uint3
 TinyCLR_Result STM32F7_Dac_CloseChannel(const TinyCLR_Dac_Controller* self, uint32_t channel) {
     auto state = reinterpret_cast<DacState*>(self->ApiInfo->State);
 
+    if (state->isPlaying && (state->playbackChannel == channel || state->playbackChannel == STM32F7_DAC_CHANNEL_DUAL))
+        STM32F7_Dac_StopPlayback(self);
+
     if (channel) {
         DAC->CR &= ~DAC_CR_EN2; // disable channel 2
     }
@@ -125,6 +154,11 @@ TinyCLR_Result STM32F7_Dac_CloseChannel(const TinyCLR_Dac_Controller* self, uint
 }
 
 TinyCLR_Result STM32F7_Dac_WriteValue(const TinyCLR_Dac_Controller* self, uint32_t channel, int32_t value) {
+    auto state = reinterpret_cast<DacState*>(self->ApiInfo->State);
+
+    if (state->isPlaying && (state->playbackChannel == channel || state->playbackChannel == STM32F7_DAC_CHANNEL_DUAL))
+        return TinyCLR_Result::InvalidOperation;
+
     value &= 0x00000FFF;
 
     if (channel)
@@ -135,6 +169,154 @@ TinyCLR_Result STM32F7_Dac_WriteValue(const TinyCLR_Dac_Controller* self, uint32
     return TinyCLR_Result::Success;
 }
 
+static void STM32F7_Dac_PlaybackDmaEventHandler(int32_t stream, STM32F7_Dma_Event event, void* param) {
+    auto self = &dacControllers[0];
+    auto state = &dacStates[0];
+
+    if (!state->isPlaying)
+        return;
+
+    auto channel = state->playbackChannel;
+    auto handler = state->playbackHandler;
+    auto length = state->playbackLength;
+    auto half = length / 2;
+
+    if (event == STM32F7_Dma_Event::Error) {
+        STM32F7_Dac_StopPlayback(self);
+
+        return;
+    }
+
+    if (state->playbackCircular) {
+        // the half just played out can be refilled while the other one is being clocked out
+        if (event == STM32F7_Dma_Event::HalfCompleted && handler != nullptr)
+            handler(self, channel, 0, half);
+
+        if (event == STM32F7_Dma_Event::Completed && handler != nullptr)
+            handler(self, channel, half, length - half);
+    }
+    else if (event == STM32F7_Dma_Event::Completed) {
+        STM32F7_Dac_StopPlayback(self);
+
+        if (handler != nullptr)
+            handler(self, channel, 0, length);
+    }
+}
+
+// channel is 0, 1 or STM32F7_DAC_CHANNEL_DUAL. Single channel buffers hold uint16_t samples, dual mode buffers hold
+// uint32_t samples with channel 1 in the low and channel 2 in the high halfword. length is in samples.
+// The buffer must stay valid until playback ends. Data written into it later must be cleaned from the data cache
+// before the DMA reaches it.
+TinyCLR_Result STM32F7_Dac_StartPlayback(const TinyCLR_Dac_Controller* self, uint32_t channel, const void* buffer, size_t length, uint32_t sampleRateHz, bool circular, STM32F7_Dac_PlaybackHandler handler) {
+    auto state = reinterpret_cast<DacState*>(self->ApiInfo->State);
+
+    if (buffer == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    if (state->isPlaying)
+        return TinyCLR_Result::InvalidOperation;
+
+    if (channel > STM32F7_DAC_CHANNEL_DUAL || length == 0 || length > 0xFFFF || (circular && length < 2) || sampleRateHz == 0)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto dual = channel == STM32F7_DAC_CHANNEL_DUAL;
+
+    if (dual ? (!state->isOpened[0] || !state->isOpened[1]) : !state->isOpened[channel])
+        return TinyCLR_Result::InvalidOperation;
+
+    if (reinterpret_cast<uint32_t>(buffer) & (dual ? 3 : 1))
+        return TinyCLR_Result::ArgumentInvalid;
+
+    uint32_t ticks = STM32F7_DAC_TIMER_CLOCK_HZ / sampleRateHz;
+
+    if (ticks < 2)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    // TIM7 is also PWM controller 6
+    if (RCC->APB1ENR & RCC_APB1ENR_TIM7EN)
+        return TinyCLR_Result::SharingViolation;
+
+    state->playbackDmaStream = STM32F7_Dma_AcquireStream(dacDmaStreams[dual ? 0 : channel], state);
+
+    if (state->playbackDmaStream == STM32F7_DMA_STREAM_NONE)
+        return TinyCLR_Result::SharingViolation;
+
+    state->playbackChannel = channel;
+    state->playbackLength = length;
+    state->playbackCircular = circular;
+    state->playbackHandler = handler;
+
+    // sample clock
+    uint32_t prescaler = (ticks - 1) / 0x10000;
+
+    RCC->APB1ENR |= RCC_APB1ENR_TIM7EN;
+
+    TIM7->CR1 = 0;
+    TIM7->DIER = 0;
+    TIM7->PSC = prescaler;
+    TIM7->ARR = ticks / (prescaler + 1) - 1;
+    TIM7->EGR = TIM_EGR_UG;
+    TIM7->CR2 = TIM_CR2_MMS_1; // update event as TRGO
+
+    // DMA
+    SCB_CleanDCache_by_Addr(reinterpret_cast<uint32_t*>(reinterpret_cast<uint32_t>(buffer) & ~31), length * (dual ? 4 : 2) + 32);
+
+    STM32F7_Dma_Transfer transfer;
+
+    transfer.control = STM32F7_DMA_CONTROL_CHANNEL(STM32F7_DAC_DMA_CHANNEL) | DMA_SxCR_PL_1 | (dual ? (DMA_SxCR_MSIZE_1 | DMA_SxCR_PSIZE_1) : (DMA_SxCR_MSIZE_0 | DMA_SxCR_PSIZE_0)) | DMA_SxCR_MINC | DMA_SxCR_DIR_0 | (circular ? (DMA_SxCR_CIRC | DMA_SxCR_HTIE) : 0);
+    transfer.peripheral = dual ? reinterpret_cast<uint32_t>(&DAC->DHR12RD) : (channel ? reinterpret_cast<uint32_t>(&DAC->DHR12R2) : reinterpret_cast<uint32_t>(&DAC->DHR12R1));
+    transfer.memory0 = reinterpret_cast<uint32_t>(buffer);
+    transfer.memory1 = 0;
+    transfer.count = length;
+    transfer.fifoControl = 0; // direct mode
+
+    STM32F7_Dma_Start(state->playbackDmaStream, &transfer, STM32F7_Dac_PlaybackDmaEventHandler, state);
+
+    // DAC, in dual mode both channels convert on the same trigger and only channel 1 requests DMA
+    uint32_t trigger = DAC_CR_TEN1 | (STM32F7_DAC_TSEL_TIM7_TRGO << 3);
+
+    if (dual)
+        DAC->CR |= (trigger | DAC_CR_DMAEN1) | (trigger << 16);
+    else
+        DAC->CR |= (trigger | DAC_CR_DMAEN1) << (channel * 16);
+
+    state->isPlaying = true;
+
+    TIM7->CR1 = TIM_CR1_CEN;
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result STM32F7_Dac_StopPlayback(const TinyCLR_Dac_Controller* self) {
+    auto state = reinterpret_cast<DacState*>(self->ApiInfo->State);
+
+    if (!state->isPlaying)
+        return TinyCLR_Result::Success;
+
+    TIM7->CR1 = 0;
+    TIM7->CR2 = 0;
+    RCC->APB1ENR &= ~RCC_APB1ENR_TIM7EN;
+
+    // outputs keep the last converted sample
+    DAC->CR &= ~(STM32F7_DAC_CR_CHANNEL_MASK | (STM32F7_DAC_CR_CHANNEL_MASK << 16));
+    DAC->SR = DAC_SR_DMAUDR1 | DAC_SR_DMAUDR2;
+
+    STM32F7_Dma_ReleaseStream(state->playbackDmaStream, state);
+
+    state->playbackDmaStream = STM32F7_DMA_STREAM_NONE;
+
+    state->isPlaying = false;
+    state->playbackHandler = nullptr;
+
+    return TinyCLR_Result::Success;
+}
+
+bool STM32F7_Dac_IsPlaying(const TinyCLR_Dac_Controller* self) {
+    auto state = reinterpret_cast<DacState*>(self->ApiInfo->State);
+
+    return state->isPlaying;
+}
+
 uint32_t STM32F7_Dac_GetChannelCount(const TinyCLR_Dac_Controller* self) {
     return STM32F7_DAC_CHANNEL_NUMS;
 }
@@ -153,6 +335,8 @@ int32_t STM32F7_Dac_GetMaxValue(const TinyCLR_Dac_Controller* self) {
 
 void STM32F7_Dac_Reset() {
     for (auto c = 0; c < TOTAL_DAC_CONTROLLERS; c++) {
+        STM32F7_Dac_StopPlayback(&dacControllers[c]);
+
         for (auto i = 0; i < STM32F7_Dac_GetChannelCount(&dacControllers[c]); i++) {
             STM32F7_Dac_CloseChannel(&dacControllers[c], i);
 
@@ -160,5 +344,4 @@ void STM32F7_Dac_Reset() {
         }
     }
 }
-
 #endif
\ No newline at end of file
@@ -64,8 +64,15 @@
 #define SECTOR_MASK               ((uint32_t)0xFFFFFF07)
 
 
-#if STM32F7_SUPPLY_VOLTAGE_MV < 2100
-#error 16 bit Flash programming not allowed for voltages below 2.1V
+// Program parallelism allowed by the supply voltage range (external VPP is needed for x64)
+#if STM32F7_SUPPLY_VOLTAGE_MV >= 2700 && defined(STM32F7_FLASH_EXTERNAL_VPP)
+#define STM32F7_FLASH_PROGRAM_SIZE      8
+#elif STM32F7_SUPPLY_VOLTAGE_MV >= 2700
+#define STM32F7_FLASH_PROGRAM_SIZE      4
+#elif STM32F7_SUPPLY_VOLTAGE_MV >= 2100
+#define STM32F7_FLASH_PROGRAM_SIZE      2
+#else
+#define STM32F7_FLASH_PROGRAM_SIZE      1
 #endif
 #if STM32F7_AHB_CLOCK_HZ < 1000000
 #error Flash programming not allowed for HCLK below 1MHz
@@ -74,6 +81,12 @@
 static const uint32_t STM32F7_FLASH_KEY1 = 0x45670123;
 static const uint32_t STM32F7_FLASH_KEY2 = 0xcdef89ab;
 
+#define STM32F7_FLASH_SR_ERRORS     (FLASH_SR_OPERR | FLASH_SR_WRPERR | FLASH_SR_PGAERR | FLASH_SR_PGPERR | FLASH_SR_ERSERR)
+
+#ifndef STM32F7_FLASH_ERASE_QUEUE_SIZE
+#define STM32F7_FLASH_ERASE_QUEUE_SIZE 16
+#endif
+
 struct DeploymentSector {
     uint32_t id;
     uint32_t address;
@@ -96,12 +109,22 @@ struct DeploymentState {
     TinyCLR_Storage_Descriptor storageDescriptor;
     TinyCLR_Startup_DeploymentConfiguration deploymentConfiguration;
 
+    // sectors waiting for the background erase, the head is the one being erased
+    uint32_t eraseQueue[STM32F7_FLASH_ERASE_QUEUE_SIZE];
+    size_t eraseQueueIn;
+    volatile size_t eraseQueueCount;
+    volatile size_t eraseErrorCount;
+    volatile bool eraseBusy;
+    STM32F7_Flash_EraseCompletedHandler eraseCompletedHandler;
+
     bool isOpened = false;
     bool tableInitialized = false;
 };
 
 static DeploymentState deploymentStates[TOTAL_DEPLOYMENT_CONTROLLERS];
 
+static STM32F7_Flash_BenchmarkHandler flashBenchmarkHandler = nullptr;
+
 const char* flashApiNames[TOTAL_DEPLOYMENT_CONTROLLERS] = {
     "GHIElectronics.TinyCLR.NativeApis.STM32F7.StorageController\\0"
 };
@@ -181,6 +204,16 @@ TinyCLR_Result __section("SectionForFlashOperations") STM32F7_Flash_Read(const T
 }
 
 
+uint32_t __section("SectionForFlashOperations") STM32F7_Flash_GetProgramSize(uint32_t address, uint32_t end) {
+    uint32_t size = STM32F7_FLASH_PROGRAM_SIZE;
+
+    // unaligned head and short tail fall back to a narrower parallelism
+    while (size > 1 && ((address & (size - 1)) != 0 || end - address < size))
+        size >>= 1;
+
+    return size;
+}
+
 TinyCLR_Result __section("SectionForFlashOperations") STM32F7_Flash_Write(const TinyCLR_Storage_Controller* self, uint64_t address, size_t& count, const uint8_t* data, uint64_t timeout) {
     if (data == nullptr) return TinyCLR_Result::ArgumentNull;
 
@@ -188,6 +221,15 @@ TinyCLR_Result __section("SectionForFlashOperations") STM32F7_Flash_Write(const
 
     if (bytePerSector <= 0) return TinyCLR_Result::IndexOutOfRange;
 
+    auto state = reinterpret_cast<DeploymentState*>(self->ApiInfo->State);
+
+    while (state->eraseBusy);
+
+    auto benchmarkHandler = flashBenchmarkHandler;
+    auto startTime = benchmarkHandler != nullptr ? STM32F7_Time_GetCurrentProcessorTime() : 0;
+    size_t programmed = 0;
+    size_t skipped = 0;
+
     STM32F7_Startup_CacheDisable();
 
     if (STM32F7_FLASH->CR & FLASH_CR_LOCK) { // unlock
@@ -197,53 +239,84 @@ TinyCLR_Result __section("SectionForFlashOperations") STM32F7_Flash_Write(const
 
     while (STM32F7_FLASH->SR & FLASH_SR_BSY);
 
-    STM32F7_FLASH->SR = (FLASH_SR_EOP | FLASH_SR_OPERR | FLASH_SR_WRPERR | FLASH_SR_PGAERR | FLASH_SR_PGPERR | FLASH_SR_ERSERR);
+    STM32F7_FLASH->SR = FLASH_SR_EOP | STM32F7_FLASH_SR_ERRORS;
 
-    uint32_t* addressStart = reinterpret_cast<uint32_t*>(address);
-    uint32_t* addressEnd = reinterpret_cast<uint32_t*>(address + count);
-    uint32_t* pBuf = (uint32_t*)data;
-
-    // enable programming
-    auto to = timeout * 1000;
+    auto result = TinyCLR_Result::Success;
+    uint32_t addressStart = static_cast<uint32_t>(address);
+    uint32_t addressEnd = static_cast<uint32_t>(address + count);
+    uint32_t currentSize = 0;
 
     while (addressStart < addressEnd) {
-        if (*addressStart != *pBuf) {
+        auto size = STM32F7_Flash_GetProgramSize(addressStart, addressEnd);
+        auto flash = reinterpret_cast<volatile uint8_t*>(addressStart);
+        auto changed = false;
 
-            STM32F7_FLASH->CR &= CR_PSIZE_MASK;
-            STM32F7_FLASH->CR |= FLASH_PSIZE_WORD;
-            STM32F7_FLASH->CR |= FLASH_CR_EOPIE;
-            STM32F7_FLASH->CR |= FLASH_CR_PG;
+        for (auto i = 0; i < size; i++) {
+            auto value = flash[i];
 
-            // write data
-            *addressStart = *pBuf;
+            if (value != data[i]) {
+                changed = true;
 
-            __DSB();
+                // bits can only be cleared, the sector has to be erased first
+                if ((value & data[i]) != data[i]) {
+                    result = TinyCLR_Result::InvalidOperation;
 
-            // wait for completion
-            to = timeout;
+                    goto end_programming;
+                }
+            }
+        }
 
-            while (((STM32F7_FLASH->SR & FLASH_SR_EOP) == 0) || (STM32F7_FLASH->SR & FLASH_SR_BSY)) {
-                STM32F7_Time_Delay(nullptr, 1);
-                to--;
+        if (changed) {
+            if (size != currentSize) {
+                // PSIZE must not change while an operation is running
+                while (STM32F7_FLASH->SR & FLASH_SR_BSY);
 
-                if (to == 0)
-                    goto end_programing;
+                STM32F7_FLASH->CR &= CR_PSIZE_MASK;
+                STM32F7_FLASH->CR |= (size == 8 ? FLASH_PSIZE_DOUBLE_WORD : size == 4 ? FLASH_PSIZE_WORD : size == 2 ? FLASH_PSIZE_HALF_WORD : FLASH_PSIZE_BYTE);
+                STM32F7_FLASH->CR |= FLASH_CR_PG;
+
+                currentSize = size;
             }
 
-            STM32F7_FLASH->SR |= FLASH_SR_EOP;
+            // write data, back to back writes are stalled by the controller until the previous one completes,
+            // errors are collected from the status register once the batch is done instead of reading back every word
+            switch (size) {
+            case 8:
+                *reinterpret_cast<volatile uint32_t*>(addressStart) = data[0] | (data[1] << 8) | (data[2] << 16) | (data[3] << 24);
+                *reinterpret_cast<volatile uint32_t*>(addressStart + 4) = data[4] | (data[5] << 8) | (data[6] << 16) | (data[7] << 24);
+                break;
+
+            case 4:
+                *reinterpret_cast<volatile uint32_t*>(addressStart) = data[0] | (data[1] << 8) | (data[2] << 16) | (data[3] << 24);
+                break;
+
+            case 2:
+                *reinterpret_cast<volatile uint16_t*>(addressStart) = data[0] | (data[1] << 8);
+                break;
+
+            default:
+                *flash = data[0];
+                break;
+            }
 
-            if (*addressStart != *pBuf) {
-                to = 0;
+            __DSB();
 
-                goto end_programing;
-            }
+            programmed += size;
+        }
+        else {
+            skipped += size;
         }
 
-        addressStart++;
-        pBuf++;
+        addressStart += size;
+        data += size;
     }
 
-end_programing:
+end_programming:
+    // wait for completion
+    while (STM32F7_FLASH->SR & FLASH_SR_BSY);
+
+    if (STM32F7_FLASH->SR & STM32F7_FLASH_SR_ERRORS)
+        result = TinyCLR_Result::InvalidOperation;
 
     STM32F7_FLASH->CR &= (~FLASH_CR_PG);
 
@@ -252,7 +325,14 @@ end_programing:
 
     STM32F7_Startup_CacheEnable();
 
-    return timeout != 0 ? TinyCLR_Result::Success : TinyCLR_Result::InvalidOperation;
+    if (benchmarkHandler != nullptr)
+        benchmarkHandler(self, programmed, skipped, result, STM32F7_Time_GetCurrentProcessorTime() - startTime);
+
+    return result;
+}
+
+void STM32F7_Flash_SetBenchmarkHandler(STM32F7_Flash_BenchmarkHandler handler) {
+    flashBenchmarkHandler = handler;
 }
 
 TinyCLR_Result __section("SectionForFlashOperations") STM32F7_Flash_IsErased(const TinyCLR_Storage_Controller* self, uint64_t address, size_t count, bool& erased) {
@@ -279,43 +359,150 @@ TinyCLR_Result __section("SectionForFlashOperations") STM32F7_Flash_IsErased(con
     return TinyCLR_Result::Success;
 }
 
-TinyCLR_Result __section("SectionForFlashOperations") STM32F7_Flash_Erase(const TinyCLR_Storage_Controller* self, uint64_t address, size_t& count, uint64_t timeout) {
-    auto sector = address; //address is sector. Use sector for clear
-    auto state = reinterpret_cast<DeploymentState*>(self->ApiInfo->State);
-
-    if (sector >= state->regionCount) return TinyCLR_Result::IndexOutOfRange;
-
+uint32_t __section("SectionForFlashOperations") STM32F7_Flash_GetSectorNumber(size_t sector) {
     uint32_t num = deploymentSectors[sector].id;
 
     if (num > 11) num += 4;
 
-    STM32F7_Startup_CacheDisable();
+    return num;
+}
 
+void __section("SectionForFlashOperations") STM32F7_Flash_StartErase(size_t sector, bool interruptEnable) {
     STM32F7_FLASH->KEYR = STM32F7_FLASH_KEY1;
     STM32F7_FLASH->KEYR = STM32F7_FLASH_KEY2;
 
-    STM32F7_FLASH->SR = (FLASH_SR_EOP | FLASH_SR_OPERR | FLASH_SR_WRPERR | FLASH_SR_PGAERR | FLASH_SR_PGPERR | FLASH_SR_ERSERR);
+    STM32F7_FLASH->SR = (FLASH_SR_EOP | STM32F7_FLASH_SR_ERRORS);
 
     STM32F7_FLASH->CR = FLASH_PSIZE_WORD;
     STM32F7_FLASH->CR |= FLASH_CR_EOPIE;
-    STM32F7_FLASH->CR |= (num << 3);
+
+    if (interruptEnable)
+        STM32F7_FLASH->CR |= FLASH_CR_ERRIE;
+
+    STM32F7_FLASH->CR |= (STM32F7_Flash_GetSectorNumber(sector) << 3);
     STM32F7_FLASH->CR |= FLASH_CR_SER;
 
     STM32F7_FLASH->CR |= FLASH_CR_STRT;
 
     __DSB();
-    // wait for completion
-    while (((STM32F7_FLASH->SR & FLASH_SR_EOP) == 0) || (STM32F7_FLASH->SR & FLASH_SR_BSY));
+}
 
-    STM32F7_FLASH->CR &= (~FLASH_CR_SER);
+void __section("SectionForFlashOperations") STM32F7_Flash_EndErase() {
+    STM32F7_FLASH->CR &= ~(FLASH_CR_SER | FLASH_CR_ERRIE);
     STM32F7_FLASH->CR &= SECTOR_MASK;
 
     // reset & lock the controller
     STM32F7_FLASH->CR |= FLASH_CR_LOCK;
+}
+
+TinyCLR_Result __section("SectionForFlashOperations") STM32F7_Flash_Erase(const TinyCLR_Storage_Controller* self, uint64_t address, size_t& count, uint64_t timeout) {
+    auto sector = address; //address is sector. Use sector for clear
+    auto state = reinterpret_cast<DeploymentState*>(self->ApiInfo->State);
+
+    if (sector >= state->regionCount) return TinyCLR_Result::IndexOutOfRange;
+
+    // let a queued background erase finish before taking the controller
+    while (state->eraseBusy);
+
+    STM32F7_Startup_CacheDisable();
+
+    STM32F7_Flash_StartErase(sector, false);
+
+    // wait for completion
+    while (((STM32F7_FLASH->SR & (FLASH_SR_EOP | STM32F7_FLASH_SR_ERRORS)) == 0) || (STM32F7_FLASH->SR & FLASH_SR_BSY));
+
+    auto error = STM32F7_FLASH->SR & STM32F7_FLASH_SR_ERRORS;
+
+    STM32F7_Flash_EndErase();
 
     STM32F7_Startup_CacheEnable();
 
-    TinyCLR_Result::Success;
+    return error == 0 ? TinyCLR_Result::Success : TinyCLR_Result::InvalidOperation;
+}
+
+void __section("SectionForFlashOperations") STM32F7_Flash_EraseInterruptHandler(void* param) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    auto state = &deploymentStates[0];
+    auto sr = STM32F7_FLASH->SR;
+    auto sector = state->eraseQueue[state->eraseQueueIn];
+
+    STM32F7_FLASH->SR = (FLASH_SR_EOP | STM32F7_FLASH_SR_ERRORS);
+
+    STM32F7_Flash_EndErase();
+
+    state->eraseQueueIn = (state->eraseQueueIn + 1) % STM32F7_FLASH_ERASE_QUEUE_SIZE;
+    state->eraseQueueCount--;
+
+    if (sr & STM32F7_FLASH_SR_ERRORS)
+        state->eraseErrorCount++;
+
+    if (state->eraseQueueCount > 0) {
+        // chain the next sector while still in the interrupt, cache stays disabled
+        STM32F7_Flash_StartErase(state->eraseQueue[state->eraseQueueIn], true);
+    }
+    else {
+        // synchronous program/erase poll EOP with EOPIE set, they must not end up here
+        STM32F7_InterruptInternal_Deactivate(FLASH_IRQn);
+
+        STM32F7_Startup_CacheEnable();
+
+        state->eraseBusy = false;
+    }
+
+    if (state->eraseCompletedHandler != nullptr)
+        state->eraseCompletedHandler(&deploymentControllers[0], sector, (sr & STM32F7_FLASH_SR_ERRORS) == 0 ? TinyCLR_Result::Success : TinyCLR_Result::InvalidOperation, state->eraseQueueCount);
+}
+
+TinyCLR_Result STM32F7_Flash_EraseAsync(const TinyCLR_Storage_Controller* self, uint64_t sector, STM32F7_Flash_EraseCompletedHandler handler) {
+    auto state = reinterpret_cast<DeploymentState*>(self->ApiInfo->State);
+
+    if (sector >= state->regionCount) return TinyCLR_Result::IndexOutOfRange;
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    if (state->eraseQueueCount == STM32F7_FLASH_ERASE_QUEUE_SIZE) return TinyCLR_Result::Busy;
+
+    if (state->eraseQueueCount > 0 && state->eraseCompletedHandler != handler) return TinyCLR_Result::SharingViolation;
+
+    state->eraseQueue[(state->eraseQueueIn + state->eraseQueueCount) % STM32F7_FLASH_ERASE_QUEUE_SIZE] = sector;
+    state->eraseQueueCount++;
+    state->eraseCompletedHandler = handler;
+
+    if (!state->eraseBusy) {
+        state->eraseBusy = true;
+        state->eraseErrorCount = 0;
+
+        STM32F7_InterruptInternal_Activate(FLASH_IRQn, (uint32_t*)&STM32F7_Flash_EraseInterruptHandler, 0);
+
+        STM32F7_Startup_CacheDisable();
+
+        STM32F7_Flash_StartErase(sector, true);
+    }
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result STM32F7_Flash_WaitForErase(const TinyCLR_Storage_Controller* self, uint64_t timeout) {
+    auto state = reinterpret_cast<DeploymentState*>(self->ApiInfo->State);
+
+    // timeout in microseconds
+    while (state->eraseBusy) {
+        if (timeout == 0)
+            return TinyCLR_Result::TimedOut;
+
+        STM32F7_Time_Delay(nullptr, 1);
+
+        timeout--;
+    }
+
+    return state->eraseErrorCount == 0 ? TinyCLR_Result::Success : TinyCLR_Result::InvalidOperation;
+}
+
+bool STM32F7_Flash_IsEraseBusy(const TinyCLR_Storage_Controller* self) {
+    auto state = reinterpret_cast<DeploymentState*>(self->ApiInfo->State);
+
+    return state->eraseBusy;
 }
 
 TinyCLR_Result STM32F7_Flash_Acquire(const TinyCLR_Storage_Controller* self) {
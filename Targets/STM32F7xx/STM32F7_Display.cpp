@@ -344,6 +344,29 @@ uint32_t displayInitializeCount = 0;
 uint16_t* m_STM32F7_Display_VituralRam = nullptr;
 size_t m_STM32F7_DisplayBufferSize = 0;
 
+// With double buffering the controller scans m_STM32F7_Display_FrontRam while drawing goes to m_STM32F7_Display_VituralRam
+uint16_t* m_STM32F7_Display_FrontRam = nullptr;
+volatile bool m_STM32F7_Display_FlipPending = false;
+STM32F7_Display_FlipHandler m_STM32F7_Display_FlipHandler = nullptr;
+
+// Framebuffer rows drawn since the last flip, and the rows the back buffer has been missing since then
+int32_t m_STM32F7_Display_DirtyTop = 0;
+int32_t m_STM32F7_Display_DirtyBottom = 0;
+int32_t m_STM32F7_Display_StaleTop = 0;
+int32_t m_STM32F7_Display_StaleBottom = 0;
+
+// The overlay is a second LTDC layer blended over the framebuffer. It is placed in panel coordinates, the rotation
+// only applies to the framebuffer. An L8 overlay keeps its palette after the pixels.
+uint8_t* m_STM32F7_Display_OverlayRam = nullptr;
+STM32F7_Display_OverlayFormat m_STM32F7_Display_OverlayFormat = STM32F7_Display_OverlayFormat::Argb8888;
+int32_t m_STM32F7_Display_OverlayX = 0;
+int32_t m_STM32F7_Display_OverlayY = 0;
+int32_t m_STM32F7_Display_OverlayWidth = 0;
+int32_t m_STM32F7_Display_OverlayHeight = 0;
+uint8_t m_STM32F7_Display_OverlayAlpha = 0xFF;
+bool m_STM32F7_Display_OverlayColorKeyEnable = false;
+uint32_t m_STM32F7_Display_OverlayColorKey = 0;
+
 uint8_t m_STM32F7_Display_TextBuffer[LCD_MAX_COLUMN][LCD_MAX_ROW];
 
 STM32F7xx_LCD_Rotation m_STM32F7_Display_CurrentRotation = STM32F7xx_LCD_Rotation::rotateNormal_0;
@@ -375,6 +398,131 @@ uint32_t* STM32F7_Display_GetFrameBuffer();
 static TinyCLR_Display_Controller displayControllers[TOTAL_DISPLAY_CONTROLLERS];
 static TinyCLR_Api_Info displayApi[TOTAL_DISPLAY_CONTROLLERS];
 
+// the buffer the controller scans, the only one without double buffering
+static uint16_t* STM32F7_Display_GetScanoutBuffer() {
+    return m_STM32F7_Display_FrontRam != nullptr ? m_STM32F7_Display_FrontRam : m_STM32F7_Display_VituralRam;
+}
+
+static void STM32F7_Display_MarkDirtyRows(int32_t top, int32_t bottom) {
+    int32_t screenHeight = m_STM32F7_DisplayHeight;
+
+    if (m_STM32F7_Display_FrontRam == nullptr)
+        return;
+
+    if (top < 0)
+        top = 0;
+
+    if (bottom > screenHeight)
+        bottom = screenHeight;
+
+    if (top >= bottom)
+        return;
+
+    if (m_STM32F7_Display_DirtyTop >= m_STM32F7_Display_DirtyBottom) {
+        m_STM32F7_Display_DirtyTop = top;
+        m_STM32F7_Display_DirtyBottom = bottom;
+    }
+    else {
+        if (top < m_STM32F7_Display_DirtyTop)
+            m_STM32F7_Display_DirtyTop = top;
+
+        if (bottom > m_STM32F7_Display_DirtyBottom)
+            m_STM32F7_Display_DirtyBottom = bottom;
+    }
+}
+
+// Framebuffer rows covered by a rectangle of the rotated screen
+static void STM32F7_Display_MarkDirty(int32_t x, int32_t y, int32_t width, int32_t height) {
+    int32_t screenHeight = m_STM32F7_DisplayHeight;
+
+    switch (m_STM32F7_Display_CurrentRotation) {
+    case STM32F7xx_LCD_Rotation::rotateCCW_90:
+        STM32F7_Display_MarkDirtyRows(screenHeight - x - width, screenHeight - x);
+        break;
+
+    case STM32F7xx_LCD_Rotation::rotateCW_90:
+        STM32F7_Display_MarkDirtyRows(x, x + width);
+        break;
+
+    case STM32F7xx_LCD_Rotation::rotate_180:
+        STM32F7_Display_MarkDirtyRows(screenHeight - y - height, screenHeight - y);
+        break;
+
+    default:
+        STM32F7_Display_MarkDirtyRows(y, y + height);
+        break;
+    }
+}
+
+// The back buffer stays on screen until a pending flip is taken. After that it is brought up to date with the rows
+// drawn in the frame that was just presented.
+static void STM32F7_Display_BeginDraw() {
+    if (m_STM32F7_Display_FrontRam == nullptr)
+        return;
+
+    while (m_STM32F7_Display_FlipPending);
+
+    if (m_STM32F7_Display_StaleTop < m_STM32F7_Display_StaleBottom) {
+        auto offset = m_STM32F7_Display_StaleTop * m_STM32F7_DisplayWidth;
+
+        memcpy(m_STM32F7_Display_VituralRam + offset, m_STM32F7_Display_FrontRam + offset, (m_STM32F7_Display_StaleBottom - m_STM32F7_Display_StaleTop) * m_STM32F7_DisplayWidth * 2);
+
+        m_STM32F7_Display_StaleTop = 0;
+        m_STM32F7_Display_StaleBottom = 0;
+    }
+}
+
+static void STM32F7_Display_FlipCompleted() {
+    m_STM32F7_Display_FlipPending = false;
+
+    if (m_STM32F7_Display_FlipHandler != nullptr)
+        m_STM32F7_Display_FlipHandler(&displayControllers[0], STM32F7_Time_GetCurrentProcessorTime());
+}
+
+void STM32F7_Display_InterruptHandler(void* param) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    if (LTDC->ISR & LTDC_ISR_RRIF) {
+        LTDC->IER &= ~LTDC_IER_RRIE;
+        LTDC->ICR = LTDC_ICR_CRRIF;
+
+        STM32F7_Display_FlipCompleted();
+    }
+}
+
+// The framebuffer is on the first layer, under the overlay. Its shadow registers are reloaded in the next vertical
+// blanking and the reload interrupt reports it.
+static void STM32F7_Display_SetScanoutBuffer(uint16_t* buffer) {
+    // the LTDC reads SDRAM, nothing drawn may be left in the DCache
+    SCB_CleanDCache_by_Addr(reinterpret_cast<uint32_t*>(reinterpret_cast<uint32_t>(buffer) & ~31), m_STM32F7_DisplayBufferSize + 32);
+
+    LTDC_Layer1->CFBAR = (uint32_t)buffer;
+
+    LTDC->ICR = LTDC_ICR_CRRIF;
+    LTDC->IER |= LTDC_IER_RRIE;
+    LTDC->SRCR = LTDC_SRCR_VBR;
+}
+
+// Hands what was drawn to the controller for the next vertical blanking, drawing goes to the old front buffer from then on
+static void STM32F7_Display_Present() {
+    if (m_STM32F7_Display_FrontRam == nullptr || m_STM32F7_DisplayEnable == false || m_STM32F7_Display_DirtyTop >= m_STM32F7_Display_DirtyBottom)
+        return;
+
+    auto front = m_STM32F7_Display_VituralRam;
+
+    m_STM32F7_Display_VituralRam = m_STM32F7_Display_FrontRam;
+    m_STM32F7_Display_FrontRam = front;
+
+    m_STM32F7_Display_StaleTop = m_STM32F7_Display_DirtyTop;
+    m_STM32F7_Display_StaleBottom = m_STM32F7_Display_DirtyBottom;
+    m_STM32F7_Display_DirtyTop = 0;
+    m_STM32F7_Display_DirtyBottom = 0;
+
+    m_STM32F7_Display_FlipPending = true;
+
+    STM32F7_Display_SetScanoutBuffer(front);
+}
+
 bool STM32F7_Ltdc_Initialize(LTDC_HandleTypeDef *hltdc) {
     uint32_t tmp = 0, tmp1 = 0;
 
@@ -505,6 +653,91 @@ void STM32F7_Ltdc_LayerConfiguration(LTDC_HandleTypeDef *hltdc, LTDC_LayerCfgTyp
 
 }
 
+static uint32_t STM32F7_Display_GetOverlayPixelSize() {
+    switch (m_STM32F7_Display_OverlayFormat) {
+    case STM32F7_Display_OverlayFormat::Argb8888: return 4;
+    case STM32F7_Display_OverlayFormat::Argb4444: return 2;
+    default: return 1;
+    }
+}
+
+static uint32_t* STM32F7_Display_GetOverlayPalette() {
+    return reinterpret_cast<uint32_t*>(m_STM32F7_Display_OverlayRam + ((m_STM32F7_Display_OverlayWidth * m_STM32F7_Display_OverlayHeight + 3) & ~3));
+}
+
+// Programs the overlay layer from the saved state. The part of the overlay outside the panel is cropped by starting the
+// layer further into its buffer, the pitch stays the overlay width. Loading the CLUT needs the layer off, so it is only
+// done when the palette changed.
+static void STM32F7_Display_ApplyOverlay(uint32_t reload, bool loadPalette) {
+    LTDC_HandleTypeDef hltdc;
+    LTDC_LayerCfgTypeDef layerCfg;
+
+    hltdc.Instance = LTDC;
+
+    auto layer = LTDC_LAYER(&hltdc, 1);
+
+    int32_t screenWidth = m_STM32F7_DisplayWidth;
+    int32_t screenHeight = m_STM32F7_DisplayHeight;
+
+    auto x0 = m_STM32F7_Display_OverlayX < 0 ? 0 : m_STM32F7_Display_OverlayX;
+    auto y0 = m_STM32F7_Display_OverlayY < 0 ? 0 : m_STM32F7_Display_OverlayY;
+    auto x1 = m_STM32F7_Display_OverlayX + m_STM32F7_Display_OverlayWidth > screenWidth ? screenWidth : m_STM32F7_Display_OverlayX + m_STM32F7_Display_OverlayWidth;
+    auto y1 = m_STM32F7_Display_OverlayY + m_STM32F7_Display_OverlayHeight > screenHeight ? screenHeight : m_STM32F7_Display_OverlayY + m_STM32F7_Display_OverlayHeight;
+
+    if (m_STM32F7_Display_OverlayRam == nullptr || x0 >= x1 || y0 >= y1) {
+        layer->CR &= ~(LTDC_LxCR_LEN | LTDC_LxCR_COLKEN | LTDC_LxCR_CLUTEN);
+
+        LTDC->SRCR = reload;
+
+        return;
+    }
+
+    auto pixelSize = STM32F7_Display_GetOverlayPixelSize();
+    auto l8 = m_STM32F7_Display_OverlayFormat == STM32F7_Display_OverlayFormat::L8;
+
+    if (l8 && loadPalette) {
+        auto palette = STM32F7_Display_GetOverlayPalette();
+
+        layer->CR &= ~LTDC_LxCR_LEN;
+
+        LTDC->SRCR = LTDC_SRCR_IMR;
+
+        for (uint32_t i = 0; i < 256; i++)
+            layer->CLUTWR = (i << 24) | (palette[i] & 0x00FFFFFF);
+    }
+
+    layerCfg.WindowX0 = x0;
+    layerCfg.WindowX1 = x1;
+    layerCfg.WindowY0 = y0;
+    layerCfg.WindowY1 = y1;
+
+    switch (m_STM32F7_Display_OverlayFormat) {
+    case STM32F7_Display_OverlayFormat::Argb8888: layerCfg.PixelFormat = LTDC_PIXEL_FORMAT_ARGB8888; break;
+    case STM32F7_Display_OverlayFormat::Argb4444: layerCfg.PixelFormat = LTDC_PIXEL_FORMAT_ARGB4444; break;
+    default: layerCfg.PixelFormat = LTDC_PIXEL_FORMAT_L8; break;
+    }
+
+    // per pixel alpha scaled by the constant alpha, outside the window the layer is transparent
+    layerCfg.Alpha = m_STM32F7_Display_OverlayAlpha;
+    layerCfg.Alpha0 = 0;
+    layerCfg.Backcolor.Blue = 0;
+    layerCfg.Backcolor.Green = 0;
+    layerCfg.Backcolor.Red = 0;
+    layerCfg.BlendingFactor1 = LTDC_BLENDING_FACTOR1_PAxCA;
+    layerCfg.BlendingFactor2 = LTDC_BLENDING_FACTOR2_PAxCA;
+
+    layerCfg.FBStartAdress = reinterpret_cast<uint32_t>(m_STM32F7_Display_OverlayRam + ((y0 - m_STM32F7_Display_OverlayY) * m_STM32F7_Display_OverlayWidth + (x0 - m_STM32F7_Display_OverlayX)) * pixelSize);
+    layerCfg.ImageWidth = m_STM32F7_Display_OverlayWidth;
+    layerCfg.ImageHeight = y1 - y0;
+
+    STM32F7_Ltdc_SetConfiguration(&hltdc, &layerCfg, 1);
+
+    layer->CKCR = m_STM32F7_Display_OverlayColorKey & 0x00FFFFFF;
+    layer->CR = (layer->CR & ~(LTDC_LxCR_COLKEN | LTDC_LxCR_CLUTEN)) | (m_STM32F7_Display_OverlayColorKeyEnable ? LTDC_LxCR_COLKEN : 0) | (l8 ? LTDC_LxCR_CLUTEN : 0);
+
+    LTDC->SRCR = reload;
+}
+
 bool STM32F7_Display_Initialize() {
     // InitializeConfiguration
     static LTDC_HandleTypeDef hltdc_F;
@@ -628,7 +861,7 @@ bool STM32F7_Display_Initialize() {
     if (m_STM32F7_Display_VituralRam == nullptr)
         return false;
 
-    pLayerCfg.FBStartAdress = (uint32_t)m_STM32F7_Display_VituralRam;
+    pLayerCfg.FBStartAdress = (uint32_t)STM32F7_Display_GetScanoutBuffer();
 
     /* Alpha constant (255 == totally opaque) */
     pLayerCfg.Alpha = 255;
@@ -653,7 +886,9 @@ bool STM32F7_Display_Initialize() {
     }
 
     /* Configure the Layer*/
-    STM32F7_Ltdc_LayerConfiguration(&hltdc_F, &pLayerCfg, 1);
+    STM32F7_Ltdc_LayerConfiguration(&hltdc_F, &pLayerCfg, 0);
+
+    STM32F7_Display_ApplyOverlay(LTDC_SRCR_IMR, true);
 
     return true;
 }
@@ -661,6 +896,9 @@ bool STM32F7_Display_Initialize() {
 bool STM32F7_Display_Uninitialize() {
     RCC->APB2ENR &= ~RCC_APB2ENR_LTDCEN;
 
+    // the controller stops before taking a pending flip, the new buffer is scanned from the next initialization
+    m_STM32F7_Display_FlipPending = false;
+
     return true;
 }
 
@@ -799,7 +1037,11 @@ void STM32F7_Display_Clear() {
     if (m_STM32F7_DisplayEnable == false || m_STM32F7_Display_VituralRam == nullptr)
         return;
 
+    STM32F7_Display_BeginDraw();
+
     memset((uint32_t*)m_STM32F7_Display_VituralRam, 0, m_STM32F7_DisplayBufferSize);
+
+    STM32F7_Display_MarkDirtyRows(0, m_STM32F7_DisplayHeight);
 }
 
 const STM32F7_Gpio_Pin g_Display_ControllerPins[] = STM32F7_DISPLAY_CONTROLLER_PINS;
@@ -1052,6 +1294,9 @@ TinyCLR_Result STM32F7_Display_Release(const TinyCLR_Display_Controller* self) {
         m_STM32F7_DisplayEnable = false;
 
         if (m_STM32F7_Display_VituralRam != nullptr) {
+            STM32F7_Display_SetDoubleBuffering(self, false);
+            STM32F7_Display_RemoveOverlay(self);
+
             auto memoryProvider = (const TinyCLR_Memory_Manager*)apiManager->FindDefault(apiManager, TinyCLR_Api_Type::MemoryManager);
 
             memoryProvider->Free(memoryProvider, m_STM32F7_Display_VituralRam);
@@ -1121,6 +1366,9 @@ TinyCLR_Result STM32F7_Display_SetConfiguration(const TinyCLR_Display_Controller
         auto memoryProvider = (const TinyCLR_Memory_Manager*)apiManager->FindDefault(apiManager, TinyCLR_Api_Type::MemoryManager);
 
         if (m_STM32F7_Display_VituralRam != nullptr) {
+            STM32F7_Display_SetDoubleBuffering(self, false);
+            STM32F7_Display_RemoveOverlay(self);
+
             memoryProvider->Free(memoryProvider, m_STM32F7_Display_VituralRam);
 
             m_STM32F7_Display_VituralRam = nullptr;
@@ -1180,7 +1428,13 @@ TinyCLR_Result STM32F7_Display_GetConfiguration(const TinyCLR_Display_Controller
 }
 
 TinyCLR_Result STM32F7_Display_DrawBuffer(const TinyCLR_Display_Controller* self, uint32_t x, uint32_t y, uint32_t width, uint32_t height, const uint8_t* data) {
+    STM32F7_Display_BeginDraw();
+
     STM32F7_Display_BitBltEx(x, y, width, height, (uint32_t*)data);
+
+    STM32F7_Display_MarkDirty(x, y, width, height);
+    STM32F7_Display_Present();
+
     return TinyCLR_Result::Success;
 }
 
@@ -1197,17 +1451,238 @@ TinyCLR_Result STM32F7_Display_DrawPixel(const TinyCLR_Display_Controller* self,
     if (y >= m_STM32F7_DisplayHeight)
         return TinyCLR_Result::InvalidOperation;
 
+    STM32F7_Display_BeginDraw();
+
     loc = m_STM32F7_Display_VituralRam + (y *m_STM32F7_DisplayWidth) + (x);
 
     *loc = rgb565;
 
+    STM32F7_Display_MarkDirtyRows(y, y + 1);
+
     return TinyCLR_Result::Success;
 }
 
 TinyCLR_Result STM32F7_Display_DrawString(const TinyCLR_Display_Controller* self, const char* data, size_t length) {
+    STM32F7_Display_BeginDraw();
+
     for (size_t i = 0; i < length; i++)
         STM32F7_Display_WriteFormattedChar(data[i]);
 
+    STM32F7_Display_MarkDirtyRows(0, m_STM32F7_DisplayHeight);
+    STM32F7_Display_Present();
+
+    return TinyCLR_Result::Success;
+}
+
+// A second framebuffer is drawn while the first one is on screen, DrawBuffer and DrawString flip them at the next
+// vertical blanking. The back buffer starts as a copy of the screen.
+TinyCLR_Result STM32F7_Display_SetDoubleBuffering(const TinyCLR_Display_Controller* self, bool enable) {
+    if (m_STM32F7_Display_VituralRam == nullptr)
+        return TinyCLR_Result::InvalidOperation;
+
+    if (enable == (m_STM32F7_Display_FrontRam != nullptr))
+        return TinyCLR_Result::Success;
+
+    auto memoryProvider = (const TinyCLR_Memory_Manager*)apiManager->FindDefault(apiManager, TinyCLR_Api_Type::MemoryManager);
+
+    if (enable) {
+        auto back = (uint16_t*)memoryProvider->Allocate(memoryProvider, m_STM32F7_DisplayBufferSize);
+
+        if (back == nullptr)
+            return TinyCLR_Result::OutOfMemory;
+
+        memcpy(back, m_STM32F7_Display_VituralRam, m_STM32F7_DisplayBufferSize);
+
+        m_STM32F7_Display_FrontRam = m_STM32F7_Display_VituralRam;
+        m_STM32F7_Display_VituralRam = back;
+
+        m_STM32F7_Display_DirtyTop = m_STM32F7_Display_DirtyBottom = 0;
+        m_STM32F7_Display_StaleTop = m_STM32F7_Display_StaleBottom = 0;
+
+        STM32F7_InterruptInternal_Activate(LTDC_IRQn, (uint32_t*)&STM32F7_Display_InterruptHandler, 0);
+    }
+    else {
+        while (m_STM32F7_Display_FlipPending);
+
+        STM32F7_Display_Present();
+
+        while (m_STM32F7_Display_FlipPending);
+
+        STM32F7_InterruptInternal_Deactivate(LTDC_IRQn);
+
+        // the back buffer is only newer when it could not be presented because the display is off
+        if (m_STM32F7_Display_DirtyTop < m_STM32F7_Display_DirtyBottom) {
+            STM32F7_Display_BeginDraw();
+
+            memoryProvider->Free(memoryProvider, m_STM32F7_Display_FrontRam);
+        }
+        else {
+            memoryProvider->Free(memoryProvider, m_STM32F7_Display_VituralRam);
+
+            m_STM32F7_Display_VituralRam = m_STM32F7_Display_FrontRam;
+        }
+
+        m_STM32F7_Display_FrontRam = nullptr;
+    }
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result STM32F7_Display_WaitForFlip(const TinyCLR_Display_Controller* self) {
+    while (m_STM32F7_Display_FlipPending);
+
+    return TinyCLR_Result::Success;
+}
+
+// Called from the interrupt once the controller scans the newly presented buffer
+TinyCLR_Result STM32F7_Display_SetFlipHandler(const TinyCLR_Display_Controller* self, STM32F7_Display_FlipHandler handler) {
+    m_STM32F7_Display_FlipHandler = handler;
+
+    return TinyCLR_Result::Success;
+}
+
+// Places an overlay of the given size and format at x, y on the panel. It starts transparent (ARGB formats) or all
+// palette entry 0 (L8) and replaces any overlay set before.
+TinyCLR_Result STM32F7_Display_SetOverlay(const TinyCLR_Display_Controller* self, int32_t x, int32_t y, int32_t width, int32_t height, STM32F7_Display_OverlayFormat format) {
+    if (m_STM32F7_Display_VituralRam == nullptr)
+        return TinyCLR_Result::InvalidOperation;
+
+    if (width <= 0 || height <= 0 || width > static_cast<int32_t>(m_STM32F7_DisplayWidth) || height > static_cast<int32_t>(m_STM32F7_DisplayHeight))
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    if (format != STM32F7_Display_OverlayFormat::Argb8888 && format != STM32F7_Display_OverlayFormat::Argb4444 && format != STM32F7_Display_OverlayFormat::L8)
+        return TinyCLR_Result::ArgumentInvalid;
+
+    STM32F7_Display_RemoveOverlay(self);
+
+    m_STM32F7_Display_OverlayFormat = format;
+    m_STM32F7_Display_OverlayWidth = width;
+    m_STM32F7_Display_OverlayHeight = height;
+
+    auto size = static_cast<size_t>(width * height) * STM32F7_Display_GetOverlayPixelSize();
+
+    if (format == STM32F7_Display_OverlayFormat::L8)
+        size = ((size + 3) & ~3) + 256 * sizeof(uint32_t);
+
+    auto memoryProvider = (const TinyCLR_Memory_Manager*)apiManager->FindDefault(apiManager, TinyCLR_Api_Type::MemoryManager);
+    auto buffer = reinterpret_cast<uint8_t*>(memoryProvider->Allocate(memoryProvider, size));
+
+    if (buffer == nullptr)
+        return TinyCLR_Result::OutOfMemory;
+
+    memset(buffer, 0, size);
+
+    // the LTDC reads SDRAM, nothing drawn may be left in the DCache
+    SCB_CleanDCache_by_Addr(reinterpret_cast<uint32_t*>(reinterpret_cast<uint32_t>(buffer) & ~31), size + 32);
+
+    m_STM32F7_Display_OverlayRam = buffer;
+    m_STM32F7_Display_OverlayX = x;
+    m_STM32F7_Display_OverlayY = y;
+    m_STM32F7_Display_OverlayAlpha = 0xFF;
+    m_STM32F7_Display_OverlayColorKeyEnable = false;
+    m_STM32F7_Display_OverlayColorKey = 0;
+
+    if (m_STM32F7_DisplayEnable)
+        STM32F7_Display_ApplyOverlay(LTDC_SRCR_IMR, true);
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result STM32F7_Display_RemoveOverlay(const TinyCLR_Display_Controller* self) {
+    if (m_STM32F7_Display_OverlayRam == nullptr)
+        return TinyCLR_Result::Success;
+
+    auto memoryProvider = (const TinyCLR_Memory_Manager*)apiManager->FindDefault(apiManager, TinyCLR_Api_Type::MemoryManager);
+    auto buffer = m_STM32F7_Display_OverlayRam;
+
+    m_STM32F7_Display_OverlayRam = nullptr;
+
+    if (m_STM32F7_DisplayEnable)
+        STM32F7_Display_ApplyOverlay(LTDC_SRCR_IMR, false);
+
+    memoryProvider->Free(memoryProvider, buffer);
+
+    return TinyCLR_Result::Success;
+}
+
+// Takes effect in the next vertical blanking, a cursor moves without tearing and without redrawing the framebuffer
+TinyCLR_Result STM32F7_Display_MoveOverlay(const TinyCLR_Display_Controller* self, int32_t x, int32_t y) {
+    if (m_STM32F7_Display_OverlayRam == nullptr)
+        return TinyCLR_Result::InvalidOperation;
+
+    m_STM32F7_Display_OverlayX = x;
+    m_STM32F7_Display_OverlayY = y;
+
+    if (m_STM32F7_DisplayEnable)
+        STM32F7_Display_ApplyOverlay(LTDC_SRCR_VBR, false);
+
+    return TinyCLR_Result::Success;
+}
+
+// alpha scales the pixel alpha of the whole overlay. Overlay pixels of the RGB888 colorKey are transparent when keying
+// is enabled, for L8 the key is compared with the palette color.
+TinyCLR_Result STM32F7_Display_SetOverlayBlending(const TinyCLR_Display_Controller* self, uint8_t alpha, bool colorKeyEnable, uint32_t colorKey) {
+    if (m_STM32F7_Display_OverlayRam == nullptr)
+        return TinyCLR_Result::InvalidOperation;
+
+    m_STM32F7_Display_OverlayAlpha = alpha;
+    m_STM32F7_Display_OverlayColorKeyEnable = colorKeyEnable;
+    m_STM32F7_Display_OverlayColorKey = colorKey;
+
+    if (m_STM32F7_DisplayEnable)
+        STM32F7_Display_ApplyOverlay(LTDC_SRCR_VBR, false);
+
+    return TinyCLR_Result::Success;
+}
+
+// RGB888 colors for the first count entries of an L8 overlay, the rest keep their color
+TinyCLR_Result STM32F7_Display_SetOverlayPalette(const TinyCLR_Display_Controller* self, const uint32_t* colors, size_t count) {
+    if (colors == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    if (m_STM32F7_Display_OverlayRam == nullptr || m_STM32F7_Display_OverlayFormat != STM32F7_Display_OverlayFormat::L8)
+        return TinyCLR_Result::InvalidOperation;
+
+    if (count > 256)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    memcpy(STM32F7_Display_GetOverlayPalette(), colors, count * sizeof(uint32_t));
+
+    if (m_STM32F7_DisplayEnable)
+        STM32F7_Display_ApplyOverlay(LTDC_SRCR_IMR, true);
+
+    return TinyCLR_Result::Success;
+}
+
+// data holds width by height pixels in the overlay format, they are drawn at x, y of the overlay and cropped to it
+TinyCLR_Result STM32F7_Display_DrawOverlay(const TinyCLR_Display_Controller* self, int32_t x, int32_t y, int32_t width, int32_t height, const uint8_t* data, size_t length) {
+    if (data == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    if (m_STM32F7_Display_OverlayRam == nullptr)
+        return TinyCLR_Result::InvalidOperation;
+
+    auto pixelSize = STM32F7_Display_GetOverlayPixelSize();
+
+    if (width <= 0 || height <= 0 || length < static_cast<uint64_t>(width) * static_cast<uint64_t>(height) * pixelSize)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto first = x < 0 ? -x : 0;
+    auto last = x + width > m_STM32F7_Display_OverlayWidth ? m_STM32F7_Display_OverlayWidth - x : width;
+
+    if (first >= last)
+        return TinyCLR_Result::Success;
+
+    for (auto row = y < 0 ? -y : 0; row < height && y + row < m_STM32F7_Display_OverlayHeight; row++) {
+        auto from = data + (row * width + first) * pixelSize;
+        auto to = m_STM32F7_Display_OverlayRam + ((y + row) * m_STM32F7_Display_OverlayWidth + x + first) * pixelSize;
+        auto size = (last - first) * pixelSize;
+
+        memcpy(to, from, size);
+
+        SCB_CleanDCache_by_Addr(reinterpret_cast<uint32_t*>(reinterpret_cast<uint32_t>(to) & ~31), size + 32);
+    }
+
     return TinyCLR_Result::Success;
 }
 
@@ -87,9 +87,13 @@ TinyCLR_Result STM32F7_Power_Sleep(const TinyCLR_Power_Controller* self, TinyCLR
     default:
         CLEAR_BIT(SCB->SCR, ((uint32_t)SCB_SCR_SLEEPDEEP_Msk));
 
+        STM32F7_Time_EnterSleep();
+
         /* Request Wait For Interrupt */
         __WFI();
 
+        STM32F7_Time_ExitSleep();
+
         return TinyCLR_Result::Success;
     }
 }
@@ -19,15 +19,25 @@
 #define TIMER_IDLE_VALUE  0x0000FFFFFFFFFFFFFull
 
 #define TOTAL_TIME_CONTROLLERS 1
+#ifdef STM32F7_TIME_TIM2
+#if STM32F7_APB1_CLOCK_HZ == STM32F7_AHB_CLOCK_HZ
+#define SLOW_CLOCKS_PER_SECOND (STM32F7_APB1_CLOCK_HZ)
+#else
+#define SLOW_CLOCKS_PER_SECOND (STM32F7_APB1_CLOCK_HZ * 2)
+#endif
+#else
 #define SLOW_CLOCKS_PER_SECOND STM32F7_AHB_CLOCK_HZ
+#endif
 #define SLOW_CLOCKS_TEN_MHZ_GCD           1000000   // GCD(SLOW_CLOCKS_PER_SECOND, 10M)
 #define SLOW_CLOCKS_MILLISECOND_GCD          1000   // GCD(SLOW_CLOCKS_PER_SECOND, 1k)
 #define CLOCK_COMMON_FACTOR               1000000   // GCD(STM32F7_SYSTEM_CLOCK_HZ, 1M)
 #define CORTEXM_SLEEP_USEC_FIXED_OVERHEAD_CLOCKS 3
 
+// 100ns units per tick as a 0.32 fixed point fraction
+#define TIME_FACTOR(clock) ((10000000ULL << 32) / (clock))
+
 struct TimeState {
     int32_t controllerIndex;
-    uint64_t m_lastRead;
     uint32_t m_currentTick;
     uint32_t m_periodTicks;
 
@@ -109,36 +119,71 @@ uint64_t STM32F7_Time_GetProcessorTicksForTime(const TinyCLR_NativeTime_Controll
 #endif
 }
 
-uint64_t STM32F7_Time_GetCurrentProcessorTime() {
-    return STM32F7_Time_GetTimeForProcessorTicks(nullptr, STM32F7_Time_GetCurrentProcessorTicks(nullptr));
+// A 32 bit counter extended to 64 bits: state holds the wrap count in bits 31..1 and the last seen bit 31 of the
+// counter in bit 0. Readers move it forward with LDREX/STREX so nothing masks interrupts, it only has to be read at
+// least once per half wrap.
+static uint64_t STM32F7_Time_ExtendCounter(volatile uint32_t* state, volatile uint32_t* counter) {
+    uint32_t current, value, next;
+
+    do {
+        current = __LDREXW(state);
+        value = *counter;
+
+        if ((current & 1) == (value >> 31)) {
+            __CLREX();
+
+            next = current;
+
+            break;
+        }
+
+        // bit 31 went from 1 to 0: the counter wrapped
+        next = (((current >> 1) + (current & 1)) << 1) | (value >> 31);
+    } while (__STREXW(next, state) != 0);
+
+    return (static_cast<uint64_t>(next >> 1) << 32) | value;
 }
 
+static uint64_t STM32F7_Time_ConvertFixedPoint(uint64_t ticks, uint64_t factor) {
+    return (ticks >> 32) * factor + (((ticks & 0xFFFFFFFF) * factor) >> 32);
+}
+
+#ifndef STM32F7_TIME_TIM2
+// The native time is DWT CYCCNT extended to 64 bits. It wraps around every 20 to 25 seconds, SysTick only schedules the
+// callbacks and fires at least once per reload, which keeps the wrap count current.
+static volatile uint32_t cycleCounterState;
+static uint64_t cycleCounterOffset;
+static uint64_t cycleCounterReloadTicks; // native time when SysTick was last reloaded
+
 uint64_t STM32F7_Time_GetCurrentProcessorTicks(const TinyCLR_NativeTime_Controller* self) {
-    DISABLE_INTERRUPTS_SCOPED(irq);
+    return STM32F7_Time_ExtendCounter(&cycleCounterState, &DWT->CYCCNT) + cycleCounterOffset;
+}
 
-    TimeState* state = ((self == nullptr) ? &timeStates[0] : reinterpret_cast<TimeState*>(self->ApiInfo->State));
+uint64_t STM32F7_Time_GetCurrentProcessorTime() {
+    return STM32F7_Time_ConvertFixedPoint(STM32F7_Time_GetCurrentProcessorTicks(nullptr), TIME_FACTOR(STM32F7_AHB_CLOCK_HZ));
+}
 
-    uint32_t tick_spent;
-    uint32_t reg = SysTick->CTRL;
-    uint32_t ticks = (SysTick->VAL & SysTick_LOAD_RELOAD_Msk);
+// CYCCNT may stop while the core sleeps, SysTick keeps counting. Whatever SysTick counted since the last reload and the
+// cycle counter missed is added to the offset. Interrupts have to be disabled.
+static void STM32F7_Time_CatchUp(bool reloadElapsed) {
+    auto state = &timeStates[0];
 
-    if ((reg & SysTick_CTRL_COUNTFLAG_Msk) == SysTick_CTRL_COUNTFLAG_Msk   // Interrupt was trigger on time as expected
-        || ticks >= state->m_currentTick) {                // Interrupt was trigger slower than expected
-        if (ticks > 0) {
-            tick_spent = state->m_currentTick + (SysTick->LOAD - ticks);
-        }
-        else {
-            tick_spent = state->m_currentTick;
-        }
-    }
-    else {
-        tick_spent = state->m_currentTick - ticks;
-    }
+    uint64_t counted = reloadElapsed ? state->m_currentTick : state->m_currentTick - (SysTick->VAL & SysTick_LOAD_RELOAD_Msk);
+    auto ticks = STM32F7_Time_GetCurrentProcessorTicks(nullptr) - cycleCounterReloadTicks;
+
+    if (counted > ticks)
+        cycleCounterOffset += counted - ticks;
+}
+
+void STM32F7_Time_EnterSleep() {
+    // SysTick keeps counting and is the reference for STM32F7_Time_CatchUp
+}
 
-    state->m_currentTick = ticks;
-    state->m_lastRead += tick_spent;
+void STM32F7_Time_ExitSleep() {
+    DISABLE_INTERRUPTS_SCOPED(irq);
 
-    return (uint64_t)(state->m_lastRead);
+    // the SysTick interrupt may not have run yet
+    STM32F7_Time_CatchUp((SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) != 0);
 }
 
 TinyCLR_Result STM32F7_Time_SetNextTickCallbackTime(const TinyCLR_NativeTime_Controller* self, uint64_t processorTicks) {
@@ -153,23 +198,8 @@ TinyCLR_Result STM32F7_Time_SetNextTickCallbackTime(const TinyCLR_NativeTime_Con
     timerNextEvent = processorTicks;
 
     if (timerNextEvent >= TIMER_IDLE_VALUE) {
-        if (ticks >= TIMER_IDLE_VALUE) {
-            timerNextEvent = timerNextEvent > ticks ? (timerNextEvent - ticks) : 0;
-
-            state->m_lastRead = 0;
-
-            state->m_currentTick = timerNextEvent;
-            state->m_periodTicks = timerNextEvent;
-
-            SysTick_Config(state->m_periodTicks);
-
-            state->Reload(state->m_periodTicks);
-
-        }
-        else {
-            state->m_periodTicks = SysTick_LOAD_RELOAD_Msk;
-            state->Reload(SysTick_LOAD_RELOAD_Msk);
-        }
+        state->m_periodTicks = SysTick_LOAD_RELOAD_Msk;
+        state->Reload(SysTick_LOAD_RELOAD_Msk);
     }
     else {
         if (ticks >= timerNextEvent) { // missed event
@@ -200,6 +230,13 @@ extern "C" {
         auto state = &timeStates[controllerIndex];
 
         auto self = &timeControllers[controllerIndex];
+
+        {
+            DISABLE_INTERRUPTS_SCOPED(irq);
+
+            STM32F7_Time_CatchUp(true);
+        }
+
         if (STM32F7_Time_GetCurrentProcessorTicks(self) >= timerNextEvent) { // handle event
             state->m_DequeuAndExecute();
         }
@@ -210,12 +247,29 @@ extern "C" {
 
 }
 
+void TimeState::Reload(uint32_t value) {
+    auto state = &timeStates[0];
+
+    state->m_currentTick = value;
+
+    SysTick->LOAD = (uint32_t)(state->m_currentTick - 1UL);
+    SysTick->VAL = 0UL;
+
+    cycleCounterReloadTicks = STM32F7_Time_GetCurrentProcessorTicks(nullptr);
+}
+
 TinyCLR_Result STM32F7_Time_Initialize(const TinyCLR_NativeTime_Controller* self) {
     timerNextEvent = TIMER_IDLE_VALUE;
 
     TimeState* state = ((self == nullptr) ? &timeStates[0] : reinterpret_cast<TimeState*>(self->ApiInfo->State));
 
-    state->m_lastRead = 0;
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->LAR = 0xC5ACCE55; // unlock
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    cycleCounterState = 0;
+    cycleCounterOffset = 0;
 
     state->m_currentTick = SysTick_LOAD_RELOAD_Msk;
     state->m_periodTicks = SysTick_LOAD_RELOAD_Msk;
@@ -233,6 +287,179 @@ TinyCLR_Result STM32F7_Time_Uninitialize(const TinyCLR_NativeTime_Controller* se
     return TinyCLR_Result::Success;
 }
 
+// The SysTick read GetCurrentProcessorTicks used before the cycle counter, kept for STM32F7_Time_Benchmark. It follows the
+// SysTick count in its own state so the live accounting is left alone.
+static uint64_t STM32F7_Time_GetSysTickProcessorTicks() {
+    static uint32_t currentTick = SysTick_LOAD_RELOAD_Msk;
+    static uint64_t lastRead;
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    uint32_t tick_spent;
+    uint32_t reg = SysTick->CTRL;
+    uint32_t ticks = (SysTick->VAL & SysTick_LOAD_RELOAD_Msk);
+
+    if ((reg & SysTick_CTRL_COUNTFLAG_Msk) == SysTick_CTRL_COUNTFLAG_Msk || ticks >= currentTick) {
+        if (ticks > 0) {
+            tick_spent = currentTick + (SysTick->LOAD - ticks);
+        }
+        else {
+            tick_spent = currentTick;
+        }
+    }
+    else {
+        tick_spent = currentTick - ticks;
+    }
+
+    currentTick = ticks;
+    lastRead += tick_spent;
+
+    return lastRead;
+}
+
+// Average cycles per call of reading and converting the time through SysTick, as before, and of GetCurrentProcessorTime
+void STM32F7_Time_Benchmark(uint32_t iterations, uint32_t& sysTickTimeCycles, uint32_t& processorTimeCycles) {
+    volatile uint64_t time;
+
+    if (iterations == 0)
+        iterations = 1;
+
+    auto start = DWT->CYCCNT;
+
+    for (auto i = 0U; i < iterations; i++)
+        time = STM32F7_Time_GetTimeForProcessorTicks(nullptr, STM32F7_Time_GetSysTickProcessorTicks());
+
+    auto middle = DWT->CYCCNT;
+
+    for (auto i = 0U; i < iterations; i++)
+        time = STM32F7_Time_GetCurrentProcessorTime();
+
+    auto end = DWT->CYCCNT;
+
+    sysTickTimeCycles = (middle - start) / iterations;
+    processorTimeCycles = (end - middle) / iterations;
+}
+
+#else
+// TIM2 free runs as the native time base. CC1 fires at the next scheduled event, CC2 halfway through the counter
+// and the update at the wrap keep the 64 bit extension current, so the core sleeps until the event is actually due
+// instead of waking up on every 24 bit SysTick reload. Devices that do not use TIM2 for PWM opt in with STM32F7_TIME_TIM2,
+// PWM controller 1 then reports SharingViolation on Acquire.
+static volatile uint32_t timerCounterState;
+
+uint64_t STM32F7_Time_GetCurrentProcessorTicks(const TinyCLR_NativeTime_Controller* self) {
+    return STM32F7_Time_ExtendCounter(&timerCounterState, &TIM2->CNT);
+}
+
+uint64_t STM32F7_Time_GetCurrentProcessorTime() {
+    return STM32F7_Time_ConvertFixedPoint(STM32F7_Time_GetCurrentProcessorTicks(nullptr), TIME_FACTOR(SLOW_CLOCKS_PER_SECOND));
+}
+
+void STM32F7_Time_EnterSleep() {
+    // TIM2 keeps counting while the core sleeps
+}
+
+void STM32F7_Time_ExitSleep() {
+
+}
+
+TinyCLR_Result STM32F7_Time_SetNextTickCallbackTime(const TinyCLR_NativeTime_Controller* self, uint64_t processorTicks) {
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    TimeState* state = ((self == nullptr) ? &timeStates[0] : reinterpret_cast<TimeState*>(self->ApiInfo->State));
+
+    auto ticks = STM32F7_Time_GetCurrentProcessorTicks(self);
+
+    timerNextEvent = processorTicks;
+
+    TIM2->DIER &= ~TIM_DIER_CC1IE;
+
+    if (timerNextEvent >= TIMER_IDLE_VALUE)
+        return TinyCLR_Result::Success;
+
+    if (ticks >= timerNextEvent) { // missed event
+        state->m_DequeuAndExecute();
+
+        return TinyCLR_Result::Success;
+    }
+
+    // events more than half a wrap away are rescheduled from the CC2 and update interrupts until they are close enough
+    if (timerNextEvent - ticks < 0x80000000) {
+        TIM2->CCR1 = static_cast<uint32_t>(timerNextEvent);
+        TIM2->SR = ~TIM_SR_CC1IF;
+        TIM2->DIER |= TIM_DIER_CC1IE;
+
+        // the compare only matches when the counter steps onto CCR1, it may have gone past while CCR1 was written
+        if (STM32F7_Time_GetCurrentProcessorTicks(self) >= timerNextEvent) {
+            TIM2->DIER &= ~TIM_DIER_CC1IE;
+
+            state->m_DequeuAndExecute();
+        }
+    }
+
+    return TinyCLR_Result::Success;
+}
+
+void STM32F7_Time_InterruptHandler(void* param) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    auto controllerIndex = 0; // default index if no specific
+
+    auto state = &timeStates[controllerIndex];
+
+    auto self = &timeControllers[controllerIndex];
+
+    TIM2->SR = ~(TIM_SR_UIF | TIM_SR_CC1IF | TIM_SR_CC2IF);
+
+    if (STM32F7_Time_GetCurrentProcessorTicks(self) >= timerNextEvent) { // handle event
+        state->m_DequeuAndExecute();
+    }
+    else {
+        STM32F7_Time_SetNextTickCallbackTime(self, timerNextEvent);
+    }
+}
+
+TinyCLR_Result STM32F7_Time_Initialize(const TinyCLR_NativeTime_Controller* self) {
+    timerNextEvent = TIMER_IDLE_VALUE;
+    timerCounterState = 0;
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->LAR = 0xC5ACCE55; // unlock
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    RCC->APB1ENR |= RCC_APB1ENR_TIM2EN;
+
+    TIM2->CR1 = 0;
+    TIM2->PSC = 0;
+    TIM2->ARR = 0xFFFFFFFF;
+    TIM2->CCR2 = 0x80000000;
+    TIM2->CCMR1 = 0; // CC1 and CC2 frozen output compare
+    TIM2->CCER = 0;
+    TIM2->EGR = TIM_EGR_UG;
+    TIM2->CNT = 0;
+    TIM2->SR = 0;
+    TIM2->DIER = TIM_DIER_UIE | TIM_DIER_CC2IE;
+
+    STM32F7_InterruptInternal_Activate(TIM2_IRQn, (uint32_t*)&STM32F7_Time_InterruptHandler, 0);
+
+    TIM2->CR1 = TIM_CR1_CEN;
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result STM32F7_Time_Uninitialize(const TinyCLR_NativeTime_Controller* self) {
+    TIM2->CR1 = 0;
+    TIM2->DIER = 0;
+
+    STM32F7_InterruptInternal_Deactivate(TIM2_IRQn);
+
+    RCC->APB1ENR &= ~RCC_APB1ENR_TIM2EN;
+
+    return TinyCLR_Result::Success;
+}
+
+#endif
+
 TinyCLR_Result STM32F7_Time_SetTickCallback(const TinyCLR_NativeTime_Controller* self, TinyCLR_NativeTime_Callback callback) {
     TimeState* state = ((self == nullptr) ? &timeStates[0] : reinterpret_cast<TimeState*>(self->ApiInfo->State));
 
@@ -268,15 +495,6 @@ void STM32F7_Time_DelayNative(const TinyCLR_NativeTime_Controller* self, uint64_
 
 //******************** Profiler ********************
 
-void TimeState::Reload(uint32_t value) {
-    auto state = &timeStates[0];
-
-    state->m_currentTick = value;
-
-    SysTick->LOAD = (uint32_t)(state->m_currentTick - 1UL);
-    SysTick->VAL = 0UL;
-}
-
 #ifdef __GNUC__
 asm volatile (
     ".syntax unified\n\t"
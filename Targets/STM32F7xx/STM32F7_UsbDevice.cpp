@@ -692,6 +692,30 @@ bool STM32F7_UsbDevice_RxEnable(UsClientState* usClientState, int32_t ep) {
     return true;
 }
 
+bool STM32F7_UsbDevice_SetEndpointStall(UsClientState* usClientState, int32_t ep, bool stall) {
+    if (usClientState == 0 || ep == 0 || ep >= usClientState->totalEndpointsCount || usClientState->queues[ep] == 0)
+        return false;
+
+    OTG_TypeDef* OTG = OTG_FS;
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    if (usClientState->isTxQueue[ep]) {
+        if (stall)
+            OTG->DIEP[ep].CTL |= OTG_DIEPCTL_STALL;
+        else
+            OTG->DIEP[ep].CTL = (OTG->DIEP[ep].CTL & ~OTG_DIEPCTL_STALL) | OTG_DIEPCTL_SD0PID;
+    }
+    else {
+        if (stall)
+            OTG->DOEP[ep].CTL |= OTG_DOEPCTL_STALL;
+        else
+            OTG->DOEP[ep].CTL = (OTG->DOEP[ep].CTL & ~OTG_DOEPCTL_STALL) | OTG_DOEPCTL_SD0PID;
+    }
+
+    return true;
+}
+
 void STM32F7_UsbDevice_ProtectPins(int32_t controller, bool on) {
     UsClientState *usClientState = usbDeviceControllers[controller].usClientState;
 
@@ -754,6 +778,10 @@ bool TinyCLR_UsbClient_RxEnable(UsClientState* usClientState, int32_t endpoint)
     return STM32F7_UsbDevice_RxEnable(usClientState, endpoint);
 }
 
+bool TinyCLR_UsbClient_SetEndpointStall(UsClientState* usClientState, int32_t endpoint, bool stall) {
+    return STM32F7_UsbDevice_SetEndpointStall(usClientState, endpoint, stall);
+}
+
 void TinyCLR_UsbClient_Delay(uint64_t microseconds) {
     STM32F7_Time_Delay(nullptr, microseconds);
 }